@@ -0,0 +1,60 @@
+//////////////////////////////////////////////////////////////////////
+// LwoAllocCounter.cpp : counting operator new for statistics of loading
+//
+// Empty unless LWO_INSTRUMENTATION is defined.
+// Linked into LWReader only (not with reader sources of tools,
+// which replace operator new themselves), see GetLwoAllocCounter().
+//
+
+#include "LwoInstrumentation.h"
+
+#ifdef LWO_INSTRUMENTATION
+
+#include <stdlib.h>
+#include <new>
+
+using namespace std;
+
+// all allocations of process (any thread)
+static tLwoAllocCounter g_LwoAllocs;
+
+// release is kept out of line: when inlined into callers
+// GCC sees free() of pointer from operator new (-Wmismatched-new-delete)
+#if defined(__GNUC__)
+#define LWO_ALLOC_NOINLINE __attribute__((noinline))
+#else
+#define LWO_ALLOC_NOINLINE
+#endif
+
+const tLwoAllocCounter *GetLwoAllocCounter()
+{
+	return &g_LwoAllocs;
+}
+
+void *operator new(size_t nSize)
+{
+	g_LwoAllocs.Add(nSize);
+	void *pMem = malloc((nSize > 0) ? nSize : 1);
+	if (pMem == NULL)
+	{
+		throw bad_alloc();
+	}
+	return pMem;
+}
+
+void *operator new[](size_t nSize)
+{
+	return operator new(nSize);
+}
+
+LWO_ALLOC_NOINLINE void operator delete(void *pMem) noexcept
+{
+	free(pMem);
+}
+
+LWO_ALLOC_NOINLINE void operator delete[](void *pMem) noexcept
+{
+	free(pMem);
+}
+
+#endif // LWO_INSTRUMENTATION
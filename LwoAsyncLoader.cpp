@@ -0,0 +1,299 @@
+//////////////////////////////////////////////////////////////////////
+// LwoAsyncLoader.cpp : non-blocking loading of objects
+//
+
+#include "LwoAsyncLoader.h"
+#include "LwoTrace.h"
+
+#include <algorithm>
+
+// how many queued files are hinted to OS ahead of reading
+#define LWO_ASYNC_PREFETCH_COUNT 4
+
+// bytes held until parsed:
+// streamed file is read while parsing
+static uint64_t GetBufferedSize(const CMemFile &File)
+{
+	return (File.IsStreaming() == true) ? 0 : File.GetFilesize();
+}
+
+
+CLwoAsyncLoader::CLwoAsyncLoader(const size_t nParseThreads, const uint64_t ullMemoryBudget)
+	: m_Pool(nParseThreads)
+	, m_Readers()
+	, m_Queue()
+	, m_nOutstanding(0)
+	, m_nNextSequence(0)
+	, m_ullBuffered(0)
+	, m_ullMemoryBudget(ullMemoryBudget)
+	, m_bPurge(false)
+	, m_bStop(false)
+	, m_IoThread()
+{
+	// object of each file within same budget as files
+	// (as in batch loading)
+	for (size_t i = 0; i < m_Pool.GetThreadCount(); i++)
+	{
+		m_Readers.push_back(unique_ptr<CLwoReader>(new CLwoReader()));
+		m_Readers.back()->SetMemoryBudget(m_ullMemoryBudget);
+	}
+
+	// after other members are ready
+	m_IoThread = thread(&CLwoAsyncLoader::IoLoop, this);
+}
+
+CLwoAsyncLoader::~CLwoAsyncLoader(void)
+{
+	{
+		lock_guard<mutex> Lock(m_Lock);
+		m_bStop = true;
+	}
+	m_IoWake.notify_all();
+	m_IoThread.join();
+
+	// parsing of files already read
+	Wait();
+	m_Pool.WaitIdle();
+}
+
+bool CLwoAsyncLoader::IsLowerPriority(const tRequest &pLeft, const tRequest &pRight)
+{
+	if (pLeft->m_iPriority != pRight->m_iPriority)
+	{
+		return (pLeft->m_iPriority < pRight->m_iPriority);
+	}
+	return (pLeft->m_nSequence > pRight->m_nSequence);
+}
+
+CLwoAsyncLoader::tRequest CLwoAsyncLoader::Load(const string &szPath, const int iPriority, tCallback Callback, tExecutor Executor)
+{
+	tRequest pRequest;
+	{
+		lock_guard<mutex> Lock(m_Lock);
+		pRequest = tRequest(new CLwoAsyncRequest(szPath, iPriority, m_nNextSequence++));
+		pRequest->m_Callback = Callback;
+		pRequest->m_Executor = Executor;
+
+		m_Queue.push_back(pRequest);
+		push_heap(m_Queue.begin(), m_Queue.end(), IsLowerPriority);
+		m_nOutstanding++;
+	}
+	m_IoWake.notify_one();
+	return pRequest;
+}
+
+void CLwoAsyncLoader::Cancel(const tRequest &pRequest)
+{
+	pRequest->m_bCancelled = true;
+	{
+		lock_guard<mutex> Lock(m_Lock);
+		m_bPurge = true;
+	}
+	m_IoWake.notify_one();
+}
+
+void CLwoAsyncLoader::CancelAll()
+{
+	{
+		lock_guard<mutex> Lock(m_Lock);
+		for (size_t i = 0; i < m_Queue.size(); i++)
+		{
+			m_Queue[i]->m_bCancelled = true;
+		}
+		m_bPurge = true;
+	}
+	m_IoWake.notify_one();
+}
+
+void CLwoAsyncLoader::Wait()
+{
+	unique_lock<mutex> Lock(m_Lock);
+	m_Finished.wait(Lock, [this]() { return (m_nOutstanding == 0); });
+}
+
+void CLwoAsyncLoader::PurgeQueue(vector<tRequest> &vCancelled)
+{
+	size_t nKept = 0;
+	for (size_t i = 0; i < m_Queue.size(); i++)
+	{
+		if (m_Queue[i]->m_bCancelled == true)
+		{
+			vCancelled.push_back(m_Queue[i]);
+		}
+		else
+		{
+			m_Queue[nKept++] = m_Queue[i];
+		}
+	}
+	m_Queue.resize(nKept);
+	make_heap(m_Queue.begin(), m_Queue.end(), IsLowerPriority);
+	m_bPurge = false;
+}
+
+void CLwoAsyncLoader::IoLoop()
+{
+	CLwoTrace::SetThreadName("io");
+
+	while (true)
+	{
+		tRequest pRequest;
+		vector<tRequest> vCancelled;
+		vector<string> vPrefetch;
+		bool bStop = false;
+		{
+			unique_lock<mutex> Lock(m_Lock);
+			m_IoWake.wait(Lock, [this]() {
+				return (m_bStop == true
+					|| m_bPurge == true
+					|| (m_Queue.empty() == false && IsWithinBudget() == true));
+			});
+
+			if (m_bStop == true)
+			{
+				// don't start new files when stopping
+				for (size_t i = 0; i < m_Queue.size(); i++)
+				{
+					m_Queue[i]->m_bCancelled = true;
+				}
+				bStop = true;
+			}
+			if (m_bPurge == true
+				|| bStop == true)
+			{
+				PurgeQueue(vCancelled);
+			}
+
+			if (m_Queue.empty() == false
+				&& IsWithinBudget() == true)
+			{
+				pop_heap(m_Queue.begin(), m_Queue.end(), IsLowerPriority);
+				pRequest = m_Queue.back();
+				m_Queue.pop_back();
+
+				// next ones in heap-order are near the front:
+				// good enough for a hint
+				for (size_t i = 0; i < m_Queue.size() && i < LWO_ASYNC_PREFETCH_COUNT; i++)
+				{
+					vPrefetch.push_back(m_Queue[i]->m_szPath);
+				}
+			}
+		}
+
+		for (size_t i = 0; i < vCancelled.size(); i++)
+		{
+			CompleteCancelled(vCancelled[i]);
+		}
+		if (bStop == true)
+		{
+			break;
+		}
+		if (pRequest == NULL)
+		{
+			continue;
+		}
+
+		// OS reads these while this one is loaded
+		if (vPrefetch.empty() == false)
+		{
+			CLwoTraceScope Trace("prefetch", 0, vPrefetch.size());
+			for (size_t i = 0; i < vPrefetch.size(); i++)
+			{
+				CMemFile::Prefetch(vPrefetch[i].c_str());
+			}
+		}
+
+		shared_ptr<CMemFile> pFile(new CMemFile(pRequest->m_szPath.c_str()));
+		pFile->SetMemoryBudget(m_ullMemoryBudget);
+		if (pFile->LoadWithinBudget() == false)
+		{
+			tResult Result(new CLwoBatchResult(pRequest->m_szPath, pRequest->m_nSequence));
+			Result->m_szError = "load";
+			Complete(pRequest, Result);
+			continue;
+		}
+		if (pRequest->m_bCancelled == true)
+		{
+			CompleteCancelled(pRequest);
+			continue;
+		}
+
+		{
+			lock_guard<mutex> Lock(m_Lock);
+			m_ullBuffered += GetBufferedSize(*pFile);
+		}
+		m_Pool.Submit([this, pRequest, pFile]() { Parse(pRequest, pFile); });
+	}
+}
+
+void CLwoAsyncLoader::Parse(tRequest pRequest, shared_ptr<CMemFile> pFile)
+{
+	tResult Result(new CLwoBatchResult(pRequest->m_szPath, pRequest->m_nSequence));
+	Result->m_ulFilesize = pFile->GetFilesize();
+
+	if (pRequest->m_bCancelled == false)
+	{
+		// only this worker uses its reader
+		CLwoReader *pReader = m_Readers[CLwoThreadPool::GetWorkerIndex()].get();
+		if (pReader->ProcessFromFile(*pFile) == true)
+		{
+			Result->m_uiFileType = pReader->GetFileType();
+			pReader->GetMemoryReport(Result->m_Memory);
+			Result->m_ObjectData = pReader->ReleaseObjectData();
+			Result->m_bSuccess = true;
+		}
+		else
+		{
+			Result->m_szError = (pReader->GetError() == LWO_ERROR_BUDGET) ? "budget" : "parse";
+			pReader->Reset();
+		}
+	}
+
+	// buffer released: reading may continue
+	const uint64_t ullBuffered = GetBufferedSize(*pFile);
+	pFile.reset();
+	{
+		lock_guard<mutex> Lock(m_Lock);
+		m_ullBuffered -= ullBuffered;
+	}
+	m_IoWake.notify_one();
+
+	if (pRequest->m_bCancelled == true)
+	{
+		CompleteCancelled(pRequest);
+		return;
+	}
+	Complete(pRequest, Result);
+}
+
+void CLwoAsyncLoader::CompleteCancelled(tRequest pRequest)
+{
+	tResult Result(new CLwoBatchResult(pRequest->m_szPath, pRequest->m_nSequence));
+	Result->m_szError = "cancelled";
+	Complete(pRequest, Result);
+}
+
+void CLwoAsyncLoader::Complete(tRequest pRequest, tResult Result)
+{
+	function<void()> Done = [pRequest, Result]() {
+		if (pRequest->m_Callback)
+		{
+			pRequest->m_Callback(Result);
+		}
+		pRequest->m_Promise.set_value(Result);
+	};
+
+	if (pRequest->m_Executor)
+	{
+		pRequest->m_Executor(Done);
+	}
+	else
+	{
+		Done();
+	}
+
+	// notify while locked:
+	// waiting thread may destroy this loader right after
+	lock_guard<mutex> Lock(m_Lock);
+	m_nOutstanding--;
+	m_Finished.notify_all();
+}
@@ -0,0 +1,183 @@
+//////////////////////////////////////////////////////////////////////
+// LwoAsyncLoader.h : non-blocking loading of objects
+//
+// Files are read on single I/O thread in order of priority
+// (highest first, same priority in order of requests),
+// parsing is done on worker threads.
+// Completion (callback and future) runs on executor given with request:
+// e.g. function which queues the task to main loop of game,
+// without executor it runs on worker thread.
+// Callback with executor is enough for wrapping as coroutine awaiter.
+//
+// Memory budget limits bytes of files read but not yet parsed:
+// when exceeded, reading and prefetching wait for parsing.
+// File larger than budget is not read whole but streamed
+// while parsing (see CMemFile::LoadWithinBudget()),
+// object which does not fit fails with error "budget"
+// (see CLwoReader::SetMemoryBudget()).
+//
+// Cancelled request completes with error "cancelled"
+// when it reaches next stage (queued, read or parsed).
+//
+
+#ifndef _LWOASYNCLOADER_H_
+#define _LWOASYNCLOADER_H_
+
+#include "LwoBatchLoader.h"
+#include "LwoThreadPool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+class CLwoAsyncLoader
+{
+public:
+	// same result as in batch loading
+	typedef CLwoBatchLoader::tResult tResult;
+	typedef CLwoBatchLoader::tCallback tCallback;
+
+	// runs given task on thread of caller's choice
+	typedef function<void(function<void()>)> tExecutor;
+
+	// single request: handle for cancelling and waiting
+	class CLwoAsyncRequest
+	{
+	protected:
+		friend class CLwoAsyncLoader;
+
+		string m_szPath;
+		int m_iPriority;
+
+		// order of requests
+		size_t m_nSequence;
+
+		atomic<bool> m_bCancelled;
+
+		tCallback m_Callback;
+		tExecutor m_Executor;
+
+		promise<tResult> m_Promise;
+		shared_future<tResult> m_Future;
+
+	public:
+		CLwoAsyncRequest(const string &szPath, const int iPriority, const size_t nSequence)
+			: m_szPath(szPath)
+			, m_iPriority(iPriority)
+			, m_nSequence(nSequence)
+			, m_bCancelled(false)
+			, m_Callback()
+			, m_Executor()
+			, m_Promise()
+			, m_Future()
+		{
+			m_Future = m_Promise.get_future().share();
+		};
+
+		const string &GetPath() const
+		{
+			return m_szPath;
+		};
+
+		int GetPriority() const
+		{
+			return m_iPriority;
+		};
+
+		bool IsCancelled() const
+		{
+			return m_bCancelled;
+		};
+
+		// ready after completion was run on executor
+		shared_future<tResult> GetFuture() const
+		{
+			return m_Future;
+		};
+	};
+	typedef shared_ptr<CLwoAsyncRequest> tRequest;
+
+protected:
+	CLwoThreadPool m_Pool;
+
+	// reader of each worker, reused for each file it parses
+	vector<unique_ptr<CLwoReader>> m_Readers;
+
+	// files to read: heap by priority
+	vector<tRequest> m_Queue;
+
+	mutex m_Lock;
+	condition_variable m_IoWake;
+	condition_variable m_Finished;
+
+	// requests not yet completed
+	size_t m_nOutstanding;
+	size_t m_nNextSequence;
+
+	// bytes read but not yet parsed
+	uint64_t m_ullBuffered;
+	uint64_t m_ullMemoryBudget;
+
+	// queue has cancelled requests to remove
+	bool m_bPurge;
+	bool m_bStop;
+
+	thread m_IoThread;
+
+	// heap-order: lower priority (later request) is "less"
+	static bool IsLowerPriority(const tRequest &pLeft, const tRequest &pRight);
+
+	// reading may continue within budget
+	// (always when nothing is buffered)
+	bool IsWithinBudget() const
+	{
+		return (m_ullMemoryBudget == 0
+			|| m_ullBuffered == 0
+			|| m_ullBuffered < m_ullMemoryBudget);
+	};
+
+	// remove cancelled requests from queue (when locked)
+	void PurgeQueue(vector<tRequest> &vCancelled);
+
+	void IoLoop();
+	void Parse(tRequest pRequest, shared_ptr<CMemFile> pFile);
+
+	// run completion on executor of request
+	void Complete(tRequest pRequest, tResult Result);
+	void CompleteCancelled(tRequest pRequest);
+
+public:
+	// zero threads: amount of hardware threads,
+	// zero budget: no limit
+	CLwoAsyncLoader(const size_t nParseThreads = 0, const uint64_t ullMemoryBudget = 0);
+
+	// cancels requests still queued and waits for others
+	~CLwoAsyncLoader(void);
+
+	// queue file for loading, returns immediately
+	tRequest Load(const string &szPath, const int iPriority = 0, tCallback Callback = tCallback(), tExecutor Executor = tExecutor());
+
+	// request stops at next stage,
+	// completes with error "cancelled" unless already finished
+	void Cancel(const tRequest &pRequest);
+	void CancelAll();
+
+	// wait until all requests are handed to their executors
+	// (don't call from executor which runs on this thread)
+	void Wait();
+
+	uint64_t GetBufferedBytes()
+	{
+		lock_guard<mutex> Lock(m_Lock);
+		return m_ullBuffered;
+	};
+};
+
+#endif // ifndef _LWOASYNCLOADER_H_
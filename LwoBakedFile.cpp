@@ -0,0 +1,724 @@
+//////////////////////////////////////////////////////////////////////
+// LwoBakedFile.cpp : pre-baked binary form of parsed object
+//
+
+#include "LwoBakedFile.h"
+#include "LwoHash.h"
+
+// memcpy(), memset(), memcmp()
+#include <cstring>
+
+// fopen(), sprintf(), rename(), remove()
+#include <cstdio>
+
+// counter of temporary names
+#include <atomic>
+
+// stat() and process id
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+static const char g_szBakedMagic[8] = "LWOBAKE";
+static const uint32_t g_uiByteOrder = 0x01020304;
+
+// element size of each section type
+static const uint32_t g_uiElementSizes[BAKED_SECTION_COUNT] =
+{
+	sizeof(tLwoBakedLayer),
+	sizeof(tLwoBakedPointSet),
+	sizeof(float),
+	sizeof(tLwoBakedPolySet),
+	sizeof(tLwoBakedPolygon),
+	sizeof(uint32_t),
+	sizeof(tLwoBakedSurface),
+	sizeof(tLwoBakedVmap),
+	sizeof(uint32_t),
+	sizeof(float),
+	sizeof(char)
+};
+
+static inline uint64_t AlignOffset(const uint64_t ullOffset)
+{
+	return ((ullOffset + (LWO_BAKED_ALIGN -1)) & ~((uint64_t)LWO_BAKED_ALIGN -1));
+}
+
+
+//////////////////////////////////////////////////////////////////////
+// CLwoBakedWriter
+//////////////////////////////////////////////////////////////////////
+
+CLwoBakedWriter::CLwoBakedWriter(void)
+{
+}
+
+CLwoBakedWriter::~CLwoBakedWriter(void)
+{
+	Clear();
+}
+
+void CLwoBakedWriter::Clear()
+{
+	m_Layers.clear();
+	m_PointSets.clear();
+	m_Points.clear();
+	m_PolySets.clear();
+	m_Polygons.clear();
+	m_Indices.clear();
+	m_Surfaces.clear();
+	m_Vmaps.clear();
+	m_VmapIndices.clear();
+	m_VmapValues.clear();
+	m_Strings.clear();
+	m_StringOffsets.clear();
+}
+
+// strings are shared in pool,
+// offset zero is always empty string
+uint32_t CLwoBakedWriter::AddString(const string &szValue)
+{
+	map<string, uint32_t>::iterator itString = m_StringOffsets.find(szValue);
+	if (itString != m_StringOffsets.end())
+	{
+		return itString->second;
+	}
+
+	uint32_t uiOffset = (uint32_t)m_Strings.size();
+	m_Strings.insert(m_Strings.end(), szValue.begin(), szValue.end());
+	m_Strings.push_back('\0');
+	m_StringOffsets.insert(map<string, uint32_t>::value_type(szValue, uiOffset));
+	return uiOffset;
+}
+
+// flatten chunks of object into arrays:
+// pointers between chunks become indices
+bool CLwoBakedWriter::BuildSections(const CLwoObjectData &Object)
+{
+	Clear();
+	AddString(string());
+
+	map<const CLwoLayer*, int32_t> mapLayers;
+	map<const CLwoSurface*, int32_t> mapSurfaces;
+	map<const CLwoPoints*, int32_t> mapPointSets;
+	map<const CLwoPolygons*, int32_t> mapPolySets;
+
+	const tLayerList &Layers = Object.GetLayers();
+	const tSurfaceList &Surfaces = Object.GetSurfaces();
+
+	// layers and surfaces first so they can be referred by index
+	for (size_t i = 0; i < Layers.size(); i++)
+	{
+		mapLayers[Layers[i]] = (int32_t)i;
+	}
+	for (size_t i = 0; i < Surfaces.size(); i++)
+	{
+		const CLwoSurface *pSurface = Surfaces[i];
+		mapSurfaces[pSurface] = (int32_t)m_Surfaces.size();
+
+		tLwoBakedSurface Surface;
+		memset(&Surface, 0, sizeof(Surface));
+		Surface.m_uiName = AddString(pSurface->m_szSurfaceName);
+		Surface.m_uiParentName = AddString(pSurface->m_szParentSurfaceName);
+		for (int j = 0; j < 3; j++)
+		{
+			Surface.m_fColor[j] = pSurface->m_fColor[j];
+		}
+		Surface.m_uiColorEnvelope = pSurface->m_uiColorEnvelope;
+		Surface.m_fDiffuse = pSurface->m_fDiffuse;
+		Surface.m_fLuminosity = pSurface->m_fLuminosity;
+		Surface.m_fSpecular = pSurface->m_fSpecular;
+		Surface.m_fGlossiness = pSurface->m_fGlossiness;
+		Surface.m_fReflection = pSurface->m_fReflection;
+		Surface.m_fTransparency = pSurface->m_fTransparency;
+		Surface.m_fTranslucency = pSurface->m_fTranslucency;
+		Surface.m_fRefractiveIndex = pSurface->m_fRefractiveIndex;
+		Surface.m_fBump = pSurface->m_fBump;
+		Surface.m_fSmoothingAngle = pSurface->m_fSmoothingAngle;
+		Surface.m_usSidedness = pSurface->m_usSidedness;
+		m_Surfaces.push_back(Surface);
+	}
+
+	// geometry of each layer in order of file
+	for (size_t i = 0; i < Layers.size(); i++)
+	{
+		const CLwoLayer *pLayer = Layers[i];
+		uint32_t uiLayer = (uint32_t)m_Layers.size();
+
+		tLwoBakedLayer Layer;
+		memset(&Layer, 0, sizeof(Layer));
+		Layer.m_uiName = AddString(pLayer->m_szLayerName);
+		Layer.m_usNumber = pLayer->m_usLayerNumber;
+		Layer.m_usFlags = pLayer->m_usLayerFlags;
+		Layer.m_iParent = -1;
+		if (pLayer->m_pParentLayer != NULL)
+		{
+			map<const CLwoLayer*, int32_t>::iterator itParent = mapLayers.find(pLayer->m_pParentLayer);
+			if (itParent != mapLayers.end())
+			{
+				Layer.m_iParent = itParent->second;
+			}
+		}
+		for (int j = 0; j < 3; j++)
+		{
+			Layer.m_fPivot[j] = pLayer->GetPivot(j);
+		}
+		Layer.m_uiFirstPointSet = (uint32_t)m_PointSets.size();
+		Layer.m_uiFirstPolySet = (uint32_t)m_PolySets.size();
+		Layer.m_uiFirstVmap = (uint32_t)m_Vmaps.size();
+
+		for (size_t c = 0; c < pLayer->m_ChunksInLayer.size(); c++)
+		{
+			const CLwoChunk *pLayerChunk = pLayer->m_ChunksInLayer[c];
+			if (pLayerChunk == NULL)
+			{
+				continue;
+			}
+
+			if (pLayerChunk->m_uiChunkType == ID_PNTS)
+			{
+				const CLwoPoints *pPoints = (const CLwoPoints*)pLayerChunk;
+				mapPointSets[pPoints] = (int32_t)m_PointSets.size();
+
+				tLwoBakedPointSet PointSet;
+				memset(&PointSet, 0, sizeof(PointSet));
+				PointSet.m_uiLayer = uiLayer;
+				PointSet.m_uiFirstPoint = (uint32_t)(m_Points.size()/3);
+				PointSet.m_uiPointCount = (uint32_t)pPoints->GetPointCount();
+				m_Points.insert(m_Points.end(), pPoints->m_PointList.begin(), pPoints->m_PointList.end());
+				m_PointSets.push_back(PointSet);
+			}
+			else if (pLayerChunk->m_uiChunkType == ID_POLS)
+			{
+				const CLwoPolygons *pPolyList = (const CLwoPolygons*)pLayerChunk;
+				mapPolySets[pPolyList] = (int32_t)m_PolySets.size();
+
+				tLwoBakedPolySet PolySet;
+				memset(&PolySet, 0, sizeof(PolySet));
+				PolySet.m_uiLayer = uiLayer;
+				PolySet.m_uiPolyTypeID = pPolyList->m_uiPolyTypeID;
+				PolySet.m_iPointSet = -1;
+				if (pPolyList->m_pPointsList != NULL)
+				{
+					map<const CLwoPoints*, int32_t>::iterator itPoints = mapPointSets.find(pPolyList->m_pPointsList);
+					if (itPoints != mapPointSets.end())
+					{
+						PolySet.m_iPointSet = itPoints->second;
+					}
+				}
+				// detail-links are set when all sets are known
+				PolySet.m_iParentSet = -1;
+				PolySet.m_iDetailSet = -1;
+				PolySet.m_uiFirstPolygon = (uint32_t)m_Polygons.size();
+				PolySet.m_uiPolygonCount = (uint32_t)pPolyList->m_PolyList.size();
+
+				for (size_t r = 0; r < pPolyList->m_PolyList.size(); r++)
+				{
+					const CLwoPolygons::CLwoPolyRow &Row = pPolyList->m_PolyList[r];
+					const int *piIndices = pPolyList->GetIndices(Row);
+
+					tLwoBakedPolygon Polygon;
+					memset(&Polygon, 0, sizeof(Polygon));
+					Polygon.m_uiFirstIndex = (uint32_t)m_Indices.size();
+					Polygon.m_usVertexCount = Row.m_wVertexCount;
+					Polygon.m_usFlags = Row.m_wFlags;
+					Polygon.m_iSurface = -1;
+					if (Row.m_pSurface != NULL)
+					{
+						map<const CLwoSurface*, int32_t>::iterator itSurface = mapSurfaces.find(Row.m_pSurface);
+						if (itSurface != mapSurfaces.end())
+						{
+							Polygon.m_iSurface = itSurface->second;
+						}
+					}
+					Polygon.m_iParentPolygon = (int32_t)Row.m_lParentRowIndex;
+					Polygon.m_uiFirstDetail = (uint32_t)Row.m_lFirstDetailIndex;
+					Polygon.m_uiDetailCount = Row.m_usDetailCount;
+
+					for (int v = 0; v < Row.m_wVertexCount; v++)
+					{
+						m_Indices.push_back((uint32_t)piIndices[v]);
+					}
+					m_Polygons.push_back(Polygon);
+				}
+				m_PolySets.push_back(PolySet);
+			}
+			else if (pLayerChunk->m_uiChunkType == ID_VMAP
+				|| pLayerChunk->m_uiChunkType == ID_VMAD)
+			{
+				const CLwoVertexMap *pVmap = (const CLwoVertexMap*)pLayerChunk;
+
+				tLwoBakedVmap Vmap;
+				memset(&Vmap, 0, sizeof(Vmap));
+				Vmap.m_uiLayer = uiLayer;
+				Vmap.m_uiVmapTypeID = pVmap->m_uiVmapTypeID;
+				Vmap.m_uiName = AddString(pVmap->m_szName);
+				Vmap.m_usDimension = pVmap->m_usDimension;
+				Vmap.m_usDiscontinuous = (pVmap->IsDiscontinuous() == true) ? 1 : 0;
+				Vmap.m_iPointSet = -1;
+				if (pVmap->m_pPointsList != NULL)
+				{
+					map<const CLwoPoints*, int32_t>::iterator itPoints = mapPointSets.find(pVmap->m_pPointsList);
+					if (itPoints != mapPointSets.end())
+					{
+						Vmap.m_iPointSet = itPoints->second;
+					}
+				}
+				Vmap.m_uiCount = (uint32_t)pVmap->m_VertexIndices.size();
+
+				Vmap.m_uiFirstVertex = (uint32_t)m_VmapIndices.size();
+				m_VmapIndices.insert(m_VmapIndices.end(), pVmap->m_VertexIndices.begin(), pVmap->m_VertexIndices.end());
+				Vmap.m_uiFirstPoly = (uint32_t)m_VmapIndices.size();
+				if (Vmap.m_usDiscontinuous != 0)
+				{
+					if (pVmap->m_PolyIndices.size() != pVmap->m_VertexIndices.size())
+					{
+						return false;
+					}
+					m_VmapIndices.insert(m_VmapIndices.end(), pVmap->m_PolyIndices.begin(), pVmap->m_PolyIndices.end());
+				}
+
+				if (pVmap->m_Values.size() != (size_t)Vmap.m_uiCount * Vmap.m_usDimension)
+				{
+					return false;
+				}
+				Vmap.m_uiFirstValue = (uint32_t)m_VmapValues.size();
+				m_VmapValues.insert(m_VmapValues.end(), pVmap->m_Values.begin(), pVmap->m_Values.end());
+				m_Vmaps.push_back(Vmap);
+			}
+		}
+
+		Layer.m_uiPointSetCount = (uint32_t)m_PointSets.size() - Layer.m_uiFirstPointSet;
+		Layer.m_uiPolySetCount = (uint32_t)m_PolySets.size() - Layer.m_uiFirstPolySet;
+		Layer.m_uiVmapCount = (uint32_t)m_Vmaps.size() - Layer.m_uiFirstVmap;
+		m_Layers.push_back(Layer);
+	}
+
+	// links between main polygons and detail-polygons
+	map<const CLwoPolygons*, int32_t>::iterator itSet = mapPolySets.begin();
+	while (itSet != mapPolySets.end())
+	{
+		const CLwoPolygons *pPolyList = itSet->first;
+		if (pPolyList->m_pDetailPolygons != NULL)
+		{
+			map<const CLwoPolygons*, int32_t>::iterator itDetail = mapPolySets.find(pPolyList->m_pDetailPolygons);
+			if (itDetail != mapPolySets.end())
+			{
+				m_PolySets[itSet->second].m_iDetailSet = itDetail->second;
+				m_PolySets[itDetail->second].m_iParentSet = itSet->second;
+			}
+		}
+		++itSet;
+	}
+	return true;
+}
+
+bool CLwoBakedWriter::Bake(const CLwoObjectData &Object, const unsigned int uiSourceType, const tLwoSourceKey &Source, vector<char> &Buffer)
+{
+	if (BuildSections(Object) == false)
+	{
+		return false;
+	}
+
+	// data and size of each section in order of directory
+	const void *pData[BAKED_SECTION_COUNT] =
+	{
+		m_Layers.empty() ? NULL : &m_Layers[0],
+		m_PointSets.empty() ? NULL : &m_PointSets[0],
+		m_Points.empty() ? NULL : &m_Points[0],
+		m_PolySets.empty() ? NULL : &m_PolySets[0],
+		m_Polygons.empty() ? NULL : &m_Polygons[0],
+		m_Indices.empty() ? NULL : &m_Indices[0],
+		m_Surfaces.empty() ? NULL : &m_Surfaces[0],
+		m_Vmaps.empty() ? NULL : &m_Vmaps[0],
+		m_VmapIndices.empty() ? NULL : &m_VmapIndices[0],
+		m_VmapValues.empty() ? NULL : &m_VmapValues[0],
+		m_Strings.empty() ? NULL : &m_Strings[0]
+	};
+	const uint64_t ullCount[BAKED_SECTION_COUNT] =
+	{
+		m_Layers.size(),
+		m_PointSets.size(),
+		m_Points.size(),
+		m_PolySets.size(),
+		m_Polygons.size(),
+		m_Indices.size(),
+		m_Surfaces.size(),
+		m_Vmaps.size(),
+		m_VmapIndices.size(),
+		m_VmapValues.size(),
+		m_Strings.size()
+	};
+
+	tLwoBakedHeader Header;
+	memset(&Header, 0, sizeof(Header));
+	memcpy(Header.m_szMagic, g_szBakedMagic, sizeof(Header.m_szMagic));
+	Header.m_uiVersion = LWO_BAKED_VERSION;
+	Header.m_uiByteOrder = g_uiByteOrder;
+	Header.m_Source = Source;
+	Header.m_uiSourceType = uiSourceType;
+	Header.m_uiSectionCount = BAKED_SECTION_COUNT;
+
+	tLwoBakedSection Sections[BAKED_SECTION_COUNT];
+	uint64_t ullOffset = sizeof(Header) + sizeof(Sections);
+	for (int i = 0; i < BAKED_SECTION_COUNT; i++)
+	{
+		ullOffset = AlignOffset(ullOffset);
+		Sections[i].m_uiType = (uint32_t)i;
+		Sections[i].m_uiElementSize = g_uiElementSizes[i];
+		Sections[i].m_ullOffset = ullOffset;
+		Sections[i].m_ullCount = ullCount[i];
+		ullOffset += ullCount[i] * g_uiElementSizes[i];
+	}
+	Header.m_ullFileSize = AlignOffset(ullOffset);
+
+	// padding is zero
+	Buffer.assign((size_t)Header.m_ullFileSize, 0);
+	memcpy(&Buffer[0], &Header, sizeof(Header));
+	memcpy(&Buffer[sizeof(Header)], Sections, sizeof(Sections));
+	for (int i = 0; i < BAKED_SECTION_COUNT; i++)
+	{
+		if (ullCount[i] > 0)
+		{
+			memcpy(&Buffer[(size_t)Sections[i].m_ullOffset], pData[i], (size_t)(ullCount[i] * g_uiElementSizes[i]));
+		}
+	}
+
+	// only keep the result
+	Clear();
+	return true;
+}
+
+bool CLwoBakedWriter::WriteFile(const CLwoObjectData &Object, const unsigned int uiSourceType, const tLwoSourceKey &Source, const char *szPath)
+{
+	vector<char> Buffer;
+	if (Bake(Object, uiSourceType, Source, Buffer) == false)
+	{
+		return false;
+	}
+
+	return WriteAtomic(szPath, Buffer);
+}
+
+bool CLwoBakedWriter::WriteAtomic(const string &szPath, const vector<char> &Buffer)
+{
+	// unique in this directory: process and counter
+	// (writers may run on many threads)
+	static atomic<unsigned long> s_ulTempCounter(0);
+#ifdef _WIN32
+	int iProcess = _getpid();
+#else
+	int iProcess = (int)getpid();
+#endif
+	char szSuffix[64];
+	sprintf(szSuffix, ".tmp%d-%lu", iProcess, s_ulTempCounter++);
+	string szTempPath = szPath + szSuffix;
+
+	FILE *pFile = fopen(szTempPath.c_str(), "wb");
+	if (pFile == NULL)
+	{
+		return false;
+	}
+	size_t nWritten = fwrite(Buffer.data(), Buffer.size(), 1, pFile);
+	if (fclose(pFile) != 0
+		|| nWritten != 1)
+	{
+		remove(szTempPath.c_str());
+		return false;
+	}
+
+#ifdef _WIN32
+	if (MoveFileExA(szTempPath.c_str(), szPath.c_str(), MOVEFILE_REPLACE_EXISTING) == FALSE)
+#else
+	if (rename(szTempPath.c_str(), szPath.c_str()) != 0)
+#endif
+	{
+		remove(szTempPath.c_str());
+		return false;
+	}
+	return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+// CLwoBakedFile
+//////////////////////////////////////////////////////////////////////
+
+CLwoBakedFile::CLwoBakedFile(void)
+	: m_pFile(NULL)
+	, m_pBuffer(NULL)
+	, m_ullBufferSize(0)
+	, m_pHeader(NULL)
+	, m_pSections(NULL)
+{
+}
+
+CLwoBakedFile::~CLwoBakedFile(void)
+{
+	Close();
+}
+
+void CLwoBakedFile::Close()
+{
+	if (m_pFile != NULL)
+	{
+		delete m_pFile;
+		m_pFile = NULL;
+	}
+	m_pBuffer = NULL;
+	m_ullBufferSize = 0;
+	m_pHeader = NULL;
+	m_pSections = NULL;
+}
+
+bool CLwoBakedFile::Open(const char *szPath)
+{
+	Close();
+
+	m_pFile = new CMemFile(szPath);
+	if (m_pFile->MapFile() == false)
+	{
+		Close();
+		return false;
+	}
+
+	m_pBuffer = (const char*)m_pFile->GetFileBuf();
+	m_ullBufferSize = m_pFile->GetFilesize();
+	if (ValidateLayout() == false)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+bool CLwoBakedFile::OpenBuffer(const void *pBuffer, const uint64_t ullSize)
+{
+	Close();
+
+	m_pBuffer = (const char*)pBuffer;
+	m_ullBufferSize = ullSize;
+	if (ValidateLayout() == false)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+// header and directory must match this version
+// and all sections must be within file:
+// after this sections can be used directly
+bool CLwoBakedFile::ValidateLayout()
+{
+	if (m_pBuffer == NULL
+		|| m_ullBufferSize < sizeof(tLwoBakedHeader) + BAKED_SECTION_COUNT*sizeof(tLwoBakedSection))
+	{
+		return false;
+	}
+
+	// structures are read in-place
+	if ((((size_t)m_pBuffer) % LWO_BAKED_ALIGN) != 0)
+	{
+		return false;
+	}
+
+	const tLwoBakedHeader *pHeader = (const tLwoBakedHeader*)m_pBuffer;
+	if (memcmp(pHeader->m_szMagic, g_szBakedMagic, sizeof(g_szBakedMagic)) != 0
+		|| pHeader->m_uiVersion != LWO_BAKED_VERSION
+		|| pHeader->m_uiByteOrder != g_uiByteOrder
+		|| pHeader->m_uiSectionCount != BAKED_SECTION_COUNT
+		|| pHeader->m_ullFileSize != m_ullBufferSize)
+	{
+		return false;
+	}
+
+	const tLwoBakedSection *pSections = (const tLwoBakedSection*)(m_pBuffer + sizeof(tLwoBakedHeader));
+	for (int i = 0; i < BAKED_SECTION_COUNT; i++)
+	{
+		const tLwoBakedSection &Section = pSections[i];
+		if (Section.m_uiType != (uint32_t)i
+			|| Section.m_uiElementSize != g_uiElementSizes[i]
+			|| (Section.m_ullOffset % LWO_BAKED_ALIGN) != 0
+			|| Section.m_ullOffset > m_ullBufferSize)
+		{
+			return false;
+		}
+		if (Section.m_ullCount > (m_ullBufferSize - Section.m_ullOffset) / Section.m_uiElementSize)
+		{
+			return false;
+		}
+	}
+
+	// string pool must end in terminator
+	const tLwoBakedSection &Strings = pSections[BAKED_STRINGS];
+	if (Strings.m_ullCount == 0
+		|| m_pBuffer[Strings.m_ullOffset + Strings.m_ullCount -1] != '\0')
+	{
+		return false;
+	}
+
+	m_pHeader = pHeader;
+	m_pSections = pSections;
+	return true;
+}
+
+const void *CLwoBakedFile::GetSection(const tLwoBakedSectionType eType, size_t &nCount) const
+{
+	nCount = 0;
+	if (m_pSections == NULL)
+	{
+		return NULL;
+	}
+	nCount = (size_t)m_pSections[eType].m_ullCount;
+	if (nCount == 0)
+	{
+		return NULL;
+	}
+	return (m_pBuffer + m_pSections[eType].m_ullOffset);
+}
+
+const char *CLwoBakedFile::GetString(const uint32_t uiOffset) const
+{
+	size_t nCount = 0;
+	const char *pStrings = (const char*)GetSection(BAKED_STRINGS, nCount);
+	if (pStrings == NULL
+		|| uiOffset >= nCount)
+	{
+		return "";
+	}
+	return (pStrings + uiOffset);
+}
+
+bool CLwoBakedFile::MatchesSource(const tLwoSourceKey &Source) const
+{
+	if (m_pHeader == NULL)
+	{
+		return false;
+	}
+	return (m_pHeader->m_Source.m_ullSize == Source.m_ullSize
+		&& m_pHeader->m_Source.m_ullTime == Source.m_ullTime
+		&& m_pHeader->m_Source.m_ullHash == Source.m_ullHash);
+}
+
+// each range and index between sections should be valid
+// (written by CLwoBakedWriter), check when source is not trusted
+bool CLwoBakedFile::VerifyReferences() const
+{
+	size_t nLayers = 0, nPointSets = 0, nPoints = 0, nPolySets = 0, nPolygons = 0;
+	size_t nIndices = 0, nSurfaces = 0, nVmaps = 0, nVmapIndices = 0, nVmapValues = 0, nStrings = 0;
+	const tLwoBakedLayer *pLayers = GetLayers(nLayers);
+	const tLwoBakedPointSet *pPointSets = GetPointSets(nPointSets);
+	GetPoints(nPoints);
+	const tLwoBakedPolySet *pPolySets = GetPolySets(nPolySets);
+	const tLwoBakedPolygon *pPolygons = GetPolygons(nPolygons);
+	const uint32_t *pIndices = GetIndices(nIndices);
+	const tLwoBakedSurface *pSurfaces = GetSurfaces(nSurfaces);
+	const tLwoBakedVmap *pVmaps = GetVmaps(nVmaps);
+	GetVmapIndices(nVmapIndices);
+	GetVmapValues(nVmapValues);
+	GetSection(BAKED_STRINGS, nStrings);
+
+	if (m_pHeader == NULL)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < nLayers; i++)
+	{
+		const tLwoBakedLayer &Layer = pLayers[i];
+		if (Layer.m_uiName >= nStrings
+			|| (Layer.m_iParent >= 0 && (size_t)Layer.m_iParent >= nLayers)
+			|| (uint64_t)Layer.m_uiFirstPointSet + Layer.m_uiPointSetCount > nPointSets
+			|| (uint64_t)Layer.m_uiFirstPolySet + Layer.m_uiPolySetCount > nPolySets
+			|| (uint64_t)Layer.m_uiFirstVmap + Layer.m_uiVmapCount > nVmaps)
+		{
+			return false;
+		}
+	}
+	for (size_t i = 0; i < nPointSets; i++)
+	{
+		if (pPointSets[i].m_uiLayer >= nLayers
+			|| ((uint64_t)pPointSets[i].m_uiFirstPoint + pPointSets[i].m_uiPointCount)*3 > nPoints)
+		{
+			return false;
+		}
+	}
+	for (size_t i = 0; i < nSurfaces; i++)
+	{
+		if (pSurfaces[i].m_uiName >= nStrings
+			|| pSurfaces[i].m_uiParentName >= nStrings)
+		{
+			return false;
+		}
+	}
+	for (size_t i = 0; i < nPolySets; i++)
+	{
+		const tLwoBakedPolySet &PolySet = pPolySets[i];
+		if (PolySet.m_uiLayer >= nLayers
+			|| (PolySet.m_iPointSet >= 0 && (size_t)PolySet.m_iPointSet >= nPointSets)
+			|| (PolySet.m_iParentSet >= 0 && (size_t)PolySet.m_iParentSet >= nPolySets)
+			|| (PolySet.m_iDetailSet >= 0 && (size_t)PolySet.m_iDetailSet >= nPolySets)
+			|| (uint64_t)PolySet.m_uiFirstPolygon + PolySet.m_uiPolygonCount > nPolygons)
+		{
+			return false;
+		}
+
+		// point-indices must be within points of the set
+		uint32_t uiPointCount = (PolySet.m_iPointSet >= 0) ? pPointSets[PolySet.m_iPointSet].m_uiPointCount : 0;
+		for (uint32_t p = 0; p < PolySet.m_uiPolygonCount; p++)
+		{
+			const tLwoBakedPolygon &Polygon = pPolygons[PolySet.m_uiFirstPolygon + p];
+			if ((uint64_t)Polygon.m_uiFirstIndex + Polygon.m_usVertexCount > nIndices
+				|| (Polygon.m_iSurface >= 0 && (size_t)Polygon.m_iSurface >= nSurfaces))
+			{
+				return false;
+			}
+			for (uint32_t v = 0; v < Polygon.m_usVertexCount; v++)
+			{
+				if (pIndices[Polygon.m_uiFirstIndex + v] >= uiPointCount)
+				{
+					return false;
+				}
+			}
+		}
+	}
+	for (size_t i = 0; i < nVmaps; i++)
+	{
+		const tLwoBakedVmap &Vmap = pVmaps[i];
+		uint64_t ullPolyCount = (Vmap.m_usDiscontinuous != 0) ? Vmap.m_uiCount : 0;
+		if (Vmap.m_uiLayer >= nLayers
+			|| Vmap.m_uiName >= nStrings
+			|| (Vmap.m_iPointSet >= 0 && (size_t)Vmap.m_iPointSet >= nPointSets)
+			|| (uint64_t)Vmap.m_uiFirstVertex + Vmap.m_uiCount > nVmapIndices
+			|| (uint64_t)Vmap.m_uiFirstPoly + ullPolyCount > nVmapIndices
+			|| (uint64_t)Vmap.m_uiFirstValue + (uint64_t)Vmap.m_uiCount * Vmap.m_usDimension > nVmapValues)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool CLwoBakedFile::MakeSourceKey(const char *szPath, const void *pData, const size_t nSize, tLwoSourceKey &Source)
+{
+	struct stat sStat;
+	if (stat(szPath, &sStat) != 0)
+	{
+		return false;
+	}
+
+	Source.m_ullSize = (uint64_t)sStat.st_size;
+	Source.m_ullTime = (uint64_t)sStat.st_mtime * 1000000000ull;
+#if defined(__APPLE__)
+	Source.m_ullTime += (uint64_t)sStat.st_mtimespec.tv_nsec;
+#elif !defined(_WIN32)
+	Source.m_ullTime += (uint64_t)sStat.st_mtim.tv_nsec;
+#endif
+	Source.m_ullHash = CLwoHash64::Hash(pData, nSize);
+	return true;
+}
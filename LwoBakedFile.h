@@ -0,0 +1,322 @@
+//////////////////////////////////////////////////////////////////////
+// LwoBakedFile.h : pre-baked binary form of parsed object
+//
+// Parsed object data is written once into single file of sections
+// which can be mapped to memory and used directly without parsing:
+// all references are offsets or indices (relocatable)
+// and each section starts at 16-byte aligned offset.
+// Values are in native byte-order of the writer
+// (loader rejects file of other byte-order).
+//
+// File records size, modification time (nanoseconds where available)
+// and content hash of the source-file so that it can be checked
+// to be up to date. File is written under temporary name and renamed
+// in place: interrupted write does not leave partial file.
+//
+// Layout:
+// - header (tLwoBakedHeader)
+// - section directory (tLwoBakedSection for each section type)
+// - sections (see tLwoBakedSectionType)
+//
+
+#ifndef _LWOBAKEDFILE_H_
+#define _LWOBAKEDFILE_H_
+
+#include "LwoObjectData.h"
+#include "MemFile.h"
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+using namespace std;
+
+// increment when layout changes
+#define LWO_BAKED_VERSION 1
+
+// alignment of each section in file
+#define LWO_BAKED_ALIGN 16
+
+// extension of baked files
+#define LWO_BAKED_EXTENSION ".lwobake"
+
+// sections in the order of directory
+enum tLwoBakedSectionType
+{
+	BAKED_LAYERS = 0,		// tLwoBakedLayer
+	BAKED_POINTSETS,		// tLwoBakedPointSet
+	BAKED_POINTS,			// float XYZ
+	BAKED_POLYSETS,			// tLwoBakedPolySet
+	BAKED_POLYGONS,			// tLwoBakedPolygon
+	BAKED_INDICES,			// uint32_t point-index of each polygon vertex
+	BAKED_SURFACES,			// tLwoBakedSurface
+	BAKED_VMAPS,			// tLwoBakedVmap
+	BAKED_VMAP_INDICES,		// uint32_t vertex (and polygon) indices of maps
+	BAKED_VMAP_VALUES,		// float values of maps
+	BAKED_STRINGS,			// string pool: NULL-terminated strings
+	BAKED_SECTION_COUNT
+};
+
+// identity of the source-file
+struct tLwoSourceKey
+{
+	uint64_t m_ullSize;
+	uint64_t m_ullTime;		// modification time in nanoseconds (seconds when not available)
+	uint64_t m_ullHash;
+};
+
+// header at start of baked file
+struct tLwoBakedHeader
+{
+	char m_szMagic[8];			// "LWOBAKE" (NULL-terminated)
+	uint32_t m_uiVersion;		// LWO_BAKED_VERSION
+	uint32_t m_uiByteOrder;		// 0x01020304 in writer byte-order
+	uint64_t m_ullFileSize;		// size of whole baked file
+	tLwoSourceKey m_Source;		// source-file this was made from
+	uint32_t m_uiSourceType;	// LWO2, LWOB or LWLO
+	uint32_t m_uiSectionCount;	// BAKED_SECTION_COUNT
+};
+
+// entry in section directory
+struct tLwoBakedSection
+{
+	uint32_t m_uiType;			// tLwoBakedSectionType
+	uint32_t m_uiElementSize;	// size of each element in bytes
+	uint64_t m_ullOffset;		// from start of file
+	uint64_t m_ullCount;		// amount of elements
+};
+
+// layer, in order of file
+struct tLwoBakedLayer
+{
+	uint32_t m_uiName;			// offset in string pool
+	uint16_t m_usNumber;
+	uint16_t m_usFlags;
+	int32_t m_iParent;			// index of parent layer or -1
+	float m_fPivot[3];
+
+	// ranges of sets belonging to this layer
+	uint32_t m_uiFirstPointSet;
+	uint32_t m_uiPointSetCount;
+	uint32_t m_uiFirstPolySet;
+	uint32_t m_uiPolySetCount;
+	uint32_t m_uiFirstVmap;
+	uint32_t m_uiVmapCount;
+};
+
+// points of PNTS-chunk
+struct tLwoBakedPointSet
+{
+	uint32_t m_uiLayer;
+	uint32_t m_uiFirstPoint;	// in BAKED_POINTS (XYZ-triplets)
+	uint32_t m_uiPointCount;
+	uint32_t m_uiReserved;
+};
+
+// polygons of POLS-chunk (or LWOB detail-polygons)
+struct tLwoBakedPolySet
+{
+	uint32_t m_uiLayer;
+	uint32_t m_uiPolyTypeID;	// FACE, CURV, PTCH, MBAL or BONE
+	int32_t m_iPointSet;		// points referred by indices or -1
+	int32_t m_iParentSet;		// for detail-polygons: main set, otherwise -1
+	int32_t m_iDetailSet;		// set of detail-polygons or -1
+	uint32_t m_uiFirstPolygon;	// in BAKED_POLYGONS
+	uint32_t m_uiPolygonCount;
+	uint32_t m_uiReserved;
+};
+
+struct tLwoBakedPolygon
+{
+	uint32_t m_uiFirstIndex;	// in BAKED_INDICES
+	uint16_t m_usVertexCount;
+	uint16_t m_usFlags;
+	int32_t m_iSurface;			// index in BAKED_SURFACES or -1
+	int32_t m_iParentPolygon;	// detail-polygon: row in parent set, otherwise -1
+	uint32_t m_uiFirstDetail;	// row in detail set
+	uint32_t m_uiDetailCount;
+};
+
+// basic material of surface (see CLwoSurface)
+struct tLwoBakedSurface
+{
+	uint32_t m_uiName;			// offset in string pool
+	uint32_t m_uiParentName;	// offset in string pool
+	float m_fColor[3];
+	uint32_t m_uiColorEnvelope;
+	float m_fDiffuse;
+	float m_fLuminosity;
+	float m_fSpecular;
+	float m_fGlossiness;
+	float m_fReflection;
+	float m_fTransparency;
+	float m_fTranslucency;
+	float m_fRefractiveIndex;
+	float m_fBump;
+	float m_fSmoothingAngle;
+	uint16_t m_usSidedness;
+	uint16_t m_usReserved;
+	uint32_t m_uiReserved;
+};
+
+// VMAP or VMAD
+struct tLwoBakedVmap
+{
+	uint32_t m_uiLayer;
+	uint32_t m_uiVmapTypeID;	// TXUV, WGHT, MORF..
+	uint32_t m_uiName;			// offset in string pool
+	uint16_t m_usDimension;
+	uint16_t m_usDiscontinuous;	// 1 for VMAD
+	int32_t m_iPointSet;		// points mapped or -1
+	uint32_t m_uiCount;			// amount of mapped vertices
+	uint32_t m_uiFirstVertex;	// vertex-indices in BAKED_VMAP_INDICES
+	uint32_t m_uiFirstPoly;		// VMAD polygon-indices (as in file) in BAKED_VMAP_INDICES
+	uint32_t m_uiFirstValue;	// m_usDimension values per vertex in BAKED_VMAP_VALUES
+	uint32_t m_uiReserved;
+};
+
+
+// write parsed object to baked file
+class CLwoBakedWriter
+{
+protected:
+	// sections built before writing
+	vector<tLwoBakedLayer> m_Layers;
+	vector<tLwoBakedPointSet> m_PointSets;
+	vector<float> m_Points;
+	vector<tLwoBakedPolySet> m_PolySets;
+	vector<tLwoBakedPolygon> m_Polygons;
+	vector<uint32_t> m_Indices;
+	vector<tLwoBakedSurface> m_Surfaces;
+	vector<tLwoBakedVmap> m_Vmaps;
+	vector<uint32_t> m_VmapIndices;
+	vector<float> m_VmapValues;
+	vector<char> m_Strings;
+
+	// offset of each string already in pool
+	map<string, uint32_t> m_StringOffsets;
+
+	uint32_t AddString(const string &szValue);
+
+	void Clear();
+
+	bool BuildSections(const CLwoObjectData &Object);
+
+public:
+	CLwoBakedWriter(void);
+	~CLwoBakedWriter(void);
+
+	// serialize object into buffer
+	bool Bake(const CLwoObjectData &Object, const unsigned int uiSourceType, const tLwoSourceKey &Source, vector<char> &Buffer);
+
+	// serialize object into file (see WriteAtomic())
+	bool WriteFile(const CLwoObjectData &Object, const unsigned int uiSourceType, const tLwoSourceKey &Source, const char *szPath);
+
+	// write complete file under temporary name (unique in process)
+	// and rename in place: others see either whole file or none
+	static bool WriteAtomic(const string &szPath, const vector<char> &Buffer);
+};
+
+
+// mapped baked file:
+// pointers to sections are valid while file is open
+class CLwoBakedFile
+{
+protected:
+	CMemFile *m_pFile;
+
+	// when used on buffer of caller instead of file
+	const char *m_pBuffer;
+	uint64_t m_ullBufferSize;
+
+	const tLwoBakedHeader *m_pHeader;
+	const tLwoBakedSection *m_pSections;
+
+	// checks of header and section directory
+	bool ValidateLayout();
+
+	const void *GetSection(const tLwoBakedSectionType eType, size_t &nCount) const;
+
+public:
+	CLwoBakedFile(void);
+	~CLwoBakedFile(void);
+
+	// map baked file and check layout
+	bool Open(const char *szPath);
+
+	// use baked data in memory (e.g. from CLwoBakedWriter::Bake()),
+	// buffer must stay valid while used
+	bool OpenBuffer(const void *pBuffer, const uint64_t ullSize);
+
+	void Close();
+
+	bool IsOpen() const
+	{
+		return (m_pHeader != NULL);
+	};
+
+	const tLwoBakedHeader *GetHeader() const
+	{
+		return m_pHeader;
+	};
+
+	// baked from given source-file?
+	bool MatchesSource(const tLwoSourceKey &Source) const;
+
+	// optional check of indices between sections
+	// (layout is always checked when opened)
+	bool VerifyReferences() const;
+
+	// sections: pointer to first element and amount of elements
+	const tLwoBakedLayer *GetLayers(size_t &nCount) const
+	{
+		return (const tLwoBakedLayer*)GetSection(BAKED_LAYERS, nCount);
+	};
+	const tLwoBakedPointSet *GetPointSets(size_t &nCount) const
+	{
+		return (const tLwoBakedPointSet*)GetSection(BAKED_POINTSETS, nCount);
+	};
+	// count of floats (three per point)
+	const float *GetPoints(size_t &nCount) const
+	{
+		return (const float*)GetSection(BAKED_POINTS, nCount);
+	};
+	const tLwoBakedPolySet *GetPolySets(size_t &nCount) const
+	{
+		return (const tLwoBakedPolySet*)GetSection(BAKED_POLYSETS, nCount);
+	};
+	const tLwoBakedPolygon *GetPolygons(size_t &nCount) const
+	{
+		return (const tLwoBakedPolygon*)GetSection(BAKED_POLYGONS, nCount);
+	};
+	const uint32_t *GetIndices(size_t &nCount) const
+	{
+		return (const uint32_t*)GetSection(BAKED_INDICES, nCount);
+	};
+	const tLwoBakedSurface *GetSurfaces(size_t &nCount) const
+	{
+		return (const tLwoBakedSurface*)GetSection(BAKED_SURFACES, nCount);
+	};
+	const tLwoBakedVmap *GetVmaps(size_t &nCount) const
+	{
+		return (const tLwoBakedVmap*)GetSection(BAKED_VMAPS, nCount);
+	};
+	const uint32_t *GetVmapIndices(size_t &nCount) const
+	{
+		return (const uint32_t*)GetSection(BAKED_VMAP_INDICES, nCount);
+	};
+	const float *GetVmapValues(size_t &nCount) const
+	{
+		return (const float*)GetSection(BAKED_VMAP_VALUES, nCount);
+	};
+
+	// string from pool by offset (empty string if invalid)
+	const char *GetString(const uint32_t uiOffset) const;
+
+	// identity of source-file: size and time from file-system,
+	// hash of given content (edit within same second still differs)
+	static bool MakeSourceKey(const char *szPath, const void *pData, const size_t nSize, tLwoSourceKey &Source);
+};
+
+#endif // ifndef _LWOBAKEDFILE_H_
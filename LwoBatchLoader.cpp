@@ -0,0 +1,239 @@
+//////////////////////////////////////////////////////////////////////
+// LwoBatchLoader.cpp : loading many objects in parallel
+//
+
+#include "LwoBatchLoader.h"
+#include "LwoTrace.h"
+
+#include <fstream>
+
+// touch pages of mapped file in the load-stage
+// so that parsing does not wait for disk
+#define LWO_BATCH_PAGE_SIZE 4096
+
+
+CLwoBatchLoader::CLwoBatchLoader(const size_t nThreads, const size_t nMaxInFlight)
+	: m_Pool(nThreads)
+	, m_Readers()
+	, m_Build()
+	, m_ullMemoryBudget(0)
+	, m_pCache(NULL)
+	, m_nInFlight(0)
+	, m_nMaxInFlight(nMaxInFlight)
+	, m_nNextIndex(0)
+{
+	for (size_t i = 0; i < m_Pool.GetThreadCount(); i++)
+	{
+		m_Readers.push_back(unique_ptr<CLwoReader>(new CLwoReader()));
+	}
+
+	if (m_nMaxInFlight == 0)
+	{
+		m_nMaxInFlight = m_Pool.GetThreadCount() * 4;
+	}
+}
+
+CLwoBatchLoader::~CLwoBatchLoader(void)
+{
+	// also tasks which are still returning from Finish()
+	// before members are destroyed
+	Wait();
+	m_Pool.WaitIdle();
+}
+
+void CLwoBatchLoader::SetMemoryBudget(const uint64_t ullBudget, const LwoBudgetPolicy ePolicy)
+{
+	m_ullMemoryBudget = ullBudget;
+	for (size_t i = 0; i < m_Readers.size(); i++)
+	{
+		m_Readers[i]->SetMemoryBudget(ullBudget, ePolicy);
+	}
+}
+
+void CLwoBatchLoader::Load(const string &szPath, tCallback Callback)
+{
+	tResult Result;
+	{
+		// bounded: wait until some file is finished
+		unique_lock<mutex> Lock(m_Lock);
+		m_Finished.wait(Lock, [this]() { return (m_nInFlight < m_nMaxInFlight); });
+		m_nInFlight++;
+
+		Result = tResult(new CLwoBatchResult(szPath, m_nNextIndex++));
+	}
+
+	m_Pool.Submit([this, Result, Callback]() { StageLoad(Result, Callback); });
+}
+
+future<CLwoBatchLoader::tResult> CLwoBatchLoader::Load(const string &szPath)
+{
+	shared_ptr<promise<tResult>> pPromise(new promise<tResult>());
+	future<tResult> Future = pPromise->get_future();
+
+	Load(szPath, [pPromise](tResult Result) { pPromise->set_value(Result); });
+	return Future;
+}
+
+void CLwoBatchLoader::LoadAll(const vector<string> &vPaths, tCallback Callback)
+{
+	for (size_t i = 0; i < vPaths.size(); i++)
+	{
+		Load(vPaths[i], Callback);
+	}
+}
+
+void CLwoBatchLoader::Wait()
+{
+	unique_lock<mutex> Lock(m_Lock);
+	m_Finished.wait(Lock, [this]() { return (m_nInFlight == 0); });
+}
+
+void CLwoBatchLoader::StageLoad(tResult Result, tCallback Callback)
+{
+	shared_ptr<CMemFile> pFile(new CMemFile(Result->m_szPath.c_str()));
+	pFile->SetMemoryBudget(m_ullMemoryBudget);
+
+	// too large to map within budget: stream while parsing
+	if (pFile->MapFile() == false
+		&& (pFile->IsOverBudget() == false || pFile->OpenStream() == false))
+	{
+		Result->m_szError = "load";
+		Finish(Result, Callback);
+		return;
+	}
+	Result->m_ulFilesize = pFile->GetFilesize();
+
+	// read each page once
+	if (pFile->IsMapped() == true)
+	{
+		CLwoTraceScope Trace("touch pages", 0, pFile->GetFilesize(), Result->m_szPath.c_str());
+		const volatile char *pData = (const volatile char*)pFile->GetFileBuf();
+		char cSum = 0;
+		for (unsigned long ulPos = 0; ulPos < pFile->GetFilesize(); ulPos += LWO_BATCH_PAGE_SIZE)
+		{
+			cSum ^= pData[ulPos];
+		}
+		(void)cSum;
+	}
+
+	// parse as next task: this worker continues with it
+	// unless another worker steals it
+	m_Pool.Submit([this, Result, pFile, Callback]() { StageParse(Result, pFile, Callback); });
+}
+
+void CLwoBatchLoader::StageParse(tResult Result, shared_ptr<CMemFile> pFile, tCallback Callback)
+{
+	// only this worker uses its reader
+	CLwoReader *pReader = m_Readers[CLwoThreadPool::GetWorkerIndex()].get();
+
+	// cache needs whole content (not streamed file)
+	bool bRet = false;
+	if (m_pCache != NULL
+		&& pFile->IsMapped() == true)
+	{
+		Result->m_pBaked.reset(new CLwoBakedFile());
+		bRet = m_pCache->Load(*pFile, *pReader, *(Result->m_pBaked), Result->m_bCacheHit);
+	}
+	else
+	{
+		bRet = pReader->ProcessFromFile(*pFile);
+	}
+	if (bRet == false)
+	{
+		// parsed but not baked or written to cache
+		Result->m_szError = (pReader->GetError() == LWO_ERROR_BUDGET) ? "budget" : "parse";
+		if (Result->m_pBaked
+			&& pReader->GetError() == LWO_ERROR_NONE)
+		{
+			Result->m_szError = "cache";
+		}
+		Result->m_pBaked.reset();
+		pReader->Reset();
+		Finish(Result, Callback);
+		return;
+	}
+
+	if (Result->m_bCacheHit == true)
+	{
+		Result->m_uiFileType = Result->m_pBaked->GetHeader()->m_uiSourceType;
+	}
+	else
+	{
+		Result->m_uiFileType = pReader->GetFileType();
+		pReader->GetMemoryReport(Result->m_Memory);
+		Result->m_ObjectData = pReader->ReleaseObjectData();
+	}
+
+	// file is no longer needed
+	pFile.reset();
+
+	if (m_Build)
+	{
+		m_Pool.Submit([this, Result, Callback]() { StageBuild(Result, Callback); });
+		return;
+	}
+
+	Result->m_bSuccess = true;
+	Finish(Result, Callback);
+}
+
+void CLwoBatchLoader::StageBuild(tResult Result, tCallback Callback)
+{
+	bool bBuilt = false;
+	{
+		CLwoTraceScope Trace("build", 0, Result->m_ulFilesize, Result->m_szPath.c_str());
+		bBuilt = m_Build(*Result);
+	}
+	if (bBuilt == false)
+	{
+		Result->m_szError = "build";
+		Finish(Result, Callback);
+		return;
+	}
+
+	Result->m_bSuccess = true;
+	Finish(Result, Callback);
+}
+
+void CLwoBatchLoader::Finish(tResult Result, tCallback &Callback)
+{
+	if (Callback)
+	{
+		Callback(Result);
+	}
+
+	// notify while locked:
+	// waiting thread may destroy this loader right after
+	lock_guard<mutex> Lock(m_Lock);
+	m_nInFlight--;
+	m_Finished.notify_all();
+}
+
+bool CLwoBatchLoader::ReadManifest(const char *szManifest, vector<string> &vPaths)
+{
+	ifstream Manifest(szManifest);
+	if (Manifest.is_open() == false)
+	{
+		return false;
+	}
+
+	string szLine;
+	while (getline(Manifest, szLine))
+	{
+		// trim whitespace (also CR of DOS-lines)
+		size_t nStart = szLine.find_first_not_of(" \t\r\n");
+		if (nStart == string::npos)
+		{
+			continue;
+		}
+		size_t nEnd = szLine.find_last_not_of(" \t\r\n");
+		szLine = szLine.substr(nStart, nEnd - nStart +1);
+
+		if (szLine[0] == '#')
+		{
+			continue;
+		}
+		vPaths.push_back(szLine);
+	}
+	return true;
+}
@@ -0,0 +1,179 @@
+//////////////////////////////////////////////////////////////////////
+// LwoBatchLoader.h : loading many objects in parallel
+//
+// Each file goes through stages which run as separate tasks
+// on a work-stealing pool so that I/O of some files
+// overlaps with parsing of others:
+// - load: map the file and touch its pages
+// - parse: CLwoReader into object data
+// - build: optional function of caller (e.g. flattening, baking)
+// Result is then given to callback (or future).
+//
+// Optional memory budget of each file (SetMemoryBudget()):
+// file larger than budget is streamed instead of mapped,
+// object which does not fit fails with error "budget".
+//
+// Optional parse-cache (SetParseCache()): mapped file is looked up
+// by content, on hit parsing is skipped and result has only
+// the baked form of object (no object data or memory report).
+//
+// Amount of files in flight is bounded:
+// Load() blocks while limit is reached.
+// Callbacks run on worker threads, possibly many at same time,
+// and should not call Load() or Wait().
+//
+
+#ifndef _LWOBATCHLOADER_H_
+#define _LWOBATCHLOADER_H_
+
+#include "LwoReader.h"
+#include "LwoThreadPool.h"
+#include "LwoParseCache.h"
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+using namespace std;
+
+// result of single file
+class CLwoBatchResult
+{
+public:
+	string m_szPath;
+
+	// order in which file was given
+	size_t m_nIndex;
+
+	bool m_bSuccess;
+
+	// stage which failed: "load", "parse" or "build",
+	// "budget" when object exceeded memory budget,
+	// "cache" when parse-cache could not keep parsed object
+	string m_szError;
+
+	// size of source-file
+	unsigned long m_ulFilesize;
+
+	// type of file: LWO2, LWOB or LWLO
+	unsigned int m_uiFileType;
+
+	// parsed object (when parsing succeeded)
+	CLwoObjectData m_ObjectData;
+
+	// memory of object and peak of parsing
+	// (when parsing succeeded)
+	tLwoMemoryReport m_Memory;
+
+	// baked form from parse-cache (NULL when not used),
+	// on hit this is the only form of object
+	shared_ptr<CLwoBakedFile> m_pBaked;
+	bool m_bCacheHit;
+
+public:
+	CLwoBatchResult(const string &szPath, const size_t nIndex)
+		: m_szPath(szPath)
+		, m_nIndex(nIndex)
+		, m_bSuccess(false)
+		, m_szError()
+		, m_ulFilesize(0)
+		, m_uiFileType(0)
+		, m_ObjectData()
+		, m_Memory()
+		, m_pBaked()
+		, m_bCacheHit(false)
+	{};
+};
+
+class CLwoBatchLoader
+{
+public:
+	typedef shared_ptr<CLwoBatchResult> tResult;
+
+	// called for each finished file (also failed)
+	typedef function<void(tResult)> tCallback;
+
+	// build-stage after parsing, false for failure
+	typedef function<bool(CLwoBatchResult&)> tBuildFunction;
+
+protected:
+	CLwoThreadPool m_Pool;
+
+	// reader of each worker, reused for each file it parses
+	vector<unique_ptr<CLwoReader>> m_Readers;
+
+	tBuildFunction m_Build;
+
+	// limit of file and object in memory for each file
+	// (zero when none)
+	uint64_t m_ullMemoryBudget;
+
+	// shared by all workers (NULL when not used)
+	CLwoParseCache *m_pCache;
+
+	// files given but not yet finished
+	mutex m_Lock;
+	condition_variable m_Finished;
+	size_t m_nInFlight;
+	size_t m_nMaxInFlight;
+
+	// index for next file
+	size_t m_nNextIndex;
+
+	// stages of single file
+	void StageLoad(tResult Result, tCallback Callback);
+	void StageParse(tResult Result, shared_ptr<CMemFile> pFile, tCallback Callback);
+	void StageBuild(tResult Result, tCallback Callback);
+	void Finish(tResult Result, tCallback &Callback);
+
+public:
+	// zero threads: amount of hardware threads,
+	// zero limit: four files per thread in flight
+	CLwoBatchLoader(const size_t nThreads = 0, const size_t nMaxInFlight = 0);
+	~CLwoBatchLoader(void);
+
+	// optional stage after parsing
+	// (set before loading any file)
+	void SetBuildFunction(tBuildFunction Build)
+	{
+		m_Build = Build;
+	};
+
+	// limit of bytes for each file while parsing
+	// (see CLwoReader::SetMemoryBudget()), zero for no limit:
+	// set before loading any file
+	void SetMemoryBudget(const uint64_t ullBudget, const LwoBudgetPolicy ePolicy = LWO_BUDGET_FAIL);
+
+	// parsed objects from and to cache (NULL for none),
+	// cache must outlive loading: set before loading any file
+	void SetParseCache(CLwoParseCache *pCache)
+	{
+		m_pCache = pCache;
+	};
+
+	// start loading file, callback gets result
+	void Load(const string &szPath, tCallback Callback);
+
+	// start loading file, result by future
+	future<tResult> Load(const string &szPath);
+
+	// start loading all given files
+	void LoadAll(const vector<string> &vPaths, tCallback Callback);
+
+	// wait until all files given are finished
+	void Wait();
+
+	size_t GetThreadCount() const
+	{
+		return m_Pool.GetThreadCount();
+	};
+
+	// list of paths from manifest-file:
+	// one path per line, empty lines and lines starting with '#' are skipped
+	static bool ReadManifest(const char *szManifest, vector<string> &vPaths);
+};
+
+#endif // ifndef _LWOBATCHLOADER_H_
@@ -0,0 +1,300 @@
+//////////////////////////////////////////////////////////////////////
+// LwoByteSwap.cpp : big-endian values of file to native
+//
+
+#include "LwoByteSwap.h"
+
+#include <atomic>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define LWO_SWAP_X86
+#endif
+
+#ifdef LWO_SWAP_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h> // __cpuid(), _xgetbv()
+#else
+#include <cpuid.h> // __get_cpuid()
+#endif
+#endif
+
+// instruction set of single function (GCC/Clang),
+// MSVC allows intrinsics without it
+#if defined(LWO_SWAP_X86) && (defined(__GNUC__) || defined(__clang__))
+#define LWO_TARGET(isa) __attribute__((target(isa)))
+#else
+#define LWO_TARGET(isa)
+#endif
+
+
+static void Swap4_Scalar(void *pDest, const char *pSrc, const size_t nCount)
+{
+	const unsigned char *pBuf = (const unsigned char*)pSrc;
+	unsigned int *puiDest = (unsigned int*)pDest;
+	for (size_t i = 0; i < nCount; i++)
+	{
+		puiDest[i] = (((unsigned int)pBuf[0] << 24)
+			| ((unsigned int)pBuf[1] << 16)
+			| ((unsigned int)pBuf[2] << 8)
+			| (unsigned int)pBuf[3]);
+		pBuf = (pBuf +4);
+	}
+}
+
+static void Swap4_Builtin(void *pDest, const char *pSrc, const size_t nCount)
+{
+	unsigned int *puiDest = (unsigned int*)pDest;
+	for (size_t i = 0; i < nCount; i++)
+	{
+		puiDest[i] = LwoGetU4(pSrc + i*4);
+	}
+}
+
+#if defined(LWO_SWAP_X86) && (defined(__GNUC__) || defined(__clang__))
+// same as builtin but compiled for movbe
+LWO_TARGET("movbe") static void Swap4_Movbe(void *pDest, const char *pSrc, const size_t nCount)
+{
+	unsigned int *puiDest = (unsigned int*)pDest;
+	for (size_t i = 0; i < nCount; i++)
+	{
+		unsigned int uiValue;
+		memcpy(&uiValue, pSrc + i*4, sizeof(unsigned int));
+		puiDest[i] = __builtin_bswap32(uiValue);
+	}
+}
+#define LWO_SWAP_HAS_MOVBE
+#endif
+
+#ifdef LWO_SWAP_X86
+LWO_TARGET("ssse3") static void Swap4_SSSE3(void *pDest, const char *pSrc, const size_t nCount)
+{
+	const __m128i Mask = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+	char *pOut = (char*)pDest;
+
+	size_t i = 0;
+	for (; (i + 4) <= nCount; i += 4)
+	{
+		__m128i Value = _mm_loadu_si128((const __m128i*)(pSrc + i*4));
+		_mm_storeu_si128((__m128i*)(pOut + i*4), _mm_shuffle_epi8(Value, Mask));
+	}
+	Swap4_Builtin(pOut + i*4, pSrc + i*4, nCount - i);
+}
+
+LWO_TARGET("avx2") static void Swap4_AVX2(void *pDest, const char *pSrc, const size_t nCount)
+{
+	const __m256i Mask = _mm256_set_epi8(
+		12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+		12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+	char *pOut = (char*)pDest;
+
+	size_t i = 0;
+	for (; (i + 8) <= nCount; i += 8)
+	{
+		__m256i Value = _mm256_loadu_si256((const __m256i*)(pSrc + i*4));
+		_mm256_storeu_si256((__m256i*)(pOut + i*4), _mm256_shuffle_epi8(Value, Mask));
+	}
+	Swap4_Builtin(pOut + i*4, pSrc + i*4, nCount - i);
+}
+
+// features of CPU (and OS for AVX state)
+struct tLwoCpuFeatures
+{
+	bool m_bSSSE3;
+	bool m_bMOVBE;
+	bool m_bAVX2;
+
+	tLwoCpuFeatures()
+		: m_bSSSE3(false)
+		, m_bMOVBE(false)
+		, m_bAVX2(false)
+	{
+		unsigned int uiRegs[4] = {0, 0, 0, 0}; // eax, ebx, ecx, edx
+#ifdef _MSC_VER
+		int iRegs[4];
+		__cpuid(iRegs, 0);
+		const unsigned int uiMaxLeaf = (unsigned int)iRegs[0];
+		__cpuid(iRegs, 1);
+		for (int i = 0; i < 4; i++)
+		{
+			uiRegs[i] = (unsigned int)iRegs[i];
+		}
+#else
+		const unsigned int uiMaxLeaf = __get_cpuid_max(0, NULL);
+		if (uiMaxLeaf < 1)
+		{
+			return;
+		}
+		__get_cpuid(1, &uiRegs[0], &uiRegs[1], &uiRegs[2], &uiRegs[3]);
+#endif
+		m_bSSSE3 = ((uiRegs[2] & (1u << 9)) != 0);
+		m_bMOVBE = ((uiRegs[2] & (1u << 22)) != 0);
+
+		// AVX registers must be saved by OS (OSXSAVE and XCR0)
+		const bool bOSXSAVE = ((uiRegs[2] & (1u << 27)) != 0);
+		if (bOSXSAVE == false
+			|| uiMaxLeaf < 7)
+		{
+			return;
+		}
+#ifdef _MSC_VER
+		const unsigned long long ullXCR0 = _xgetbv(0);
+		__cpuidex(iRegs, 7, 0);
+		const unsigned int uiLeaf7EBX = (unsigned int)iRegs[1];
+#else
+		unsigned int uiXCR0Low = 0;
+		unsigned int uiXCR0High = 0;
+		__asm__ ("xgetbv" : "=a" (uiXCR0Low), "=d" (uiXCR0High) : "c" (0));
+		const unsigned long long ullXCR0 = ((unsigned long long)uiXCR0High << 32) | uiXCR0Low;
+		__cpuid_count(7, 0, uiRegs[0], uiRegs[1], uiRegs[2], uiRegs[3]);
+		const unsigned int uiLeaf7EBX = uiRegs[1];
+#endif
+		m_bAVX2 = ((ullXCR0 & 0x6) == 0x6
+			&& (uiLeaf7EBX & (1u << 5)) != 0);
+	}
+};
+
+static const tLwoCpuFeatures &GetCpuFeatures()
+{
+	static const tLwoCpuFeatures Features;
+	return Features;
+}
+#endif // LWO_SWAP_X86
+
+
+// selected when first used
+static tLwoSwap4Func ResolveSwap4();
+static void Swap4_Resolve(void *pDest, const char *pSrc, const size_t nCount)
+{
+	ResolveSwap4()(pDest, pSrc, nCount);
+}
+
+static std::atomic<tLwoSwap4Func> g_pfnSwap4(&Swap4_Resolve);
+static std::atomic<int> g_iSwapVariant(LWO_SWAP_AUTO);
+
+static tLwoSwap4Func ResolveSwap4()
+{
+	CLwoByteSwap::Select(LWO_SWAP_AUTO);
+	return g_pfnSwap4.load(std::memory_order_relaxed);
+}
+
+
+bool CLwoByteSwap::IsSupported(const LwoSwapVariant eVariant)
+{
+	return (GetSwap4(eVariant) != NULL);
+}
+
+tLwoSwap4Func CLwoByteSwap::GetSwap4(const LwoSwapVariant eVariant)
+{
+	switch (eVariant)
+	{
+	case LWO_SWAP_AUTO:
+		// preference by measurements:
+		// wider shuffle is faster on supported CPUs
+		if (IsSupported(LWO_SWAP_AVX2) == true)
+		{
+			return GetSwap4(LWO_SWAP_AVX2);
+		}
+		if (IsSupported(LWO_SWAP_SSSE3) == true)
+		{
+			return GetSwap4(LWO_SWAP_SSSE3);
+		}
+		return GetSwap4(LWO_SWAP_BUILTIN);
+
+	case LWO_SWAP_SCALAR:
+		return &Swap4_Scalar;
+
+	case LWO_SWAP_BUILTIN:
+		return &Swap4_Builtin;
+
+	case LWO_SWAP_MOVBE:
+#ifdef LWO_SWAP_HAS_MOVBE
+		if (GetCpuFeatures().m_bMOVBE == true)
+		{
+			return &Swap4_Movbe;
+		}
+#endif
+		return NULL;
+
+	case LWO_SWAP_SSSE3:
+#ifdef LWO_SWAP_X86
+		if (GetCpuFeatures().m_bSSSE3 == true)
+		{
+			return &Swap4_SSSE3;
+		}
+#endif
+		return NULL;
+
+	case LWO_SWAP_AVX2:
+#ifdef LWO_SWAP_X86
+		if (GetCpuFeatures().m_bAVX2 == true)
+		{
+			return &Swap4_AVX2;
+		}
+#endif
+		return NULL;
+	}
+	return NULL;
+}
+
+bool CLwoByteSwap::Select(const LwoSwapVariant eVariant)
+{
+	tLwoSwap4Func pfnSwap4 = GetSwap4(eVariant);
+	if (pfnSwap4 == NULL)
+	{
+		return false;
+	}
+
+	LwoSwapVariant eSelected = eVariant;
+	if (eVariant == LWO_SWAP_AUTO)
+	{
+		// name of actual variant
+		const LwoSwapVariant eOrder[3] = {LWO_SWAP_AVX2, LWO_SWAP_SSSE3, LWO_SWAP_BUILTIN};
+		for (int i = 0; i < 3; i++)
+		{
+			if (GetSwap4(eOrder[i]) == pfnSwap4)
+			{
+				eSelected = eOrder[i];
+				break;
+			}
+		}
+	}
+
+	g_iSwapVariant.store(eSelected, std::memory_order_relaxed);
+	g_pfnSwap4.store(pfnSwap4, std::memory_order_relaxed);
+	return true;
+}
+
+LwoSwapVariant CLwoByteSwap::GetSelected()
+{
+	if (g_pfnSwap4.load(std::memory_order_relaxed) == &Swap4_Resolve)
+	{
+		ResolveSwap4();
+	}
+	return (LwoSwapVariant)g_iSwapVariant.load(std::memory_order_relaxed);
+}
+
+const char *CLwoByteSwap::GetVariantName(const LwoSwapVariant eVariant)
+{
+	switch (eVariant)
+	{
+	case LWO_SWAP_AUTO:
+		return "auto";
+	case LWO_SWAP_SCALAR:
+		return "scalar";
+	case LWO_SWAP_BUILTIN:
+		return "builtin";
+	case LWO_SWAP_MOVBE:
+		return "movbe";
+	case LWO_SWAP_SSSE3:
+		return "ssse3";
+	case LWO_SWAP_AVX2:
+		return "avx2";
+	}
+	return "unknown";
+}
+
+void CLwoByteSwap::Swap4(void *pDest, const char *pSrc, const size_t nCount)
+{
+	g_pfnSwap4.load(std::memory_order_relaxed)(pDest, pSrc, nCount);
+}
@@ -0,0 +1,116 @@
+//////////////////////////////////////////////////////////////////////
+// LwoByteSwap.h : big-endian values of file to native
+//
+// Single values: LwoGetU2(), LwoGetU4(), LwoGetF4()
+// from any (unaligned) position.
+//
+// Arrays of 4-byte values (points, vertex maps): CLwoByteSwap::Swap4()
+// with variant selected for CPU at runtime (SSSE3 or AVX2 when supported),
+// see tools/LwoSwapBench.cpp for measurements of each variant.
+//
+
+#ifndef _LWOBYTESWAP_H_
+#define _LWOBYTESWAP_H_
+
+#include <stddef.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+#include <stdlib.h> // _byteswap_ushort(), _byteswap_ulong()
+#endif
+
+// byte-order of single values:
+// compilers make these a load and bswap (or movbe)
+inline unsigned short LwoSwap16(const unsigned short usValue)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_bswap16(usValue);
+#elif defined(_MSC_VER)
+	return _byteswap_ushort(usValue);
+#else
+	return (unsigned short)((usValue >> 8) | (usValue << 8));
+#endif
+}
+
+inline unsigned int LwoSwap32(const unsigned int uiValue)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_bswap32(uiValue);
+#elif defined(_MSC_VER)
+	return _byteswap_ulong(uiValue);
+#else
+	return ((uiValue >> 24)
+		| ((uiValue >> 8) & 0x0000FF00)
+		| ((uiValue << 8) & 0x00FF0000)
+		| (uiValue << 24));
+#endif
+}
+
+inline unsigned short LwoGetU2(const char *pBuf)
+{
+	unsigned short usValue;
+	memcpy(&usValue, pBuf, sizeof(unsigned short));
+	return LwoSwap16(usValue);
+}
+
+inline unsigned int LwoGetU4(const char *pBuf)
+{
+	unsigned int uiValue;
+	memcpy(&uiValue, pBuf, sizeof(unsigned int));
+	return LwoSwap32(uiValue);
+}
+
+inline float LwoGetF4(const char *pBuf)
+{
+	unsigned int uiValue = LwoGetU4(pBuf);
+	float fValue;
+	memcpy(&fValue, &uiValue, sizeof(float));
+	return fValue;
+}
+
+// implementations of array conversion
+enum LwoSwapVariant
+{
+	// best supported by CPU
+	LWO_SWAP_AUTO = 0,
+
+	// shifts of bytes
+	LWO_SWAP_SCALAR,
+
+	// compiler builtin (bswap)
+	LWO_SWAP_BUILTIN,
+
+	// load with movbe (x86)
+	LWO_SWAP_MOVBE,
+
+	// 16 bytes at a time with pshufb
+	LWO_SWAP_SSSE3,
+
+	// 32 bytes at a time with vpshufb
+	LWO_SWAP_AVX2
+};
+
+// nCount 4-byte values from pSrc (any alignment) to pDest
+typedef void (*tLwoSwap4Func)(void *pDest, const char *pSrc, const size_t nCount);
+
+class CLwoByteSwap
+{
+public:
+	// variant can be used on this CPU (and compiler)
+	static bool IsSupported(const LwoSwapVariant eVariant);
+
+	// implementation of variant or NULL if not supported
+	static tLwoSwap4Func GetSwap4(const LwoSwapVariant eVariant);
+
+	// use variant for Swap4() (e.g. to compare):
+	// false if not supported, auto selects best supported
+	static bool Select(const LwoSwapVariant eVariant);
+	static LwoSwapVariant GetSelected();
+
+	static const char *GetVariantName(const LwoSwapVariant eVariant);
+
+	// with selected variant
+	static void Swap4(void *pDest, const char *pSrc, const size_t nCount);
+};
+
+#endif // ifndef _LWOBYTESWAP_H_
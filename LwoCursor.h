@@ -0,0 +1,316 @@
+//////////////////////////////////////////////////////////////////////
+// LwoCursor.h : bounds-checked reading of chunk-data
+//
+// Position within range of chunk (or sub-chunk) data,
+// values are big-endian as in file.
+//
+// Checked reads (ReadU2() etc.) verify each value.
+// For loops over many records, check size of whole record
+// once with Require() and use unchecked reads (U2() etc.) for its fields.
+//
+// On failure the first error and its position are kept,
+// see CLwoReader::GetError() for offset in file.
+//
+
+#ifndef _LWOCURSOR_H_
+#define _LWOCURSOR_H_
+
+#include <stddef.h>
+#include <string.h>
+#include <string>
+using namespace std;
+
+// reason of parsing failure
+enum LwoParseError
+{
+	LWO_ERROR_NONE = 0,
+
+	// not IFF-file of LWO2, LWOB or LWLO or size does not match file
+	LWO_ERROR_HEADER,
+
+	// chunk (or its header) is larger than remains in file
+	LWO_ERROR_CHUNK_SIZE,
+
+	// sub-chunk is larger than remains in its chunk
+	LWO_ERROR_SUBCHUNK_SIZE,
+
+	// value does not fit before end of chunk or sub-chunk
+	LWO_ERROR_OVERRUN,
+
+	// string has no terminating NULL before end
+	LWO_ERROR_STRING,
+
+	// reading data of file failed (streaming)
+	LWO_ERROR_READ,
+
+	// chunk failed otherwise (e.g. stopped by handler)
+	LWO_ERROR_CHUNK,
+
+	// file or object would exceed memory budget
+	// (see CLwoReader::SetMemoryBudget())
+	LWO_ERROR_BUDGET
+};
+
+// short description of error for messages
+inline const char *GetLwoErrorName(const LwoParseError eError)
+{
+	switch (eError)
+	{
+	case LWO_ERROR_NONE:
+		return "none";
+	case LWO_ERROR_HEADER:
+		return "invalid header";
+	case LWO_ERROR_CHUNK_SIZE:
+		return "chunk exceeds file";
+	case LWO_ERROR_SUBCHUNK_SIZE:
+		return "sub-chunk exceeds chunk";
+	case LWO_ERROR_OVERRUN:
+		return "value exceeds chunk";
+	case LWO_ERROR_STRING:
+		return "unterminated string";
+	case LWO_ERROR_READ:
+		return "read failed";
+	case LWO_ERROR_CHUNK:
+		return "invalid chunk";
+	case LWO_ERROR_BUDGET:
+		return "exceeds memory budget";
+	}
+	return "unknown";
+}
+
+class CLwoCursor
+{
+protected:
+	const char *m_pBegin;
+	const char *m_pPos;
+	const char *m_pEnd;
+
+	// first failure and where it happened
+	LwoParseError m_eError;
+	const char *m_pErrorPos;
+
+public:
+	CLwoCursor(const char *pBegin, const size_t nSize)
+		: m_pBegin(pBegin)
+		, m_pPos(pBegin)
+		, m_pEnd(pBegin + nSize)
+		, m_eError(LWO_ERROR_NONE)
+		, m_pErrorPos(NULL)
+	{};
+
+	const char *GetPos() const
+	{
+		return m_pPos;
+	};
+	const char *GetEnd() const
+	{
+		return m_pEnd;
+	};
+
+	// offset from start of range
+	size_t GetOffset() const
+	{
+		return (size_t)(m_pPos - m_pBegin);
+	};
+	size_t GetRemaining() const
+	{
+		return (size_t)(m_pEnd - m_pPos);
+	};
+	bool IsAtEnd() const
+	{
+		return (m_pPos >= m_pEnd);
+	};
+
+	LwoParseError GetError() const
+	{
+		return m_eError;
+	};
+	const char *GetErrorPos() const
+	{
+		return m_pErrorPos;
+	};
+
+	// keep first error at current position:
+	// returns false for convenience
+	bool Fail(const LwoParseError eError)
+	{
+		if (m_eError == LWO_ERROR_NONE)
+		{
+			m_eError = eError;
+			m_pErrorPos = m_pPos;
+		}
+		return false;
+	};
+
+	// check once that following unchecked reads fit
+	bool Require(const size_t nSize)
+	{
+		if (GetRemaining() < nSize)
+		{
+			return Fail(LWO_ERROR_OVERRUN);
+		}
+		return true;
+	};
+
+	//// unchecked reads: only after Require() of enough size
+
+	unsigned char U1()
+	{
+		unsigned char ucValue = (unsigned char)m_pPos[0];
+		m_pPos = (m_pPos +1);
+		return ucValue;
+	};
+
+	unsigned short U2()
+	{
+		const unsigned char *pBuf = (const unsigned char*)m_pPos;
+		m_pPos = (m_pPos +2);
+		return (unsigned short)((pBuf[0] << 8) | pBuf[1]);
+	};
+
+	unsigned int U4()
+	{
+		const unsigned char *pBuf = (const unsigned char*)m_pPos;
+		m_pPos = (m_pPos +4);
+		return (((unsigned int)pBuf[0] << 24)
+			| ((unsigned int)pBuf[1] << 16)
+			| ((unsigned int)pBuf[2] << 8)
+			| (unsigned int)pBuf[3]);
+	};
+
+	float F4()
+	{
+		unsigned int uiValue = U4();
+		float fValue;
+		memcpy(&fValue, &uiValue, sizeof(float));
+		return fValue;
+	};
+
+	// variable-length index: 2 bytes,
+	// or 4 bytes when first byte is 0xFF (need Require(4))
+	unsigned int VX()
+	{
+		if ((unsigned char)m_pPos[0] == 0xFF)
+		{
+			return (U4() & 0x00FFFFFF);
+		}
+		return U2();
+	};
+
+	void Skip(const size_t nSize)
+	{
+		m_pPos = (m_pPos + nSize);
+	};
+
+	//// checked reads: false when value does not fit
+
+	bool ReadU2(unsigned short &usValue)
+	{
+		if (Require(2) == false)
+		{
+			return false;
+		}
+		usValue = U2();
+		return true;
+	};
+
+	bool ReadU4(unsigned int &uiValue)
+	{
+		if (Require(4) == false)
+		{
+			return false;
+		}
+		uiValue = U4();
+		return true;
+	};
+
+	bool ReadF4(float &fValue)
+	{
+		if (Require(4) == false)
+		{
+			return false;
+		}
+		fValue = F4();
+		return true;
+	};
+
+	bool ReadVec12(float *pfVector)
+	{
+		if (Require(12) == false)
+		{
+			return false;
+		}
+		for (int i = 0; i < 3; i++)
+		{
+			pfVector[i] = F4();
+		}
+		return true;
+	};
+
+	bool ReadVX(unsigned int &uiValue)
+	{
+		if (Require(2) == false)
+		{
+			return false;
+		}
+		if ((unsigned char)m_pPos[0] == 0xFF
+			&& Require(4) == false)
+		{
+			return false;
+		}
+		uiValue = VX();
+		return true;
+	};
+
+	// sub-chunk: 4-byte type and 2-byte size, data must fit in this range.
+	// sub-chunk data is given as its own range and this moves past it
+	// (and padding-byte of odd size) whether or not all of it is read
+	bool ReadSubChunk(unsigned int &uiType, CLwoCursor &SubChunk)
+	{
+		if (Require(6) == false)
+		{
+			return false;
+		}
+		uiType = U4();
+		size_t nSize = U2();
+		if (nSize > GetRemaining())
+		{
+			return Fail(LWO_ERROR_SUBCHUNK_SIZE);
+		}
+		SubChunk = CLwoCursor(m_pPos, nSize);
+		m_pPos = (m_pPos + nSize);
+		if (nSize % 2 != 0
+			&& m_pPos < m_pEnd)
+		{
+			m_pPos = (m_pPos +1);
+		}
+		return true;
+	};
+
+	// string with terminating NULL (padded to even length):
+	// NULL must be found before end, padding may be missing at end
+	bool ReadS0(string &szValue)
+	{
+		if (IsAtEnd() == true)
+		{
+			return Fail(LWO_ERROR_STRING);
+		}
+		const char *pNull = (const char*)memchr(m_pPos, 0, GetRemaining());
+		if (pNull == NULL)
+		{
+			return Fail(LWO_ERROR_STRING);
+		}
+		szValue.assign(m_pPos, pNull);
+
+		size_t nSize = (size_t)(pNull - m_pPos) +1;
+		if (nSize % 2 != 0
+			&& (pNull +1) < m_pEnd)
+		{
+			nSize += 1;
+		}
+		m_pPos = (m_pPos + nSize);
+		return true;
+	};
+};
+
+#endif // ifndef _LWOCURSOR_H_
@@ -0,0 +1,565 @@
+//////////////////////////////////////////////////////////////////////
+// LwoEnvelope.cpp : evaluation of envelopes (animated values)
+//
+// Curve shapes and behaviours follow envelope.c of Lightwave SDK.
+//
+
+#include "LwoEnvelope.h"
+
+// floor(), fabs()
+#include <cmath>
+
+// upper_bound()
+#include <algorithm>
+
+// SSE when available for polynomial pass
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define LWO_ENVELOPE_SSE
+#endif
+
+typedef CLwoEnvelope::CLwoEnvelopeKey tEnvKey;
+
+// outgoing tangent of key0 (in span key0 -> key1),
+// key0 may have previous key
+static float GetOutgoing(const tEnvKey *pPrev, const tEnvKey &Key0, const tEnvKey &Key1)
+{
+	float fOut = 0.0f;
+	switch (Key0.m_uiShape)
+	{
+	case ID_TCB:
+		{
+			float a = (1.0f - Key0.m_fTension) * (1.0f + Key0.m_fContinuity) * (1.0f + Key0.m_fBias);
+			float b = (1.0f - Key0.m_fTension) * (1.0f - Key0.m_fContinuity) * (1.0f - Key0.m_fBias);
+			float d = Key1.m_fValue - Key0.m_fValue;
+			if (pPrev != NULL)
+			{
+				float t = (Key1.m_fTime - Key0.m_fTime) / (Key1.m_fTime - pPrev->m_fTime);
+				fOut = t * (a * (Key0.m_fValue - pPrev->m_fValue) + b * d);
+			}
+			else
+			{
+				fOut = b * d;
+			}
+		}
+		break;
+
+	case ID_LINE:
+		{
+			float d = Key1.m_fValue - Key0.m_fValue;
+			if (pPrev != NULL)
+			{
+				float t = (Key1.m_fTime - Key0.m_fTime) / (Key1.m_fTime - pPrev->m_fTime);
+				fOut = t * (Key0.m_fValue - pPrev->m_fValue + d);
+			}
+			else
+			{
+				fOut = d;
+			}
+		}
+		break;
+
+	case ID_BEZI:
+	case ID_HERM:
+		fOut = Key0.m_fParam[1];
+		if (pPrev != NULL)
+		{
+			fOut *= (Key1.m_fTime - Key0.m_fTime) / (Key1.m_fTime - pPrev->m_fTime);
+		}
+		break;
+
+	case ID_BEZ2:
+		fOut = Key0.m_fParam[3] * (Key1.m_fTime - Key0.m_fTime);
+		if (fabs(Key0.m_fParam[2]) > 1e-5f)
+		{
+			fOut /= Key0.m_fParam[2];
+		}
+		else
+		{
+			fOut *= 1e5f;
+		}
+		break;
+
+	case ID_STEP:
+	default:
+		fOut = 0.0f;
+		break;
+	}
+	return fOut;
+}
+
+// incoming tangent of key1 (in span key0 -> key1),
+// key1 may have next key
+static float GetIncoming(const tEnvKey &Key0, const tEnvKey &Key1, const tEnvKey *pNext)
+{
+	float fIn = 0.0f;
+	switch (Key1.m_uiShape)
+	{
+	case ID_LINE:
+		{
+			float d = Key1.m_fValue - Key0.m_fValue;
+			if (pNext != NULL)
+			{
+				float t = (Key1.m_fTime - Key0.m_fTime) / (pNext->m_fTime - Key0.m_fTime);
+				fIn = t * (pNext->m_fValue - Key1.m_fValue + d);
+			}
+			else
+			{
+				fIn = d;
+			}
+		}
+		break;
+
+	case ID_TCB:
+		{
+			float a = (1.0f - Key1.m_fTension) * (1.0f - Key1.m_fContinuity) * (1.0f + Key1.m_fBias);
+			float b = (1.0f - Key1.m_fTension) * (1.0f + Key1.m_fContinuity) * (1.0f - Key1.m_fBias);
+			float d = Key1.m_fValue - Key0.m_fValue;
+			if (pNext != NULL)
+			{
+				float t = (Key1.m_fTime - Key0.m_fTime) / (pNext->m_fTime - Key0.m_fTime);
+				fIn = t * (b * (pNext->m_fValue - Key1.m_fValue) + a * d);
+			}
+			else
+			{
+				fIn = a * d;
+			}
+		}
+		break;
+
+	case ID_BEZI:
+	case ID_HERM:
+		fIn = Key1.m_fParam[0];
+		if (pNext != NULL)
+		{
+			fIn *= (Key1.m_fTime - Key0.m_fTime) / (pNext->m_fTime - Key0.m_fTime);
+		}
+		break;
+
+	case ID_BEZ2:
+		fIn = Key1.m_fParam[1] * (Key1.m_fTime - Key0.m_fTime);
+		if (fabs(Key1.m_fParam[0]) > 1e-5f)
+		{
+			fIn /= Key1.m_fParam[0];
+		}
+		else
+		{
+			fIn *= 1e5f;
+		}
+		break;
+
+	case ID_STEP:
+	default:
+		fIn = 0.0f;
+		break;
+	}
+	return fIn;
+}
+
+// bezier-curve control points to polynomial coefficients
+static void BezierToPolynomial(const float x0, const float x1, const float x2, const float x3, float &a, float &b, float &c, float &d)
+{
+	c = 3.0f * (x1 - x0);
+	b = 3.0f * (x2 - x1) - c;
+	a = x3 - x0 - c - b;
+	d = x0;
+}
+
+// time in range of keys for repeating behaviours,
+// count of cycles outside of range also
+static float GetRangeTime(const float fTime, const float fStart, const float fEnd, int &iCycle)
+{
+	float fLength = fEnd - fStart;
+	if (fLength <= 0.0f)
+	{
+		iCycle = 0;
+		return fStart;
+	}
+
+	float fCycles = (float)floor((fTime - fStart) / fLength);
+	iCycle = (int)fCycles;
+
+	float fRange = fTime - fCycles * fLength;
+
+	// rounding may place it just outside
+	if (fRange < fStart)
+	{
+		fRange = fStart;
+	}
+	else if (fRange > fEnd)
+	{
+		fRange = fEnd;
+	}
+	return fRange;
+}
+
+
+CLwoEnvelopeEvaluator::CLwoEnvelopeEvaluator(void)
+	: m_Envelopes()
+{
+}
+
+CLwoEnvelopeEvaluator::~CLwoEnvelopeEvaluator(void)
+{
+	m_Envelopes.clear();
+}
+
+void CLwoEnvelopeEvaluator::Clear()
+{
+	m_Envelopes.clear();
+}
+
+size_t CLwoEnvelopeEvaluator::AddEnvelope(const CLwoEnvelope &Envelope)
+{
+	m_Envelopes.push_back(CLwoCompiledEnvelope());
+	CLwoCompiledEnvelope &Env = m_Envelopes.back();
+
+	const CLwoEnvelope::tKeyList &Keys = Envelope.m_Keys;
+	size_t nKeys = Keys.size();
+
+	Env.m_usPreBehavior = Envelope.m_usPreBehavior;
+	Env.m_usPostBehavior = Envelope.m_usPostBehavior;
+	Env.m_fPreSlope = 0.0f;
+	Env.m_fPostSlope = 0.0f;
+	Env.m_nSpanCache = 0;
+	Env.m_fFirstTime = 0.0f;
+	Env.m_fLastTime = 0.0f;
+	Env.m_fFirstValue = 0.0f;
+	Env.m_fLastValue = 0.0f;
+
+	if (nKeys == 0)
+	{
+		// no keys: value is zero always
+		return (m_Envelopes.size() -1);
+	}
+
+	Env.m_fFirstTime = Keys.front().m_fTime;
+	Env.m_fLastTime = Keys.back().m_fTime;
+	Env.m_fFirstValue = Keys.front().m_fValue;
+	Env.m_fLastValue = Keys.back().m_fValue;
+
+	Env.m_KeyTimes.reserve(nKeys);
+	for (size_t i = 0; i < nKeys; i++)
+	{
+		Env.m_KeyTimes.push_back(Keys[i].m_fTime);
+	}
+
+	if (nKeys < 2)
+	{
+		// single key: constant value
+		return (m_Envelopes.size() -1);
+	}
+
+	Env.m_Spans.reserve(nKeys -1);
+	for (size_t i = 0; i +1 < nKeys; i++)
+	{
+		const tEnvKey &Key0 = Keys[i];
+		const tEnvKey &Key1 = Keys[i +1];
+		const tEnvKey *pPrev = (i > 0) ? &Keys[i -1] : NULL;
+		const tEnvKey *pNext = (i +2 < nKeys) ? &Keys[i +2] : NULL;
+
+		CLwoEnvelopeSpan Span;
+		Span.m_fStartTime = Key0.m_fTime;
+		Span.m_fInvLength = (Key1.m_fTime > Key0.m_fTime) ? 1.0f / (Key1.m_fTime - Key0.m_fTime) : 0.0f;
+		Span.m_bSolveTime = false;
+		Span.m_fTimeA = Span.m_fTimeB = Span.m_fTimeC = Span.m_fTimeD = 0.0f;
+
+		// shape of span is given by the key at end of span
+		switch (Key1.m_uiShape)
+		{
+		case ID_TCB:
+		case ID_BEZI:
+		case ID_HERM:
+			{
+				// hermite-basis expanded to polynomial
+				float fOut = GetOutgoing(pPrev, Key0, Key1);
+				float fIn = GetIncoming(Key0, Key1, pNext);
+				float v0 = Key0.m_fValue;
+				float v1 = Key1.m_fValue;
+				Span.m_fA = 2.0f * (v0 - v1) + fOut + fIn;
+				Span.m_fB = 3.0f * (v1 - v0) - 2.0f * fOut - fIn;
+				Span.m_fC = fOut;
+				Span.m_fD = v0;
+			}
+			break;
+
+		case ID_BEZ2:
+			{
+				float x1 = 0.0f;
+				float y1 = 0.0f;
+				if (Key0.m_uiShape == ID_BEZ2)
+				{
+					x1 = Key0.m_fTime + Key0.m_fParam[2];
+					y1 = Key0.m_fValue + Key0.m_fParam[3];
+				}
+				else
+				{
+					x1 = Key0.m_fTime + (Key1.m_fTime - Key0.m_fTime) / 3.0f;
+					y1 = Key0.m_fValue + Key0.m_fParam[1] / 3.0f;
+				}
+				float x2 = Key1.m_fTime + Key1.m_fParam[0];
+				float y2 = Key1.m_fValue + Key1.m_fParam[1];
+
+				BezierToPolynomial(Key0.m_fTime, x1, x2, Key1.m_fTime, Span.m_fTimeA, Span.m_fTimeB, Span.m_fTimeC, Span.m_fTimeD);
+				BezierToPolynomial(Key0.m_fValue, y1, y2, Key1.m_fValue, Span.m_fA, Span.m_fB, Span.m_fC, Span.m_fD);
+				Span.m_bSolveTime = true;
+			}
+			break;
+
+		case ID_LINE:
+			Span.m_fA = 0.0f;
+			Span.m_fB = 0.0f;
+			Span.m_fC = Key1.m_fValue - Key0.m_fValue;
+			Span.m_fD = Key0.m_fValue;
+			break;
+
+		case ID_STEP:
+			Span.m_fA = Span.m_fB = Span.m_fC = 0.0f;
+			Span.m_fD = Key0.m_fValue;
+			break;
+
+		default:
+			// unknown shape
+			Span.m_fA = Span.m_fB = Span.m_fC = Span.m_fD = 0.0f;
+			break;
+		}
+
+		Env.m_Spans.push_back(Span);
+	}
+
+	// slopes for linear extrapolation
+	if (Keys[1].m_fTime > Keys[0].m_fTime)
+	{
+		Env.m_fPreSlope = GetOutgoing(NULL, Keys[0], Keys[1]) / (Keys[1].m_fTime - Keys[0].m_fTime);
+	}
+	if (Keys[nKeys -1].m_fTime > Keys[nKeys -2].m_fTime)
+	{
+		Env.m_fPostSlope = GetIncoming(Keys[nKeys -2], Keys[nKeys -1], NULL) / (Keys[nKeys -1].m_fTime - Keys[nKeys -2].m_fTime);
+	}
+
+	return (m_Envelopes.size() -1);
+}
+
+// span where time is in [start, end),
+// times are usually ascending between calls so check cached span first
+size_t CLwoEnvelopeEvaluator::FindSpan(CLwoCompiledEnvelope &Env, const float fTime)
+{
+	const size_t nSpans = Env.m_Spans.size();
+	size_t nSpan = Env.m_nSpanCache;
+	if (nSpan < nSpans)
+	{
+		if (fTime >= Env.m_KeyTimes[nSpan])
+		{
+			if (fTime < Env.m_KeyTimes[nSpan +1])
+			{
+				return nSpan;
+			}
+			// next span?
+			if (nSpan +1 < nSpans
+				&& fTime < Env.m_KeyTimes[nSpan +2])
+			{
+				Env.m_nSpanCache = nSpan +1;
+				return nSpan +1;
+			}
+		}
+	}
+
+	// binary search: first key after time
+	vector<float>::const_iterator itKey = upper_bound(Env.m_KeyTimes.begin(), Env.m_KeyTimes.end(), fTime);
+	nSpan = (size_t)(itKey - Env.m_KeyTimes.begin());
+	nSpan = (nSpan > 0) ? nSpan -1 : 0;
+	if (nSpan >= nSpans)
+	{
+		nSpan = nSpans -1;
+	}
+	Env.m_nSpanCache = nSpan;
+	return nSpan;
+}
+
+// coefficients of polynomial for envelope at given time,
+// handles behaviours before first and after last key
+void CLwoEnvelopeEvaluator::GetCoefficients(CLwoCompiledEnvelope &Env, const float fTime, float &fT, float &fA, float &fB, float &fC, float &fD)
+{
+	fT = 0.0f;
+	fA = fB = fC = 0.0f;
+
+	if (Env.m_Spans.empty() == true)
+	{
+		// no keys or single key
+		fD = Env.m_fFirstValue;
+		return;
+	}
+
+	float fTime2 = fTime;
+	float fOffset = 0.0f;
+	int iCycle = 0;
+
+	if (fTime < Env.m_fFirstTime
+		|| fTime > Env.m_fLastTime)
+	{
+		bool bPre = (fTime < Env.m_fFirstTime);
+		unsigned short usBehavior = (bPre == true) ? Env.m_usPreBehavior : Env.m_usPostBehavior;
+		switch (usBehavior)
+		{
+		case CLwoEnvelope::BEH_RESET:
+			fD = 0.0f;
+			return;
+
+		case CLwoEnvelope::BEH_CONSTANT:
+			fD = (bPre == true) ? Env.m_fFirstValue : Env.m_fLastValue;
+			return;
+
+		case CLwoEnvelope::BEH_REPEAT:
+			fTime2 = GetRangeTime(fTime, Env.m_fFirstTime, Env.m_fLastTime, iCycle);
+			break;
+
+		case CLwoEnvelope::BEH_OSCILLATE:
+			fTime2 = GetRangeTime(fTime, Env.m_fFirstTime, Env.m_fLastTime, iCycle);
+			if (iCycle % 2 != 0)
+			{
+				fTime2 = Env.m_fLastTime - (fTime2 - Env.m_fFirstTime);
+			}
+			break;
+
+		case CLwoEnvelope::BEH_OFFSET:
+			fTime2 = GetRangeTime(fTime, Env.m_fFirstTime, Env.m_fLastTime, iCycle);
+			fOffset = (float)iCycle * (Env.m_fLastValue - Env.m_fFirstValue);
+			break;
+
+		case CLwoEnvelope::BEH_LINEAR:
+			// linear polynomial of time from the key
+			if (bPre == true)
+			{
+				fT = fTime - Env.m_fFirstTime;
+				fC = Env.m_fPreSlope;
+				fD = Env.m_fFirstValue;
+			}
+			else
+			{
+				fT = fTime - Env.m_fLastTime;
+				fC = Env.m_fPostSlope;
+				fD = Env.m_fLastValue;
+			}
+			return;
+
+		default:
+			fD = 0.0f;
+			return;
+		}
+	}
+
+	if (fTime2 >= Env.m_fLastTime)
+	{
+		// exactly at last key
+		fD = Env.m_fLastValue + fOffset;
+		return;
+	}
+
+	const CLwoEnvelopeSpan &Span = Env.m_Spans[FindSpan(Env, fTime2)];
+
+	fT = (fTime2 - Span.m_fStartTime) * Span.m_fInvLength;
+	if (Span.m_bSolveTime == true)
+	{
+		// time is bezier-curve also:
+		// bisect parameter for given time (curve is ascending)
+		float fT0 = 0.0f;
+		float fT1 = 1.0f;
+		for (int i = 0; i < 32; i++)
+		{
+			float fMid = (fT0 + fT1) * 0.5f;
+			float fX = ((Span.m_fTimeA * fMid + Span.m_fTimeB) * fMid + Span.m_fTimeC) * fMid + Span.m_fTimeD;
+			if (fabs(fX - fTime2) <= 0.0001f)
+			{
+				fT0 = fT1 = fMid;
+				break;
+			}
+			if (fX > fTime2)
+			{
+				fT1 = fMid;
+			}
+			else
+			{
+				fT0 = fMid;
+			}
+		}
+		fT = (fT0 + fT1) * 0.5f;
+	}
+
+	fA = Span.m_fA;
+	fB = Span.m_fB;
+	fC = Span.m_fC;
+	fD = Span.m_fD + fOffset;
+}
+
+// value = ((a*t + b)*t + c)*t + d for each in scratch buffers
+void CLwoEnvelopeEvaluator::EvaluatePolynomials(const size_t nCount, float *pfResults)
+{
+	const float *pfT = &m_vT[0];
+	const float *pfA = &m_vA[0];
+	const float *pfB = &m_vB[0];
+	const float *pfC = &m_vC[0];
+	const float *pfD = &m_vD[0];
+
+	size_t i = 0;
+
+#ifdef LWO_ENVELOPE_SSE
+	for (; i +4 <= nCount; i += 4)
+	{
+		__m128 t = _mm_loadu_ps(pfT +i);
+		__m128 v = _mm_loadu_ps(pfA +i);
+		v = _mm_add_ps(_mm_mul_ps(v, t), _mm_loadu_ps(pfB +i));
+		v = _mm_add_ps(_mm_mul_ps(v, t), _mm_loadu_ps(pfC +i));
+		v = _mm_add_ps(_mm_mul_ps(v, t), _mm_loadu_ps(pfD +i));
+		_mm_storeu_ps(pfResults +i, v);
+	}
+#endif
+
+	for (; i < nCount; i++)
+	{
+		pfResults[i] = ((pfA[i] * pfT[i] + pfB[i]) * pfT[i] + pfC[i]) * pfT[i] + pfD[i];
+	}
+}
+
+float CLwoEnvelopeEvaluator::Evaluate(const size_t nEnvelope, const float fTime)
+{
+	if (nEnvelope >= m_Envelopes.size())
+	{
+		return 0.0f;
+	}
+
+	float fT, fA, fB, fC, fD;
+	GetCoefficients(m_Envelopes[nEnvelope], fTime, fT, fA, fB, fC, fD);
+	return ((fA * fT + fB) * fT + fC) * fT + fD;
+}
+
+void CLwoEnvelopeEvaluator::EvaluateBatch(const float *pfTimes, const size_t nTimes, float *pfResults)
+{
+	if (nTimes == 0)
+	{
+		return;
+	}
+
+	// scratch for one row (grows only)
+	if (m_vT.size() < nTimes)
+	{
+		m_vT.resize(nTimes);
+		m_vA.resize(nTimes);
+		m_vB.resize(nTimes);
+		m_vC.resize(nTimes);
+		m_vD.resize(nTimes);
+	}
+
+	for (size_t e = 0; e < m_Envelopes.size(); e++)
+	{
+		CLwoCompiledEnvelope &Env = m_Envelopes[e];
+
+		// first pass: span search and coefficients
+		for (size_t i = 0; i < nTimes; i++)
+		{
+			GetCoefficients(Env, pfTimes[i], m_vT[i], m_vA[i], m_vB[i], m_vC[i], m_vD[i]);
+		}
+
+		// second pass: evaluate polynomials
+		EvaluatePolynomials(nTimes, pfResults + (e * nTimes));
+	}
+}
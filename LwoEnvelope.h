@@ -0,0 +1,115 @@
+//////////////////////////////////////////////////////////////////////
+// LwoEnvelope.h : evaluation of envelopes (animated values)
+//
+// Envelopes are compiled once into spans of cubic polynomials
+// so that many envelopes can be evaluated at many times in a single call:
+// key-search is cached between consecutive times and
+// polynomials are evaluated in a vectorized pass.
+//
+// Curve shapes and behaviours follow envelope.c of Lightwave SDK.
+//
+
+#ifndef _LWOENVELOPE_H_
+#define _LWOENVELOPE_H_
+
+#include "LwoObjectData.h"
+
+#include <vector>
+using namespace std;
+
+class CLwoEnvelopeEvaluator
+{
+protected:
+	// span between two keys as polynomial of normalized time t (0..1):
+	// value = ((a*t + b)*t + c)*t + d
+	class CLwoEnvelopeSpan
+	{
+	public:
+		float m_fStartTime;
+		float m_fInvLength;
+
+		float m_fA;
+		float m_fB;
+		float m_fC;
+		float m_fD;
+
+		// BEZ2-shape: time is also a bezier-curve,
+		// need to solve t for given time first
+		bool m_bSolveTime;
+		float m_fTimeA;
+		float m_fTimeB;
+		float m_fTimeC;
+		float m_fTimeD;
+	};
+
+	// envelope prepared for evaluation
+	class CLwoCompiledEnvelope
+	{
+	public:
+		// time of each key for searching span,
+		// span i is from key i to key i+1
+		vector<float> m_KeyTimes;
+		vector<CLwoEnvelopeSpan> m_Spans;
+
+		float m_fFirstTime;
+		float m_fLastTime;
+		float m_fFirstValue;
+		float m_fLastValue;
+
+		unsigned short m_usPreBehavior;
+		unsigned short m_usPostBehavior;
+
+		// slopes for linear behaviour before/after keys
+		float m_fPreSlope;
+		float m_fPostSlope;
+
+		// cached span from previous evaluation
+		size_t m_nSpanCache;
+	};
+
+	vector<CLwoCompiledEnvelope> m_Envelopes;
+
+	// scratch buffers of batch evaluation,
+	// kept between calls to avoid reallocating
+	vector<float> m_vT;
+	vector<float> m_vA;
+	vector<float> m_vB;
+	vector<float> m_vC;
+	vector<float> m_vD;
+
+	// coefficients for evaluating envelope at given time
+	inline void GetCoefficients(CLwoCompiledEnvelope &Env, const float fTime, float &fT, float &fA, float &fB, float &fC, float &fD);
+
+	// locate span for time within keys, cached search
+	inline size_t FindSpan(CLwoCompiledEnvelope &Env, const float fTime);
+
+	// vectorized polynomial pass over scratch buffers
+	void EvaluatePolynomials(const size_t nCount, float *pfResults);
+
+public:
+	CLwoEnvelopeEvaluator(void);
+	~CLwoEnvelopeEvaluator(void);
+
+	// remove compiled envelopes (keeps allocated capacity)
+	void Clear();
+
+	// compile envelope for evaluation,
+	// returns index of envelope in this evaluator
+	size_t AddEnvelope(const CLwoEnvelope &Envelope);
+
+	size_t GetEnvelopeCount() const
+	{
+		return m_Envelopes.size();
+	};
+
+	// evaluate single envelope at given time
+	float Evaluate(const size_t nEnvelope, const float fTime);
+
+	// evaluate all compiled envelopes at each given time:
+	// results are row per envelope, nTimes values in each row
+	// (pfResults must have room for GetEnvelopeCount()*nTimes values).
+	// ascending times are fastest (cached search).
+	void EvaluateBatch(const float *pfTimes, const size_t nTimes, float *pfResults);
+};
+
+#endif // ifndef _LWOENVELOPE_H_
@@ -0,0 +1,134 @@
+//////////////////////////////////////////////////////////////////////
+// LwoEventHandler.h : callbacks for streaming object parsing
+//
+// Used with CLwoReader::ProcessWithHandler() when object tree is not needed:
+// geometry (points, polygons, polygon-tags and vertex maps) is given
+// in decoded batches of fixed size and is not kept in memory.
+// Small chunks (layers, tags and surfaces) are parsed as usual
+// and given when complete.
+//
+// Pointers in batches are valid only during the call.
+// Return false from any callback to stop parsing.
+//
+
+#ifndef _LWOEVENTHANDLER_H_
+#define _LWOEVENTHANDLER_H_
+
+#include "LwoObjectData.h"
+
+#include <stddef.h>
+
+// amount of points/polygons/records in single batch at most
+#define LWO_EVENT_BATCH_SIZE 1024
+
+// batch of polygons from POLS (or LWOB CRVS)
+struct tLwoPolygonBatch
+{
+	// FACE, CURV, PTCH, MBAL or BONE
+	unsigned int m_uiPolyTypeID;
+
+	// index of first polygon in batch within its POLS-chunk
+	// (as referred to by PTAG and VMAD)
+	unsigned long m_ulFirstPolygon;
+
+	// amount of polygons in batch
+	size_t m_nCount;
+
+	// vertex-count and flags of each polygon
+	const unsigned short *m_pusVertexCounts;
+	const unsigned short *m_pusFlags;
+
+	// indices of vertices of all polygons, one after another
+	const unsigned int *m_puiIndices;
+
+	// LWOB only (NULL in LWO2 where PTAG is used):
+	// 1-based surface-index to SRFS-names of each polygon, zero for none.
+	// LWOB detail-polygons follow their polygon as ordinary polygons.
+	const unsigned short *m_pusSurfaces;
+};
+
+// batch of PTAG-mappings: polygon to tag
+struct tLwoPtagBatch
+{
+	// SURF, PART, SMGP..
+	unsigned int m_uiPtagTypeID;
+
+	size_t m_nCount;
+
+	// polygon-index within previous POLS and
+	// 0-based index to TAGS-names
+	const unsigned int *m_puiPolygons;
+	const unsigned short *m_pusTags;
+};
+
+// batch of VMAP (or VMAD) values
+struct tLwoVmapBatch
+{
+	// TXUV, WGHT, MORF, RGB..
+	unsigned int m_uiVmapTypeID;
+
+	// values per mapped vertex
+	unsigned short m_usDimension;
+
+	const char *m_szName;
+
+	// VMAD: values per vertex of polygon
+	bool m_bPerPolygon;
+
+	size_t m_nCount;
+
+	// index of point (and polygon in VMAD, otherwise NULL)
+	const unsigned int *m_puiPoints;
+	const unsigned int *m_puiPolygons;
+
+	// m_usDimension values for each
+	const float *m_pfValues;
+};
+
+class CLwoEventHandler
+{
+public:
+	virtual ~CLwoEventHandler(void)
+	{};
+
+	// new layer starts, following geometry belongs to it
+	virtual bool OnLayer(const CLwoLayer & /*Layer*/)
+	{
+		return true;
+	};
+
+	// batch of points (x,y,z for each):
+	// index of first point within its PNTS-chunk
+	virtual bool OnPoints(const float * /*pfPoints*/, const size_t /*nCount*/, const unsigned long /*ulFirstIndex*/)
+	{
+		return true;
+	};
+
+	virtual bool OnPolygons(const tLwoPolygonBatch & /*Batch*/)
+	{
+		return true;
+	};
+
+	// names referred to by PTAG (TAGS, or SRFS in LWOB)
+	virtual bool OnTags(const CLwoTagnameList & /*Tags*/)
+	{
+		return true;
+	};
+
+	virtual bool OnPtag(const tLwoPtagBatch & /*Batch*/)
+	{
+		return true;
+	};
+
+	virtual bool OnSurface(const CLwoSurface & /*Surface*/)
+	{
+		return true;
+	};
+
+	virtual bool OnVmap(const tLwoVmapBatch & /*Batch*/)
+	{
+		return true;
+	};
+};
+
+#endif // ifndef _LWOEVENTHANDLER_H_
@@ -0,0 +1,1856 @@
+//////////////////////////////////////////////////////////////////////
+// LwoExport.cpp : writing parsed objects as Wavefront OBJ, PLY and glTF binary (GLB)
+//
+
+#include "LwoExport.h"
+#include "LwoTrace.h"
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// points or polygons formatted as one block
+#define LWO_EXPORT_BLOCK_SIZE 65536
+
+// buffer of output file (blocks are written whole)
+#define LWO_EXPORT_FILE_BUFFER (1 << 20)
+
+
+//////////////////////////////////////////////////////////////////////
+// number formatting
+//////////////////////////////////////////////////////////////////////
+
+static const char g_szDigitPairs[201] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+// exact in double
+static const double g_dPow10[23] =
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const uint64_t g_ullPow10[10] =
+{
+	1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL,
+	1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL
+};
+
+// value * 10^iExp: dividing by exact power
+// keeps result correctly rounded for small values
+static inline double ScalePow10(const double dValue, const int iExp)
+{
+	if (iExp >= 0)
+	{
+		return dValue * ((iExp <= 22) ? g_dPow10[iExp] : pow(10.0, iExp));
+	}
+	return dValue / ((-iExp <= 22) ? g_dPow10[-iExp] : pow(10.0, -iExp));
+}
+
+// nearest of positive value below 2^52 (half away from zero)
+static inline uint64_t RoundToUInt(const double dValue)
+{
+	return (uint64_t)(dValue + 0.5);
+}
+
+char *LwoFormatUInt(char *pOut, uint32_t uiValue)
+{
+	// two digits at a time from end
+	char szDigits[10];
+	char *pEnd = (szDigits +10);
+	char *pPos = pEnd;
+	while (uiValue >= 100)
+	{
+		const uint32_t uiPair = (uiValue % 100) * 2;
+		uiValue /= 100;
+		pPos = (pPos -2);
+		pPos[0] = g_szDigitPairs[uiPair];
+		pPos[1] = g_szDigitPairs[uiPair +1];
+	}
+	if (uiValue >= 10)
+	{
+		pPos = (pPos -2);
+		pPos[0] = g_szDigitPairs[uiValue*2];
+		pPos[1] = g_szDigitPairs[uiValue*2 +1];
+	}
+	else
+	{
+		pPos = (pPos -1);
+		pPos[0] = (char)('0' + uiValue);
+	}
+
+	const size_t nLength = (size_t)(pEnd - pPos);
+	memcpy(pOut, pPos, nLength);
+	return (pOut + nLength);
+}
+
+char *LwoFormatFloat(char *pOut, const float fValue)
+{
+	if (fValue != fValue)
+	{
+		memcpy(pOut, "nan", 3);
+		return (pOut +3);
+	}
+
+	float fAbs = fValue;
+	if (fValue < 0.0f)
+	{
+		*pOut++ = '-';
+		fAbs = -fValue;
+	}
+	if (fAbs == 0.0f)
+	{
+		*pOut++ = '0';
+		return pOut;
+	}
+	if (fAbs > FLT_MAX)
+	{
+		memcpy(pOut, "inf", 3);
+		return (pOut +3);
+	}
+
+	// nine significant digits always read back as same float:
+	// estimate of exponent from binary exponent may be off by one
+	const double dAbs = fAbs;
+	int iExp2 = 0;
+	frexp(dAbs, &iExp2);
+	int iExp10 = (int)floor((iExp2 -1) * 0.30102999566398120);
+	uint64_t ullDigits9 = RoundToUInt(ScalePow10(dAbs, 8 - iExp10));
+	for (int i = 0; i < 2; i++)
+	{
+		if (ullDigits9 >= g_ullPow10[9])
+		{
+			iExp10++;
+		}
+		else if (ullDigits9 < g_ullPow10[8])
+		{
+			iExp10--;
+		}
+		else
+		{
+			break;
+		}
+		ullDigits9 = RoundToUInt(ScalePow10(dAbs, 8 - iExp10));
+	}
+
+	// shortest from six digits up: rounding to fewer digits
+	// than six is same as six with trailing zeros (removed below),
+	// except for denormals with less precision.
+	// value rounded to nearest with given digits (not from nine digits
+	// which would round twice) is only candidate of that length
+	uint64_t ullDigits = ullDigits9;
+	int iDigits = 9;
+	int iExp = iExp10;
+	for (int iTry = (fAbs < FLT_MIN) ? 1 : 6; iTry < 9; iTry++)
+	{
+		uint64_t ullTry = RoundToUInt(ScalePow10(dAbs, iTry -1 - iExp10));
+		int iTryExp = iExp10;
+		if (ullTry == g_ullPow10[iTry])
+		{
+			// rounded up to next power of ten
+			ullTry /= 10;
+			iTryExp++;
+		}
+		if ((float)ScalePow10((double)ullTry, iTryExp - iTry +1) == fAbs)
+		{
+			ullDigits = ullTry;
+			iDigits = iTry;
+			iExp = iTryExp;
+			break;
+		}
+	}
+	while (iDigits > 1
+		&& (ullDigits % 10) == 0)
+	{
+		ullDigits /= 10;
+		iDigits--;
+	}
+
+	char szDigits[10];
+	LwoFormatUInt(szDigits, (uint32_t)ullDigits);
+
+	if (iExp < -5 || iExp > 8)
+	{
+		// scientific: d.ddde-XX
+		*pOut++ = szDigits[0];
+		if (iDigits > 1)
+		{
+			*pOut++ = '.';
+			memcpy(pOut, (szDigits +1), iDigits -1);
+			pOut = (pOut + (iDigits -1));
+		}
+		*pOut++ = 'e';
+		if (iExp < 0)
+		{
+			*pOut++ = '-';
+		}
+		return LwoFormatUInt(pOut, (uint32_t)((iExp < 0) ? -iExp : iExp));
+	}
+
+	if (iExp < 0)
+	{
+		// 0.000ddd
+		*pOut++ = '0';
+		*pOut++ = '.';
+		for (int i = -1; i > iExp; i--)
+		{
+			*pOut++ = '0';
+		}
+		memcpy(pOut, szDigits, iDigits);
+		return (pOut + iDigits);
+	}
+
+	if (iDigits <= (iExp +1))
+	{
+		// integer: ddd000
+		memcpy(pOut, szDigits, iDigits);
+		pOut = (pOut + iDigits);
+		for (int i = iDigits; i <= iExp; i++)
+		{
+			*pOut++ = '0';
+		}
+		return pOut;
+	}
+
+	// ddd.ddd
+	memcpy(pOut, szDigits, iExp +1);
+	pOut = (pOut + (iExp +1));
+	*pOut++ = '.';
+	memcpy(pOut, (szDigits + (iExp +1)), iDigits - (iExp +1));
+	return (pOut + (iDigits - (iExp +1)));
+}
+
+
+//////////////////////////////////////////////////////////////////////
+// helpers of formats
+//////////////////////////////////////////////////////////////////////
+
+static bool IsLittleEndian()
+{
+	const uint16_t usValue = 1;
+	return (*((const uint8_t*)&usValue) == 1);
+}
+
+// name without whitespace or control characters
+// (names are single tokens in OBJ)
+static char *AppendName(char *pOut, const string &szName)
+{
+	for (size_t i = 0; i < szName.size(); i++)
+	{
+		const unsigned char c = (unsigned char)szName[i];
+		*pOut++ = (c <= ' ') ? '_' : (char)c;
+	}
+	return pOut;
+}
+
+// room for nBytes more after nUsed bytes of buffer
+static char *ReserveBytes(vector<char> &Buffer, const size_t nUsed, const size_t nBytes)
+{
+	if (Buffer.size() < (nUsed + nBytes))
+	{
+		Buffer.resize((nUsed + nBytes) * 2);
+	}
+	return (Buffer.data() + nUsed);
+}
+
+// indices of rows in block (within polygon-list)
+static size_t GetBlockIndexCount(const CLwoPolygons *pPolygons, const size_t nFirst, const size_t nCount)
+{
+	size_t nIndices = 0;
+	for (size_t r = nFirst; r < (nFirst + nCount); r++)
+	{
+		nIndices += pPolygons->m_PolyList[r].m_wVertexCount;
+	}
+	return nIndices;
+}
+
+// polygon can be written: face with indices within its points
+static bool IsValidRow(const CLwoPolygons *pPolygons, const CLwoPolygons::CLwoPolyRow &Row, const long lPointCount)
+{
+	if (Row.m_wVertexCount < 3)
+	{
+		return false;
+	}
+	const int *piIndices = pPolygons->GetIndices(Row);
+	for (unsigned short v = 0; v < Row.m_wVertexCount; v++)
+	{
+		if (piIndices[v] < 0
+			|| piIndices[v] >= lPointCount)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+// CLwoExporter
+//////////////////////////////////////////////////////////////////////
+
+CLwoExporter::CLwoExporter(const size_t nThreads)
+	: m_Pool(nThreads)
+{
+}
+
+CLwoExporter::~CLwoExporter(void)
+{
+}
+
+bool CLwoExporter::MakeLayout(const CLwoObjectData &Object, tExportLayout &Layout) const
+{
+	Layout.m_PointBlocks.clear();
+	Layout.m_PolygonBlocks.clear();
+	Layout.m_uiPointCount = 0;
+	Layout.m_ullPolygonCount = 0;
+	Layout.m_bLargePolygons = false;
+
+	// points of all layers one after another
+	map<const CLwoPoints*, uint32_t> PointBase;
+	uint64_t ullPoints = 0;
+	const tLayerList &Layers = Object.GetLayers();
+	for (size_t l = 0; l < Layers.size(); l++)
+	{
+		const tPointsList &Points = Layers[l]->GetPoints();
+		for (size_t p = 0; p < Points.size(); p++)
+		{
+			const size_t nCount = (size_t)Points[p]->GetPointCount();
+			PointBase[Points[p]] = (uint32_t)ullPoints;
+			for (size_t nFirst = 0; nFirst < nCount; nFirst += LWO_EXPORT_BLOCK_SIZE)
+			{
+				tExportBlock Block;
+				Block.m_pChunk = Points[p];
+				Block.m_nFirst = nFirst;
+				Block.m_nCount = ((nCount - nFirst) < LWO_EXPORT_BLOCK_SIZE) ? (nCount - nFirst) : LWO_EXPORT_BLOCK_SIZE;
+				Block.m_uiPointBase = 0;
+				Block.m_pLayer = NULL;
+				Layout.m_PointBlocks.push_back(Block);
+			}
+			ullPoints += nCount;
+		}
+	}
+
+	// indices are 32-bit in output
+	if (ullPoints > 0xFFFFFFFFULL)
+	{
+		return false;
+	}
+	Layout.m_uiPointCount = (uint32_t)ullPoints;
+
+	// faces and sub-patches (same as faces in output)
+	for (size_t l = 0; l < Layers.size(); l++)
+	{
+		const CLwoLayer *pLayerStart = Layers[l];
+		const tPolygonsList &Polygons = Layers[l]->GetPolygons();
+		for (size_t p = 0; p < Polygons.size(); p++)
+		{
+			const CLwoPolygons *pPolygons = Polygons[p];
+			if (pPolygons->m_uiPolyTypeID != ID_FACE
+				&& pPolygons->m_uiPolyTypeID != ID_PTCH)
+			{
+				continue;
+			}
+			map<const CLwoPoints*, uint32_t>::const_iterator itBase = PointBase.find(pPolygons->m_pPointsList);
+			if (itBase == PointBase.end())
+			{
+				continue;
+			}
+
+			// polygons left out when writing are not counted
+			const size_t nCount = pPolygons->m_PolyList.size();
+			const long lPointCount = pPolygons->m_pPointsList->GetPointCount();
+			for (size_t r = 0; r < nCount; r++)
+			{
+				const CLwoPolygons::CLwoPolyRow &Row = pPolygons->m_PolyList[r];
+				if (Row.m_wVertexCount > 255)
+				{
+					Layout.m_bLargePolygons = true;
+				}
+				if (IsValidRow(pPolygons, Row, lPointCount) == true)
+				{
+					Layout.m_ullPolygonCount++;
+				}
+			}
+			for (size_t nFirst = 0; nFirst < nCount; nFirst += LWO_EXPORT_BLOCK_SIZE)
+			{
+				tExportBlock Block;
+				Block.m_pChunk = pPolygons;
+				Block.m_nFirst = nFirst;
+				Block.m_nCount = ((nCount - nFirst) < LWO_EXPORT_BLOCK_SIZE) ? (nCount - nFirst) : LWO_EXPORT_BLOCK_SIZE;
+				Block.m_uiPointBase = itBase->second;
+				Block.m_pLayer = pLayerStart;
+				Layout.m_PolygonBlocks.push_back(Block);
+
+				// name before first polygons of layer
+				pLayerStart = NULL;
+			}
+		}
+	}
+	return true;
+}
+
+bool CLwoExporter::WriteBlocks(FILE *pFile, const vector<tExportBlock> &Blocks, tFormatBlock Format, uint64_t &ullCount)
+{
+	// formatted block waiting for its turn
+	struct tPending
+	{
+		vector<char> m_Buffer;
+		uint64_t m_ullCount;
+		bool m_bDone;
+
+		tPending() : m_Buffer(), m_ullCount(0), m_bDone(false) {};
+	};
+
+	// few blocks ahead of writing so that threads stay busy
+	const size_t nBlocks = Blocks.size();
+	const size_t nAhead = (m_Pool.GetThreadCount() * 2) +1;
+	vector<tPending> vPending(nBlocks);
+	mutex Lock;
+	condition_variable Done;
+
+	auto Submit = [&](const size_t nBlock)
+	{
+		m_Pool.Submit([&, nBlock]()
+		{
+			tPending &Pending = vPending[nBlock];
+			{
+				CLwoTraceScope Trace("format", 0, Blocks[nBlock].m_nCount);
+				Format(Blocks[nBlock], Pending.m_Buffer, Pending.m_ullCount);
+			}
+			lock_guard<mutex> Guard(Lock);
+			Pending.m_bDone = true;
+			Done.notify_all();
+		});
+	};
+
+	size_t nSubmitted = 0;
+	while (nSubmitted < nBlocks
+		&& nSubmitted < nAhead)
+	{
+		Submit(nSubmitted++);
+	}
+
+	// in order: only blocks already submitted after failure
+	bool bRet = true;
+	for (size_t i = 0; i < nSubmitted; i++)
+	{
+		tPending &Pending = vPending[i];
+		{
+			unique_lock<mutex> Guard(Lock);
+			Done.wait(Guard, [&Pending]() { return Pending.m_bDone; });
+		}
+
+		if (bRet == true
+			&& Pending.m_Buffer.empty() == false)
+		{
+			CLwoTraceScope Trace("write", 0, Pending.m_Buffer.size());
+			bRet = (fwrite(Pending.m_Buffer.data(), Pending.m_Buffer.size(), 1, pFile) == 1);
+		}
+		ullCount += Pending.m_ullCount;
+		vector<char>().swap(Pending.m_Buffer);
+
+		if (bRet == true
+			&& nSubmitted < nBlocks)
+		{
+			Submit(nSubmitted++);
+		}
+	}
+	return bRet;
+}
+
+bool CLwoExporter::WriteObj(const CLwoObjectData &Object, const char *szPath)
+{
+	CLwoTraceScope Trace("export obj", 0, 0, szPath);
+
+	tExportLayout Layout;
+	if (MakeLayout(Object, Layout) == false)
+	{
+		return false;
+	}
+
+	FILE *pFile = fopen(szPath, "wb");
+	if (pFile == NULL)
+	{
+		return false;
+	}
+	setvbuf(pFile, NULL, _IOFBF, LWO_EXPORT_FILE_BUFFER);
+
+	// "v x y z" of each point
+	uint64_t ullPoints = 0;
+	bool bRet = WriteBlocks(pFile, Layout.m_PointBlocks, [](const tExportBlock &Block, vector<char> &Buffer, uint64_t &ullCount)
+	{
+		const float *pfPoint = (((const CLwoPoints*)Block.m_pChunk)->m_PointList.data() + Block.m_nFirst*3);
+		Buffer.resize(Block.m_nCount * (3 * (LWO_FORMAT_MAX +1) +2));
+		char *pOut = Buffer.data();
+		for (size_t n = 0; n < Block.m_nCount; n++)
+		{
+			*pOut++ = 'v';
+			for (int i = 0; i < 3; i++)
+			{
+				*pOut++ = ' ';
+				pOut = LwoFormatFloat(pOut, pfPoint[i]);
+			}
+			*pOut++ = '\n';
+			pfPoint = (pfPoint +3);
+		}
+		Buffer.resize((size_t)(pOut - Buffer.data()));
+		ullCount += Block.m_nCount;
+	}, ullPoints);
+
+	// "f a b c.." with 1-based index of point,
+	// object-name of layer and material-name of surface when changed
+	uint64_t ullPolygons = 0;
+	if (bRet == true)
+	{
+		bRet = WriteBlocks(pFile, Layout.m_PolygonBlocks, [](const tExportBlock &Block, vector<char> &Buffer, uint64_t &ullCount)
+		{
+			const CLwoPolygons *pPolygons = (const CLwoPolygons*)Block.m_pChunk;
+			const long lPointCount = pPolygons->m_pPointsList->GetPointCount();
+			const uint32_t uiBase = Block.m_uiPointBase +1;
+
+			size_t nUsed = 0;
+			Buffer.resize(Block.m_nCount*3 + GetBlockIndexCount(pPolygons, Block.m_nFirst, Block.m_nCount)*(LWO_FORMAT_MAX/2));
+			if (Block.m_pLayer != NULL)
+			{
+				const CLwoLayer *pLayer = Block.m_pLayer;
+				char *pOut = ReserveBytes(Buffer, nUsed, pLayer->m_szLayerName.size() + LWO_FORMAT_MAX);
+				char *pStart = pOut;
+				memcpy(pOut, "o ", 2);
+				pOut = (pOut +2);
+				if (pLayer->m_szLayerName.empty() == true)
+				{
+					memcpy(pOut, "layer", 5);
+					pOut = LwoFormatUInt((pOut +5), pLayer->m_usLayerNumber);
+				}
+				else
+				{
+					pOut = AppendName(pOut, pLayer->m_szLayerName);
+				}
+				*pOut++ = '\n';
+				nUsed += (size_t)(pOut - pStart);
+			}
+
+			const CLwoSurface *pSurface = NULL;
+			for (size_t r = Block.m_nFirst; r < (Block.m_nFirst + Block.m_nCount); r++)
+			{
+				const CLwoPolygons::CLwoPolyRow &Row = pPolygons->m_PolyList[r];
+				if (IsValidRow(pPolygons, Row, lPointCount) == false)
+				{
+					continue;
+				}
+
+				const size_t nName = (Row.m_pSurface != NULL) ? Row.m_pSurface->m_szSurfaceName.size() : 0;
+				char *pOut = ReserveBytes(Buffer, nUsed, nName + 10 + Row.m_wVertexCount*(LWO_FORMAT_MAX/2) +3);
+				char *pStart = pOut;
+				if (Row.m_pSurface != NULL
+					&& Row.m_pSurface != pSurface)
+				{
+					pSurface = Row.m_pSurface;
+					memcpy(pOut, "usemtl ", 7);
+					pOut = AppendName((pOut +7), pSurface->m_szSurfaceName);
+					*pOut++ = '\n';
+				}
+
+				*pOut++ = 'f';
+				const int *piIndices = pPolygons->GetIndices(Row);
+				for (unsigned short v = 0; v < Row.m_wVertexCount; v++)
+				{
+					*pOut++ = ' ';
+					pOut = LwoFormatUInt(pOut, uiBase + (uint32_t)piIndices[v]);
+				}
+				*pOut++ = '\n';
+				nUsed += (size_t)(pOut - pStart);
+				ullCount++;
+			}
+			Buffer.resize(nUsed);
+		}, ullPolygons);
+	}
+
+	if (fclose(pFile) != 0)
+	{
+		bRet = false;
+	}
+	if (bRet == false)
+	{
+		remove(szPath);
+	}
+	return bRet;
+}
+
+bool CLwoExporter::WritePlyHeader(FILE *pFile, const bool bBinary, const tExportLayout &Layout)
+{
+	string szHeader = "ply\nformat ";
+	if (bBinary == false)
+	{
+		szHeader += "ascii";
+	}
+	else
+	{
+		szHeader += (IsLittleEndian() == true) ? "binary_little_endian" : "binary_big_endian";
+	}
+
+	char szCounts[256];
+	snprintf(szCounts, sizeof(szCounts),
+		" 1.0\nelement vertex %lu\nproperty float x\nproperty float y\nproperty float z\n"
+		"element face %llu\nproperty list %s int vertex_indices\nend_header\n",
+		(unsigned long)Layout.m_uiPointCount, (unsigned long long)Layout.m_ullPolygonCount,
+		(Layout.m_bLargePolygons == true) ? "ushort" : "uchar");
+	szHeader += szCounts;
+
+	return (fwrite(szHeader.data(), szHeader.size(), 1, pFile) == 1);
+}
+
+bool CLwoExporter::WritePly(const CLwoObjectData &Object, const char *szPath, const bool bBinary)
+{
+	CLwoTraceScope Trace("export ply", 0, 0, szPath);
+
+	tExportLayout Layout;
+	if (MakeLayout(Object, Layout) == false)
+	{
+		return false;
+	}
+
+	FILE *pFile = fopen(szPath, "wb");
+	if (pFile == NULL)
+	{
+		return false;
+	}
+	setvbuf(pFile, NULL, _IOFBF, LWO_EXPORT_FILE_BUFFER);
+
+	bool bRet = WritePlyHeader(pFile, bBinary, Layout);
+
+	uint64_t ullPoints = 0;
+	if (bRet == true
+		&& bBinary == true)
+	{
+		// floats of points are already as in file
+		CLwoTraceScope TraceWrite("write", 0, (uint64_t)Layout.m_uiPointCount * 12);
+		for (size_t i = 0; i < Layout.m_PointBlocks.size() && bRet == true; i++)
+		{
+			const tExportBlock &Block = Layout.m_PointBlocks[i];
+			const float *pfPoint = (((const CLwoPoints*)Block.m_pChunk)->m_PointList.data() + Block.m_nFirst*3);
+			bRet = (fwrite(pfPoint, Block.m_nCount * 12, 1, pFile) == 1);
+		}
+	}
+	else if (bRet == true)
+	{
+		bRet = WriteBlocks(pFile, Layout.m_PointBlocks, [](const tExportBlock &Block, vector<char> &Buffer, uint64_t &ullCount)
+		{
+			const float *pfPoint = (((const CLwoPoints*)Block.m_pChunk)->m_PointList.data() + Block.m_nFirst*3);
+			Buffer.resize(Block.m_nCount * (3 * (LWO_FORMAT_MAX +1) +1));
+			char *pOut = Buffer.data();
+			for (size_t n = 0; n < Block.m_nCount; n++)
+			{
+				for (int i = 0; i < 3; i++)
+				{
+					pOut = LwoFormatFloat(pOut, pfPoint[i]);
+					*pOut++ = (i < 2) ? ' ' : '\n';
+				}
+				pfPoint = (pfPoint +3);
+			}
+			Buffer.resize((size_t)(pOut - Buffer.data()));
+			ullCount += Block.m_nCount;
+		}, ullPoints);
+	}
+
+	// count of vertices and their indices
+	uint64_t ullPolygons = 0;
+	if (bRet == true)
+	{
+		const bool bLarge = Layout.m_bLargePolygons;
+		bRet = WriteBlocks(pFile, Layout.m_PolygonBlocks, [bBinary, bLarge](const tExportBlock &Block, vector<char> &Buffer, uint64_t &ullCount)
+		{
+			const CLwoPolygons *pPolygons = (const CLwoPolygons*)Block.m_pChunk;
+			const long lPointCount = pPolygons->m_pPointsList->GetPointCount();
+			const size_t nIndices = GetBlockIndexCount(pPolygons, Block.m_nFirst, Block.m_nCount);
+
+			Buffer.resize((bBinary == true)
+				? (Block.m_nCount*2 + nIndices*4)
+				: (Block.m_nCount*7 + nIndices*(LWO_FORMAT_MAX/2)));
+			char *pOut = Buffer.data();
+			for (size_t r = Block.m_nFirst; r < (Block.m_nFirst + Block.m_nCount); r++)
+			{
+				const CLwoPolygons::CLwoPolyRow &Row = pPolygons->m_PolyList[r];
+				if (IsValidRow(pPolygons, Row, lPointCount) == false)
+				{
+					continue;
+				}
+
+				const int *piIndices = pPolygons->GetIndices(Row);
+				if (bBinary == true)
+				{
+					if (bLarge == true)
+					{
+						const uint16_t usCount = Row.m_wVertexCount;
+						memcpy(pOut, &usCount, 2);
+						pOut = (pOut +2);
+					}
+					else
+					{
+						*pOut++ = (char)(uint8_t)Row.m_wVertexCount;
+					}
+					for (unsigned short v = 0; v < Row.m_wVertexCount; v++)
+					{
+						const uint32_t uiIndex = Block.m_uiPointBase + (uint32_t)piIndices[v];
+						memcpy(pOut, &uiIndex, 4);
+						pOut = (pOut +4);
+					}
+				}
+				else
+				{
+					pOut = LwoFormatUInt(pOut, Row.m_wVertexCount);
+					for (unsigned short v = 0; v < Row.m_wVertexCount; v++)
+					{
+						*pOut++ = ' ';
+						pOut = LwoFormatUInt(pOut, Block.m_uiPointBase + (uint32_t)piIndices[v]);
+					}
+					*pOut++ = '\n';
+				}
+				ullCount++;
+			}
+			Buffer.resize((size_t)(pOut - Buffer.data()));
+		}, ullPolygons);
+	}
+
+	// same rows are left out as when counted for header
+	if (bRet == true)
+	{
+		bRet = (ullPolygons == Layout.m_ullPolygonCount);
+	}
+
+	if (fclose(pFile) != 0)
+	{
+		bRet = false;
+	}
+	if (bRet == false)
+	{
+		remove(szPath);
+	}
+	return bRet;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+// glTF binary (GLB)
+//////////////////////////////////////////////////////////////////////
+
+// header and chunks of GLB
+#define GLB_MAGIC 0x46546C67 // "glTF"
+#define GLB_CHUNK_JSON 0x4E4F534A // "JSON"
+#define GLB_CHUNK_BIN 0x004E4942 // "BIN\0"
+
+// componentType and target of glTF
+#define GLTF_BYTE 5120
+#define GLTF_SHORT 5122
+#define GLTF_UNSIGNED_SHORT 5123
+#define GLTF_UNSIGNED_INT 5125
+#define GLTF_FLOAT 5126
+#define GLTF_ARRAY_BUFFER 34962
+#define GLTF_ELEMENT_ARRAY_BUFFER 34963
+
+// no vertex or primitive
+#define GLB_NONE 0xFFFFFFFFU
+
+// attributes in order of views in binary chunk
+enum tGlbAttribute
+{
+	GLB_POSITION = 0,
+	GLB_NORMAL,
+	GLB_TEXCOORD,
+	GLB_INDICES
+};
+
+// triangles of one surface in mesh
+struct tGlbPrimitive
+{
+	const CLwoSurface *m_pSurface;
+	size_t m_nFirstIndex;
+	size_t m_nIndexCount;
+};
+
+// triangles of layer with vertices split by normal and UV
+struct tGlbMesh
+{
+	const CLwoLayer *m_pLayer;
+
+	// of each vertex in glTF axes, UVs with V flipped
+	// (UVs empty when layer has no UV-map)
+	vector<float> m_Positions;
+	vector<float> m_Normals;
+	vector<float> m_TexCoords;
+
+	// triangles of each primitive one after another
+	vector<uint32_t> m_Indices;
+	vector<tGlbPrimitive> m_Primitives;
+
+	float m_fMin[3];
+	float m_fMax[3];
+
+	// in file (see WriteGlb())
+	float m_fOffset[3];
+	float m_fScale;
+	bool m_bShortTexCoords;
+	uint32_t m_uiIndexSize;
+	uint32_t m_uiFirstAccessor;
+
+	tGlbMesh()
+		: m_pLayer(NULL)
+		, m_fScale(1.0f)
+		, m_bShortTexCoords(false)
+		, m_uiIndexSize(4)
+		, m_uiFirstAccessor(0)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			m_fMin[i] = 0.0f;
+			m_fMax[i] = 0.0f;
+			m_fOffset[i] = 0.0f;
+		}
+	};
+
+	size_t GetVertexCount() const
+	{
+		return (m_Positions.size() / 3);
+	};
+};
+
+// attribute of mesh as range of binary chunk
+struct tGlbView
+{
+	const tGlbMesh *m_pMesh;
+	tGlbAttribute m_eAttribute;
+	uint32_t m_uiOffset;
+	uint32_t m_uiLength;
+};
+
+// zero in place of infinity and NaN
+// (coordinates of broken files, not valid in JSON)
+static inline float GetFinite(const float fValue)
+{
+	return ((fValue - fValue) == 0.0f) ? fValue : 0.0f;
+}
+
+static inline float Clamp01(const float fValue)
+{
+	if (!(fValue > 0.0f))
+	{
+		return 0.0f;
+	}
+	return (fValue < 1.0f) ? fValue : 1.0f;
+}
+
+// position quantized to 16-bit integer (see WriteGlb())
+static inline int16_t QuantizePosition(const tGlbMesh &Mesh, const int iAxis, const float fValue)
+{
+	const float fQuantized = floorf((fValue - Mesh.m_fOffset[iAxis]) / Mesh.m_fScale + 0.5f);
+	if (fQuantized < -32767.0f)
+	{
+		return -32767;
+	}
+	return (int16_t)((fQuantized > 32767.0f) ? 32767.0f : fQuantized);
+}
+
+// is TXUV of layer by name with same points as polygons
+static bool IsLayerUVMap(const CLwoVertexMap *pMap, const string &szName, const CLwoPoints *pPoints)
+{
+	return (pMap->m_uiVmapTypeID == ID_TXUV
+		&& pMap->m_usDimension >= 2
+		&& pMap->m_pPointsList == pPoints
+		&& pMap->m_szName == szName);
+}
+
+// continuous TXUV (VMAP) of layer by name
+static const CLwoVertexMap *FindLayerUVMap(const CLwoLayer *pLayer, const string &szName, const CLwoPoints *pPoints)
+{
+	const tVertexMapList &Maps = pLayer->GetVertexMaps();
+	for (size_t i = 0; i < Maps.size(); i++)
+	{
+		const CLwoVertexMap *pMap = Maps[i];
+		if (pMap->IsDiscontinuous() == false
+			&& IsLayerUVMap(pMap, szName, pPoints) == true)
+		{
+			return pMap;
+		}
+	}
+	return NULL;
+}
+
+// UVs of polygon-vertices by polygon-list and (polygon-index, point):
+// all discontinuous TXUVs (VMAD) of layer by name,
+// each for the polygon-list it follows
+typedef unordered_map<uint64_t, const float*> tCornerUVs;
+typedef map<const CLwoPolygons*, tCornerUVs> tListCornerUVs;
+
+static void GetLayerCornerUVs(const CLwoLayer *pLayer, const string &szName, const CLwoPoints *pPoints, tListCornerUVs &CornerUVs)
+{
+	const tVertexMapList &Maps = pLayer->GetVertexMaps();
+	for (size_t m = 0; m < Maps.size(); m++)
+	{
+		const CLwoVertexMap *pVmad = Maps[m];
+		if (pVmad->IsDiscontinuous() == false
+			|| pVmad->m_pPolyList == NULL
+			|| IsLayerUVMap(pVmad, szName, pPoints) == false)
+		{
+			continue;
+		}
+		tCornerUVs &ListUVs = CornerUVs[pVmad->m_pPolyList];
+		ListUVs.reserve(ListUVs.size() + pVmad->m_VertexIndices.size());
+		for (size_t i = 0; i < pVmad->m_VertexIndices.size(); i++)
+		{
+			const size_t nValue = i * pVmad->m_usDimension;
+			if ((nValue +1) < pVmad->m_Values.size())
+			{
+				const uint64_t ullKey = ((uint64_t)(uint32_t)pVmad->m_PolyIndices[i] << 32) | (uint32_t)pVmad->m_VertexIndices[i];
+				ListUVs[ullKey] = &pVmad->m_Values[nValue];
+			}
+		}
+	}
+}
+
+// UV-map of layer: one used by color image-map of first surface
+// having one in this layer, otherwise first TXUV of layer
+static bool GetLayerUVName(const CLwoLayer *pLayer, const vector<tGlbPrimitive> &Primitives, string &szName)
+{
+	const tVertexMapList &Maps = pLayer->GetVertexMaps();
+	for (size_t p = 0; p < Primitives.size(); p++)
+	{
+		const CLwoSurface *pSurface = Primitives[p].m_pSurface;
+		if (pSurface == NULL)
+		{
+			continue;
+		}
+		for (size_t t = 0; t < pSurface->m_TextureLayers.size(); t++)
+		{
+			const CLwoSurface::CLwoTextureLayer &Texture = pSurface->m_TextureLayers[t];
+			if (Texture.m_uiBlokTypeID != ID_IMAP
+				|| Texture.m_uiChannel != ID_COLR
+				|| Texture.m_usEnable == 0)
+			{
+				continue;
+			}
+			for (size_t i = 0; i < Maps.size(); i++)
+			{
+				if (Maps[i]->m_uiVmapTypeID == ID_TXUV
+					&& Maps[i]->m_szName == Texture.m_szVmapName)
+				{
+					szName = Texture.m_szVmapName;
+					return true;
+				}
+			}
+		}
+	}
+	for (size_t i = 0; i < Maps.size(); i++)
+	{
+		if (Maps[i]->m_uiVmapTypeID == ID_TXUV
+			&& Maps[i]->m_usDimension >= 2)
+		{
+			szName = Maps[i]->m_szName;
+			return true;
+		}
+	}
+	return false;
+}
+
+// triangles of faces and sub-patches of layer
+static void MakeGlbMesh(const CLwoLayer *pLayer, tGlbMesh &Mesh)
+{
+	CLwoTraceScope Trace("build mesh", ID_LAYR);
+	Mesh.m_pLayer = pLayer;
+
+	tPolygonsList Lists;
+	const tPolygonsList &Polygons = pLayer->GetPolygons();
+	for (size_t l = 0; l < Polygons.size(); l++)
+	{
+		if ((Polygons[l]->m_uiPolyTypeID == ID_FACE || Polygons[l]->m_uiPolyTypeID == ID_PTCH)
+			&& Polygons[l]->m_pPointsList != NULL)
+		{
+			Lists.push_back(Polygons[l]);
+		}
+	}
+
+	// polygon-lists by their points: vertices of point are shared
+	// by polygons of all lists referring to same points
+	vector<const CLwoPoints*> PointLists;
+	vector<vector<const CLwoPolygons*> > ListsOfPoints;
+	for (size_t l = 0; l < Lists.size(); l++)
+	{
+		size_t nGroup = 0;
+		while (nGroup < PointLists.size()
+			&& PointLists[nGroup] != Lists[l]->m_pPointsList)
+		{
+			nGroup++;
+		}
+		if (nGroup == PointLists.size())
+		{
+			PointLists.push_back(Lists[l]->m_pPointsList);
+			ListsOfPoints.push_back(vector<const CLwoPolygons*>());
+		}
+		ListsOfPoints[nGroup].push_back(Lists[l]);
+	}
+
+	// valid polygons of each group with primitive of each
+	// (surfaces in order of first polygon), room for triangles of each primitive
+	struct tGlbRow
+	{
+		const CLwoPolygons *m_pPolygons;
+		uint32_t m_uiRow;
+		uint32_t m_uiPrimitive;
+	};
+	vector<vector<tGlbRow> > GroupRows(PointLists.size());
+	map<const CLwoSurface*, uint32_t> PrimitiveOf;
+	for (size_t g = 0; g < PointLists.size(); g++)
+	{
+		const long lPointCount = PointLists[g]->GetPointCount();
+		for (size_t l = 0; l < ListsOfPoints[g].size(); l++)
+		{
+			const CLwoPolygons *pPolygons = ListsOfPoints[g][l];
+			for (size_t r = 0; r < pPolygons->m_PolyList.size(); r++)
+			{
+				const CLwoPolygons::CLwoPolyRow &Row = pPolygons->m_PolyList[r];
+				if (IsValidRow(pPolygons, Row, lPointCount) == false)
+				{
+					continue;
+				}
+				map<const CLwoSurface*, uint32_t>::iterator itPrimitive = PrimitiveOf.find(Row.m_pSurface);
+				if (itPrimitive == PrimitiveOf.end())
+				{
+					tGlbPrimitive Primitive;
+					Primitive.m_pSurface = Row.m_pSurface;
+					Primitive.m_nFirstIndex = 0;
+					Primitive.m_nIndexCount = 0;
+					itPrimitive = PrimitiveOf.insert(map<const CLwoSurface*, uint32_t>::value_type(Row.m_pSurface, (uint32_t)Mesh.m_Primitives.size())).first;
+					Mesh.m_Primitives.push_back(Primitive);
+				}
+				Mesh.m_Primitives[itPrimitive->second].m_nIndexCount += (size_t)(Row.m_wVertexCount -2) * 3;
+
+				tGlbRow GlbRow;
+				GlbRow.m_pPolygons = pPolygons;
+				GlbRow.m_uiRow = (uint32_t)r;
+				GlbRow.m_uiPrimitive = itPrimitive->second;
+				GroupRows[g].push_back(GlbRow);
+			}
+		}
+	}
+
+	vector<size_t> Cursors(Mesh.m_Primitives.size());
+	size_t nIndices = 0;
+	for (size_t p = 0; p < Mesh.m_Primitives.size(); p++)
+	{
+		Mesh.m_Primitives[p].m_nFirstIndex = nIndices;
+		Cursors[p] = nIndices;
+		nIndices += Mesh.m_Primitives[p].m_nIndexCount;
+	}
+	if (nIndices == 0)
+	{
+		Mesh.m_Primitives.clear();
+		return;
+	}
+	Mesh.m_Indices.resize(nIndices);
+
+	string szUVName;
+	const bool bTexCoords = GetLayerUVName(pLayer, Mesh.m_Primitives, szUVName);
+
+	// next vertex made of same point
+	vector<uint32_t> VertexNext;
+	vector<uint32_t> Corners;
+
+	for (size_t g = 0; g < PointLists.size(); g++)
+	{
+		const CLwoPoints *pPoints = PointLists[g];
+		const size_t nPoints = (size_t)pPoints->GetPointCount();
+		const vector<tGlbRow> &Rows = GroupRows[g];
+		const size_t nRows = Rows.size();
+
+		// points in glTF axes
+		vector<float> Points(nPoints*3);
+		for (size_t i = 0; i < nPoints; i++)
+		{
+			Points[i*3] = GetFinite(pPoints->m_PointList[i*3]);
+			Points[i*3 +1] = GetFinite(pPoints->m_PointList[i*3 +1]);
+			Points[i*3 +2] = 0.0f - GetFinite(pPoints->m_PointList[i*3 +2]);
+		}
+
+		// normal of each polygon (Newell's method),
+		// sign flipped since order of vertices is reversed
+		vector<float> FaceNormals(nRows*3, 0.0f);
+		bool bSmoothing = false;
+		for (size_t r = 0; r < nRows; r++)
+		{
+			const CLwoPolygons::CLwoPolyRow &Row = Rows[r].m_pPolygons->m_PolyList[Rows[r].m_uiRow];
+			const int *piIndices = Rows[r].m_pPolygons->GetIndices(Row);
+			double dNormal[3] = {0.0, 0.0, 0.0};
+			for (unsigned short v = 0; v < Row.m_wVertexCount; v++)
+			{
+				const float *pfA = &Points[piIndices[v]*3];
+				const float *pfB = &Points[piIndices[(v +1) % Row.m_wVertexCount]*3];
+				dNormal[0] += ((double)pfA[1] - pfB[1]) * ((double)pfA[2] + pfB[2]);
+				dNormal[1] += ((double)pfA[2] - pfB[2]) * ((double)pfA[0] + pfB[0]);
+				dNormal[2] += ((double)pfA[0] - pfB[0]) * ((double)pfA[1] + pfB[1]);
+			}
+			const double dLength = sqrt(dNormal[0]*dNormal[0] + dNormal[1]*dNormal[1] + dNormal[2]*dNormal[2]);
+			if (dLength > 0.0)
+			{
+				for (int i = 0; i < 3; i++)
+				{
+					FaceNormals[r*3 +i] = (float)(-dNormal[i] / dLength);
+				}
+			}
+
+			const CLwoSurface *pSurface = Mesh.m_Primitives[Rows[r].m_uiPrimitive].m_pSurface;
+			if (pSurface != NULL
+				&& pSurface->m_fSmoothingAngle > 0.0f)
+			{
+				bSmoothing = true;
+			}
+		}
+
+		// polygons of each point for smoothing
+		vector<uint32_t> PointFirstRow;
+		vector<uint32_t> PointRows;
+		if (bSmoothing == true)
+		{
+			PointFirstRow.assign(nPoints +1, 0);
+			for (size_t r = 0; r < nRows; r++)
+			{
+				const CLwoPolygons::CLwoPolyRow &Row = Rows[r].m_pPolygons->m_PolyList[Rows[r].m_uiRow];
+				const int *piIndices = Rows[r].m_pPolygons->GetIndices(Row);
+				for (unsigned short v = 0; v < Row.m_wVertexCount; v++)
+				{
+					PointFirstRow[piIndices[v] +1]++;
+				}
+			}
+			for (size_t i = 0; i < nPoints; i++)
+			{
+				PointFirstRow[i +1] += PointFirstRow[i];
+			}
+			PointRows.resize(PointFirstRow[nPoints]);
+			vector<uint32_t> Fill(PointFirstRow.begin(), (PointFirstRow.end() -1));
+			for (size_t r = 0; r < nRows; r++)
+			{
+				const CLwoPolygons::CLwoPolyRow &Row = Rows[r].m_pPolygons->m_PolyList[Rows[r].m_uiRow];
+				const int *piIndices = Rows[r].m_pPolygons->GetIndices(Row);
+				for (unsigned short v = 0; v < Row.m_wVertexCount; v++)
+				{
+					PointRows[Fill[piIndices[v]]++] = (uint32_t)r;
+				}
+			}
+		}
+
+		// UVs of points (VMAP) and of polygon-vertices (VMAD,
+		// by index of polygon in its list)
+		const CLwoVertexMap *pVmap = (bTexCoords == true) ? FindLayerUVMap(pLayer, szUVName, pPoints) : NULL;
+		vector<float> PointUVs;
+		if (pVmap != NULL)
+		{
+			PointUVs.assign(nPoints*2, 0.0f);
+			for (size_t i = 0; i < pVmap->m_VertexIndices.size(); i++)
+			{
+				const size_t nValue = i * pVmap->m_usDimension;
+				const int iPoint = pVmap->m_VertexIndices[i];
+				if (iPoint >= 0
+					&& (size_t)iPoint < nPoints
+					&& (nValue +1) < pVmap->m_Values.size())
+				{
+					PointUVs[iPoint*2] = pVmap->m_Values[nValue];
+					PointUVs[iPoint*2 +1] = pVmap->m_Values[nValue +1];
+				}
+			}
+		}
+		tListCornerUVs CornerUVs;
+		if (bTexCoords == true)
+		{
+			GetLayerCornerUVs(pLayer, szUVName, pPoints, CornerUVs);
+		}
+
+		// vertex of corner: existing one of point when normal and UV are same
+		vector<uint32_t> PointVertex(nPoints, GLB_NONE);
+		for (size_t r = 0; r < nRows; r++)
+		{
+			const uint32_t uiPrimitive = Rows[r].m_uiPrimitive;
+			const CLwoPolygons::CLwoPolyRow &Row = Rows[r].m_pPolygons->m_PolyList[Rows[r].m_uiRow];
+			const int *piIndices = Rows[r].m_pPolygons->GetIndices(Row);
+			const CLwoSurface *pSurface = Mesh.m_Primitives[uiPrimitive].m_pSurface;
+			const bool bSmooth = (pSurface != NULL && pSurface->m_fSmoothingAngle > 0.0f);
+			const float fMinCos = (bSmooth == true) ? cosf(pSurface->m_fSmoothingAngle) : 1.0f;
+			const float *pfFaceNormal = &FaceNormals[r*3];
+			const tListCornerUVs::const_iterator itRowUVs = CornerUVs.find(Rows[r].m_pPolygons);
+
+			Corners.resize(Row.m_wVertexCount);
+			for (unsigned short v = 0; v < Row.m_wVertexCount; v++)
+			{
+				const uint32_t uiPoint = (uint32_t)piIndices[v];
+
+				// polygons of same surface within smoothing angle
+				float fNormal[3] = {pfFaceNormal[0], pfFaceNormal[1], pfFaceNormal[2]};
+				if (bSmooth == true)
+				{
+					double dSum[3] = {0.0, 0.0, 0.0};
+					for (uint32_t i = PointFirstRow[uiPoint]; i < PointFirstRow[uiPoint +1]; i++)
+					{
+						const uint32_t uiRow = PointRows[i];
+						const float *pfOther = &FaceNormals[uiRow*3];
+						if (Rows[uiRow].m_uiPrimitive == uiPrimitive
+							&& (pfFaceNormal[0]*pfOther[0] + pfFaceNormal[1]*pfOther[1] + pfFaceNormal[2]*pfOther[2]) >= fMinCos)
+						{
+							dSum[0] += pfOther[0];
+							dSum[1] += pfOther[1];
+							dSum[2] += pfOther[2];
+						}
+					}
+					const double dLength = sqrt(dSum[0]*dSum[0] + dSum[1]*dSum[1] + dSum[2]*dSum[2]);
+					if (dLength > 0.0)
+					{
+						for (int i = 0; i < 3; i++)
+						{
+							fNormal[i] = (float)(dSum[i] / dLength);
+						}
+					}
+				}
+				if (fNormal[0] == 0.0f
+					&& fNormal[1] == 0.0f
+					&& fNormal[2] == 0.0f)
+				{
+					// degenerate polygon
+					fNormal[1] = 1.0f;
+				}
+
+				float fUV[2] = {0.0f, 0.0f};
+				if (bTexCoords == true)
+				{
+					const float *pfCornerUV = NULL;
+					if (itRowUVs != CornerUVs.end())
+					{
+						tCornerUVs::const_iterator itCorner = itRowUVs->second.find(((uint64_t)Rows[r].m_uiRow << 32) | uiPoint);
+						if (itCorner != itRowUVs->second.end())
+						{
+							pfCornerUV = itCorner->second;
+						}
+					}
+					if (pfCornerUV != NULL)
+					{
+						fUV[0] = pfCornerUV[0];
+						fUV[1] = pfCornerUV[1];
+					}
+					else if (pVmap != NULL)
+					{
+						fUV[0] = PointUVs[uiPoint*2];
+						fUV[1] = PointUVs[uiPoint*2 +1];
+					}
+					fUV[0] = GetFinite(fUV[0]);
+					fUV[1] = 1.0f - GetFinite(fUV[1]);
+				}
+
+				uint32_t uiVertex = PointVertex[uiPoint];
+				while (uiVertex != GLB_NONE)
+				{
+					const float *pfNormal = &Mesh.m_Normals[uiVertex*3];
+					if (pfNormal[0] == fNormal[0]
+						&& pfNormal[1] == fNormal[1]
+						&& pfNormal[2] == fNormal[2]
+						&& (bTexCoords == false
+							|| (Mesh.m_TexCoords[uiVertex*2] == fUV[0] && Mesh.m_TexCoords[uiVertex*2 +1] == fUV[1])))
+					{
+						break;
+					}
+					uiVertex = VertexNext[uiVertex];
+				}
+				if (uiVertex == GLB_NONE)
+				{
+					uiVertex = (uint32_t)Mesh.GetVertexCount();
+					Mesh.m_Positions.insert(Mesh.m_Positions.end(), &Points[uiPoint*3], &Points[uiPoint*3] +3);
+					Mesh.m_Normals.insert(Mesh.m_Normals.end(), fNormal, fNormal +3);
+					if (bTexCoords == true)
+					{
+						Mesh.m_TexCoords.insert(Mesh.m_TexCoords.end(), fUV, fUV +2);
+					}
+					VertexNext.push_back(PointVertex[uiPoint]);
+					PointVertex[uiPoint] = uiVertex;
+				}
+				Corners[v] = uiVertex;
+			}
+
+			// fan in reversed order
+			size_t &nCursor = Cursors[uiPrimitive];
+			for (unsigned short v = 1; (v +1) < Row.m_wVertexCount; v++)
+			{
+				Mesh.m_Indices[nCursor++] = Corners[0];
+				Mesh.m_Indices[nCursor++] = Corners[v +1];
+				Mesh.m_Indices[nCursor++] = Corners[v];
+			}
+		}
+	}
+
+	// bounds of positions (required by glTF)
+	for (int i = 0; i < 3; i++)
+	{
+		Mesh.m_fMin[i] = Mesh.m_Positions[i];
+		Mesh.m_fMax[i] = Mesh.m_Positions[i];
+	}
+	for (size_t n = 0; n < Mesh.m_Positions.size(); n += 3)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			const float fValue = Mesh.m_Positions[n +i];
+			Mesh.m_fMin[i] = (fValue < Mesh.m_fMin[i]) ? fValue : Mesh.m_fMin[i];
+			Mesh.m_fMax[i] = (fValue > Mesh.m_fMax[i]) ? fValue : Mesh.m_fMax[i];
+		}
+	}
+}
+
+// JSON string in UTF-8:
+// names which are not valid UTF-8 are taken as Latin-1
+static void AppendJsonString(string &szJson, const string &szValue)
+{
+	bool bUtf8 = true;
+	for (size_t i = 0; i < szValue.size() && bUtf8 == true; i++)
+	{
+		const unsigned char c = (unsigned char)szValue[i];
+		size_t nFollowing = 0;
+		if (c >= 0xF0 && c <= 0xF4)
+		{
+			nFollowing = 3;
+		}
+		else if (c >= 0xE0 && c <= 0xEF)
+		{
+			nFollowing = 2;
+		}
+		else if (c >= 0xC2 && c <= 0xDF)
+		{
+			nFollowing = 1;
+		}
+		else if (c >= 0x80)
+		{
+			bUtf8 = false;
+		}
+		for (size_t n = 0; n < nFollowing && bUtf8 == true; n++)
+		{
+			i++;
+			bUtf8 = (i < szValue.size() && ((unsigned char)szValue[i] & 0xC0) == 0x80);
+		}
+	}
+
+	szJson += '"';
+	for (size_t i = 0; i < szValue.size(); i++)
+	{
+		const unsigned char c = (unsigned char)szValue[i];
+		if (c == '"' || c == '\\')
+		{
+			szJson += '\\';
+			szJson += (char)c;
+		}
+		else if (c < 0x20
+			|| (c >= 0x80 && bUtf8 == false))
+		{
+			char szEscape[8];
+			snprintf(szEscape, sizeof(szEscape), "\\u%04x", (unsigned int)c);
+			szJson += szEscape;
+		}
+		else
+		{
+			szJson += (char)c;
+		}
+	}
+	szJson += '"';
+}
+
+static void AppendJsonUInt(string &szJson, const uint32_t uiValue)
+{
+	char szValue[LWO_FORMAT_MAX];
+	szJson.append(szValue, LwoFormatUInt(szValue, uiValue));
+}
+
+static void AppendJsonInt(string &szJson, const int iValue)
+{
+	if (iValue < 0)
+	{
+		szJson += '-';
+	}
+	AppendJsonUInt(szJson, (uint32_t)((iValue < 0) ? -iValue : iValue));
+}
+
+static void AppendJsonFloat(string &szJson, const float fValue)
+{
+	char szValue[LWO_FORMAT_MAX];
+	szJson.append(szValue, LwoFormatFloat(szValue, GetFinite(fValue)));
+}
+
+static void AppendJsonFloats(string &szJson, const float *pfValues, const int iCount)
+{
+	szJson += '[';
+	for (int i = 0; i < iCount; i++)
+	{
+		if (i > 0)
+		{
+			szJson += ',';
+		}
+		AppendJsonFloat(szJson, pfValues[i]);
+	}
+	szJson += ']';
+}
+
+// material of surface: basic factors only (no textures)
+static void AppendJsonMaterial(string &szJson, const CLwoSurface *pSurface)
+{
+	szJson += "{\"name\":";
+	AppendJsonString(szJson, pSurface->m_szSurfaceName);
+
+	// color as albedo, opacity from transparency,
+	// reflection as metal and glossiness of specular as smoothness
+	float fBaseColor[4];
+	for (int i = 0; i < 3; i++)
+	{
+		fBaseColor[i] = Clamp01(pSurface->m_fColor[i]);
+	}
+	fBaseColor[3] = 1.0f - Clamp01(pSurface->m_fTransparency);
+	szJson += ",\"pbrMetallicRoughness\":{\"baseColorFactor\":";
+	AppendJsonFloats(szJson, fBaseColor, 4);
+	szJson += ",\"metallicFactor\":";
+	AppendJsonFloat(szJson, Clamp01(pSurface->m_fReflection));
+	szJson += ",\"roughnessFactor\":";
+	AppendJsonFloat(szJson, (pSurface->m_fSpecular > 0.0f) ? (1.0f - Clamp01(pSurface->m_fGlossiness)) : 1.0f);
+	szJson += '}';
+
+	const float fLuminosity = Clamp01(pSurface->m_fLuminosity);
+	if (fLuminosity > 0.0f)
+	{
+		const float fEmissive[3] = {fBaseColor[0]*fLuminosity, fBaseColor[1]*fLuminosity, fBaseColor[2]*fLuminosity};
+		szJson += ",\"emissiveFactor\":";
+		AppendJsonFloats(szJson, fEmissive, 3);
+	}
+	if (fBaseColor[3] < 1.0f)
+	{
+		szJson += ",\"alphaMode\":\"BLEND\"";
+	}
+	if (pSurface->m_usSidedness == 3)
+	{
+		szJson += ",\"doubleSided\":true";
+	}
+	szJson += '}';
+}
+
+static void AppendJsonView(string &szJson, const tGlbView &View, const uint32_t uiStride, const uint32_t uiTarget)
+{
+	szJson += (szJson.empty() == true) ? "{\"buffer\":0,\"byteOffset\":" : ",{\"buffer\":0,\"byteOffset\":";
+	AppendJsonUInt(szJson, View.m_uiOffset);
+	szJson += ",\"byteLength\":";
+	AppendJsonUInt(szJson, View.m_uiLength);
+	if (uiStride > 0)
+	{
+		szJson += ",\"byteStride\":";
+		AppendJsonUInt(szJson, uiStride);
+	}
+	szJson += ",\"target\":";
+	AppendJsonUInt(szJson, uiTarget);
+	szJson += '}';
+}
+
+static void AppendJsonAccessor(string &szJson, const uint32_t uiView, const uint32_t uiByteOffset, const uint32_t uiComponentType, const bool bNormalized, const size_t nCount, const char *szType)
+{
+	szJson += (szJson.empty() == true) ? "{\"bufferView\":" : ",{\"bufferView\":";
+	AppendJsonUInt(szJson, uiView);
+	if (uiByteOffset > 0)
+	{
+		szJson += ",\"byteOffset\":";
+		AppendJsonUInt(szJson, uiByteOffset);
+	}
+	szJson += ",\"componentType\":";
+	AppendJsonUInt(szJson, uiComponentType);
+	if (bNormalized == true)
+	{
+		szJson += ",\"normalized\":true";
+	}
+	szJson += ",\"count\":";
+	AppendJsonUInt(szJson, (uint32_t)nCount);
+	szJson += ",\"type\":\"";
+	szJson += szType;
+	szJson += '"';
+}
+
+// elements converted in blocks for writing
+typedef function<void(const size_t nFirst, const size_t nCount, char *pOut)> tConvertBlock;
+static bool WriteConverted(FILE *pFile, const size_t nElements, const size_t nElementSize, tConvertBlock Convert)
+{
+	vector<char> Staging(LWO_EXPORT_BLOCK_SIZE * nElementSize);
+	for (size_t nFirst = 0; nFirst < nElements; nFirst += LWO_EXPORT_BLOCK_SIZE)
+	{
+		const size_t nCount = ((nElements - nFirst) < LWO_EXPORT_BLOCK_SIZE) ? (nElements - nFirst) : LWO_EXPORT_BLOCK_SIZE;
+		Convert(nFirst, nCount, Staging.data());
+		if (fwrite(Staging.data(), nCount * nElementSize, 1, pFile) != 1)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// attribute of mesh as in file
+static bool WriteGlbView(FILE *pFile, const tGlbView &View, const bool bQuantize)
+{
+	CLwoTraceScope Trace("write", 0, View.m_uiLength);
+	const tGlbMesh &Mesh = *View.m_pMesh;
+	const size_t nVertices = Mesh.GetVertexCount();
+
+	switch (View.m_eAttribute)
+	{
+	case GLB_POSITION:
+		if (bQuantize == false)
+		{
+			return (fwrite(Mesh.m_Positions.data(), View.m_uiLength, 1, pFile) == 1);
+		}
+		return WriteConverted(pFile, nVertices, 8, [&Mesh](const size_t nFirst, const size_t nCount, char *pOut)
+		{
+			int16_t *psOut = (int16_t*)pOut;
+			for (size_t n = nFirst; n < (nFirst + nCount); n++)
+			{
+				for (int i = 0; i < 3; i++)
+				{
+					*psOut++ = QuantizePosition(Mesh, i, Mesh.m_Positions[n*3 +i]);
+				}
+				*psOut++ = 0;
+			}
+		});
+
+	case GLB_NORMAL:
+		if (bQuantize == false)
+		{
+			return (fwrite(Mesh.m_Normals.data(), View.m_uiLength, 1, pFile) == 1);
+		}
+		return WriteConverted(pFile, nVertices, 4, [&Mesh](const size_t nFirst, const size_t nCount, char *pOut)
+		{
+			for (size_t n = nFirst; n < (nFirst + nCount); n++)
+			{
+				for (int i = 0; i < 3; i++)
+				{
+					*pOut++ = (char)(int8_t)floorf(Mesh.m_Normals[n*3 +i] * 127.0f + 0.5f);
+				}
+				*pOut++ = 0;
+			}
+		});
+
+	case GLB_TEXCOORD:
+		if (Mesh.m_bShortTexCoords == false)
+		{
+			return (fwrite(Mesh.m_TexCoords.data(), View.m_uiLength, 1, pFile) == 1);
+		}
+		return WriteConverted(pFile, nVertices*2, 2, [&Mesh](const size_t nFirst, const size_t nCount, char *pOut)
+		{
+			uint16_t *pusOut = (uint16_t*)pOut;
+			for (size_t n = nFirst; n < (nFirst + nCount); n++)
+			{
+				*pusOut++ = (uint16_t)floorf(Mesh.m_TexCoords[n] * 65535.0f + 0.5f);
+			}
+		});
+
+	case GLB_INDICES:
+		if (Mesh.m_uiIndexSize == 4)
+		{
+			return (fwrite(Mesh.m_Indices.data(), View.m_uiLength, 1, pFile) == 1);
+		}
+		return WriteConverted(pFile, Mesh.m_Indices.size(), 2, [&Mesh](const size_t nFirst, const size_t nCount, char *pOut)
+		{
+			uint16_t *pusOut = (uint16_t*)pOut;
+			for (size_t n = nFirst; n < (nFirst + nCount); n++)
+			{
+				*pusOut++ = (uint16_t)Mesh.m_Indices[n];
+			}
+		});
+	}
+	return false;
+}
+
+bool CLwoExporter::WriteGlb(const CLwoObjectData &Object, const char *szPath, const bool bQuantize)
+{
+	CLwoTraceScope Trace("export glb", 0, 0, szPath);
+
+	// mesh of each layer on pool
+	const tLayerList &Layers = Object.GetLayers();
+	vector<tGlbMesh> vMeshes(Layers.size());
+	for (size_t l = 0; l < Layers.size(); l++)
+	{
+		m_Pool.Submit([&Layers, &vMeshes, l]()
+		{
+			MakeGlbMesh(Layers[l], vMeshes[l]);
+		});
+	}
+	m_Pool.WaitIdle();
+
+	// views of binary chunk at 4-byte boundaries:
+	// quantized positions and normals padded to 4-byte elements
+	vector<tGlbView> vViews;
+	uint64_t ullBinSize = 0;
+	for (size_t m = 0; m < vMeshes.size(); m++)
+	{
+		tGlbMesh &Mesh = vMeshes[m];
+		if (Mesh.m_Indices.empty() == true)
+		{
+			continue;
+		}
+		const size_t nVertices = Mesh.GetVertexCount();
+
+		// largest value of type is restart of primitive (not allowed)
+		Mesh.m_uiIndexSize = (nVertices < 0xFFFF) ? 2 : 4;
+
+		// 16-bit positions around center, same scale on all axes
+		// (node's scale keeps normals as they are)
+		if (bQuantize == true)
+		{
+			float fHalf = 0.0f;
+			for (int i = 0; i < 3; i++)
+			{
+				Mesh.m_fOffset[i] = (Mesh.m_fMin[i] + Mesh.m_fMax[i]) * 0.5f;
+				fHalf = (((Mesh.m_fMax[i] - Mesh.m_fMin[i]) * 0.5f) > fHalf) ? ((Mesh.m_fMax[i] - Mesh.m_fMin[i]) * 0.5f) : fHalf;
+			}
+			Mesh.m_fScale = (fHalf > 0.0f && (fHalf - fHalf) == 0.0f) ? (fHalf / 32767.0f) : 1.0f;
+
+			Mesh.m_bShortTexCoords = (Mesh.m_TexCoords.empty() == false);
+			for (size_t n = 0; n < Mesh.m_TexCoords.size() && Mesh.m_bShortTexCoords == true; n++)
+			{
+				Mesh.m_bShortTexCoords = (Mesh.m_TexCoords[n] >= 0.0f && Mesh.m_TexCoords[n] <= 1.0f);
+			}
+		}
+
+		const uint64_t ullLengths[4] =
+		{
+			nVertices * ((bQuantize == true) ? 8 : 12),
+			nVertices * ((bQuantize == true) ? 4 : 12),
+			nVertices * ((Mesh.m_TexCoords.empty() == true) ? 0 : ((Mesh.m_bShortTexCoords == true) ? 4 : 8)),
+			(uint64_t)Mesh.m_Indices.size() * Mesh.m_uiIndexSize
+		};
+		for (int a = GLB_POSITION; a <= GLB_INDICES; a++)
+		{
+			if (ullLengths[a] == 0)
+			{
+				continue;
+			}
+			tGlbView View;
+			View.m_pMesh = &Mesh;
+			View.m_eAttribute = (tGlbAttribute)a;
+			View.m_uiOffset = (uint32_t)ullBinSize;
+			View.m_uiLength = (uint32_t)ullLengths[a];
+			vViews.push_back(View);
+			ullBinSize += ((ullLengths[a] +3) & ~3ULL);
+			if (ullBinSize > 0xF0000000ULL)
+			{
+				// GLB has 32-bit sizes
+				return false;
+			}
+		}
+	}
+
+	// JSON by parts: nodes, meshes, materials, accessors and views
+	string szNodes, szMeshes, szMaterials, szAccessors, szViews;
+	map<const CLwoSurface*, uint32_t> MaterialOf;
+	uint32_t uiMeshes = 0;
+	uint32_t uiAccessors = 0;
+	size_t nView = 0;
+	for (size_t m = 0; m < vMeshes.size(); m++)
+	{
+		tGlbMesh &Mesh = vMeshes[m];
+		if (Mesh.m_Indices.empty() == true)
+		{
+			continue;
+		}
+		const size_t nVertices = Mesh.GetVertexCount();
+		const bool bTexCoords = (Mesh.m_TexCoords.empty() == false);
+
+		// layer name or number
+		string szName = Mesh.m_pLayer->m_szLayerName;
+		if (szName.empty() == true)
+		{
+			char szNumber[LWO_FORMAT_MAX];
+			szName = "layer" + string(szNumber, LwoFormatUInt(szNumber, Mesh.m_pLayer->m_usLayerNumber));
+		}
+
+		szNodes += (uiMeshes == 0) ? "{\"name\":" : ",{\"name\":";
+		AppendJsonString(szNodes, szName);
+		szNodes += ",\"mesh\":";
+		AppendJsonUInt(szNodes, uiMeshes);
+		if (bQuantize == true)
+		{
+			const float fScale[3] = {Mesh.m_fScale, Mesh.m_fScale, Mesh.m_fScale};
+			szNodes += ",\"translation\":";
+			AppendJsonFloats(szNodes, Mesh.m_fOffset, 3);
+			szNodes += ",\"scale\":";
+			AppendJsonFloats(szNodes, fScale, 3);
+		}
+		szNodes += '}';
+
+		// vertex attributes
+		Mesh.m_uiFirstAccessor = uiAccessors;
+		uiAccessors += (bTexCoords == true) ? 3 : 2;
+		AppendJsonView(szViews, vViews[nView], (bQuantize == true) ? 8 : 0, GLTF_ARRAY_BUFFER);
+		AppendJsonAccessor(szAccessors, (uint32_t)nView++, 0, (bQuantize == true) ? GLTF_SHORT : GLTF_FLOAT, false, nVertices, "VEC3");
+		if (bQuantize == true)
+		{
+			szAccessors += ",\"min\":[";
+			for (int i = 0; i < 3; i++)
+			{
+				szAccessors += (i > 0) ? "," : "";
+				AppendJsonInt(szAccessors, QuantizePosition(Mesh, i, Mesh.m_fMin[i]));
+			}
+			szAccessors += "],\"max\":[";
+			for (int i = 0; i < 3; i++)
+			{
+				szAccessors += (i > 0) ? "," : "";
+				AppendJsonInt(szAccessors, QuantizePosition(Mesh, i, Mesh.m_fMax[i]));
+			}
+			szAccessors += "]}";
+		}
+		else
+		{
+			szAccessors += ",\"min\":";
+			AppendJsonFloats(szAccessors, Mesh.m_fMin, 3);
+			szAccessors += ",\"max\":";
+			AppendJsonFloats(szAccessors, Mesh.m_fMax, 3);
+			szAccessors += '}';
+		}
+
+		AppendJsonView(szViews, vViews[nView], (bQuantize == true) ? 4 : 0, GLTF_ARRAY_BUFFER);
+		AppendJsonAccessor(szAccessors, (uint32_t)nView++, 0, (bQuantize == true) ? GLTF_BYTE : GLTF_FLOAT, bQuantize, nVertices, "VEC3");
+		szAccessors += '}';
+
+		if (bTexCoords == true)
+		{
+			AppendJsonView(szViews, vViews[nView], 0, GLTF_ARRAY_BUFFER);
+			AppendJsonAccessor(szAccessors, (uint32_t)nView++, 0, (Mesh.m_bShortTexCoords == true) ? GLTF_UNSIGNED_SHORT : GLTF_FLOAT, Mesh.m_bShortTexCoords, nVertices, "VEC2");
+			szAccessors += '}';
+		}
+
+		// primitive of each surface: range of same index view
+		const uint32_t uiIndexView = (uint32_t)nView;
+		AppendJsonView(szViews, vViews[nView++], 0, GLTF_ELEMENT_ARRAY_BUFFER);
+
+		szMeshes += (uiMeshes == 0) ? "{\"name\":" : ",{\"name\":";
+		AppendJsonString(szMeshes, szName);
+		szMeshes += ",\"primitives\":[";
+		for (size_t p = 0; p < Mesh.m_Primitives.size(); p++)
+		{
+			const tGlbPrimitive &Primitive = Mesh.m_Primitives[p];
+			szMeshes += (p == 0) ? "{\"attributes\":{\"POSITION\":" : ",{\"attributes\":{\"POSITION\":";
+			AppendJsonUInt(szMeshes, Mesh.m_uiFirstAccessor);
+			szMeshes += ",\"NORMAL\":";
+			AppendJsonUInt(szMeshes, Mesh.m_uiFirstAccessor +1);
+			if (bTexCoords == true)
+			{
+				szMeshes += ",\"TEXCOORD_0\":";
+				AppendJsonUInt(szMeshes, Mesh.m_uiFirstAccessor +2);
+			}
+			szMeshes += "},\"indices\":";
+			AppendJsonUInt(szMeshes, uiAccessors);
+			AppendJsonAccessor(szAccessors, uiIndexView, (uint32_t)(Primitive.m_nFirstIndex * Mesh.m_uiIndexSize),
+				(Mesh.m_uiIndexSize == 2) ? GLTF_UNSIGNED_SHORT : GLTF_UNSIGNED_INT, false, Primitive.m_nIndexCount, "SCALAR");
+			szAccessors += '}';
+			uiAccessors++;
+
+			if (Primitive.m_pSurface != NULL)
+			{
+				map<const CLwoSurface*, uint32_t>::iterator itMaterial = MaterialOf.find(Primitive.m_pSurface);
+				if (itMaterial == MaterialOf.end())
+				{
+					itMaterial = MaterialOf.insert(map<const CLwoSurface*, uint32_t>::value_type(Primitive.m_pSurface, (uint32_t)MaterialOf.size())).first;
+					szMaterials += (itMaterial->second == 0) ? "" : ",";
+					AppendJsonMaterial(szMaterials, Primitive.m_pSurface);
+				}
+				szMeshes += ",\"material\":";
+				AppendJsonUInt(szMeshes, itMaterial->second);
+			}
+			szMeshes += '}';
+		}
+		szMeshes += "]}";
+		uiMeshes++;
+	}
+
+	// arrays are left out when empty (not allowed by glTF)
+	string szJson = "{\"asset\":{\"version\":\"2.0\",\"generator\":\"LWO_reader\"}";
+	if (bQuantize == true
+		&& uiMeshes > 0)
+	{
+		szJson += ",\"extensionsUsed\":[\"KHR_mesh_quantization\"],\"extensionsRequired\":[\"KHR_mesh_quantization\"]";
+	}
+	szJson += ",\"scene\":0,\"scenes\":[{";
+	if (uiMeshes > 0)
+	{
+		szJson += "\"nodes\":[";
+		for (uint32_t n = 0; n < uiMeshes; n++)
+		{
+			szJson += (n > 0) ? "," : "";
+			AppendJsonUInt(szJson, n);
+		}
+		szJson += "]";
+	}
+	szJson += "}]";
+	if (uiMeshes > 0)
+	{
+		szJson += ",\"nodes\":[" + szNodes + "],\"meshes\":[" + szMeshes + "]";
+		if (szMaterials.empty() == false)
+		{
+			szJson += ",\"materials\":[" + szMaterials + "]";
+		}
+		szJson += ",\"accessors\":[" + szAccessors + "],\"bufferViews\":[" + szViews + "]";
+		szJson += ",\"buffers\":[{\"byteLength\":";
+		AppendJsonUInt(szJson, (uint32_t)ullBinSize);
+		szJson += "}]";
+	}
+	szJson += "}";
+
+	// chunks padded to 4 bytes: JSON with spaces, binary with zeros
+	while ((szJson.size() % 4) != 0)
+	{
+		szJson += ' ';
+	}
+	const uint64_t ullTotal = 12 + 8 + szJson.size() + ((ullBinSize > 0) ? (8 + ullBinSize) : 0);
+	if (ullTotal > 0xFFFFFFFFULL)
+	{
+		return false;
+	}
+
+	FILE *pFile = fopen(szPath, "wb");
+	if (pFile == NULL)
+	{
+		return false;
+	}
+	setvbuf(pFile, NULL, _IOFBF, LWO_EXPORT_FILE_BUFFER);
+
+	const uint32_t uiHeader[5] = {GLB_MAGIC, 2, (uint32_t)ullTotal, (uint32_t)szJson.size(), GLB_CHUNK_JSON};
+	bool bRet = (fwrite(uiHeader, sizeof(uiHeader), 1, pFile) == 1
+		&& fwrite(szJson.data(), szJson.size(), 1, pFile) == 1);
+	if (bRet == true
+		&& ullBinSize > 0)
+	{
+		const uint32_t uiBinHeader[2] = {(uint32_t)ullBinSize, GLB_CHUNK_BIN};
+		bRet = (fwrite(uiBinHeader, sizeof(uiBinHeader), 1, pFile) == 1);
+
+		const char szPadding[4] = {0, 0, 0, 0};
+		for (size_t v = 0; v < vViews.size() && bRet == true; v++)
+		{
+			const size_t nPadding = (4 - (vViews[v].m_uiLength % 4)) % 4;
+			bRet = (WriteGlbView(pFile, vViews[v], bQuantize) == true
+				&& (nPadding == 0 || fwrite(szPadding, nPadding, 1, pFile) == 1));
+		}
+	}
+
+	if (fclose(pFile) != 0)
+	{
+		bRet = false;
+	}
+	if (bRet == false)
+	{
+		remove(szPath);
+	}
+	return bRet;
+}
@@ -0,0 +1,119 @@
+//////////////////////////////////////////////////////////////////////
+// LwoExport.h : writing parsed objects as Wavefront OBJ, PLY and GLB
+//
+// Geometry is written straight from points and polygons of layers
+// (no intermediate mesh): points of all layers in order of layers,
+// then polygons (FACE and PTCH) referring to them.
+// Polygons with less than three vertices or indices outside
+// of their points are left out.
+//
+// Text is formatted by hand (see LwoFormatFloat()) in blocks
+// on pool of threads, blocks are written in order
+// with few of them in memory at a time.
+// Binary PLY is in byte-order of this machine:
+// points are written directly from object without copying.
+//
+// Header of PLY is written once with counts from layout
+// (polygons which are left out are not counted),
+// output need not be seekable (file is removed when writing fails).
+//
+// glTF 2.0 binary (GLB) has a mesh for each layer (built on pool):
+// polygons are triangulated as fans, vertices are split by normal
+// (smoothed within smoothing angle of surface) and by UV
+// (TXUV of surface's image-map or first of layer, VMADs of each
+// polygon-list over VMAP).
+// Each surface is a primitive with basic PBR factors as material.
+// Axes are converted to glTF (Z negated, winding reversed).
+// JSON is written as text and each attribute as one aligned view of
+// the binary chunk (floats directly from the meshes, little-endian
+// as assumed by reader), optionally quantized (KHR_mesh_quantization).
+//
+
+#ifndef _LWOEXPORT_H_
+#define _LWOEXPORT_H_
+
+#include "LwoObjectData.h"
+#include "LwoThreadPool.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <functional>
+#include <vector>
+using namespace std;
+
+// bytes enough for any value from formatting below
+#define LWO_FORMAT_MAX 24
+
+// shortest decimal (at most 9 significant digits)
+// which reads back as same float, without terminating NULL:
+// returns end of written characters
+char *LwoFormatFloat(char *pOut, const float fValue);
+
+// decimal digits of value, returns end of written characters
+char *LwoFormatUInt(char *pOut, uint32_t uiValue);
+
+class CLwoExporter
+{
+protected:
+	CLwoThreadPool m_Pool;
+
+	// range of points or polygons formatted as one block
+	struct tExportBlock
+	{
+		// CLwoPoints or CLwoPolygons
+		const CLwoChunk *m_pChunk;
+		size_t m_nFirst;
+		size_t m_nCount;
+
+		// index of first point of polygons in output
+		uint32_t m_uiPointBase;
+
+		// name of layer before polygons (OBJ), NULL when none
+		const CLwoLayer *m_pLayer;
+	};
+
+	// counts of object in output
+	struct tExportLayout
+	{
+		vector<tExportBlock> m_PointBlocks;
+		vector<tExportBlock> m_PolygonBlocks;
+		uint32_t m_uiPointCount;
+
+		// polygons which are written (see IsValidRow())
+		uint64_t m_ullPolygonCount;
+
+		// polygons exceed 255 vertices (PLY: 16-bit counts)
+		bool m_bLargePolygons;
+	};
+
+	// points and polygons in blocks of output
+	bool MakeLayout(const CLwoObjectData &Object, tExportLayout &Layout) const;
+
+	// format each block on pool and write in order:
+	// returns false when writing fails.
+	// count of each block (e.g. polygons written) is added to ullCount
+	typedef function<void(const tExportBlock &Block, vector<char> &Buffer, uint64_t &ullCount)> tFormatBlock;
+	bool WriteBlocks(FILE *pFile, const vector<tExportBlock> &Blocks, tFormatBlock Format, uint64_t &ullCount);
+
+	// header of PLY with counts of layout
+	bool WritePlyHeader(FILE *pFile, const bool bBinary, const tExportLayout &Layout);
+
+public:
+	// zero threads: amount of hardware threads
+	CLwoExporter(const size_t nThreads = 0);
+	~CLwoExporter(void);
+
+	// text with "o" for each layer and "usemtl" for surfaces
+	bool WriteObj(const CLwoObjectData &Object, const char *szPath);
+
+	// binary (native byte-order) or text PLY:
+	// vertex x, y, z and list of vertex_indices of faces
+	bool WritePly(const CLwoObjectData &Object, const char *szPath, const bool bBinary = true);
+
+	// single .glb file, quantized: positions as 16-bit integers
+	// (placed by node), 8-bit normals and 16-bit UVs when within 0..1
+	bool WriteGlb(const CLwoObjectData &Object, const char *szPath, const bool bQuantize = false);
+};
+
+#endif // ifndef _LWOEXPORT_H_
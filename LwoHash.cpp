@@ -0,0 +1,184 @@
+//////////////////////////////////////////////////////////////////////
+// LwoHash.cpp : fast 64-bit content hash (xxHash64)
+//
+// Same results as reference implementation of xxHash64
+// (little-endian reading of input on all platforms).
+//
+
+#include "LwoHash.h"
+
+// memcpy()
+#include <cstring>
+
+static const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+static const uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t RotL64(const uint64_t ullValue, const int iBits)
+{
+	return ((ullValue << iBits) | (ullValue >> (64 - iBits)));
+}
+
+// unaligned little-endian reads
+static inline uint64_t Read64(const unsigned char *pData)
+{
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+	uint64_t ullValue = 0;
+	for (int i = 7; i >= 0; i--)
+	{
+		ullValue = (ullValue << 8) | pData[i];
+	}
+	return ullValue;
+#else
+	uint64_t ullValue;
+	memcpy(&ullValue, pData, sizeof(ullValue));
+	return ullValue;
+#endif
+}
+
+static inline uint32_t Read32(const unsigned char *pData)
+{
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+	return ((uint32_t)pData[0] | ((uint32_t)pData[1] << 8) | ((uint32_t)pData[2] << 16) | ((uint32_t)pData[3] << 24));
+#else
+	uint32_t uiValue;
+	memcpy(&uiValue, pData, sizeof(uiValue));
+	return uiValue;
+#endif
+}
+
+static inline uint64_t Round(uint64_t ullAcc, const uint64_t ullInput)
+{
+	ullAcc += ullInput * PRIME64_2;
+	ullAcc = RotL64(ullAcc, 31);
+	ullAcc *= PRIME64_1;
+	return ullAcc;
+}
+
+static inline uint64_t MergeRound(uint64_t ullAcc, const uint64_t ullValue)
+{
+	ullAcc ^= Round(0, ullValue);
+	ullAcc = ullAcc * PRIME64_1 + PRIME64_4;
+	return ullAcc;
+}
+
+CLwoHash64::CLwoHash64(const uint64_t ullSeed)
+{
+	Reset(ullSeed);
+}
+
+void CLwoHash64::Reset(const uint64_t ullSeed)
+{
+	m_ullSeed = ullSeed;
+	m_ullAcc[0] = ullSeed + PRIME64_1 + PRIME64_2;
+	m_ullAcc[1] = ullSeed + PRIME64_2;
+	m_ullAcc[2] = ullSeed;
+	m_ullAcc[3] = ullSeed - PRIME64_1;
+	m_ullTotalSize = 0;
+	m_nBufferSize = 0;
+}
+
+void CLwoHash64::Update(const void *pData, const size_t nSize)
+{
+	const unsigned char *pPos = (const unsigned char*)pData;
+	const unsigned char *pEnd = (pPos + nSize);
+
+	m_ullTotalSize += nSize;
+
+	// fill partial stripe first
+	if (m_nBufferSize > 0)
+	{
+		size_t nFill = (32 - m_nBufferSize);
+		if (nFill > nSize)
+		{
+			nFill = nSize;
+		}
+		memcpy(m_ucBuffer + m_nBufferSize, pPos, nFill);
+		m_nBufferSize += nFill;
+		pPos = (pPos + nFill);
+
+		if (m_nBufferSize < 32)
+		{
+			return;
+		}
+		for (int i = 0; i < 4; i++)
+		{
+			m_ullAcc[i] = Round(m_ullAcc[i], Read64(m_ucBuffer + i*8));
+		}
+		m_nBufferSize = 0;
+	}
+
+	// full stripes directly from input
+	while ((pEnd - pPos) >= 32)
+	{
+		m_ullAcc[0] = Round(m_ullAcc[0], Read64(pPos));
+		m_ullAcc[1] = Round(m_ullAcc[1], Read64(pPos +8));
+		m_ullAcc[2] = Round(m_ullAcc[2], Read64(pPos +16));
+		m_ullAcc[3] = Round(m_ullAcc[3], Read64(pPos +24));
+		pPos = (pPos +32);
+	}
+
+	// keep remaining for next update
+	if (pPos < pEnd)
+	{
+		m_nBufferSize = (size_t)(pEnd - pPos);
+		memcpy(m_ucBuffer, pPos, m_nBufferSize);
+	}
+}
+
+uint64_t CLwoHash64::Digest() const
+{
+	uint64_t ullHash = 0;
+	if (m_ullTotalSize >= 32)
+	{
+		ullHash = RotL64(m_ullAcc[0], 1) + RotL64(m_ullAcc[1], 7) + RotL64(m_ullAcc[2], 12) + RotL64(m_ullAcc[3], 18);
+		for (int i = 0; i < 4; i++)
+		{
+			ullHash = MergeRound(ullHash, m_ullAcc[i]);
+		}
+	}
+	else
+	{
+		ullHash = m_ullSeed + PRIME64_5;
+	}
+	ullHash += m_ullTotalSize;
+
+	// remaining bytes of last partial stripe
+	const unsigned char *pPos = m_ucBuffer;
+	const unsigned char *pEnd = (m_ucBuffer + m_nBufferSize);
+	while ((pEnd - pPos) >= 8)
+	{
+		ullHash ^= Round(0, Read64(pPos));
+		ullHash = RotL64(ullHash, 27) * PRIME64_1 + PRIME64_4;
+		pPos = (pPos +8);
+	}
+	if ((pEnd - pPos) >= 4)
+	{
+		ullHash ^= (uint64_t)Read32(pPos) * PRIME64_1;
+		ullHash = RotL64(ullHash, 23) * PRIME64_2 + PRIME64_3;
+		pPos = (pPos +4);
+	}
+	while (pPos < pEnd)
+	{
+		ullHash ^= (*pPos) * PRIME64_5;
+		ullHash = RotL64(ullHash, 11) * PRIME64_1;
+		pPos++;
+	}
+
+	// final mixing
+	ullHash ^= ullHash >> 33;
+	ullHash *= PRIME64_2;
+	ullHash ^= ullHash >> 29;
+	ullHash *= PRIME64_3;
+	ullHash ^= ullHash >> 32;
+	return ullHash;
+}
+
+uint64_t CLwoHash64::Hash(const void *pData, const size_t nSize, const uint64_t ullSeed)
+{
+	CLwoHash64 Hash(ullSeed);
+	Hash.Update(pData, nSize);
+	return Hash.Digest();
+}
@@ -0,0 +1,45 @@
+//////////////////////////////////////////////////////////////////////
+// LwoHash.h : fast 64-bit content hash (xxHash64)
+//
+// Used to identify source files by content
+// (e.g. pre-baked files and caches):
+// data can be given in pieces as it is read.
+//
+
+#ifndef _LWOHASH_H_
+#define _LWOHASH_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+class CLwoHash64
+{
+protected:
+	// accumulators of 32-byte stripes
+	uint64_t m_ullAcc[4];
+	uint64_t m_ullSeed;
+
+	// total amount of data given
+	uint64_t m_ullTotalSize;
+
+	// partial stripe kept between updates
+	unsigned char m_ucBuffer[32];
+	size_t m_nBufferSize;
+
+public:
+	CLwoHash64(const uint64_t ullSeed = 0);
+
+	// start new hash
+	void Reset(const uint64_t ullSeed = 0);
+
+	// add data to hash
+	void Update(const void *pData, const size_t nSize);
+
+	// hash of data given so far
+	uint64_t Digest() const;
+
+	// hash of single buffer
+	static uint64_t Hash(const void *pData, const size_t nSize, const uint64_t ullSeed = 0);
+};
+
+#endif // ifndef _LWOHASH_H_
@@ -0,0 +1,275 @@
+//////////////////////////////////////////////////////////////////////
+// LwoImageResolver.cpp : shared image references of loaded objects
+//
+
+#include "LwoImageResolver.h"
+
+// tolower(), toupper()
+#include <cctype>
+
+// sprintf()
+#include <cstdio>
+
+
+CLwoImageResolver::CLwoImageResolver(const bool bIgnoreCase)
+	: m_Textures()
+	, m_KeyToTexture()
+	, m_Objects()
+	, m_bIgnoreCase(bIgnoreCase)
+{
+}
+
+CLwoImageResolver::~CLwoImageResolver(void)
+{
+	Clear();
+}
+
+void CLwoImageResolver::Clear()
+{
+	m_Textures.clear();
+	m_KeyToTexture.clear();
+	m_Objects.clear();
+}
+
+// platform-neutral form of LWO (also Windows drive):
+// "Device:path", device is name before first ':' (no separator in it),
+// returns length of "Device:" or zero when none
+size_t CLwoImageResolver::GetDeviceLength(const string &szPath)
+{
+	size_t nColon = szPath.find(':');
+	if (nColon == string::npos
+		|| nColon == 0)
+	{
+		return 0;
+	}
+	if (szPath.find('/') < nColon)
+	{
+		return 0;
+	}
+	return (nColon +1);
+}
+
+string CLwoImageResolver::CanonicalizePath(const string &szPath, const string &szBaseDir) const
+{
+	string szFull = szPath;
+
+	// same separator for all
+	for (size_t i = 0; i < szFull.length(); i++)
+	{
+		if (szFull[i] == '\\')
+		{
+			szFull[i] = '/';
+		}
+	}
+
+	// absolute: "/path", "//server/path" or "Device:path",
+	// otherwise relative to base directory
+	size_t nDevice = GetDeviceLength(szFull);
+	bool bAbsolute = (nDevice > 0 || (szFull.empty() == false && szFull[0] == '/'));
+	if (bAbsolute == false
+		&& szBaseDir.empty() == false)
+	{
+		string szBase = CanonicalizePath(szBaseDir, string());
+		if (szBase.empty() == false
+			&& szBase[szBase.length() -1] != '/')
+		{
+			szBase += '/';
+		}
+		szFull = szBase + szFull;
+		nDevice = GetDeviceLength(szFull);
+	}
+
+	// keep root part as-is:
+	// device is always root of its path ("C:Images/x.tga" is "C:/Images/x.tga"),
+	// drive letter in upper case
+	string szRoot;
+	size_t nPos = 0;
+	if (nDevice > 0)
+	{
+		szRoot = szFull.substr(0, nDevice);
+		if (nDevice == 2)
+		{
+			szRoot[0] = (char)toupper((unsigned char)szRoot[0]);
+		}
+		szRoot += '/';
+		nPos = nDevice;
+	}
+	else if (nPos < szFull.length()
+		&& szFull[nPos] == '/')
+	{
+		// network path keeps double separator
+		if (szFull.length() > 1
+			&& szFull[1] == '/')
+		{
+			szRoot += '/';
+			nPos++;
+		}
+		szRoot += '/';
+		nPos++;
+	}
+	bool bRooted = (szRoot.empty() == false && szRoot[szRoot.length() -1] == '/');
+
+	// remove empty and "." parts, resolve ".." parts
+	vector<string> vParts;
+	while (nPos <= szFull.length())
+	{
+		size_t nNext = szFull.find('/', nPos);
+		if (nNext == string::npos)
+		{
+			nNext = szFull.length();
+		}
+		string szPart = szFull.substr(nPos, nNext - nPos);
+		nPos = nNext +1;
+
+		if (szPart.empty() == true
+			|| szPart == ".")
+		{
+			continue;
+		}
+		if (szPart == "..")
+		{
+			if (vParts.empty() == false
+				&& vParts.back() != "..")
+			{
+				vParts.pop_back();
+			}
+			else if (bRooted == false)
+			{
+				// relative path above start: keep it
+				vParts.push_back(szPart);
+			}
+			continue;
+		}
+		vParts.push_back(szPart);
+	}
+
+	string szCanonical = szRoot;
+	for (size_t i = 0; i < vParts.size(); i++)
+	{
+		if (i > 0)
+		{
+			szCanonical += '/';
+		}
+		szCanonical += vParts[i];
+	}
+
+	if (m_bIgnoreCase == true)
+	{
+		for (size_t i = 0; i < szCanonical.length(); i++)
+		{
+			szCanonical[i] = (char)tolower((unsigned char)szCanonical[i]);
+		}
+	}
+	return szCanonical;
+}
+
+// XREF refers to another clip of same object by index,
+// that may be reference also
+const CLwoClip *CLwoImageResolver::ResolveXref(const CLwoClip *pClip, const map<unsigned int, const CLwoClip*> &mapClips) const
+{
+	// guard against loops in references:
+	// chain can't be longer than amount of clips
+	size_t nDepth = 0;
+	while (pClip != NULL
+		&& pClip->m_uiClipTypeID == ID_XREF)
+	{
+		if (nDepth > mapClips.size())
+		{
+			return NULL;
+		}
+		map<unsigned int, const CLwoClip*>::const_iterator itClip = mapClips.find(pClip->m_uiXrefIndex);
+		if (itClip == mapClips.end())
+		{
+			return NULL;
+		}
+		pClip = itClip->second;
+		nDepth++;
+	}
+	return pClip;
+}
+
+unsigned int CLwoImageResolver::GetOrAddTexture(const CLwoClip *pClip, const string &szBaseDir)
+{
+	if (pClip == NULL
+		|| pClip->m_szFilename.empty() == true)
+	{
+		return NO_TEXTURE;
+	}
+
+	string szPath = CanonicalizePath(pClip->m_szFilename, szBaseDir);
+
+	// identity of image source:
+	// type, path and what else selects the image files
+	string szKey;
+	char szTmp[128];
+	switch (pClip->m_uiClipTypeID)
+	{
+	case ID_ISEQ:
+		sprintf(szTmp, "ISEQ|%u|%d|%d|%d|", (unsigned int)pClip->m_ucSeqDigits, (int)pClip->m_sSeqOffset, (int)pClip->m_sSeqStart, (int)pClip->m_sSeqEnd);
+		szKey = szTmp + szPath + "|" + pClip->m_szSeqSuffix;
+		break;
+	case ID_ANIM:
+		szKey = "ANIM|" + pClip->m_szServerName + "|" + szPath;
+		break;
+	case ID_STCC:
+		sprintf(szTmp, "STCC|%d|%d|", (int)pClip->m_sCycleLow, (int)pClip->m_sCycleHigh);
+		szKey = szTmp + szPath;
+		break;
+	default:
+		// still image
+		szKey = "STIL|" + szPath;
+		break;
+	}
+
+	map<string, unsigned int>::iterator itTexture = m_KeyToTexture.find(szKey);
+	if (itTexture != m_KeyToTexture.end())
+	{
+		m_Textures[itTexture->second].m_uiRefCount++;
+		return itTexture->second;
+	}
+
+	unsigned int uiTextureId = (unsigned int)m_Textures.size();
+	m_Textures.push_back(CLwoTextureRef(*pClip, szPath));
+	m_KeyToTexture.insert(map<string, unsigned int>::value_type(szKey, uiTextureId));
+	return uiTextureId;
+}
+
+size_t CLwoImageResolver::AddObject(const CLwoObjectData &Object, const string &szBaseDir)
+{
+	// clips of this object by index
+	map<unsigned int, const CLwoClip*> mapClips;
+
+	const tClipList &Clips = Object.GetClips();
+	for (size_t i = 0; i < Clips.size(); i++)
+	{
+		mapClips[Clips[i]->m_uiClipIndex] = Clips[i];
+	}
+
+	m_Objects.push_back(tClipToTexture());
+	tClipToTexture &ClipToTexture = m_Objects.back();
+
+	map<unsigned int, const CLwoClip*>::iterator itClip = mapClips.begin();
+	while (itClip != mapClips.end())
+	{
+		const CLwoClip *pImageClip = ResolveXref(itClip->second, mapClips);
+		ClipToTexture[itClip->first] = GetOrAddTexture(pImageClip, szBaseDir);
+		++itClip;
+	}
+
+	return (m_Objects.size() -1);
+}
+
+unsigned int CLwoImageResolver::GetTextureId(const size_t nObject, const unsigned int uiClipIndex) const
+{
+	if (nObject >= m_Objects.size())
+	{
+		return NO_TEXTURE;
+	}
+	const tClipToTexture &ClipToTexture = m_Objects[nObject];
+	tClipToTexture::const_iterator itClip = ClipToTexture.find(uiClipIndex);
+	if (itClip == ClipToTexture.end())
+	{
+		return NO_TEXTURE;
+	}
+	return itClip->second;
+}
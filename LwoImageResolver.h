@@ -0,0 +1,145 @@
+//////////////////////////////////////////////////////////////////////
+// LwoImageResolver.h : shared image references of loaded objects
+//
+// Clips of each object refer to images by path (possibly through
+// XREF to another clip). When many objects are loaded, same images
+// should be loaded only once: resolver canonicalizes the paths
+// and keeps single texture table where each image has one ID.
+//
+
+#ifndef _LWOIMAGERESOLVER_H_
+#define _LWOIMAGERESOLVER_H_
+
+#include "LwoObjectData.h"
+
+#include <map>
+#include <string>
+#include <vector>
+using namespace std;
+
+class CLwoImageResolver
+{
+public:
+	// texture ID of clip without image
+	// (or reference which cannot be resolved)
+	static const unsigned int NO_TEXTURE = 0xFFFFFFFF;
+
+	// image in the shared texture table
+	class CLwoTextureRef
+	{
+	public:
+		// STIL, ISEQ, ANIM or STCC
+		unsigned int m_uiClipTypeID;
+
+		// canonical path of image
+		// (prefix of image sequence)
+		string m_szPath;
+
+		// details of clip which first referred to this image,
+		// copied since objects may be released before the table
+		// (see CLwoClip)
+		unsigned char m_ucSeqDigits;
+		unsigned char m_ucSeqFlags;
+		short m_sSeqOffset;
+		short m_sSeqStart;
+		short m_sSeqEnd;
+		string m_szSeqSuffix;
+		string m_szServerName;
+		unsigned short m_usAnimFlags;
+		vector<char> m_AnimData;
+		short m_sCycleLow;
+		short m_sCycleHigh;
+		float m_fStartTime;
+		float m_fDuration;
+		float m_fFrameRate;
+		unsigned short m_usColorSpaceRGB;
+		unsigned short m_usColorSpaceAlpha;
+
+		// amount of clips (in all objects) using this image
+		unsigned int m_uiRefCount;
+
+	public:
+		CLwoTextureRef(const CLwoClip &Clip, const string &szPath)
+			: m_uiClipTypeID((Clip.m_uiClipTypeID != 0) ? Clip.m_uiClipTypeID : ID_STIL)
+			, m_szPath(szPath)
+			, m_ucSeqDigits(Clip.m_ucSeqDigits)
+			, m_ucSeqFlags(Clip.m_ucSeqFlags)
+			, m_sSeqOffset(Clip.m_sSeqOffset)
+			, m_sSeqStart(Clip.m_sSeqStart)
+			, m_sSeqEnd(Clip.m_sSeqEnd)
+			, m_szSeqSuffix(Clip.m_szSeqSuffix)
+			, m_szServerName(Clip.m_szServerName)
+			, m_usAnimFlags(Clip.m_usAnimFlags)
+			, m_AnimData(Clip.m_AnimData)
+			, m_sCycleLow(Clip.m_sCycleLow)
+			, m_sCycleHigh(Clip.m_sCycleHigh)
+			, m_fStartTime(Clip.m_fStartTime)
+			, m_fDuration(Clip.m_fDuration)
+			, m_fFrameRate(Clip.m_fFrameRate)
+			, m_usColorSpaceRGB(Clip.m_usColorSpaceRGB)
+			, m_usColorSpaceAlpha(Clip.m_usColorSpaceAlpha)
+			, m_uiRefCount(1)
+		{};
+	};
+
+protected:
+	// texture table: index is texture ID
+	vector<CLwoTextureRef> m_Textures;
+
+	// identity of image (type and canonical path) to texture ID
+	map<string, unsigned int> m_KeyToTexture;
+
+	// for each added object: clip-index to texture ID
+	typedef map<unsigned int, unsigned int> tClipToTexture;
+	vector<tClipToTexture> m_Objects;
+
+	// compare paths ignoring case (e.g. on Windows)
+	bool m_bIgnoreCase;
+
+	// follow XREF-chain to clip which has actual image
+	const CLwoClip *ResolveXref(const CLwoClip *pClip, const map<unsigned int, const CLwoClip*> &mapClips) const;
+
+	// texture ID for clip, add new texture when not found
+	unsigned int GetOrAddTexture(const CLwoClip *pClip, const string &szBaseDir);
+
+public:
+	CLwoImageResolver(const bool bIgnoreCase = false);
+	~CLwoImageResolver(void);
+
+	void Clear();
+
+	// length of "Device:" at start of path (zero when none)
+	static size_t GetDeviceLength(const string &szPath);
+
+	// canonical form of image path:
+	// uses '/' as separator, removes "." and ".." parts
+	// and makes relative path relative to given base directory.
+	// paths with device ("Images:x.tga", "C:Images/x.tga") are absolute
+	string CanonicalizePath(const string &szPath, const string &szBaseDir) const;
+
+	// add clips of object to the shared table,
+	// relative paths are resolved from base directory (content directory).
+	// returns index of object in this resolver
+	size_t AddObject(const CLwoObjectData &Object, const string &szBaseDir);
+
+	// texture ID of clip in object (see AddObject()),
+	// NO_TEXTURE if clip has no image
+	unsigned int GetTextureId(const size_t nObject, const unsigned int uiClipIndex) const;
+
+	size_t GetObjectCount() const
+	{
+		return m_Objects.size();
+	};
+
+	size_t GetTextureCount() const
+	{
+		return m_Textures.size();
+	};
+
+	const CLwoTextureRef &GetTexture(const unsigned int uiTextureId) const
+	{
+		return m_Textures[uiTextureId];
+	};
+};
+
+#endif // ifndef _LWOIMAGERESOLVER_H_
@@ -0,0 +1,113 @@
+//////////////////////////////////////////////////////////////////////
+// LwoInstrumentation.cpp : statistics of loading as JSON
+//
+// Empty unless LWO_INSTRUMENTATION is defined.
+//
+
+#include "LwoInstrumentation.h"
+
+#ifdef LWO_INSTRUMENTATION
+
+#include <stdio.h>
+
+using namespace std;
+
+// string with JSON escapes
+static void AppendJsonString(string &szJson, const string &szValue)
+{
+	szJson += '"';
+	for (size_t i = 0; i < szValue.size(); i++)
+	{
+		const unsigned char c = (unsigned char)szValue[i];
+		if (c == '"' || c == '\\')
+		{
+			szJson += '\\';
+			szJson += (char)c;
+		}
+		else if (c < 0x20)
+		{
+			char szEscape[8];
+			snprintf(szEscape, sizeof(szEscape), "\\u%04x", (unsigned int)c);
+			szJson += szEscape;
+		}
+		else
+		{
+			szJson += (char)c;
+		}
+	}
+	szJson += '"';
+}
+
+// fields of statistic (without braces),
+// allocations only when counted: zero would look like a measurement
+static void AppendJsonStat(string &szJson, const tLwoStat &Stat, const bool bAllocs)
+{
+	char szFields[256];
+	snprintf(szFields, sizeof(szFields),
+		"\"count\":%lu,\"bytes\":%llu,\"ms\":%.6f",
+		Stat.m_ulCount, Stat.m_ullBytes, Stat.m_dSeconds * 1000.0);
+	szJson += szFields;
+	if (bAllocs == true)
+	{
+		snprintf(szFields, sizeof(szFields),
+			",\"allocs\":%llu,\"alloc_bytes\":%llu",
+			Stat.m_ullAllocs, Stat.m_ullAllocBytes);
+		szJson += szFields;
+	}
+}
+
+// chunk tag-ID as text (e.g. "POLS")
+static string GetTagName(const unsigned int uiTag)
+{
+	string szTag;
+	for (int i = 3; i >= 0; i--)
+	{
+		char c = (char)((uiTag >> (i*8)) & 0xFF);
+		szTag += (c >= 0x20 && c < 0x7F) ? c : '?';
+	}
+	return szTag;
+}
+
+string tLwoLoadStats::ToJson() const
+{
+	string szJson = "{\"file\":";
+	AppendJsonString(szJson, m_szFile);
+
+	char szSize[64];
+	snprintf(szSize, sizeof(szSize), ",\"file_size\":%lu,\"total\":{", m_ulFileSize);
+	szJson += szSize;
+	AppendJsonStat(szJson, m_Total, m_bAllocs);
+	szJson += "}";
+
+	szJson += ",\"chunks\":[";
+	for (map<unsigned int, tLwoStat>::const_iterator it = m_ChunkStats.begin(); it != m_ChunkStats.end(); ++it)
+	{
+		if (it != m_ChunkStats.begin())
+		{
+			szJson += ",";
+		}
+		szJson += "{\"type\":";
+		AppendJsonString(szJson, GetTagName(it->first));
+		szJson += ",";
+		AppendJsonStat(szJson, it->second, m_bAllocs);
+		szJson += "}";
+	}
+
+	szJson += "],\"handlers\":[";
+	for (map<string, tLwoStat>::const_iterator it = m_HandlerStats.begin(); it != m_HandlerStats.end(); ++it)
+	{
+		if (it != m_HandlerStats.begin())
+		{
+			szJson += ",";
+		}
+		szJson += "{\"name\":";
+		AppendJsonString(szJson, it->first);
+		szJson += ",";
+		AppendJsonStat(szJson, it->second, m_bAllocs);
+		szJson += "}";
+	}
+	szJson += "]}";
+	return szJson;
+}
+
+#endif // LWO_INSTRUMENTATION
@@ -0,0 +1,167 @@
+//////////////////////////////////////////////////////////////////////
+// LwoInstrumentation.h : time, bytes and allocations of loading
+//
+// Enabled by defining LWO_INSTRUMENTATION
+// (cmake -DLWReader_INSTRUMENTATION=ON):
+// CLwoReader keeps statistics of last file for each chunk type
+// and each handler (e.g. Handle_LWO2_ID_POLS), see CLwoReader::GetStats().
+// Without it the scopes compile to nothing and reader has no statistics.
+//
+// Allocations are counted only when application gives a counter
+// (e.g. updated by replaced operator new), see CLwoReader::SetAllocCounter().
+// LWReader links LwoAllocCounter.cpp for it, see GetLwoAllocCounter();
+// without a counter the statistics have no allocation fields.
+//
+
+#ifndef _LWOINSTRUMENTATION_H_
+#define _LWOINSTRUMENTATION_H_
+
+#include <stddef.h>
+#include <atomic>
+
+// count of allocations, updated by application
+// (e.g. replaced operator new), may be left as zero:
+// atomic since allocations happen on any thread (e.g. batch workers),
+// copy is a snapshot of both values
+struct tLwoAllocCounter
+{
+	std::atomic<unsigned long long> m_ullCount;
+	std::atomic<unsigned long long> m_ullBytes;
+
+	tLwoAllocCounter()
+		: m_ullCount(0)
+		, m_ullBytes(0)
+	{};
+
+	tLwoAllocCounter(const tLwoAllocCounter &Other)
+		: m_ullCount(Other.m_ullCount.load(std::memory_order_relaxed))
+		, m_ullBytes(Other.m_ullBytes.load(std::memory_order_relaxed))
+	{};
+
+	tLwoAllocCounter &operator=(const tLwoAllocCounter &Other)
+	{
+		m_ullCount.store(Other.m_ullCount.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		m_ullBytes.store(Other.m_ullBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		return *this;
+	}
+
+	void Add(const size_t nSize)
+	{
+		m_ullCount.fetch_add(1, std::memory_order_relaxed);
+		m_ullBytes.fetch_add(nSize, std::memory_order_relaxed);
+	}
+};
+
+#ifdef LWO_INSTRUMENTATION
+
+#include <map>
+#include <string>
+#include <chrono>
+
+// accumulated for chunk type or handler
+struct tLwoStat
+{
+	unsigned long m_ulCount;
+	unsigned long long m_ullBytes;
+	double m_dSeconds;
+	unsigned long long m_ullAllocs;
+	unsigned long long m_ullAllocBytes;
+
+	tLwoStat()
+		: m_ulCount(0)
+		, m_ullBytes(0)
+		, m_dSeconds(0.0)
+		, m_ullAllocs(0)
+		, m_ullAllocBytes(0)
+	{};
+};
+
+// statistics of one file:
+// handlers are timed also when called within another
+// (e.g. Handle_LWO2_BLOK within Handle_LWO2_ID_SURF),
+// time of streaming handlers includes event handler callbacks
+struct tLwoLoadStats
+{
+	std::string m_szFile;
+	unsigned long m_ulFileSize;
+
+	// whole ProcessFromFile() or ProcessWithHandler()
+	tLwoStat m_Total;
+
+	// by chunk type (tag-ID)
+	std::map<unsigned int, tLwoStat> m_ChunkStats;
+
+	// by name of handler
+	std::map<std::string, tLwoStat> m_HandlerStats;
+
+	// allocations were counted (reader had a counter)
+	bool m_bAllocs;
+
+	tLwoLoadStats()
+		: m_szFile()
+		, m_ulFileSize(0)
+		, m_Total()
+		, m_ChunkStats()
+		, m_HandlerStats()
+		, m_bAllocs(false)
+	{};
+
+	void Clear()
+	{
+		m_szFile.clear();
+		m_ulFileSize = 0;
+		m_Total = tLwoStat();
+		m_ChunkStats.clear();
+		m_HandlerStats.clear();
+		m_bAllocs = false;
+	}
+
+	// single-line JSON object of statistics
+	// (no allocation fields unless counted)
+	std::string ToJson() const;
+};
+
+// counter of replaced operator new in LwoAllocCounter.cpp
+// (linked into LWReader only: tools replace operator new themselves)
+const tLwoAllocCounter *GetLwoAllocCounter();
+
+// adds time of scope to statistic
+class CLwoStatScope
+{
+private:
+	tLwoStat &m_Stat;
+	const tLwoAllocCounter *m_pAllocs;
+	tLwoAllocCounter m_StartAllocs;
+	std::chrono::steady_clock::time_point m_Start;
+
+public:
+	CLwoStatScope(tLwoStat &Stat, const unsigned long long ullBytes, const tLwoAllocCounter *pAllocs)
+		: m_Stat(Stat)
+		, m_pAllocs(pAllocs)
+		, m_StartAllocs()
+		, m_Start()
+	{
+		m_Stat.m_ulCount += 1;
+		m_Stat.m_ullBytes += ullBytes;
+		if (m_pAllocs != NULL)
+		{
+			m_StartAllocs = *m_pAllocs;
+		}
+		m_Start = std::chrono::steady_clock::now();
+	}
+
+	~CLwoStatScope()
+	{
+		std::chrono::duration<double> Elapsed = (std::chrono::steady_clock::now() - m_Start);
+		m_Stat.m_dSeconds += Elapsed.count();
+		if (m_pAllocs != NULL)
+		{
+			m_Stat.m_ullAllocs += (m_pAllocs->m_ullCount - m_StartAllocs.m_ullCount);
+			m_Stat.m_ullAllocBytes += (m_pAllocs->m_ullBytes - m_StartAllocs.m_ullBytes);
+		}
+	}
+};
+
+#endif // LWO_INSTRUMENTATION
+
+#endif // ifndef _LWOINSTRUMENTATION_H_
@@ -0,0 +1,40 @@
+//////////////////////////////////////////////////////////////////////
+// LwoMemoryReport.cpp : memory used by parsed objects
+//
+
+#include "LwoMemoryReport.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "psapi.lib")
+#endif
+#else
+#include <sys/resource.h>
+#endif
+
+uint64_t GetLwoProcessPeakRSS()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS Counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &Counters, sizeof(Counters)) == FALSE)
+	{
+		return 0;
+	}
+	return (uint64_t)Counters.PeakWorkingSetSize;
+#else
+	struct rusage sUsage;
+	if (getrusage(RUSAGE_SELF, &sUsage) != 0)
+	{
+		return 0;
+	}
+#ifdef __APPLE__
+	// bytes on macOS
+	return (uint64_t)sUsage.ru_maxrss;
+#else
+	// kilobytes on Linux and BSD
+	return (uint64_t)sUsage.ru_maxrss * 1024;
+#endif
+#endif
+}
@@ -0,0 +1,99 @@
+//////////////////////////////////////////////////////////////////////
+// LwoMemoryReport.h : memory used by parsed objects
+//
+// Bytes of heap by category (see CLwoObjectData::GetMemoryReport()),
+// counted from capacity of containers (not only used size):
+// allocator's own overhead per allocation is not included,
+// map nodes are counted with their links.
+//
+// Peak of parsing (see CLwoReader::GetMemoryReport()) is estimated
+// as buffer of file + object + reader's decode buffers at end of parsing:
+// object only grows while file is kept.
+// Actual peak of whole process is from GetLwoProcessPeakRSS().
+//
+
+#ifndef _LWOMEMORYREPORT_H_
+#define _LWOMEMORYREPORT_H_
+
+#include <stdint.h>
+
+struct tLwoMemoryReport
+{
+	// coordinates of points (PNTS)
+	uint64_t m_ullPoints;
+
+	// polygon rows (POLS)
+	uint64_t m_ullPolygons;
+
+	// vertex indices of polygons
+	uint64_t m_ullIndices;
+
+	// polygon tags (PTAG)
+	uint64_t m_ullPolyTags;
+
+	// vertex maps (VMAP, VMAD): indices and values
+	uint64_t m_ullVertexMaps;
+
+	// surfaces, envelopes and clips
+	// (texture layers, keys, plugin data)
+	uint64_t m_ullSurfaces;
+
+	// heap of strings (names, tags, paths)
+	uint64_t m_ullStrings;
+
+	// chunk objects, lists of chunks, maps
+	uint64_t m_ullOverhead;
+
+	// when made by reader (otherwise zero):
+	// file in memory, reader's buffers and estimated peak
+	uint64_t m_ullFileBuffer;
+	uint64_t m_ullReaderBuffers;
+	uint64_t m_ullParsePeak;
+
+	tLwoMemoryReport()
+		: m_ullPoints(0)
+		, m_ullPolygons(0)
+		, m_ullIndices(0)
+		, m_ullPolyTags(0)
+		, m_ullVertexMaps(0)
+		, m_ullSurfaces(0)
+		, m_ullStrings(0)
+		, m_ullOverhead(0)
+		, m_ullFileBuffer(0)
+		, m_ullReaderBuffers(0)
+		, m_ullParsePeak(0)
+	{};
+
+	// bytes of object
+	uint64_t GetObjectTotal() const
+	{
+		return (m_ullPoints + m_ullPolygons + m_ullIndices + m_ullPolyTags
+			+ m_ullVertexMaps + m_ullSurfaces + m_ullStrings + m_ullOverhead);
+	};
+
+	// sum of reports (e.g. for batch),
+	// peak is largest of them
+	void Add(const tLwoMemoryReport &Other)
+	{
+		m_ullPoints += Other.m_ullPoints;
+		m_ullPolygons += Other.m_ullPolygons;
+		m_ullIndices += Other.m_ullIndices;
+		m_ullPolyTags += Other.m_ullPolyTags;
+		m_ullVertexMaps += Other.m_ullVertexMaps;
+		m_ullSurfaces += Other.m_ullSurfaces;
+		m_ullStrings += Other.m_ullStrings;
+		m_ullOverhead += Other.m_ullOverhead;
+		m_ullFileBuffer += Other.m_ullFileBuffer;
+		m_ullReaderBuffers += Other.m_ullReaderBuffers;
+		if (Other.m_ullParsePeak > m_ullParsePeak)
+		{
+			m_ullParsePeak = Other.m_ullParsePeak;
+		}
+	};
+};
+
+// peak resident memory of this process in bytes
+// (zero when not available)
+uint64_t GetLwoProcessPeakRSS();
+
+#endif // ifndef _LWOMEMORYREPORT_H_
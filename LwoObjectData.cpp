@@ -6,75 +6,590 @@
 
 #include "LwoObjectData.h"
 
-CLwoChunk *CLwoObjectData::GetNextOfType(const unsigned int uiType, tChunkList &ChunkList, tChunkList::iterator &itCurPos)
+// SSE when compiler has it enabled
+// (always on x64)
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define LWO_OBJECTDATA_SSE
+#endif
+
+// links of a map node (red-black tree: color and three pointers)
+#define LWO_MAP_NODE_LINKS (4 * sizeof(void*))
+
+// heap of containers by capacity
+template <class T>
+static uint64_t GetVectorBytes(const vector<T> &vList)
+{
+	return (uint64_t)vList.capacity() * sizeof(T);
+}
+
+template <class K, class V>
+static uint64_t GetMapBytes(const map<K, V> &Map)
+{
+	return (uint64_t)Map.size() * (sizeof(typename map<K, V>::value_type) + LWO_MAP_NODE_LINKS);
+}
+
+// short strings are kept within string object (no heap)
+static uint64_t GetStringBytes(const string &szValue)
+{
+	const char *pData = szValue.data();
+	if (pData >= (const char*)&szValue
+		&& pData < (const char*)(&szValue +1))
+	{
+		return 0;
+	}
+	return (uint64_t)szValue.capacity() +1;
+}
+
+// translate XYZ-triplets in-place:
+// subtract given offset from each point
+static void TranslatePoints(float *pfPoints, const long lPointCount, const float *pfOffset)
+{
+	long lPoint = 0;
+
+#ifdef LWO_OBJECTDATA_SSE
+	// four points (12 floats) at a time:
+	// offset repeats in three registers
+	// as x y z x | y z x y | z x y z
+	const __m128 vOffset0 = _mm_setr_ps(pfOffset[0], pfOffset[1], pfOffset[2], pfOffset[0]);
+	const __m128 vOffset1 = _mm_setr_ps(pfOffset[1], pfOffset[2], pfOffset[0], pfOffset[1]);
+	const __m128 vOffset2 = _mm_setr_ps(pfOffset[2], pfOffset[0], pfOffset[1], pfOffset[2]);
+	for (; lPoint +4 <= lPointCount; lPoint += 4)
+	{
+		float *pfPos = (pfPoints + lPoint*3);
+		_mm_storeu_ps(pfPos, _mm_sub_ps(_mm_loadu_ps(pfPos), vOffset0));
+		_mm_storeu_ps(pfPos +4, _mm_sub_ps(_mm_loadu_ps(pfPos +4), vOffset1));
+		_mm_storeu_ps(pfPos +8, _mm_sub_ps(_mm_loadu_ps(pfPos +8), vOffset2));
+	}
+#endif
+
+	// remaining points
+	for (; lPoint < lPointCount; lPoint++)
+	{
+		float *pfPos = (pfPoints + lPoint*3);
+		pfPos[0] -= pfOffset[0];
+		pfPos[1] -= pfOffset[1];
+		pfPos[2] -= pfOffset[2];
+	}
+}
+
+// type of chunk is known only here:
+// keep in lists by type so that users don't need to check it
+bool CLwoLayer::AddChunkToLayer(CLwoChunk *pChunk)
 {
-	tChunkList::iterator itEnd = ChunkList.end();
-	while (itCurPos != itEnd)
+	m_ChunksInLayer.push_back(pChunk);
+
+	switch (pChunk->m_uiChunkType)
 	{
-		CLwoChunk *pChunk = (*itCurPos);
-		if (pChunk != NULL)
+	case ID_PNTS:
+		m_PointsInLayer.push_back((CLwoPoints*)pChunk);
+		break;
+
+	case ID_POLS:
 		{
-			if (pChunk->m_uiChunkType == uiType)
+			CLwoPolygons *pPolyList = (CLwoPolygons*)pChunk;
+			m_PolygonsInLayer.push_back(pPolyList);
+			m_PolygonsByType[pPolyList->m_uiPolyTypeID].push_back(pPolyList);
+		}
+		break;
+
+	case ID_VMAP:
+	case ID_VMAD:
+		m_VertexMapsInLayer.push_back((CLwoVertexMap*)pChunk);
+		break;
+
+	case ID_BBOX:
+		m_pBoundingBox = (CLwoBoundingBox*)pChunk;
+		break;
+	}
+	return true;
+}
+
+void CLwoObjectData::IndexChunk(CLwoChunk *pChunk)
+{
+	m_LastOfType[pChunk->m_uiChunkType] = pChunk;
+
+	switch (pChunk->m_uiChunkType)
+	{
+	case ID_LAYR:
+		m_Layers.push_back((CLwoLayer*)pChunk);
+		break;
+
+	case ID_TAGS:
+		m_Tagnames.push_back((CLwoTagnameList*)pChunk);
+		break;
+
+	case ID_PTAG:
+		m_PolyTags.push_back((CLwoPolyTags*)pChunk);
+		break;
+
+	case ID_SURF:
+		m_Surfaces.push_back((CLwoSurface*)pChunk);
+		break;
+
+	case ID_ENVL:
+		m_Envelopes.push_back((CLwoEnvelope*)pChunk);
+		break;
+
+	case ID_CLIP:
+		m_Clips.push_back((CLwoClip*)pChunk);
+		break;
+
+	case ID_VMAP:
+	case ID_VMAD:
+		m_VertexMaps.push_back((CLwoVertexMap*)pChunk);
+		break;
+	}
+}
+
+// resolve texture layers for baking:
+// map each image-map to the CLIP it uses (by clip-index)
+// and to the UV-map it uses (by name of VMAP/VMAD)
+bool CLwoObjectData::ResolveTextureLayers()
+{
+	// collect clips and UV-maps first,
+	// there should be only few of these
+	map<unsigned int, CLwoClip*> mapClips;
+	map<string, CLwoVertexMap*> mapUVMaps;
+	map<string, CLwoVertexMap*> mapUVMapsDisc;
+
+	for (size_t i = 0; i < m_Clips.size(); i++)
+	{
+		CLwoClip *pClip = m_Clips[i];
+		mapClips[pClip->m_uiClipIndex] = pClip;
+	}
+	for (size_t i = 0; i < m_VertexMaps.size(); i++)
+	{
+		CLwoVertexMap *pVmap = m_VertexMaps[i];
+		if (pVmap->m_uiVmapTypeID == ID_TXUV)
+		{
+			// first one by name is used
+			// (same name may be in multiple layers)
+			if (pVmap->IsDiscontinuous() == true)
+			{
+				mapUVMapsDisc.insert(map<string, CLwoVertexMap*>::value_type(pVmap->m_szName, pVmap));
+			}
+			else
+			{
+				mapUVMaps.insert(map<string, CLwoVertexMap*>::value_type(pVmap->m_szName, pVmap));
+			}
+		}
+	}
+
+	// now link each image-map in each surface
+	for (size_t i = 0; i < m_Surfaces.size(); i++)
+	{
+		CLwoSurface *pSurface = m_Surfaces[i];
+		CLwoSurface::tTextureLayerList::iterator itLayer = pSurface->m_TextureLayers.begin();
+		CLwoSurface::tTextureLayerList::iterator itLayerEnd = pSurface->m_TextureLayers.end();
+		while (itLayer != itLayerEnd)
+		{
+			CLwoSurface::CLwoTextureLayer &Layer = (*itLayer);
+			if (Layer.m_uiBlokTypeID == ID_IMAP)
 			{
-				return pChunk;
+				// zero index: no image
+				map<unsigned int, CLwoClip*>::iterator itClip = mapClips.find(Layer.m_uiImageIndex);
+				if (itClip != mapClips.end())
+				{
+					Layer.m_pClip = itClip->second;
+				}
+
+				map<string, CLwoVertexMap*>::iterator itUV = mapUVMaps.find(Layer.m_szVmapName);
+				if (itUV != mapUVMaps.end())
+				{
+					Layer.m_pUVMap = itUV->second;
+				}
+				itUV = mapUVMapsDisc.find(Layer.m_szVmapName);
+				if (itUV != mapUVMapsDisc.end())
+				{
+					Layer.m_pUVMapDiscontinuous = itUV->second;
+				}
 			}
+			++itLayer;
 		}
-		++itCurPos;
 	}
-	return NULL;
+	return true;
 }
 
-// create internal links between 
-// related chunks and sub-chunks in the object data:
-// when file has been parsed this is called
-// to prepare information for actual using.
-bool CLwoObjectData::CreateObjectLinkage()
+// parent of layer is given by layer-number:
+// link layers and collect them so that parent is always before its children.
+// missing parent or parent that would create a loop
+// leaves layer as a root-layer.
+bool CLwoObjectData::BuildLayerTree()
+{
+	m_LayerOrder.clear();
+
+	// layers by number, first one if same number is used again
+	const tLayerList &vLayers = m_Layers;
+	map<int, CLwoLayer*> mapLayers;
+
+	CLwoLayer *pLayer = NULL;
+	for (size_t i = 0; i < vLayers.size(); i++)
+	{
+		pLayer = vLayers[i];
+		pLayer->m_pParentLayer = NULL;
+		pLayer->m_ChildLayers.clear();
+
+		mapLayers.insert(map<int, CLwoLayer*>::value_type((int)pLayer->m_usLayerNumber, pLayer));
+	}
+
+	for (size_t i = 0; i < vLayers.size(); i++)
+	{
+		pLayer = vLayers[i];
+		if (pLayer->m_iParentLayerIndex < 0)
+		{
+			continue;
+		}
+
+		map<int, CLwoLayer*>::iterator itParent = mapLayers.find(pLayer->m_iParentLayerIndex);
+		if (itParent == mapLayers.end())
+		{
+			continue;
+		}
+
+		// tree so far has no loops:
+		// linking is safe unless this layer is above the parent
+		CLwoLayer *pParent = itParent->second;
+		CLwoLayer *pAncestor = pParent;
+		while (pAncestor != NULL
+			&& pAncestor != pLayer)
+		{
+			pAncestor = pAncestor->m_pParentLayer;
+		}
+		if (pAncestor == pLayer)
+		{
+			continue;
+		}
+
+		pLayer->m_pParentLayer = pParent;
+		pParent->m_ChildLayers.push_back(pLayer);
+	}
+
+	// roots first, then children of each added layer
+	for (size_t i = 0; i < vLayers.size(); i++)
+	{
+		if (vLayers[i]->m_pParentLayer == NULL)
+		{
+			m_LayerOrder.push_back(vLayers[i]);
+		}
+	}
+	for (size_t i = 0; i < m_LayerOrder.size(); i++)
+	{
+		tLayerList &Children = m_LayerOrder[i]->m_ChildLayers;
+		m_LayerOrder.insert(m_LayerOrder.end(), Children.begin(), Children.end());
+	}
+	return true;
+}
+
+// polygons refer to surfaces by name:
+// PTAG SURF maps polygon to index in TAGS
+// and surface with that name is used.
+// LWOB surface-indices are kept as same mapping when parsing.
+bool CLwoObjectData::ResolvePolygonSurfaces()
 {
-	//vector<CVertexTriplet> vTriplets;
+	// surfaces by name (first one if same name is repeated)
+	// and list of tag names
+	map<string, CLwoSurface*> mapSurfaces;
+	CLwoTagnameList *pTagnames = NULL;
 
-	// count polygons in poly-chunks 
-	// to determine amount of triplets needed
-	// (first locate each poly-chunk and get count)
-	unsigned long ulPolyCount = 0;
+	for (size_t i = 0; i < m_Surfaces.size(); i++)
+	{
+		CLwoSurface *pSurface = m_Surfaces[i];
+		mapSurfaces.insert(map<string, CLwoSurface*>::value_type(pSurface->m_szSurfaceName, pSurface));
+	}
+	if (m_Tagnames.empty() == false)
+	{
+		pTagnames = m_Tagnames.front();
+	}
 
-	/*
-	CVertexTriplet Tmp;
-	Tmp.m_fX = 1;
-	Tmp.m_fY = 2;
-	Tmp.m_fZ = 3;
-	vTriplets.push_back(Tmp);
-	*/
+	if (pTagnames == NULL
+		|| mapSurfaces.empty() == true)
+	{
+		// nothing to map
+		return true;
+	}
 
-	tChunkList::iterator itChunks = m_ChunkList.begin();
-	tChunkList::iterator itChunksEnd = m_ChunkList.end();
+	// surface of each tag-index
+	vector<CLwoSurface*> vTagSurfaces(pTagnames->m_TagnameList.size(), (CLwoSurface*)NULL);
+	for (size_t i = 0; i < vTagSurfaces.size(); i++)
+	{
+		map<string, CLwoSurface*>::iterator itSurface = mapSurfaces.find(pTagnames->GetTagname((long)i));
+		if (itSurface != mapSurfaces.end())
+		{
+			vTagSurfaces[i] = itSurface->second;
+		}
+	}
 
-	CLwoLayer *pLayer = (CLwoLayer*)GetNextOfType(ID_LAYR, m_ChunkList, itChunks);
-	if (pLayer != NULL)
+	for (size_t t = 0; t < m_PolyTags.size(); t++)
 	{
-		tChunkList::iterator itLChunks = pLayer->m_ChunksInLayer.begin();
-		//tChunkList::iterator itLChunksEnd = pLayer->m_ChunksInLayer.end();
+		CLwoPolyTags *pPolyTags = m_PolyTags[t];
+		CLwoPolygons *pPolyList = pPolyTags->m_pPolyList;
+		if (pPolyTags->m_uiPtagTypeID == ID_SURF
+			&& pPolyList != NULL)
+		{
+			size_t nPolyCount = pPolyList->m_PolyList.size();
 
-		CLwoPoints *pPoints = (CLwoPoints*)GetNextOfType(ID_PNTS, pLayer->m_ChunksInLayer, itLChunks);
+			CLwoPolyTags::tPolyTagList::iterator itTag = pPolyTags->m_PolyTagList.begin();
+			CLwoPolyTags::tPolyTagList::iterator itTagEnd = pPolyTags->m_PolyTagList.end();
+			while (itTag != itTagEnd)
+			{
+				// skip invalid indices
+				if (itTag->first >= 0 && (size_t)itTag->first < nPolyCount
+					&& itTag->second >= 0 && (size_t)itTag->second < vTagSurfaces.size())
+				{
+					pPolyList->m_PolyList[itTag->first].m_pSurface = vTagSurfaces[itTag->second];
+				}
+				++itTag;
+			}
+		}
 	}
+	return true;
+}
 
-	/*
-	while (itChunks != itChunksEnd)
+// points are in object-space in file
+// and pivot is only center of rotation:
+// when layers are kept separate, points are made relative to pivot
+// and the layer is placed by its offset from parent pivot instead.
+void CLwoObjectData::FlattenLayers(const bool bKeepSeparate)
+{
+	for (size_t i = 0; i < m_LayerOrder.size(); i++)
 	{
-		CLwoChunk *pChunk = (*itChunks);
-		if (pChunk != NULL)
+		CLwoLayer *pLayer = m_LayerOrder[i];
+
+		// offset wanted in points, and difference to current
+		float fOffset[3];
+		float fDelta[3];
+		for (int iAxis = 0; iAxis < 3; iAxis++)
 		{
-			if (pChunk->m_uiChunkType == ID_LAYR)
+			fOffset[iAxis] = (bKeepSeparate == true) ? pLayer->GetPivot(iAxis) : 0.0f;
+			fDelta[iAxis] = fOffset[iAxis] - pLayer->m_fPointOffset[iAxis];
+			pLayer->m_fPointOffset[iAxis] = fOffset[iAxis];
+
+			pLayer->m_fLocalOffset[iAxis] = 0.0f;
+			if (bKeepSeparate == true)
+			{
+				float fParentPivot = (pLayer->m_pParentLayer != NULL) ? pLayer->m_pParentLayer->GetPivot(iAxis) : 0.0f;
+				pLayer->m_fLocalOffset[iAxis] = pLayer->GetPivot(iAxis) - fParentPivot;
+			}
+		}
+
+		if (fDelta[0] == 0.0f
+			&& fDelta[1] == 0.0f
+			&& fDelta[2] == 0.0f)
+		{
+			continue;
+		}
+
+		// positions in layer: points, extents
+		// and spot-maps (morphs are relative, not moved)
+		const tPointsList &Points = pLayer->GetPoints();
+		for (size_t p = 0; p < Points.size(); p++)
+		{
+			TranslatePoints(Points[p]->m_PointList.data(), Points[p]->GetPointCount(), fDelta);
+		}
+
+		CLwoBoundingBox *pBBox = pLayer->GetBoundingBox();
+		if (pBBox != NULL)
+		{
+			TranslatePoints(pBBox->m_fBoxExtents, pBBox->m_lValueCount/3, fDelta);
+		}
+
+		const tVertexMapList &Vmaps = pLayer->GetVertexMaps();
+		for (size_t v = 0; v < Vmaps.size(); v++)
+		{
+			CLwoVertexMap *pVmap = Vmaps[v];
+			if (pVmap->m_uiVmapTypeID == ID_SPOT
+				&& pVmap->m_usDimension == 3
+				&& pVmap->m_Values.empty() == false)
 			{
-				// find points-chunk,
-				// then find each poly-chunk in layer
-				// and generate polygon vertices
-				// by point-coordinates and poly-indices
+				TranslatePoints(&(pVmap->m_Values[0]), (long)(pVmap->m_Values.size()/3), fDelta);
 			}
 		}
-		++itChunks;
 	}
-	*/
+}
 
+// create internal links between 
+// related chunks and sub-chunks in the object data:
+// when file has been parsed this is called
+// to prepare information for actual using.
+bool CLwoObjectData::CreateObjectLinkage()
+{
+	// parents and children of layers
+	if (BuildLayerTree() == false)
+	{
+		return false;
+	}
+
+	// surface of each polygon (also LWOB)
+	if (ResolvePolygonSurfaces() == false)
+	{
+		return false;
+	}
+
+	// image-maps to clips and UV-maps (bake-ready textures)
+	if (ResolveTextureLayers() == false)
+	{
+		return false;
+	}
+	return true;
+}
+
+void CLwoObjectData::GetMemoryReport(tLwoMemoryReport &Report) const
+{
+	// lists of chunks in this
+	Report.m_ullOverhead += GetVectorBytes(m_ChunkList);
+	Report.m_ullOverhead += GetVectorBytes(m_LayerOrder);
+	Report.m_ullOverhead += GetVectorBytes(m_Layers);
+	Report.m_ullOverhead += GetVectorBytes(m_Tagnames);
+	Report.m_ullOverhead += GetVectorBytes(m_PolyTags);
+	Report.m_ullOverhead += GetVectorBytes(m_Surfaces);
+	Report.m_ullOverhead += GetVectorBytes(m_Envelopes);
+	Report.m_ullOverhead += GetVectorBytes(m_Clips);
+	Report.m_ullOverhead += GetVectorBytes(m_VertexMaps);
+	Report.m_ullOverhead += GetMapBytes(m_LastOfType);
+
+	GetChunkMemoryReport(0, Report);
+}
+
+void CLwoObjectData::GetChunkMemoryReport(const size_t nFirstChunk, tLwoMemoryReport &Report) const
+{
+	for (size_t i = nFirstChunk; i < m_ChunkList.size(); i++)
+	{
+		const CLwoChunk *pChunk = m_ChunkList[i].get();
+		switch (pChunk->m_uiChunkType)
+		{
+		case ID_TAGS:
+			{
+				const CLwoTagnameList *pTags = (const CLwoTagnameList*)pChunk;
+				Report.m_ullOverhead += sizeof(CLwoTagnameList) + GetMapBytes(pTags->m_TagnameList);
+				CLwoTagnameList::tTagList::const_iterator itTag = pTags->m_TagnameList.begin();
+				while (itTag != pTags->m_TagnameList.end())
+				{
+					Report.m_ullStrings += GetStringBytes(itTag->second);
+					++itTag;
+				}
+			}
+			break;
+
+		case ID_LAYR:
+			{
+				const CLwoLayer *pLayer = (const CLwoLayer*)pChunk;
+				Report.m_ullOverhead += sizeof(CLwoLayer);
+				Report.m_ullOverhead += GetVectorBytes(pLayer->m_ChildLayers);
+				Report.m_ullOverhead += GetVectorBytes(pLayer->m_ChunksInLayer);
+				Report.m_ullOverhead += GetVectorBytes(pLayer->m_PointsInLayer);
+				Report.m_ullOverhead += GetVectorBytes(pLayer->m_PolygonsInLayer);
+				Report.m_ullOverhead += GetVectorBytes(pLayer->m_VertexMapsInLayer);
+				Report.m_ullOverhead += GetMapBytes(pLayer->m_PolygonsByType);
+				map<unsigned int, tPolygonsList>::const_iterator itType = pLayer->m_PolygonsByType.begin();
+				while (itType != pLayer->m_PolygonsByType.end())
+				{
+					Report.m_ullOverhead += GetVectorBytes(itType->second);
+					++itType;
+				}
+				Report.m_ullStrings += GetStringBytes(pLayer->m_szLayerName);
+			}
+			break;
 
-	return false;
+		case ID_BBOX:
+			Report.m_ullOverhead += sizeof(CLwoBoundingBox);
+			break;
+
+		case ID_PNTS:
+			Report.m_ullOverhead += sizeof(CLwoPoints);
+			Report.m_ullPoints += GetVectorBytes(((const CLwoPoints*)pChunk)->m_PointList);
+			break;
+
+		case ID_POLS:
+			{
+				const CLwoPolygons *pPolygons = (const CLwoPolygons*)pChunk;
+				Report.m_ullOverhead += sizeof(CLwoPolygons);
+				Report.m_ullPolygons += GetVectorBytes(pPolygons->m_PolyList);
+				Report.m_ullIndices += GetVectorBytes(pPolygons->m_Indices);
+			}
+			break;
+
+		case ID_PTAG:
+			Report.m_ullOverhead += sizeof(CLwoPolyTags);
+			Report.m_ullPolyTags += GetVectorBytes(((const CLwoPolyTags*)pChunk)->m_PolyTagList);
+			break;
+
+		case ID_SURF:
+			{
+				const CLwoSurface *pSurface = (const CLwoSurface*)pChunk;
+				Report.m_ullOverhead += sizeof(CLwoSurface);
+				Report.m_ullStrings += GetStringBytes(pSurface->m_szSurfaceName);
+				Report.m_ullStrings += GetStringBytes(pSurface->m_szParentSurfaceName);
+				Report.m_ullSurfaces += GetVectorBytes(pSurface->m_TextureLayers);
+				for (size_t l = 0; l < pSurface->m_TextureLayers.size(); l++)
+				{
+					const CLwoSurface::CLwoTextureLayer &Layer = pSurface->m_TextureLayers[l];
+					Report.m_ullStrings += GetStringBytes(Layer.m_szOrdinal);
+					Report.m_ullStrings += GetStringBytes(Layer.m_szReferenceObject);
+					Report.m_ullStrings += GetStringBytes(Layer.m_szVmapName);
+					Report.m_ullStrings += GetStringBytes(Layer.m_szFunction);
+					Report.m_ullStrings += GetStringBytes(Layer.m_szParameterName);
+					Report.m_ullStrings += GetStringBytes(Layer.m_szItemName);
+					Report.m_ullSurfaces += GetVectorBytes(Layer.m_FunctionData);
+					Report.m_ullSurfaces += GetVectorBytes(Layer.m_GradientKeys);
+					Report.m_ullSurfaces += GetVectorBytes(Layer.m_GradientInterpolation);
+				}
+			}
+			break;
+
+		case ID_ENVL:
+			{
+				const CLwoEnvelope *pEnvelope = (const CLwoEnvelope*)pChunk;
+				Report.m_ullOverhead += sizeof(CLwoEnvelope);
+				Report.m_ullStrings += GetStringBytes(pEnvelope->m_szName);
+				Report.m_ullSurfaces += GetVectorBytes(pEnvelope->m_Keys);
+				Report.m_ullSurfaces += GetVectorBytes(pEnvelope->m_Plugins);
+				for (size_t p = 0; p < pEnvelope->m_Plugins.size(); p++)
+				{
+					Report.m_ullStrings += GetStringBytes(pEnvelope->m_Plugins[p].m_szServerName);
+					Report.m_ullSurfaces += GetVectorBytes(pEnvelope->m_Plugins[p].m_Data);
+				}
+			}
+			break;
+
+		case ID_CLIP:
+			{
+				const CLwoClip *pClip = (const CLwoClip*)pChunk;
+				Report.m_ullOverhead += sizeof(CLwoClip);
+				Report.m_ullStrings += GetStringBytes(pClip->m_szFilename);
+				Report.m_ullStrings += GetStringBytes(pClip->m_szSeqSuffix);
+				Report.m_ullStrings += GetStringBytes(pClip->m_szServerName);
+				Report.m_ullStrings += GetStringBytes(pClip->m_szXrefName);
+				Report.m_ullSurfaces += GetVectorBytes(pClip->m_AnimData);
+
+				const CLwoClip::tFilterList *pFilters[2] = {&pClip->m_ImageFilters, &pClip->m_PixelFilters};
+				for (int f = 0; f < 2; f++)
+				{
+					Report.m_ullSurfaces += GetVectorBytes(*pFilters[f]);
+					for (size_t p = 0; p < pFilters[f]->size(); p++)
+					{
+						Report.m_ullStrings += GetStringBytes((*pFilters[f])[p].m_szServerName);
+						Report.m_ullSurfaces += GetVectorBytes((*pFilters[f])[p].m_Data);
+					}
+				}
+			}
+			break;
+
+		case ID_VMAP:
+		case ID_VMAD:
+			{
+				const CLwoVertexMap *pVmap = (const CLwoVertexMap*)pChunk;
+				Report.m_ullOverhead += sizeof(CLwoVertexMap);
+				Report.m_ullStrings += GetStringBytes(pVmap->m_szName);
+				Report.m_ullVertexMaps += GetVectorBytes(pVmap->m_VertexIndices);
+				Report.m_ullVertexMaps += GetVectorBytes(pVmap->m_PolyIndices);
+				Report.m_ullVertexMaps += GetVectorBytes(pVmap->m_Values);
+			}
+			break;
+
+		default:
+			Report.m_ullOverhead += sizeof(CLwoChunk);
+			break;
+		}
+	}
 }
@@ -10,8 +10,10 @@
 #define _LWOOBJECTDATA_H_
 
 #include "LwoTags.h"
+#include "LwoMemoryReport.h"
 
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 using namespace std;
@@ -37,6 +39,11 @@ public:
 	{};
 	virtual ~CLwoChunk()
 	{};
+
+	// owned by CLwoObjectData and referred to by pointer
+	// from other chunks: never copied
+	CLwoChunk(const CLwoChunk &Other) = delete;
+	CLwoChunk &operator = (const CLwoChunk &Other) = delete;
 };
 
 // tags: list of tag names
@@ -79,24 +86,65 @@ public:
 
 
 // use list for chunks of data
+// (references to chunks owned by CLwoObjectData)
 typedef vector<CLwoChunk*> tChunkList;
 
+// chunks owned by object data
+typedef vector<unique_ptr<CLwoChunk>> tOwnedChunkList;
+
+// list of layers in hierarchy
+class CLwoLayer;
+typedef vector<CLwoLayer*> tLayerList;
+
+// lists of chunks by type:
+// indexed when added so that lookups don't need scanning
+class CLwoBoundingBox;
+class CLwoPoints;
+class CLwoPolygons;
+class CLwoPolyTags;
+class CLwoSurface;
+class CLwoEnvelope;
+class CLwoClip;
+class CLwoVertexMap;
+typedef vector<CLwoTagnameList*> tTagnameListList;
+typedef vector<CLwoPoints*> tPointsList;
+typedef vector<CLwoPolygons*> tPolygonsList;
+typedef vector<CLwoPolyTags*> tPolyTagsList;
+typedef vector<CLwoSurface*> tSurfaceList;
+typedef vector<CLwoEnvelope*> tEnvelopeList;
+typedef vector<CLwoClip*> tClipList;
+typedef vector<CLwoVertexMap*> tVertexMapList;
+
 // layer: collection of points/polygons/vectors/surfaces etc.
 // can have pivot point and other info directly on it also
 class CLwoLayer : public CLwoChunk
 {
 public:
 	// if parent-layer for layer is given, keep here:
-	// zero-based value,
+	// layer-number of parent (see m_usLayerNumber),
 	// can be -1 if not specified
 	int m_iParentLayerIndex;
 
-	// TODO: replace index by pointer to parent-layer? (if any?)
-	//CLwoLayer *m_pParentLayer;
+	// parent-layer located by number above
+	// (NULL when none or not found),
+	// see CLwoObjectData::BuildLayerTree()
+	CLwoLayer *m_pParentLayer;
+
+	// layers having this as parent
+	tLayerList m_ChildLayers;
 
 	// triplet of floats (vertex, XYZ)
-	// for layer pivot-point
-	float *m_pfPivotPoint;
+	// for layer pivot-point (origin when not given)
+	float m_fPivotPoint[3];
+
+	// offset currently subtracted from point-coordinates
+	// (zero as in file, pivot when kept separate),
+	// see CLwoObjectData::FlattenLayers()
+	float m_fPointOffset[3];
+
+	// translation relative to parent-layer
+	// when layers are kept separate (pivot minus parent pivot)
+	float m_fLocalOffset[3];
 
 	unsigned short m_usLayerNumber;
 	unsigned short m_usLayerFlags;
@@ -109,36 +157,95 @@ public:
 	// has "true" list of data (with release) 
 	tChunkList m_ChunksInLayer;
 
+	// same by type (in order of file),
+	// polygons also by polygon-type (FACE, CURV..)
+	tPointsList m_PointsInLayer;
+	tPolygonsList m_PolygonsInLayer;
+	map<unsigned int, tPolygonsList> m_PolygonsByType;
+	tVertexMapList m_VertexMapsInLayer;
+
+	// most recent BBOX (NULL when not given)
+	CLwoBoundingBox *m_pBoundingBox;
+
 public:
 	// zero-base index of the layer (this)
 	CLwoLayer(const unsigned int uiLayerIndex)
 		: CLwoChunk(ID_LAYR, uiLayerIndex)
 		, m_iParentLayerIndex(-1)
-		, m_pfPivotPoint(NULL)
+		, m_pParentLayer(NULL)
+		, m_ChildLayers()
 		, m_usLayerNumber(0)
 		, m_usLayerFlags(0)
 		, m_szLayerName()
 		, m_ChunksInLayer()
-	{};
-	virtual ~CLwoLayer()
+		, m_PointsInLayer()
+		, m_PolygonsInLayer()
+		, m_PolygonsByType()
+		, m_VertexMapsInLayer()
+		, m_pBoundingBox(NULL)
 	{
-		if (m_pfPivotPoint != NULL)
+		for (int i = 0; i < 3; i++)
 		{
-			delete m_pfPivotPoint;
-			m_pfPivotPoint = NULL;
+			m_fPivotPoint[i] = 0.0f;
+			m_fPointOffset[i] = 0.0f;
+			m_fLocalOffset[i] = 0.0f;
 		}
-
+	};
+	virtual ~CLwoLayer()
+	{
 		// don't destroy objects here,
 		// only remove the pointers (see CLwoObjectData)
 		m_ChunksInLayer.clear();
+		m_PointsInLayer.clear();
+		m_PolygonsInLayer.clear();
+		m_PolygonsByType.clear();
+		m_VertexMapsInLayer.clear();
+		m_pBoundingBox = NULL;
+		m_ChildLayers.clear();
+	};
+
+	// pivot-point or origin when not given
+	float GetPivot(const int iAxis) const
+	{
+		return m_fPivotPoint[iAxis];
 	};
 
 	// reference-list only so that we can easily
-	// locate data in a single layer
-	bool AddChunkToLayer(CLwoChunk *pChunk)
+	// locate data in a single layer,
+	// also indexed by type (polygon-type must be set before adding)
+	bool AddChunkToLayer(CLwoChunk *pChunk);
+
+	const tPointsList &GetPoints() const
 	{
-		m_ChunksInLayer.push_back(pChunk);
-		return true;
+		return m_PointsInLayer;
+	};
+
+	// all polygon-lists or only of given type (FACE, CURV..)
+	const tPolygonsList &GetPolygons() const
+	{
+		return m_PolygonsInLayer;
+	};
+	const tPolygonsList &GetPolygons(const unsigned int uiPolyTypeID) const
+	{
+		static const tPolygonsList EmptyList;
+
+		map<unsigned int, tPolygonsList>::const_iterator itType = m_PolygonsByType.find(uiPolyTypeID);
+		if (itType == m_PolygonsByType.end())
+		{
+			return EmptyList;
+		}
+		return itType->second;
+	};
+
+	// VMAP and VMAD
+	const tVertexMapList &GetVertexMaps() const
+	{
+		return m_VertexMapsInLayer;
+	};
+
+	CLwoBoundingBox *GetBoundingBox() const
+	{
+		return m_pBoundingBox;
 	};
 };
 
@@ -146,11 +253,11 @@ public:
 class CLwoBoundingBox : public CLwoChunk
 {
 public:
-	// array of floats with the extents of the layer
+	// minimum and maximum of the layer
 	//
-	float *m_pfBoxExtents;
+	float m_fBoxExtents[6];
 
-	// amount of values in buffer (size of buffer)
+	// amount of values given in file (six when valid)
 	long m_lValueCount;
 
 public:
@@ -158,15 +265,14 @@ public:
 	CLwoBoundingBox(const unsigned int uiLayerIndex)
 		: CLwoChunk(ID_BBOX, uiLayerIndex)
 		, m_lValueCount(0)
-		, m_pfBoxExtents(NULL)
-	{};
-	virtual ~CLwoBoundingBox()
 	{
-		if (m_pfBoxExtents != NULL)
+		for (int i = 0; i < 6; i++)
 		{
-			delete m_pfBoxExtents;
-			m_pfBoxExtents = NULL;
+			m_fBoxExtents[i] = 0.0f;
 		}
+	};
+	virtual ~CLwoBoundingBox()
+	{
 		m_lValueCount = 0;
 	};
 };
@@ -180,30 +286,24 @@ public:
 class CLwoPoints : public CLwoChunk
 {
 public:
-	// array of floats with coordinates of points
+	// floats with coordinates of points (XYZ of each)
 	// which may be shared by vertices (before adding normals)
 	//
-	float *m_pfPointList;
-
-	// amount of values in buffer (size of buffer)
-	long m_lValueCount;
+	vector<float> m_PointList;
 
 	// TODO: keep reference to polygon-data here?
 
 public:
 	CLwoPoints(const unsigned int uiLayerIndex)
 		: CLwoChunk(ID_PNTS, uiLayerIndex)
-		, m_lValueCount(0)
-		, m_pfPointList(NULL)
+		, m_PointList()
 	{};
 	virtual ~CLwoPoints()
+	{};
+
+	long GetPointCount() const
 	{
-		if (m_pfPointList != NULL)
-		{
-			delete m_pfPointList;
-			m_pfPointList = NULL;
-		}
-		m_lValueCount = 0;
+		return (long)(m_PointList.size() / 3);
 	};
 };
 
@@ -221,39 +321,43 @@ public:
 		unsigned short m_wVertexCount;
 		unsigned short m_wFlags;
 
-		// TODO:
 		// in older LWOB-format, we can have
 		// 1-based surface-index in each row
+		// (zero when not given)
 		unsigned short m_wSurfaceIndex;
-		// use pointer to surface to simplify later?
-		//CLwoChunk *m_pSurface;
 
-		// TODO: also, each poly may have detail-polygons
+		// surface of polygon by PTAG SURF-mapping
+		// (LWOB: by surface-index),
+		// see CLwoObjectData::ResolvePolygonSurfaces()
+		CLwoSurface *m_pSurface;
+
+		// LWOB detail-polygons of this polygon:
+		// rows in m_pDetailPolygons of the polygon-list
+		long m_lFirstDetailIndex;
+		unsigned short m_usDetailCount;
 
-		// list of indices (keep as int for simplicity, 
-		// varying sizes in source data),
-		// see m_wVertexCount for count (length of array)
+		// in detail-polygon list: row of parent polygon
+		// (-1 in normal polygons)
+		long m_lParentRowIndex;
+
+		// position of indices in m_Indices of the polygon-list
+		// (keep as int for simplicity, varying sizes in source data),
+		// see m_wVertexCount for count and CLwoPolygons::GetIndices()
 		// 
-		int *m_piIndices;
+		long m_lFirstIndex;
 
 	public:
-		CLwoPolyRow(const long lPolyRowIndex, const unsigned short wVertexCount, const unsigned short wFlags)
+		CLwoPolyRow(const long lPolyRowIndex, const unsigned short wVertexCount, const unsigned short wFlags, const long lFirstIndex)
 			: m_lPolyRowIndex(lPolyRowIndex)
 			, m_wVertexCount(wVertexCount)
 			, m_wFlags(wFlags)
 			, m_wSurfaceIndex(0)
-			, m_piIndices(NULL)
-		{
-			m_piIndices = new int[m_wVertexCount];
-		};
-		~CLwoPolyRow(void)
-		{
-			if (m_piIndices != NULL)
-			{
-				delete m_piIndices;
-				m_piIndices = NULL;
-			}
-		};
+			, m_pSurface(NULL)
+			, m_lFirstDetailIndex(0)
+			, m_usDetailCount(0)
+			, m_lParentRowIndex(-1)
+			, m_lFirstIndex(lFirstIndex)
+		{};
 	};
 
 public:
@@ -261,38 +365,56 @@ public:
 	// FACE, CURV, PTCH, MBAL or BONE
 	unsigned int m_uiPolyTypeID;
 
-	// keep arrays of indices
-	// (may have different sizes)
-	// which refer to point-list
-	typedef vector<CLwoPolyRow*> tPolyList;
+	// rows of polygons, each refers to its indices
+	// (may have different sizes) which refer to point-list
+	typedef vector<CLwoPolyRow> tPolyList;
 	tPolyList m_PolyList;
 
+	// vertex-indices of all rows one after another
+	vector<int> m_Indices;
+
 	// keep reference to points
 	CLwoPoints *m_pPointsList;
 
+	// LWOB detail-polygons are kept as second polygon-list
+	// (separate chunk in object data):
+	// main list refers to details and details to main list
+	CLwoPolygons *m_pDetailPolygons;
+	CLwoPolygons *m_pParentPolygons;
+
 public:
 	CLwoPolygons(const unsigned int uiLayerIndex)
 		: CLwoChunk(ID_POLS, uiLayerIndex)
 		, m_uiPolyTypeID(0)
 		, m_pPointsList(NULL)
+		, m_pDetailPolygons(NULL)
+		, m_pParentPolygons(NULL)
 	{};
 	virtual ~CLwoPolygons()
 	{
-		tPolyList::iterator itList = m_PolyList.begin();
-		tPolyList::iterator itListEnd = m_PolyList.end();
-		while (itList != itListEnd)
-		{
-			CLwoPolyRow *pRow = (*itList);
-			if (pRow != NULL)
-			{
-				delete pRow;
-			}
-			++itList;
-		}
-		m_PolyList.clear();
-
 		// don't delete, only reference here
 		m_pPointsList = NULL;
+		m_pDetailPolygons = NULL;
+		m_pParentPolygons = NULL;
+	};
+
+	// new row with room for its indices:
+	// reference is valid until next row is added
+	CLwoPolyRow &AddRow(const unsigned short wVertexCount, const unsigned short wFlags)
+	{
+		m_PolyList.push_back(CLwoPolyRow((long)m_PolyList.size(), wVertexCount, wFlags, (long)m_Indices.size()));
+		m_Indices.resize(m_Indices.size() + wVertexCount);
+		return m_PolyList.back();
+	};
+
+	// indices of row (m_wVertexCount of them)
+	int *GetIndices(const CLwoPolyRow &Row)
+	{
+		return (m_Indices.data() + Row.m_lFirstIndex);
+	};
+	const int *GetIndices(const CLwoPolyRow &Row) const
+	{
+		return (m_Indices.data() + Row.m_lFirstIndex);
 	};
 };
 
@@ -334,22 +456,167 @@ public:
 // for polygon
 class CLwoSurface : public CLwoChunk
 {
-	/*
 public:
-	// sub-chunk of surface
-	class CSurfacePart
+	// texture layer of surface (BLOK sub-chunk):
+	// image-map, procedural texture, gradient or shader
+	// with the texture-mapping (TMAP) and attributes of that type
+	class CLwoTextureLayer
 	{
 	public:
-		unsigned int m_uiSurfTypeID;
+		// IMAP, PROC, GRAD or SHDR
+		unsigned int m_uiBlokTypeID;
+
+		// ordinal string: layers are evaluated
+		// in order of these (compare as strings)
+		string m_szOrdinal;
+
+		// header attributes: CHAN, ENAB, OPAC, AXIS, NEGA
+
+		// surface channel affected:
+		// COLR, DIFF, LUMI, SPEC, GLOS, REFL, TRAN, RIND, TRNL or BUMP
+		unsigned int m_uiChannel;
+		unsigned short m_usEnable;
+		unsigned short m_usOpacityType;
+		float m_fOpacity;
+		unsigned int m_uiOpacityEnvelope;
+		unsigned short m_usDisplacementAxis;
+		unsigned short m_usNegative;
+
+		// texture mapping (TMAP):
+		// vector and envelope-index of each
+		float m_fCenter[3];
+		unsigned int m_uiCenterEnvelope;
+		float m_fSize[3];
+		unsigned int m_uiSizeEnvelope;
+		float m_fRotation[3];
+		unsigned int m_uiRotationEnvelope;
+		string m_szReferenceObject;
+		unsigned short m_usFalloffType;
+		float m_fFalloff[3];
+		unsigned int m_uiFalloffEnvelope;
+		unsigned short m_usCoordSystem;
+
+		// image-map (IMAP) attributes
+		unsigned short m_usProjection;
+		unsigned short m_usAxis;
+
+		// 1-based index of CLIP, zero if not used
+		unsigned int m_uiImageIndex;
+		unsigned short m_usWrapWidth;
+		unsigned short m_usWrapHeight;
+		float m_fWrapWidthCycles;
+		unsigned int m_uiWrapWidthEnvelope;
+		float m_fWrapHeightCycles;
+		unsigned int m_uiWrapHeightEnvelope;
+
+		// name of TXUV vertex-map for UV-projection
+		string m_szVmapName;
+		unsigned short m_usAntialiasFlags;
+		float m_fAntialiasStrength;
+		unsigned short m_usPixelBlending;
+		unsigned short m_usSticky;
+		float m_fStickyTime;
+		float m_fAmplitude;
+		unsigned int m_uiAmplitudeEnvelope;
+
+		// procedural texture (PROC) value (1 or 3 floats)
+		// and algorithm of procedural (or shader, SHDR)
+		float m_fValue[3];
+		unsigned short m_usValueCount;
+		string m_szFunction;
+		vector<char> m_FunctionData;
+
+		// gradient (GRAD) attributes
+		string m_szParameterName;
+		string m_szItemName;
+		float m_fGradientStart;
+		float m_fGradientEnd;
+		unsigned short m_usRepeatMode;
+
+		// gradient key: input and RGBA output
+		class CLwoGradientKey
+		{
+		public:
+			float m_fInput;
+			float m_fOutput[4];
+		};
+		vector<CLwoGradientKey> m_GradientKeys;
+		vector<unsigned short> m_GradientInterpolation;
 
-	};
+		// resolved after parsing (see CLwoObjectData):
+		// image (CLIP) and UV-map (VMAP/VMAD) this layer uses,
+		// NULL when not available
+		CLwoClip *m_pClip;
+		CLwoVertexMap *m_pUVMap;
+		CLwoVertexMap *m_pUVMapDiscontinuous;
 
-	// or:
-	class CTexture
-	{
+	public:
+		CLwoTextureLayer()
+			: m_uiBlokTypeID(0)
+			, m_szOrdinal()
+			, m_uiChannel(0)
+			, m_usEnable(1)
+			, m_usOpacityType(0)
+			, m_fOpacity(1.0f)
+			, m_uiOpacityEnvelope(0)
+			, m_usDisplacementAxis(0)
+			, m_usNegative(0)
+			, m_uiCenterEnvelope(0)
+			, m_uiSizeEnvelope(0)
+			, m_uiRotationEnvelope(0)
+			, m_szReferenceObject()
+			, m_usFalloffType(0)
+			, m_uiFalloffEnvelope(0)
+			, m_usCoordSystem(0)
+			, m_usProjection(0)
+			, m_usAxis(0)
+			, m_uiImageIndex(0)
+			, m_usWrapWidth(1)
+			, m_usWrapHeight(1)
+			, m_fWrapWidthCycles(1.0f)
+			, m_uiWrapWidthEnvelope(0)
+			, m_fWrapHeightCycles(1.0f)
+			, m_uiWrapHeightEnvelope(0)
+			, m_szVmapName()
+			, m_usAntialiasFlags(0)
+			, m_fAntialiasStrength(0.0f)
+			, m_usPixelBlending(0)
+			, m_usSticky(0)
+			, m_fStickyTime(0.0f)
+			, m_fAmplitude(1.0f)
+			, m_uiAmplitudeEnvelope(0)
+			, m_usValueCount(0)
+			, m_szFunction()
+			, m_FunctionData()
+			, m_szParameterName()
+			, m_szItemName()
+			, m_fGradientStart(0.0f)
+			, m_fGradientEnd(1.0f)
+			, m_usRepeatMode(0)
+			, m_GradientKeys()
+			, m_GradientInterpolation()
+			, m_pClip(NULL)
+			, m_pUVMap(NULL)
+			, m_pUVMapDiscontinuous(NULL)
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				m_fCenter[i] = 0.0f;
+				m_fSize[i] = 1.0f;
+				m_fRotation[i] = 0.0f;
+				m_fFalloff[i] = 0.0f;
+				m_fValue[i] = 0.0f;
+			}
+		};
+
+		// texture layers are kept sorted by ordinal
+		bool operator < (const CLwoTextureLayer &Other) const
+		{
+			return (m_szOrdinal < Other.m_szOrdinal);
+		};
 	};
 
-	*/
+	typedef vector<CLwoTextureLayer> tTextureLayerList;
 
 public:
 	// name of this surface
@@ -358,60 +625,385 @@ public:
 	// name of parent surface (if any)
 	string m_szParentSurfaceName;
 
+	// texture layers of this surface (BLOK sub-chunks),
+	// sorted by ordinal when surface has been parsed
+	tTextureLayerList m_TextureLayers;
+
+	// basic material parameters,
+	// LWOB values are converted to same ranges as in LWO2
+	// (defaults as in Lightwave SDK)
+	float m_fColor[3];
+	unsigned int m_uiColorEnvelope;
+	float m_fDiffuse;
+	float m_fLuminosity;
+	float m_fSpecular;
+	float m_fGlossiness;
+	float m_fReflection;
+	float m_fTransparency;
+	float m_fTranslucency;
+	float m_fRefractiveIndex;
+	float m_fBump;
+
+	// max smoothing angle in radians (zero: not smoothed)
+	float m_fSmoothingAngle;
+
+	// 1: front-side only, 3: double-sided
+	unsigned short m_usSidedness;
+
 public:
 	CLwoSurface(const unsigned int uiLayerIndex)
 		: CLwoChunk(ID_SURF, uiLayerIndex)
 		, m_szSurfaceName()
 		, m_szParentSurfaceName()
-	{};
+		, m_TextureLayers()
+		, m_uiColorEnvelope(0)
+		, m_fDiffuse(1.0f)
+		, m_fLuminosity(0.0f)
+		, m_fSpecular(0.0f)
+		, m_fGlossiness(0.4f)
+		, m_fReflection(0.0f)
+		, m_fTransparency(0.0f)
+		, m_fTranslucency(0.0f)
+		, m_fRefractiveIndex(1.0f)
+		, m_fBump(1.0f)
+		, m_fSmoothingAngle(0.0f)
+		, m_usSidedness(1)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			m_fColor[i] = 0.78431f;
+		}
+	};
 	virtual ~CLwoSurface()
-	{};
+	{
+		m_TextureLayers.clear();
+	};
+
+	// value of scalar channel by sub-chunk ID
+	// (DIFF, LUMI, SPEC, GLOS, REFL, TRAN, TRNL, RIND, BUMP),
+	// NULL for other IDs
+	float *GetChannelValue(const unsigned int uiChannel)
+	{
+		switch (uiChannel)
+		{
+		case ID_DIFF:
+			return &m_fDiffuse;
+		case ID_LUMI:
+			return &m_fLuminosity;
+		case ID_SPEC:
+			return &m_fSpecular;
+		case ID_GLOS:
+			return &m_fGlossiness;
+		case ID_REFL:
+			return &m_fReflection;
+		case ID_TRAN:
+			return &m_fTransparency;
+		case ID_TRNL:
+			return &m_fTranslucency;
+		case ID_RIND:
+			return &m_fRefractiveIndex;
+		case ID_BUMP:
+			return &m_fBump;
+		}
+		return NULL;
+	};
 };
 
+// envelope: animated value of a parameter,
+// keys of the curve and behaviour before first and after last key
 class CLwoEnvelope : public CLwoChunk
 {
-	/*
 public:
-	// sub-chunk of envelope
-	class CEnvelopePart
+	// key of the curve (KEY and SPAN sub-chunks):
+	// shape describes the span from previous key to this one
+	class CLwoEnvelopeKey
 	{
 	public:
-		unsigned int m_uiEnvlTypeID;
+		float m_fTime;
+		float m_fValue;
+
+		// TCB, HERM, BEZI, BEZ2, LINE or STEP
+		unsigned int m_uiShape;
+
+		// TCB-spline parameters
+		float m_fTension;
+		float m_fContinuity;
+		float m_fBias;
+
+		// Hermite and Bezier curve parameters
+		float m_fParam[4];
+
+	public:
+		CLwoEnvelopeKey(const float fTime, const float fValue)
+			: m_fTime(fTime)
+			, m_fValue(fValue)
+			, m_uiShape(ID_TCB)
+			, m_fTension(0.0f)
+			, m_fContinuity(0.0f)
+			, m_fBias(0.0f)
+		{
+			for (int i = 0; i < 4; i++)
+			{
+				m_fParam[i] = 0.0f;
+			}
+		};
 
+		// keys are kept sorted by time
+		bool operator < (const CLwoEnvelopeKey &Other) const
+		{
+			return (m_fTime < Other.m_fTime);
+		};
 	};
-	*/
+
+	// behaviour outside of the keys (PRE and POST)
+	enum tEnvelopeBehavior
+	{
+		BEH_RESET = 0,
+		BEH_CONSTANT = 1,
+		BEH_REPEAT = 2,
+		BEH_OSCILLATE = 3,
+		BEH_OFFSET = 4,
+		BEH_LINEAR = 5
+	};
+
+	// channel modifier plugin (CHAN sub-chunk)
+	class CLwoEnvelopePlugin
+	{
+	public:
+		string m_szServerName;
+		unsigned short m_usFlags;
+		vector<char> m_Data;
+	};
+
+	typedef vector<CLwoEnvelopeKey> tKeyList;
+	typedef vector<CLwoEnvelopePlugin> tPluginList;
 
 public:
+	// index of this envelope (referred by VX of other chunks)
 	int m_iEnvelopeIndex;
 
+	// TYPE sub-chunk: user-interface format and type of value
+	unsigned char m_ucUserFormat;
+	unsigned char m_ucType;
+
+	// tEnvelopeBehavior before first and after last key
+	unsigned short m_usPreBehavior;
+	unsigned short m_usPostBehavior;
+
+	// keys sorted by time
+	tKeyList m_Keys;
+
+	tPluginList m_Plugins;
+
+	// name of channel (if given)
+	string m_szName;
+
 public:
 	CLwoEnvelope(const unsigned int uiLayerIndex)
 		: CLwoChunk(ID_ENVL, uiLayerIndex)
 		, m_iEnvelopeIndex(0)
+		, m_ucUserFormat(0)
+		, m_ucType(0)
+		, m_usPreBehavior(BEH_CONSTANT)
+		, m_usPostBehavior(BEH_CONSTANT)
+		, m_Keys()
+		, m_Plugins()
+		, m_szName()
 	{};
 	virtual ~CLwoEnvelope()
-	{};
+	{
+		m_Keys.clear();
+		m_Plugins.clear();
+	};
 };
 
+// clip: image (or sequence) used by texture layers,
+// referred to by 1-based index
 class CLwoClip : public CLwoChunk
 {
+public:
+	// image/pixel filter plugin (IFLT, PFLT sub-chunks)
+	class CLwoClipFilter
+	{
+	public:
+		string m_szServerName;
+		unsigned short m_usFlags;
+		vector<char> m_Data;
+	};
+
+	// image adjustment with envelope
+	// (CONT, BRIT, SATR, HUE, GAMM sub-chunks)
+	class CLwoClipAdjust
+	{
+	public:
+		float m_fValue;
+		unsigned int m_uiEnvelope;
+
+		CLwoClipAdjust(const float fValue = 0.0f)
+			: m_fValue(fValue)
+			, m_uiEnvelope(0)
+		{};
+	};
+
+	typedef vector<CLwoClipFilter> tFilterList;
+
+public:
+	// index of this clip (referred from IMAG of texture layer)
+	unsigned int m_uiClipIndex;
+
+	// source of clip: STIL, ISEQ, ANIM, XREF or STCC
+	unsigned int m_uiClipTypeID;
+
+	// still image filename (STIL),
+	// prefix of image sequence (ISEQ),
+	// animation filename (ANIM)
+	// or color-cycling still filename (STCC)
+	string m_szFilename;
+
+	// image sequence (ISEQ):
+	// filename is prefix + frame number (digits) + suffix
+	unsigned char m_ucSeqDigits;
+	unsigned char m_ucSeqFlags;
+	short m_sSeqOffset;
+	short m_sSeqStart;
+	short m_sSeqEnd;
+	string m_szSeqSuffix;
+
+	// plugin animation (ANIM)
+	string m_szServerName;
+	unsigned short m_usAnimFlags;
+	vector<char> m_AnimData;
+
+	// reference to another clip (XREF):
+	// index of clip and name of this instance
+	unsigned int m_uiXrefIndex;
+	string m_szXrefName;
+
+	// color-cycling still (STCC)
+	short m_sCycleLow;
+	short m_sCycleHigh;
+
+	// time of animated clip (TIME)
+	float m_fStartTime;
+	float m_fDuration;
+	float m_fFrameRate;
+
+	// color space of RGB and alpha (CLRS, CLRA)
+	unsigned short m_usColorSpaceRGB;
+	unsigned short m_usColorSpaceAlpha;
+
+	// filtering and dithering (FILT, DITH)
+	unsigned short m_usFiltering;
+	unsigned short m_usDithering;
+
+	// image adjustments
+	CLwoClipAdjust m_Contrast;
+	CLwoClipAdjust m_Brightness;
+	CLwoClipAdjust m_Saturation;
+	CLwoClipAdjust m_Hue;
+	CLwoClipAdjust m_Gamma;
+	unsigned short m_usNegative;
+
+	// plugin filters
+	tFilterList m_ImageFilters;
+	tFilterList m_PixelFilters;
+
 public:
 	CLwoClip(const unsigned int uiLayerIndex)
 		: CLwoChunk(ID_CLIP, uiLayerIndex)
+		, m_uiClipIndex(0)
+		, m_uiClipTypeID(0)
+		, m_szFilename()
+		, m_ucSeqDigits(0)
+		, m_ucSeqFlags(0)
+		, m_sSeqOffset(0)
+		, m_sSeqStart(0)
+		, m_sSeqEnd(0)
+		, m_szSeqSuffix()
+		, m_szServerName()
+		, m_usAnimFlags(0)
+		, m_AnimData()
+		, m_uiXrefIndex(0)
+		, m_szXrefName()
+		, m_sCycleLow(0)
+		, m_sCycleHigh(0)
+		, m_fStartTime(0.0f)
+		, m_fDuration(0.0f)
+		, m_fFrameRate(0.0f)
+		, m_usColorSpaceRGB(0)
+		, m_usColorSpaceAlpha(0)
+		, m_usFiltering(0)
+		, m_usDithering(0)
+		, m_Contrast()
+		, m_Brightness()
+		, m_Saturation()
+		, m_Hue()
+		, m_Gamma(1.0f)
+		, m_usNegative(0)
+		, m_ImageFilters()
+		, m_PixelFilters()
 	{};
 	virtual ~CLwoClip()
-	{};
+	{
+		m_ImageFilters.clear();
+		m_PixelFilters.clear();
+	};
 };
 
-// TODO: also for VMAD (discontinuous mapping)?
+// vertex map (VMAP) or 
+// discontinuous vertex map (VMAD) when polygon-indices are given:
+// values per vertex (and polygon) such as UV-coordinates, weights..
 class CLwoVertexMap : public CLwoChunk
 {
 public:
-	CLwoVertexMap(const unsigned int uiLayerIndex)
-		: CLwoChunk(ID_VMAP, uiLayerIndex)
+	// type of map: TXUV, WGHT, MORF, RGB, RGBA, PICK..
+	unsigned int m_uiVmapTypeID;
+
+	// amount of values per vertex
+	unsigned short m_usDimension;
+
+	// name of this map (referred by texture layers etc.)
+	string m_szName;
+
+	// vertex-indices to point-list,
+	// and polygon-indices when discontinuous (VMAD)
+	vector<int> m_VertexIndices;
+	vector<int> m_PolyIndices;
+
+	// values of each mapped vertex:
+	// m_usDimension values for each index in list
+	vector<float> m_Values;
+
+	// keep reference to points this maps
+	CLwoPoints *m_pPointsList;
+
+	// polygon-list of polygon-indices (VMAD only):
+	// one preceding this
+	CLwoPolygons *m_pPolyList;
+
+public:
+	CLwoVertexMap(const unsigned int uiLayerIndex, const bool bDiscontinuous = false)
+		: CLwoChunk((bDiscontinuous == true) ? ID_VMAD : ID_VMAP, uiLayerIndex)
+		, m_uiVmapTypeID(0)
+		, m_usDimension(0)
+		, m_szName()
+		, m_VertexIndices()
+		, m_PolyIndices()
+		, m_Values()
+		, m_pPointsList(NULL)
+		, m_pPolyList(NULL)
 	{};
 	virtual ~CLwoVertexMap()
-	{};
+	{
+		// don't delete, only reference here
+		m_pPointsList = NULL;
+		m_pPolyList = NULL;
+	};
+
+	bool IsDiscontinuous() const
+	{
+		return (m_uiChunkType == ID_VMAD);
+	};
 };
 
 //////////////////
@@ -426,64 +1018,146 @@ class CLwoObjectData
 {
 protected:
 	// list of all chunks found for the object in file:
-	// when destroying this list should also destroy objects
-	// to release memory (see destructor here)
-	tChunkList m_ChunkList;
+	// owns them, others refer to them by pointer
+	tOwnedChunkList m_ChunkList;
 
 	// zero-based index for next layer (if any),
 	// counter when adding layers for simplicity
 	unsigned int m_uiNextLayerIndex;
 
-	inline CLwoChunk *GetNextOfType(const unsigned int uiType, tChunkList &ChunkList, tChunkList::iterator &itCurPos);
+	// layers with parents before children
+	// (root-layers in order of file, then children of each)
+	tLayerList m_LayerOrder;
+
+	// chunks by type in order of file,
+	// indexed when added (see AddChunk())
+	tLayerList m_Layers;
+	tTagnameListList m_Tagnames;
+	tPolyTagsList m_PolyTags;
+	tSurfaceList m_Surfaces;
+	tEnvelopeList m_Envelopes;
+	tClipList m_Clips;
+	tVertexMapList m_VertexMaps;
+
+	// most recently added of each chunk-type
+	// (for parsing where chunks refer to previous ones)
+	map<unsigned int, CLwoChunk*> m_LastOfType;
+
+	// map image-map texture layers to clips and UV-maps
+	bool ResolveTextureLayers();
+
+	// link layers to parents by layer-number
+	// and collect layers in hierarchy order
+	bool BuildLayerTree();
+
+	// map polygons to surfaces (PTAG SURF and TAGS),
+	// same for LWOB where tags are made from SRFS
+	bool ResolvePolygonSurfaces();
+
+	// lists by type and most recent of type (see AddChunk())
+	void IndexChunk(CLwoChunk *pChunk);
 
 public:
 	CLwoObjectData(void)
 		: m_uiNextLayerIndex(0) // zero-based
+		, m_LayerOrder()
+		, m_Layers()
+		, m_Tagnames()
+		, m_PolyTags()
+		, m_Surfaces()
+		, m_Envelopes()
+		, m_Clips()
+		, m_VertexMaps()
+		, m_LastOfType()
 	{};
 	~CLwoObjectData(void)
 	{
-		tChunkList::iterator itChunks = m_ChunkList.begin();
-		tChunkList::iterator itChunksEnd = m_ChunkList.end();
-		while (itChunks != itChunksEnd)
+		Clear();
+	};
+
+	// chunks are owned by this: no copies,
+	// moving hands over all chunks and leaves source empty
+	CLwoObjectData(const CLwoObjectData &Other) = delete;
+	CLwoObjectData &operator = (const CLwoObjectData &Other) = delete;
+
+	CLwoObjectData(CLwoObjectData &&Other)
+		: m_uiNextLayerIndex(0)
+		, m_LayerOrder()
+		, m_Layers()
+		, m_Tagnames()
+		, m_PolyTags()
+		, m_Surfaces()
+		, m_Envelopes()
+		, m_Clips()
+		, m_VertexMaps()
+		, m_LastOfType()
+	{
+		Swap(Other);
+	};
+	CLwoObjectData &operator = (CLwoObjectData &&Other)
+	{
+		if (this != &Other)
 		{
-			CLwoChunk *pChunk = (*itChunks);
-			if (pChunk != NULL)
-			{
-				delete pChunk;
-			}
-			++itChunks;
+			Clear();
+			Swap(Other);
 		}
+		return *this;
+	};
+
+	void Swap(CLwoObjectData &Other)
+	{
+		m_ChunkList.swap(Other.m_ChunkList);
+		m_LayerOrder.swap(Other.m_LayerOrder);
+		m_Layers.swap(Other.m_Layers);
+		m_Tagnames.swap(Other.m_Tagnames);
+		m_PolyTags.swap(Other.m_PolyTags);
+		m_Surfaces.swap(Other.m_Surfaces);
+		m_Envelopes.swap(Other.m_Envelopes);
+		m_Clips.swap(Other.m_Clips);
+		m_VertexMaps.swap(Other.m_VertexMaps);
+		m_LastOfType.swap(Other.m_LastOfType);
+		unsigned int uiIndex = m_uiNextLayerIndex;
+		m_uiNextLayerIndex = Other.m_uiNextLayerIndex;
+		Other.m_uiNextLayerIndex = uiIndex;
+	};
+
+	// release all chunks for reusing this:
+	// lists keep their allocated capacity
+	void Clear()
+	{
 		m_ChunkList.clear();
+		m_LayerOrder.clear();
+		m_Layers.clear();
+		m_Tagnames.clear();
+		m_PolyTags.clear();
+		m_Surfaces.clear();
+		m_Envelopes.clear();
+		m_Clips.clear();
+		m_VertexMaps.clear();
+		m_LastOfType.clear();
+		m_uiNextLayerIndex = 0;
 	};
 
-	bool AddChunk(CLwoChunk *pChunk)
+	// takes ownership of new chunk and indexes it by type:
+	// returns the chunk for filling in,
+	// other chunks and layers may refer to it by pointer
+	template <class T> T *AddChunk(unique_ptr<T> pChunk)
 	{
-		// this list is used when eventually 
-		// releasing object from memory,
-		// other objects may link to each other 
-		// but they should not destroy others
-		m_ChunkList.push_back(pChunk);
-		return true;
+		T *pAdded = pChunk.get();
+		m_ChunkList.push_back(unique_ptr<CLwoChunk>(std::move(pChunk)));
+		IndexChunk(pAdded);
+		return pAdded;
 	};
 
-	CLwoChunk *GetPreviousOfType(const unsigned int uiType)
+	// previously added of given type (NULL if none)
+	CLwoChunk *GetPreviousOfType(const unsigned int uiType) const
 	{
-		// loop list if reverse to locate previously added of given type
-		tChunkList::reverse_iterator itChunks = m_ChunkList.rbegin();
-		tChunkList::reverse_iterator itChunksEnd = m_ChunkList.rend();
-		while (itChunks != itChunksEnd)
+		map<unsigned int, CLwoChunk*>::const_iterator itLast = m_LastOfType.find(uiType);
+		if (itLast == m_LastOfType.end())
 		{
-			CLwoChunk *pChunk = (*itChunks);
-			if (pChunk != NULL)
-			{
-				if (pChunk->m_uiChunkType == uiType)
-				{
-					return pChunk;
-				}
-			}
-			++itChunks;
+			return NULL;
 		}
-		return NULL;
+		return itLast->second;
 	};
 
 	unsigned int GetNextLayerIndex()
@@ -497,6 +1171,66 @@ public:
 	// related chunks and sub-chunks in the object data
 	bool CreateObjectLinkage();
 
+	// list of all chunks in order found from file
+	const tOwnedChunkList &GetChunkList() const
+	{
+		return m_ChunkList;
+	};
+
+	// layers with parents always before children,
+	// valid after CreateObjectLinkage()
+	const tLayerList &GetLayerOrder() const
+	{
+		return m_LayerOrder;
+	};
+
+	// chunks of each type in order of file:
+	// use these instead of scanning GetChunkList(),
+	// geometry of each layer is in CLwoLayer (GetPoints(), GetPolygons()..)
+	const tLayerList &GetLayers() const
+	{
+		return m_Layers;
+	};
+	const tTagnameListList &GetTagnames() const
+	{
+		return m_Tagnames;
+	};
+	const tPolyTagsList &GetPolyTags() const
+	{
+		return m_PolyTags;
+	};
+	const tSurfaceList &GetSurfaces() const
+	{
+		return m_Surfaces;
+	};
+	const tEnvelopeList &GetEnvelopes() const
+	{
+		return m_Envelopes;
+	};
+	const tClipList &GetClips() const
+	{
+		return m_Clips;
+	};
+	const tVertexMapList &GetVertexMaps() const
+	{
+		return m_VertexMaps;
+	};
+
+	// move points of each layer in-place:
+	// by default points are in object-space (as in file),
+	// when kept separate (for instancing) points are relative to layer pivot
+	// and m_fLocalOffset of each layer places it under its parent.
+	// can be called again to switch between these.
+	void FlattenLayers(const bool bKeepSeparate = false);
+
+	// heap used by this object by category
+	// (see LwoMemoryReport.h), added to given report
+	void GetMemoryReport(tLwoMemoryReport &Report) const;
+
+	// heap of chunks from given index onwards (see GetChunkList()),
+	// without lists of this: for accounting while parsing
+	void GetChunkMemoryReport(const size_t nFirstChunk, tLwoMemoryReport &Report) const;
+
 	//friend class CLwoReader;
 };
 
@@ -0,0 +1,256 @@
+//////////////////////////////////////////////////////////////////////
+// LwoParseCache.cpp : on-disk cache of parsed objects
+//
+
+#include "LwoParseCache.h"
+#include "LwoHash.h"
+#include "LwoReader.h"
+#include "LwoTrace.h"
+
+// sprintf(), remove()
+#include <cstdio>
+
+// sort()
+#include <algorithm>
+
+// directory listing and file times
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>
+#include <sys/utime.h>
+#else
+#include <dirent.h>
+#include <utime.h>
+#endif
+
+// extension of cached files,
+// version of baked format is part of name
+#define LWO_CACHE_EXTENSION LWO_BAKED_EXTENSION
+
+// cached file found when trimming
+struct tCacheEntry
+{
+	string m_szPath;
+	uint64_t m_ullSize;
+	uint64_t m_ullTime;
+
+	bool operator < (const tCacheEntry &Other) const
+	{
+		return (m_ullTime < Other.m_ullTime);
+	};
+};
+
+
+CLwoParseCache::CLwoParseCache(const string &szCacheDir, const uint64_t ullMaxSize)
+	: m_szCacheDir(szCacheDir)
+	, m_ullMaxSize(ullMaxSize)
+	, m_ulHits(0)
+	, m_ulMisses(0)
+{
+	if (m_szCacheDir.empty() == true)
+	{
+		m_szCacheDir = ".";
+	}
+
+	// create directory if missing (single level)
+#ifdef _WIN32
+	_mkdir(m_szCacheDir.c_str());
+#else
+	mkdir(m_szCacheDir.c_str(), 0777);
+#endif
+}
+
+CLwoParseCache::~CLwoParseCache(void)
+{
+}
+
+string CLwoParseCache::GetCachePath(const uint64_t ullHash) const
+{
+	char szName[64];
+	sprintf(szName, "/%016llx-v%d" LWO_CACHE_EXTENSION, (unsigned long long)ullHash, LWO_BAKED_VERSION);
+	return (m_szCacheDir + szName);
+}
+
+void CLwoParseCache::Touch(const string &szPath)
+{
+	// modification time to current time
+#ifdef _WIN32
+	_utime(szPath.c_str(), NULL);
+#else
+	utime(szPath.c_str(), NULL);
+#endif
+}
+
+bool CLwoParseCache::Load(const char *szPath, CLwoBakedFile &Baked, bool &bHit)
+{
+	bHit = false;
+
+	CMemFile LwoFile(szPath);
+	if (LwoFile.MapFile() == false)
+	{
+		return false;
+	}
+
+	CLwoReader LwoReader;
+	return Load(LwoFile, LwoReader, Baked, bHit);
+}
+
+bool CLwoParseCache::Load(CMemFile &LwoFile, CLwoReader &LwoReader, CLwoBakedFile &Baked, bool &bHit)
+{
+	bHit = false;
+	const char *szPath = LwoFile.GetFilename();
+	if (LwoFile.GetFileBuf() == NULL)
+	{
+		return false;
+	}
+
+	// content identifies the cached file
+	tLwoSourceKey Source;
+	{
+		CLwoTraceScope Trace("hash", 0, LwoFile.GetFilesize(), szPath);
+		if (CLwoBakedFile::MakeSourceKey(szPath, LwoFile.GetFileBuf(), LwoFile.GetFilesize(), Source) == false)
+		{
+			return false;
+		}
+	}
+	string szCachePath = GetCachePath(Source.m_ullHash);
+
+	// time of file is not part of the content:
+	// same content from any path is same object
+	if (Baked.Open(szCachePath.c_str()) == true)
+	{
+		const tLwoBakedHeader *pHeader = Baked.GetHeader();
+		if (pHeader->m_Source.m_ullHash == Source.m_ullHash
+			&& pHeader->m_Source.m_ullSize == Source.m_ullSize)
+		{
+			Touch(szCachePath);
+			bHit = true;
+			m_ulHits++;
+			return true;
+		}
+		Baked.Close();
+	}
+	m_ulMisses++;
+
+	if (LwoReader.ProcessFromFile(LwoFile) == false)
+	{
+		return false;
+	}
+
+	vector<char> Buffer;
+	{
+		CLwoTraceScope Trace("bake", 0, LwoFile.GetFilesize(), szPath);
+		CLwoBakedWriter Writer;
+		if (Writer.Bake(LwoReader.GetObjectData(), LwoReader.GetFileType(), Source, Buffer) == false)
+		{
+			return false;
+		}
+	}
+
+	{
+		CLwoTraceScope Trace("write cache", 0, Buffer.size(), szCachePath.c_str());
+		bool bWritten = CLwoBakedWriter::WriteAtomic(szCachePath, Buffer);
+#ifdef _WIN32
+		// replacing fails if other process has same file mapped:
+		// then it already has same content
+		if (bWritten == false)
+		{
+			struct _stat sStat;
+			bWritten = (_stat(szCachePath.c_str(), &sStat) == 0);
+		}
+#endif
+		if (bWritten == false
+			|| Baked.Open(szCachePath.c_str()) == false)
+		{
+			return false;
+		}
+	}
+
+	// mapped already: can be removed from directory
+	// by trimming without affecting this
+	Trim();
+	return true;
+}
+
+void CLwoParseCache::Trim()
+{
+	if (m_ullMaxSize == 0)
+	{
+		return;
+	}
+
+	// cached files with size and time of last use
+	vector<tCacheEntry> vEntries;
+	uint64_t ullTotalSize = 0;
+	string szExtension = LWO_CACHE_EXTENSION;
+
+#ifdef _WIN32
+	WIN32_FIND_DATAA FindData;
+	string szPattern = m_szCacheDir + "/*" + szExtension;
+	HANDLE hFind = FindFirstFileA(szPattern.c_str(), &FindData);
+	if (hFind == INVALID_HANDLE_VALUE)
+	{
+		return;
+	}
+	do
+	{
+		tCacheEntry Entry;
+		Entry.m_szPath = m_szCacheDir + "/" + FindData.cFileName;
+		Entry.m_ullSize = ((uint64_t)FindData.nFileSizeHigh << 32) | FindData.nFileSizeLow;
+		Entry.m_ullTime = ((uint64_t)FindData.ftLastWriteTime.dwHighDateTime << 32) | FindData.ftLastWriteTime.dwLowDateTime;
+		ullTotalSize += Entry.m_ullSize;
+		vEntries.push_back(Entry);
+	} while (FindNextFileA(hFind, &FindData) != FALSE);
+	FindClose(hFind);
+#else
+	DIR *pDir = opendir(m_szCacheDir.c_str());
+	if (pDir == NULL)
+	{
+		return;
+	}
+	struct dirent *pEntry = NULL;
+	while ((pEntry = readdir(pDir)) != NULL)
+	{
+		string szName = pEntry->d_name;
+		if (szName.length() <= szExtension.length()
+			|| szName.compare(szName.length() - szExtension.length(), szExtension.length(), szExtension) != 0)
+		{
+			// not cached file (or temporary of other process)
+			continue;
+		}
+
+		tCacheEntry Entry;
+		Entry.m_szPath = m_szCacheDir + "/" + szName;
+		struct stat sStat;
+		if (stat(Entry.m_szPath.c_str(), &sStat) != 0)
+		{
+			// removed by other process
+			continue;
+		}
+		Entry.m_ullSize = (uint64_t)sStat.st_size;
+		Entry.m_ullTime = (uint64_t)sStat.st_mtime;
+		ullTotalSize += Entry.m_ullSize;
+		vEntries.push_back(Entry);
+	}
+	closedir(pDir);
+#endif
+
+	if (ullTotalSize <= m_ullMaxSize)
+	{
+		return;
+	}
+
+	// oldest first
+	sort(vEntries.begin(), vEntries.end());
+	for (size_t i = 0; i < vEntries.size() && ullTotalSize > m_ullMaxSize; i++)
+	{
+		// failure is fine: other process may have removed it
+		// (or has it in use on Windows)
+		if (remove(vEntries[i].m_szPath.c_str()) == 0)
+		{
+			ullTotalSize -= vEntries[i].m_ullSize;
+		}
+	}
+}
@@ -0,0 +1,83 @@
+//////////////////////////////////////////////////////////////////////
+// LwoParseCache.h : on-disk cache of parsed objects
+//
+// Parsed objects are kept as baked files (see LwoBakedFile.h)
+// in a cache directory, named by hash of the source-file content:
+// same content is parsed only once, by any process using same directory.
+//
+// Files are written to temporary name and renamed in place
+// so that other processes see either whole file or none.
+// When directory grows over size-limit, least recently used files
+// (by modification time, updated on each hit) are removed.
+//
+// One cache can be used by many threads at same time
+// (e.g. workers of CLwoBatchLoader).
+//
+
+#ifndef _LWOPARSECACHE_H_
+#define _LWOPARSECACHE_H_
+
+#include "LwoBakedFile.h"
+
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+using namespace std;
+
+class CLwoReader;
+
+class CLwoParseCache
+{
+protected:
+	// directory of cached files
+	string m_szCacheDir;
+
+	// limit of total size of cached files in bytes
+	// (zero: no limit)
+	uint64_t m_ullMaxSize;
+
+	// statistics of this instance (any thread)
+	atomic<unsigned long> m_ulHits;
+	atomic<unsigned long> m_ulMisses;
+
+	// path of cached file for content hash
+	string GetCachePath(const uint64_t ullHash) const;
+
+	// mark cached file as recently used
+	void Touch(const string &szPath);
+
+public:
+	CLwoParseCache(const string &szCacheDir, const uint64_t ullMaxSize = 0);
+	~CLwoParseCache(void);
+
+	// baked form of source-file:
+	// from cache when content has been parsed before,
+	// otherwise file is parsed and added to cache.
+	// bHit tells if parsing was avoided.
+	bool Load(const char *szPath, CLwoBakedFile &Baked, bool &bHit);
+
+	// same for file already in memory (mapped or loaded):
+	// on miss it is parsed with given reader
+	// which keeps the parsed object for caller
+	bool Load(CMemFile &LwoFile, CLwoReader &LwoReader, CLwoBakedFile &Baked, bool &bHit);
+
+	// remove least recently used files until total size is within limit
+	void Trim();
+
+	uint64_t GetMaxSize() const
+	{
+		return m_ullMaxSize;
+	};
+
+	unsigned long GetHits() const
+	{
+		return m_ulHits;
+	};
+	unsigned long GetMisses() const
+	{
+		return m_ulMisses;
+	};
+};
+
+#endif // ifndef _LWOPARSECACHE_H_
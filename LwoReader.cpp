@@ -9,114 +9,170 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "LwoReader.h"
+#include "LwoByteSwap.h"
+#include "LwoTrace.h"
 
 // abs(), need explicit include for GCC
 #include <cmath>
 
+// memchr()
+#include <cstring>
+
+// stable_sort()
+#include <algorithm>
+
+// part of chunk read at a time when streaming to event handler
+// (grows if single record does not fit)
+#ifndef LWO_EVENT_WINDOW_SIZE
+#define LWO_EVENT_WINDOW_SIZE 65536
+#endif
+
+// statistics of handler or chunk type for rest of scope
+// (nothing when instrumentation is not enabled)
+#ifdef LWO_INSTRUMENTATION
+#define LWO_STAT_HANDLER(szName, ullBytes) CLwoStatScope HandlerStat(m_Stats.m_HandlerStats[szName], (ullBytes), m_pAllocs)
+#define LWO_STAT_CHUNK(uiChunkType, ullBytes) CLwoStatScope ChunkStat(m_Stats.m_ChunkStats[uiChunkType], (ullBytes), m_pAllocs)
+#define LWO_STAT_FILE(LwoFile) \
+	m_Stats.Clear(); \
+	m_Stats.m_szFile = (LwoFile).GetFilename(); \
+	m_Stats.m_ulFileSize = (LwoFile).GetFilesize(); \
+	m_Stats.m_bAllocs = (m_pAllocs != NULL); \
+	CLwoStatScope TotalStat(m_Stats.m_Total, m_Stats.m_ulFileSize, m_pAllocs)
+#else
+#define LWO_STAT_HANDLER(szName, ullBytes)
+#define LWO_STAT_CHUNK(uiChunkType, ullBytes)
+#define LWO_STAT_FILE(LwoFile)
+#endif
+
 
 /////// protected methods
 
 // make tag-ID from file
 unsigned int CLwoReader::MakeTag(const char *buf)
 {
-	return (
-		(unsigned long) (buf[0])<<24 
-		| (unsigned long) (buf[1])<<16 
-		| (unsigned long) (buf[2])<<8 
-		| (unsigned long) (buf[3]));
+	// (unsigned bytes, char may be signed)
+	return LwoGetU4(buf);
 }
 
 // byteswap 2 (short)
 unsigned short CLwoReader::BSwap2s(const unsigned short *buf)
 {
-	unsigned short tmp = (*buf);
-	return (((tmp >> 8)) | (tmp << 8));
+	return LwoGetU2((const char*)buf);
 }
 
 // byteswap 4 (int)
 unsigned int CLwoReader::BSwap4i(const unsigned int *buf)
 {
-	unsigned int tmp = (*buf);
-	return (
-			((tmp & 0x000000FF) << 24) + ((tmp & 0x0000FF00) <<8) +
-			((tmp & 0x00FF0000) >> 8) + ((tmp & 0xFF000000) >>24)
-			);
-}
-
-// byteswap 4: float special case (see comments)
-float CLwoReader::BSwapF(const float fVal)
-{
-	float fTmp = fVal;
-
-	// cast the "bit-array" via pointer for byteswap
-	// so we don't make int<->float cast by mistake
-
-	unsigned int uiTmp = BSwap4i((unsigned int*)(&fTmp));
-
-	fTmp = (*((float*)(&uiTmp)));
-	return fTmp;
+	return LwoGetU4((const char*)buf);
 }
 
 // get variable-length index-value from chunk-position,
 // may be 2 or 4 byte integer
 unsigned int CLwoReader::GetVarlenIX(const char *pChunk, int &iIxSize)
 {
-	// temp for value from buffer
-	unsigned int uiVertIndex = 0;
+	const unsigned char *pBuf = (const unsigned char*)pChunk;
 
 	// get variable-length index-value,
 	// it may be 2 or 4 bytes:
 	// if first byte is 0xFF -> 4-byte index,
 	// otherwise 2-byte index
-	if (pChunk[0] == 0xFF)
+	// (shifts of bytes measured fastest for mixed sizes,
+	// see tools/LwoSwapBench.cpp)
+	if (pBuf[0] == 0xFF)
 	{
-		// get four bytes and 
-		// mask out the first byte
-		uiVertIndex = BSwap4i((unsigned int*)pChunk);
+		// upper-most byte is the marker only
+		iIxSize = 4;
+		return (((unsigned int)pBuf[1] << 16)
+			| ((unsigned int)pBuf[2] << 8)
+			| (unsigned int)pBuf[3]);
+	}
 
-		// mask out upper-most byte
-		uiVertIndex = (uiVertIndex & 0x00FFFFFF);
+	// 2-byte index kept as four-byte integer
+	iIxSize = 2;
+	return (((unsigned int)pBuf[0] << 8)
+		| (unsigned int)pBuf[1]);
+}
 
-		// out: 4-byte int found
-		iIxSize = 4;
+// keep first error: offset in file
+// from position within current chunk
+bool CLwoReader::SetError(const LwoParseError eError, const char *pPos)
+{
+	if (m_eError != LWO_ERROR_NONE)
+	{
+		return false;
 	}
-	else
+	m_eError = eError;
+	m_ulErrorOffset = m_ulChunkOffset;
+	if (pPos != NULL
+		&& m_pChunkData != NULL
+		&& pPos >= m_pChunkData)
 	{
-		// use the two bytes,
-		// keep as four-byte integer
-		// for simplicity and efficiency
-		uiVertIndex = (int)BSwap2s((unsigned short*)pChunk);
+		m_ulErrorOffset += (unsigned long)(pPos - m_pChunkData);
+	}
+	return false;
+}
 
-		// out: 2-byte int found
-		iIxSize = 2;
+bool CLwoReader::SetError(const CLwoCursor &Cursor)
+{
+	return SetError(Cursor.GetError(), Cursor.GetErrorPos());
+}
+
+bool CLwoReader::SetReadError(const CMemFile &LwoFile)
+{
+	return SetError((LwoFile.IsOverBudget() == true) ? LWO_ERROR_BUDGET : LWO_ERROR_READ, NULL);
+}
+
+bool CLwoReader::IsChunkWithinBudget(const CMemFile &LwoFile, const unsigned int uiChunkType, const unsigned int uiChunkSize) const
+{
+	// least size decoded:
+	// floats of points, rows and 4-byte indices of polygons and tags,
+	// other chunks are accounted when decoded
+	uint64_t ullLeast = 0;
+	switch (uiChunkType)
+	{
+	case ID_PNTS:
+	case ID_POLS:
+	case ID_CRVS:
+	case ID_PTAG:
+	case ID_VMAP:
+	case ID_VMAD:
+		ullLeast = uiChunkSize;
+		break;
 	}
-	return uiVertIndex;
+	return ((uint64_t)LwoFile.GetBufferSize() + m_ullObjectBytes + ullLeast <= m_ullMemoryBudget);
 }
 
-string CLwoReader::GetPaddedString(const char *pBufPos, unsigned int &uiSize)
+bool CLwoReader::AccountChunks(const CMemFile &LwoFile)
 {
-	// each string is ASCII with terminating NULL,
-	// but can have double-NULL to make even-byte alignment
-	string szName = pBufPos;
-	uiSize = szName.length();
+	tLwoMemoryReport Report;
+	m_ObjectData.GetChunkMemoryReport(m_nAccountedChunks, Report);
+	m_nAccountedChunks = m_ObjectData.GetChunkList().size();
+	m_ullObjectBytes += Report.GetObjectTotal();
 
-	if (uiSize % 2 == 0)
+	if ((uint64_t)LwoFile.GetBufferSize() + m_ullObjectBytes > m_ullMemoryBudget)
 	{
-		// remainder zero: even-length string
-		// -> handle padding-byte (second terminating NULL)
-		uiSize += 2;
+		return SetError(LWO_ERROR_BUDGET, NULL);
 	}
-	else
+	return true;
+}
+
+CLwoLayer *CLwoReader::GetCurrentLayer()
+{
+	CLwoLayer *pCurrentLayer = (CLwoLayer*)m_ObjectData.GetPreviousOfType(ID_LAYR);
+
+	// older format may have chunks and no layer?
+	// -> may be in some other cases also that we don't have layer yet..
+	if (pCurrentLayer == NULL)
 	{
-		// non-zero remainder: odd-length string
-		// -> only single terminating NULL
-		uiSize += 1;
+		pCurrentLayer = m_ObjectData.AddChunk(unique_ptr<CLwoLayer>(new CLwoLayer(m_ObjectData.GetNextLayerIndex())));
 	}
-	return szName;
+	return pCurrentLayer;
 }
 
 bool CLwoReader::HandleFileHeader(const char *pLwoBuf, const unsigned long ulFileSize)
 {
+	LWO_STAT_HANDLER("HandleFileHeader", 12);
+
 	if (pLwoBuf == NULL
 		|| ulFileSize < 12)
 	{
@@ -170,6 +226,7 @@ bool CLwoReader::HandleFileHeader(const char *pLwoBuf, const unsigned long ulFil
 
 	// keep this expected length according to file header
 	m_uiLWOSize = uiLWOSize;
+	SelectChunkHandlers();
 	return true;
 }
 
@@ -200,32 +257,14 @@ unsigned int CLwoReader::GetSubChunkType(const char *pLwoBuf, unsigned short &us
 	return uiType;
 }
 
-bool CLwoReader::ProcessChunk(const char *pChunk, const unsigned int uiChunkType, const unsigned int uiChunkSize)
+// chunk-handlers specialized for each file-type:
+// checks of file-type are constant in each
+// so only handlers of that format remain in switch.
+// LWOB and LWLO differ only in layers.
+template <unsigned int uiFileType>
+bool CLwoReader::ProcessChunkOf(const char *pChunk, const unsigned int uiChunkType, const unsigned int uiChunkSize)
 {
-	if (pChunk == NULL
-		|| uiChunkSize <= 0)
-	{
-		return false;
-	}
-
-	char *pBufPos = (char*)pChunk;
-
-	/*
-	TODO: use this check before all chunk-types
-	to verify we create internally a layer even if file doesn't specify one..?
-
-	// locate the current layer
-	CLwoLayer *pCurrentLayer = (CLwoLayer*)m_ObjectData.GetPreviousOfType(ID_LAYR);
-
-	// older format may have chunks and no layer?
-	// -> may be in some other cases also that we don't have layer yet..
-	if (pCurrentLayer == NULL
-		&& uiChunkType != ID_LAYR)
-	{
-		pCurrentLayer = new CLwoLayer(0);
-		m_ObjectData.AddChunk(pCurrentLayer);
-	}
-	*/
+	const bool bLwo2 = (uiFileType == ID_LWO2);
 
 	// check type and handle chunk
 	switch (uiChunkType)
@@ -234,7 +273,7 @@ bool CLwoReader::ProcessChunk(const char *pChunk, const unsigned int uiChunkType
 		// this chunk should have tag name(s),
 		// can be array of tag names:
 		// this does not belong to a layer
-		if (m_uiLwoFileType == ID_LWO2)
+		if (bLwo2 == true)
 		{
 			return Handle_LWO2_ID_TAGS(pChunk, uiChunkSize);
 		}
@@ -243,7 +282,7 @@ bool CLwoReader::ProcessChunk(const char *pChunk, const unsigned int uiChunkType
 	case ID_PTAG:
 		// associates tags with polygons
 		// e.g. surface -> polygon
-		if (m_uiLwoFileType == ID_LWO2)
+		if (bLwo2 == true)
 		{
 			return Handle_LWO2_ID_PTAG(pChunk, uiChunkSize);
 		}
@@ -251,11 +290,11 @@ bool CLwoReader::ProcessChunk(const char *pChunk, const unsigned int uiChunkType
 
 	case ID_LAYR:
 		// layer: combines set of geometry
-		if (m_uiLwoFileType == ID_LWO2)
+		if (bLwo2 == true)
 		{
 			return Handle_LWO2_ID_LAYR(pChunk, uiChunkSize);
 		}
-		else if (m_uiLwoFileType == ID_LWLO)
+		else if (uiFileType == ID_LWLO)
 		{
 			return Handle_LWLO_ID_LAYR(pChunk, uiChunkSize);
 		}
@@ -263,7 +302,7 @@ bool CLwoReader::ProcessChunk(const char *pChunk, const unsigned int uiChunkType
 
 	case ID_BBOX:
 		// bounding box: extents of layer
-		if (m_uiLwoFileType == ID_LWO2)
+		if (bLwo2 == true)
 		{
 			return Handle_LWO2_ID_BBOX(pChunk, uiChunkSize);
 		}
@@ -272,61 +311,24 @@ bool CLwoReader::ProcessChunk(const char *pChunk, const unsigned int uiChunkType
 	case ID_PNTS:
 		// points:
 		// vertex coordinates (triplets of floats),
-		// not yet polygons (need poly-index list for that).
-		// this should be same in LWO2 and LWOB (also LWLO)?
-		{
-			// locate the current layer
-			CLwoLayer *pCurrentLayer = (CLwoLayer*)m_ObjectData.GetPreviousOfType(ID_LAYR);
-
-			// older format may have chunks and no layer?
-			// -> may be in some other cases also that we don't have layer yet..
-			if (pCurrentLayer == NULL)
-			{
-				pCurrentLayer = new CLwoLayer(0);
-				m_ObjectData.AddChunk(pCurrentLayer);
-			}
-
-			// points is the raw-coordinate position data
-			// which form polygons with indices and surfaces
-			CLwoPoints *pPoints = new CLwoPoints(pCurrentLayer->m_uiLayerIndex);
-
-			pPoints->m_lValueCount = uiChunkSize/sizeof(float);
-			pPoints->m_pfPointList = new float[pPoints->m_lValueCount];
-
-			float *pfPointBuf = (float*)pBufPos;
-			for (long i = 0; i < pPoints->m_lValueCount; i++)
-			{
-				// byteswap and keep in box-object
-				pPoints->m_pfPointList[i] = BSwapF(pfPointBuf[i]);
-			}
-
-			// keep reference in layer, store to object data container
-			pCurrentLayer->AddChunkToLayer(pPoints);
-			m_ObjectData.AddChunk(pPoints);
-		}
-		break;
+		// same in LWO2 and LWOB (also LWLO)
+		return Handle_ID_PNTS(pChunk, uiChunkSize);
 
 	case ID_POLS:
 		// polygons, these refer by index to most-recent point-list
 		// to define which are the vertices of each polygon
-		if (m_uiLwoFileType == ID_LWO2)
+		if (bLwo2 == true)
 		{
 			return Handle_LWO2_ID_POLS(pChunk, uiChunkSize);
 		}
-		else if (m_uiLwoFileType == ID_LWOB
-			|| m_uiLwoFileType == ID_LWLO)
-		{
-			// this older format has some differences..
-			// warning: not fixed yet?
-			return Handle_LWOB_ID_POLS(pChunk, uiChunkSize);
-		}
-		break;
+		// this older format has some differences..
+		// warning: not fixed yet?
+		return Handle_LWOB_ID_POLS(pChunk, uiChunkSize);
 
 	case ID_CRVS:
 		// this it's own chunk in LWOB
 		// instead of sub-type of POLS (as in LWO2)
-		if (m_uiLwoFileType == ID_LWOB
-			|| m_uiLwoFileType == ID_LWLO)
+		if (bLwo2 == false)
 		{
 			return Handle_LWOB_ID_CRVS(pChunk, uiChunkSize);
 		}
@@ -335,8 +337,7 @@ bool CLwoReader::ProcessChunk(const char *pChunk, const unsigned int uiChunkType
 	case ID_SRFS:
 		// LWOB (pre-6.0) only list of surfaces?
 		// (names of surfaces, mapping-by-name)
-		if (m_uiLwoFileType == ID_LWOB
-			|| m_uiLwoFileType == ID_LWLO)
+		if (bLwo2 == false)
 		{
 			return Handle_LWOB_ID_SRFS(pChunk, uiChunkSize);
 		}
@@ -345,20 +346,15 @@ bool CLwoReader::ProcessChunk(const char *pChunk, const unsigned int uiChunkType
 	case ID_SURF:
 		// surface-defition refers to polygons,
 		// describes colors, texturing etc.
-		if (m_uiLwoFileType == ID_LWO2)
+		if (bLwo2 == true)
 		{
 			return Handle_LWO2_ID_SURF(pChunk, uiChunkSize);
 		}
-		else if (m_uiLwoFileType == ID_LWOB
-			|| m_uiLwoFileType == ID_LWLO)
-		{
-			return Handle_LWOB_ID_SURF(pChunk, uiChunkSize);
-		}
-		break;
+		return Handle_LWOB_ID_SURF(pChunk, uiChunkSize);
 
 	case ID_ENVL:
 		// envelope with sub-chunks
-		if (m_uiLwoFileType == ID_LWO2)
+		if (bLwo2 == true)
 		{
 			return Handle_LWO2_ID_ENVL(pChunk, uiChunkSize);
 		}
@@ -367,7 +363,7 @@ bool CLwoReader::ProcessChunk(const char *pChunk, const unsigned int uiChunkType
 	case ID_CLIP:
 		// clip with sub-chunks:
 		// single, possibly time-varying image
-		if (m_uiLwoFileType == ID_LWO2)
+		if (bLwo2 == true)
 		{
 			return Handle_LWO2_ID_CLIP(pChunk, uiChunkSize);
 		}
@@ -375,7 +371,7 @@ bool CLwoReader::ProcessChunk(const char *pChunk, const unsigned int uiChunkType
 
 	case ID_VMAP:
 		// vector-map, refers to most-recent points-list
-		if (m_uiLwoFileType == ID_LWO2)
+		if (bLwo2 == true)
 		{
 			return Handle_LWO2_ID_VMAP(pChunk, uiChunkSize);
 		}
@@ -383,7 +379,7 @@ bool CLwoReader::ProcessChunk(const char *pChunk, const unsigned int uiChunkType
 
 	case ID_VMAD:
 		// LW6.5: Discontinuous Vertex Mapping
-		if (m_uiLwoFileType == ID_LWO2)
+		if (bLwo2 == true)
 		{
 			return Handle_LWO2_ID_VMAD(pChunk, uiChunkSize);
 		}
@@ -391,257 +387,311 @@ bool CLwoReader::ProcessChunk(const char *pChunk, const unsigned int uiChunkType
 
 	case ID_DESC:
 		// description line
-		{
-			unsigned int uiStrLen = 0;
-			string szFileDescription = GetPaddedString(pBufPos, uiStrLen);
-			pBufPos = (pBufPos + uiStrLen);
-		}
-		break;
-
 	case ID_TEXT:
 		// comments about anything in the file
-		{
-			unsigned int uiStrLen = 0;
-			string szComments = GetPaddedString(pBufPos, uiStrLen);
-			pBufPos = (pBufPos + uiStrLen);
-		}
-		break;
-
 	case ID_ICON:
 		// thumbnail icon image
+		// (not kept)
 		break;
 	}
 
 	return true;
 }
 
-bool CLwoReader::Handle_LWO2_ID_TAGS(const char *pChunk, const unsigned int uiChunkSize)
+// handling of chunks for file-type of current file,
+// selected once when header is read
+void CLwoReader::SelectChunkHandlers()
 {
-	char *pBufPos = (char*)pChunk;
+	switch (m_uiLwoFileType)
+	{
+	case ID_LWO2:
+		m_pProcessChunk = &CLwoReader::ProcessChunkOf<ID_LWO2>;
+		break;
+	case ID_LWOB:
+		m_pProcessChunk = &CLwoReader::ProcessChunkOf<ID_LWOB>;
+		break;
+	case ID_LWLO:
+		m_pProcessChunk = &CLwoReader::ProcessChunkOf<ID_LWLO>;
+		break;
+	default:
+		m_pProcessChunk = NULL;
+		break;
+	}
+}
+
+bool CLwoReader::ProcessChunk(const char *pChunk, const unsigned int uiChunkType, const unsigned int uiChunkSize)
+{
+	if (pChunk == NULL
+		|| uiChunkSize <= 0
+		|| m_pProcessChunk == NULL)
+	{
+		return false;
+	}
 
-	// tags: list of names referred to with 0-based index
+	/*
+	TODO: use this check before all chunk-types
+	to verify we create internally a layer even if file doesn't specify one..?
 
-	CLwoTagnameList *pTagnames = new CLwoTagnameList();
+	// locate the current layer
+	CLwoLayer *pCurrentLayer = (CLwoLayer*)m_ObjectData.GetPreviousOfType(ID_LAYR);
 
-	char *pTagsEnd = (pBufPos + uiChunkSize);
-	while (pBufPos != pTagsEnd)
+	// older format may have chunks and no layer?
+	// -> may be in some other cases also that we don't have layer yet..
+	if (pCurrentLayer == NULL
+		&& uiChunkType != ID_LAYR)
 	{
-		// size with possible padding
-		unsigned int uiStrLen = 0;
+		pCurrentLayer = m_ObjectData.AddChunk(unique_ptr<CLwoLayer>(new CLwoLayer(0)));
+	}
+	*/
+
+	return (this->*m_pProcessChunk)(pChunk, uiChunkType, uiChunkSize);
+}
+
+bool CLwoReader::LinkObjectData()
+{
+	LWO_STAT_HANDLER("LinkObjectData", 0);
+
+	return m_ObjectData.CreateObjectLinkage();
+}
+
+// points:
+// vertex coordinates (triplets of floats),
+// not yet polygons (need poly-index list for that).
+bool CLwoReader::Handle_ID_PNTS(const char *pChunk, const unsigned int uiChunkSize)
+{
+	LWO_STAT_HANDLER("Handle_ID_PNTS", uiChunkSize);
+
+	CLwoLayer *pCurrentLayer = GetCurrentLayer();
+
+	// points is the raw-coordinate position data
+	// which form polygons with indices and surfaces
+	CLwoPoints *pPoints = m_ObjectData.AddChunk(unique_ptr<CLwoPoints>(new CLwoPoints(pCurrentLayer->m_uiLayerIndex)));
+
+	// whole points only
+	pPoints->m_PointList.resize((uiChunkSize/12)*3);
 
+	// byteswap and keep in points-object
+	CLwoByteSwap::Swap4(pPoints->m_PointList.data(), pChunk, pPoints->m_PointList.size());
+
+	// keep reference in layer, store to object data container
+	pCurrentLayer->AddChunkToLayer(pPoints);
+	return true;
+}
+
+bool CLwoReader::Handle_LWO2_ID_TAGS(const char *pChunk, const unsigned int uiChunkSize)
+{
+	LWO_STAT_HANDLER("Handle_LWO2_ID_TAGS", uiChunkSize);
+
+	// tags: list of names referred to with 0-based index,
+	// keep tag-name list (released with object also on error)
+	CLwoTagnameList *pTagnames = m_ObjectData.AddChunk(unique_ptr<CLwoTagnameList>(new CLwoTagnameList()));
+
+	CLwoCursor Cursor(pChunk, uiChunkSize);
+	while (Cursor.IsAtEnd() == false)
+	{
 		// each string is ASCII with terminating NULL,
 		// but can have double-NULL to make even-byte alignment
-		string szTagName = GetPaddedString(pBufPos, uiStrLen);
+		string szTagName;
+		if (Cursor.ReadS0(szTagName) == false)
+		{
+			return SetError(Cursor);
+		}
 
 		// keep name
 		pTagnames->AddTagname(szTagName);
-
-		// more strings? (this should be in loop then)
-		pBufPos = (pBufPos + uiStrLen);
 	}
-
-	// keep tag-name list
-	m_ObjectData.AddChunk(pTagnames);
 	return true;
 }
 
 bool CLwoReader::Handle_LWO2_ID_PTAG(const char *pChunk, const unsigned int uiChunkSize)
 {
-	CLwoLayer *pCurrentLayer = (CLwoLayer*)m_ObjectData.GetPreviousOfType(ID_LAYR);
+	LWO_STAT_HANDLER("Handle_LWO2_ID_PTAG", uiChunkSize);
 
-	CLwoPolygons *pPrevPols = (CLwoPolygons*)m_ObjectData.GetPreviousOfType(ID_POLS);
-	CLwoChunk *pTags = m_ObjectData.GetPreviousOfType(ID_TAGS);
+	CLwoLayer *pCurrentLayer = GetCurrentLayer();
 
-	char *pBufPos = (char*)pChunk;
+	CLwoPolygons *pPrevPols = (CLwoPolygons*)m_ObjectData.GetPreviousOfType(ID_POLS);
 
-	CLwoPolyTags *pPolyTags = new CLwoPolyTags(pCurrentLayer->m_uiLayerIndex);
+	CLwoPolyTags *pPolyTags = m_ObjectData.AddChunk(unique_ptr<CLwoPolyTags>(new CLwoPolyTags(pCurrentLayer->m_uiLayerIndex)));
 
 	// keep reference to latest polygon-list
 	// (should reverse this relation?)
 	pPolyTags->m_pPolyList = pPrevPols;
 
-	// SURF, PART, SMGP
-	pPolyTags->m_uiPtagTypeID = MakeTag(pBufPos);
-
-	// count end
-	char *pEnd = (pBufPos + uiChunkSize);
+	// keep reference in layer, store to chunk-list
+	// (released with object also on error)
+	pCurrentLayer->AddChunkToLayer(pPolyTags);
 
-	// skip to data
-	pBufPos = (pBufPos +4);
+	CLwoCursor Cursor(pChunk, uiChunkSize);
 
-	while (pBufPos != pEnd)
+	// SURF, PART, SMGP
+	if (Cursor.ReadU4(pPolyTags->m_uiPtagTypeID) == false)
 	{
-		// here we have pair<polIX, tagIX>:
-		// polygon-index is variable-length and tag index is 2 bytes
-
-		// reading index determines if it's 2 or 4 bytes
-		int iIxSize = 0;
-
-		// get polygon index (var-len), 0-based
-		int iPolIX = (int)GetVarlenIX(pBufPos, iIxSize);
+		return SetError(Cursor);
+	}
 
-		// skip to past index
-		pBufPos = (pBufPos +iIxSize);
+	// at least 4 bytes per pair
+	pPolyTags->m_PolyTagList.reserve(Cursor.GetRemaining()/4);
 
-		// get tag index, 0-based
-		int iTagIX = (int)BSwap2s((unsigned short *)pBufPos);
+	while (Cursor.IsAtEnd() == false)
+	{
+		// here we have pair<polIX, tagIX>:
+		// polygon-index is variable-length and tag index is 2 bytes,
+		// check largest size once for both
+		if (Cursor.GetRemaining() < 6)
+		{
+			unsigned int uiPolIX = 0;
+			unsigned short usTagIX = 0;
+			if (Cursor.ReadVX(uiPolIX) == false
+				|| Cursor.ReadU2(usTagIX) == false)
+			{
+				return SetError(Cursor);
+			}
+			pPolyTags->m_PolyTagList.push_back(CLwoPolyTags::tPolToTag((int)uiPolIX, (int)usTagIX));
+			continue;
+		}
 
-		// skip to next "row" (pair)
-		pBufPos = (pBufPos +2);
+		// polygon index (var-len) and tag index, both 0-based
+		int iPolIX = (int)Cursor.VX();
+		int iTagIX = (int)Cursor.U2();
 
 		// keep mapping
 		pPolyTags->m_PolyTagList.push_back(CLwoPolyTags::tPolToTag(iPolIX, iTagIX));
 	}
-
-	// keep reference in layer, store to chunk-list
-	pCurrentLayer->AddChunkToLayer(pPolyTags);
-	m_ObjectData.AddChunk(pPolyTags);
 	return true;
 }
 
 // for newer LWO2-layer definition
 bool CLwoReader::Handle_LWO2_ID_LAYR(const char *pChunk, const unsigned int uiChunkSize)
 {
+	LWO_STAT_HANDLER("Handle_LWO2_ID_LAYR", uiChunkSize);
+
 	// layer: all chunks from this upto next layer
 	// belong to this layer
 
 	// TODO: locate previous/parent layer (if any?)
 	//CLwoLayer *pCurrentLayer = (CLwoLayer*)m_ObjectData.GetPreviousOfType(ID_LAYR);
 
-	CLwoLayer *pLayer = new CLwoLayer(m_ObjectData.GetNextLayerIndex());
-
-	char *pBufPos = (char*)pChunk;
-
-	// count chunk end for later..
-	char *pEnd = (pBufPos + uiChunkSize);
-
-	// layer-index (0-based)
-	pLayer->m_usLayerNumber = BSwap2s((unsigned short *)pBufPos);
-	pBufPos = (pBufPos +2);
+	CLwoLayer *pLayer = m_ObjectData.AddChunk(unique_ptr<CLwoLayer>(new CLwoLayer(m_ObjectData.GetNextLayerIndex())));
 
-	pLayer->m_usLayerFlags = BSwap2s((unsigned short *)pBufPos);
-	pBufPos = (pBufPos +2);
+	CLwoCursor Cursor(pChunk, uiChunkSize);
 
+	// layer-index (0-based), flags,
 	// layer pivot-point (vertex, triplet of floats)
-	pLayer->m_pfPivotPoint = new float[3];
-
-	float *pfPointBuf = (float*)pBufPos;
-	for (long i = 0; i < 3; i++)
+	// and name (with possible padding)
+	if (Cursor.ReadU2(pLayer->m_usLayerNumber) == false
+		|| Cursor.ReadU2(pLayer->m_usLayerFlags) == false
+		|| Cursor.ReadVec12(pLayer->m_fPivotPoint) == false
+		|| Cursor.ReadS0(pLayer->m_szLayerName) == false)
 	{
-		// byteswap and keep in container
-		pLayer->m_pfPivotPoint[i] = BSwapF(pfPointBuf[i]);
+		return SetError(Cursor);
 	}
-	pBufPos = (pBufPos + 3*sizeof(float));
-
-	// get string, check size (in case of padding)
-	unsigned int uiSize = 0;
-	pLayer->m_szLayerName = GetPaddedString(pBufPos, uiSize);
-	pBufPos = (pBufPos + uiSize);
 
 	// now if we are not yet at end there should be U2 for parent-number,
 	// which can be missing if no parent
-	if (pBufPos != pEnd)
+	if (Cursor.GetRemaining() >= 2)
 	{
-		pLayer->m_iParentLayerIndex = (int)BSwap2s((unsigned short *)pBufPos);
+		pLayer->m_iParentLayerIndex = (int)Cursor.U2();
 	}
-
-	m_ObjectData.AddChunk(pLayer);
 	return true;
 }
 
 // for older LWLO-format layer definition
 bool CLwoReader::Handle_LWLO_ID_LAYR(const char *pChunk, const unsigned int uiChunkSize)
 {
+	LWO_STAT_HANDLER("Handle_LWLO_ID_LAYR", uiChunkSize);
+
 	// TODO: locate previous layer (if any?)
 	//CLwoLayer *pCurrentLayer = (CLwoLayer*)m_ObjectData.GetPreviousOfType(ID_LAYR);
 
-	CLwoLayer *pLayer = new CLwoLayer(m_ObjectData.GetNextLayerIndex());
-
-	char *pBufPos = (char*)pChunk;
-
-	// layer number: should be from 1..10 in LWLO
-	pLayer->m_usLayerNumber = BSwap2s((unsigned short *)pBufPos);
-	pBufPos = (pBufPos +2);
-
-	// lowest-order bit defined: 1 if active layer, 0 if background
-	pLayer->m_usLayerFlags = BSwap2s((unsigned short *)pBufPos);
-	pBufPos = (pBufPos +2);
+	CLwoLayer *pLayer = m_ObjectData.AddChunk(unique_ptr<CLwoLayer>(new CLwoLayer(m_ObjectData.GetNextLayerIndex())));
 
-	// get string (name of layer) 
-	// and check size (in case of padding for even-address)
-	unsigned int uiSize = 0;
-	pLayer->m_szLayerName = GetPaddedString(pBufPos, uiSize);
-	pBufPos = (pBufPos + uiSize);
+	CLwoCursor Cursor(pChunk, uiChunkSize);
 
-	m_ObjectData.AddChunk(pLayer);
+	// layer number: should be from 1..10 in LWLO,
+	// flags: lowest-order bit defined: 1 if active layer, 0 if background,
+	// name of layer (padded for even-address)
+	if (Cursor.ReadU2(pLayer->m_usLayerNumber) == false
+		|| Cursor.ReadU2(pLayer->m_usLayerFlags) == false
+		|| Cursor.ReadS0(pLayer->m_szLayerName) == false)
+	{
+		return SetError(Cursor);
+	}
 	return true;
 }
 
 bool CLwoReader::Handle_LWO2_ID_BBOX(const char *pChunk, const unsigned int uiChunkSize)
 {
-	// locate the current layer
-	CLwoLayer *pCurrentLayer = (CLwoLayer*)m_ObjectData.GetPreviousOfType(ID_LAYR);
-	CLwoBoundingBox *pBBox = new CLwoBoundingBox(pCurrentLayer->m_uiLayerIndex);
+	LWO_STAT_HANDLER("Handle_LWO2_ID_BBOX", uiChunkSize);
+
+	CLwoLayer *pCurrentLayer = GetCurrentLayer();
+	CLwoBoundingBox *pBBox = m_ObjectData.AddChunk(unique_ptr<CLwoBoundingBox>(new CLwoBoundingBox(pCurrentLayer->m_uiLayerIndex)));
 
 	char *pBufPos = (char*)pChunk;
 
+	// minimum and maximum (ignore anything extra)
 	pBBox->m_lValueCount = uiChunkSize/sizeof(float);
-	pBBox->m_pfBoxExtents = new float[pBBox->m_lValueCount];
+	if (pBBox->m_lValueCount > 6)
+	{
+		pBBox->m_lValueCount = 6;
+	}
 
-	float *pfPointBuf = (float*)pBufPos;
 	for (long i = 0; i < pBBox->m_lValueCount; i++)
 	{
 		// byteswap and keep in box-object
-		pBBox->m_pfBoxExtents[i] = BSwapF(pfPointBuf[i]);
+		pBBox->m_fBoxExtents[i] = LwoGetF4(pBufPos + i*4);
 	}
 
 	pCurrentLayer->AddChunkToLayer(pBBox); // keep box-reference in layer for fast access
-	m_ObjectData.AddChunk(pBBox); // actual storage of the container
 	return true;
 }
 
 // newer LWO2 polygons-chunk
 bool CLwoReader::Handle_LWO2_ID_POLS(const char *pChunk, const unsigned int uiChunkSize)
 {
+	LWO_STAT_HANDLER("Handle_LWO2_ID_POLS", uiChunkSize);
+
 	// polygons, these refer by index to most-recent point-list
 	// to define which are the vertices of each polygon
-	CLwoLayer *pCurrentLayer = (CLwoLayer*)m_ObjectData.GetPreviousOfType(ID_LAYR);
+	CLwoLayer *pCurrentLayer = GetCurrentLayer();
 
-	CLwoPolygons *pPolyList = new CLwoPolygons(pCurrentLayer->m_uiLayerIndex);
+	CLwoPolygons *pPolyList = m_ObjectData.AddChunk(unique_ptr<CLwoPolygons>(new CLwoPolygons(pCurrentLayer->m_uiLayerIndex)));
 	pPolyList->m_pPointsList = (CLwoPoints*)m_ObjectData.GetPreviousOfType(ID_PNTS);
 
-	char *pBufPos = (char*)pChunk;
-
-	// count end of chunk for handling
-	char *pPolyEnd = (pBufPos + uiChunkSize);
+	CLwoCursor Cursor(pChunk, uiChunkSize);
 
 	// FACE, CURV, PTCH, MBAL or BONE
 	// Note! we need to mask out upper 6-bits of each vertex-count
 	// when POLS=CURV !!
 	//
 	// keep the sub-chunk information
-	pPolyList->m_uiPolyTypeID = MakeTag(pBufPos);
+	// (type is needed before adding to layer)
+	bool bTypeRead = Cursor.ReadU4(pPolyList->m_uiPolyTypeID);
 
-	// skip sub-type to actual data
-	pBufPos = (pBufPos +4);
+	// keep reference in layer, store to object data container
+	// (released with object data also on error)
+	pCurrentLayer->AddChunkToLayer(pPolyList);
+
+	if (bTypeRead == false)
+	{
+		return SetError(Cursor);
+	}
 
 	// TODO: we might want to pre-process points into polygons
 	// here for simplicity later when actually using the data?
 
-	long lPolyRowIndex = 0;
-	while (pBufPos != pPolyEnd)
+	while (Cursor.IsAtEnd() == false)
 	{
 		// pBufPos has vertex-count
-		unsigned short wVertexCount = BSwap2s((unsigned short*)pBufPos);
+		unsigned short wVertexCount = 0;
+		if (Cursor.ReadU2(wVertexCount) == false)
+		{
+			return SetError(Cursor);
+		}
 
 		// get and mask out flags in upper 6-bits
 		unsigned short wFlags = ((0xfc00 & wVertexCount) >> 10);
 		wVertexCount = (0x03ff & wVertexCount);
 
-		// skip past vertex-count (short)
-		// to actual index-list
-		pBufPos = (pBufPos +2);
-
 		// only CURV uses flags there but need to mask out anyway,
 		// this is sub-definition in POLS-chunk in LWO2.
 		// note: LW9 
@@ -656,292 +706,320 @@ bool CLwoReader::Handle_LWO2_ID_POLS(const char *pChunk, const unsigned int uiCh
 			wFlags = (wFlags & 0x3); // only two flags should remain?
 		}
 
-		CLwoPolygons::CLwoPolyRow *pVertList = new CLwoPolygons::CLwoPolyRow(lPolyRowIndex, wVertexCount, wFlags);
+		CLwoPolygons::CLwoPolyRow &VertList = pPolyList->AddRow(wVertexCount, wFlags);
+		int *piIndices = pPolyList->GetIndices(VertList);
+
+		// handle each index according to size (2 or 4 bytes):
+		// when all fit as largest size, check once for the polygon
+		if (Cursor.GetRemaining() >= (size_t)wVertexCount*4)
+		{
+			for (int l = 0; l < wVertexCount; l++)
+			{
+				piIndices[l] = (int)Cursor.VX();
+			}
+			continue;
+		}
 
-		// handle each index according to size
+		// near end of chunk: check each
 		for (int l = 0; l < wVertexCount; l++)
 		{
-			// reading index determines if it's 2 or 4 bytes
-			int iIxSize = 0;
+			unsigned int uiIndex = 0;
+			if (Cursor.ReadVX(uiIndex) == false)
+			{
+				return SetError(Cursor);
+			}
+			piIndices[l] = (int)uiIndex;
+		} // for
+	}
+	return true;
+}
+
+// older LWOB-format polygon "row":
+// vertex-count, 2-byte indices and 1-based surface-index
+bool CLwoReader::Read_LWOB_PolyRow(CLwoCursor &Cursor, CLwoPolygons &PolyList, short &sSurfaceIndex)
+{
+	// cursor has vertex-count
+	unsigned short wVertexCount = 0;
+	if (Cursor.ReadU2(wVertexCount) == false)
+	{
+		return SetError(Cursor);
+	}
 
-			// get vertex index from position,
-			// get size of it for locating next (may be 2 or 4 bytes)
-			// and keep this index in list
-			pVertList->m_piIndices[l] = (int)GetVarlenIX(pBufPos, iIxSize);
+	// get and mask out flags in upper 6-bits
+	unsigned short wFlags = ((0xfc00 & wVertexCount) >> 10);
+	wVertexCount = (0x03ff & wVertexCount);
 
-			// skip to next index
-			pBufPos = (pBufPos +iIxSize);
-		} // for
+	// only CURV uses flags there, but only for ID_CURV
+	// which is actually it's own chunk-type in LWOB
+	// instead of sub-defition of POLS (as in LWO2)
 
-		// keep row for later
-		pPolyList->m_PolyList.push_back(pVertList);
-		lPolyRowIndex++;
+	// row is kept in list with room for indices
+	CLwoPolygons::CLwoPolyRow &VertList = PolyList.AddRow(wVertexCount, wFlags);
+	int *piIndices = PolyList.GetIndices(VertList);
+
+	// in older LWOB, we have only 2-byte integers and indices
+	// (newer have variable-length indices),
+	// additionally, index to surface-list after each vertex-index "row":
+	// check whole row once
+	if (Cursor.Require(((size_t)wVertexCount +1)*2) == false)
+	{
+		return SetError(Cursor);
 	}
 
-	pCurrentLayer->AddChunkToLayer(pPolyList);
-	m_ObjectData.AddChunk(pPolyList);
+	// handle each index
+	for (int l = 0; l < wVertexCount; l++)
+	{
+		piIndices[l] = (int)Cursor.U2();
+	}
+
+	sSurfaceIndex = (short)Cursor.U2();
+
+	// keep the absolute-number of negative surface-index
+	// to determine actual surface-index
+	VertList.m_wSurfaceIndex = (unsigned short)abs((int)sSurfaceIndex);
 	return true;
 }
 
 // older LWOB-format polygons-chunk
 bool CLwoReader::Handle_LWOB_ID_POLS(const char *pChunk, const unsigned int uiChunkSize)
 {
+	LWO_STAT_HANDLER("Handle_LWOB_ID_POLS", uiChunkSize);
+
 	// polygons, these refer by index to most-recent point-list
 	// to define which are the vertices of each polygon
-	CLwoLayer *pCurrentLayer = (CLwoLayer*)m_ObjectData.GetPreviousOfType(ID_LAYR);
-
-	if (pCurrentLayer == NULL)
-	{
-		pCurrentLayer = new CLwoLayer(0);
-		m_ObjectData.AddChunk(pCurrentLayer);
-	}
+	CLwoLayer *pCurrentLayer = GetCurrentLayer();
 
-	CLwoPolygons *pPolyList = new CLwoPolygons(pCurrentLayer->m_uiLayerIndex);
+	CLwoPolygons *pPolyList = m_ObjectData.AddChunk(unique_ptr<CLwoPolygons>(new CLwoPolygons(pCurrentLayer->m_uiLayerIndex)));
 	pPolyList->m_pPointsList = (CLwoPoints*)m_ObjectData.GetPreviousOfType(ID_PNTS);
 
-	char *pBufPos = (char*)pChunk;
-
-	// count end of chunk for handling
-	char *pPolyEnd = (pBufPos + uiChunkSize);
-
 	// in older format, there is not tag in current pos
 	// -> assume FACE always here (LWOB)
 	pPolyList->m_uiPolyTypeID = ID_FACE;
 
+	// keep reference in layer, store to object data container
+	// (released with object data also on error)
+	pCurrentLayer->AddChunkToLayer(pPolyList);
 
-	// TODO: we might want to pre-process points into polygons
-	// here for simplicity later when actually using the data?
-
+	CLwoCursor Cursor(pChunk, uiChunkSize);
 
 	long lPolyRowIndex = 0;
-	while (pBufPos != pPolyEnd)
+	while (Cursor.IsAtEnd() == false)
 	{
-		// pBufPos has vertex-count
-		unsigned short wVertexCount = BSwap2s((unsigned short*)pBufPos);
-
-		// get and mask out flags in upper 6-bits
-		unsigned short wFlags = ((0xfc00 & wVertexCount) >> 10);
-		wVertexCount = (0x03ff & wVertexCount);
-
-		// only CURV uses flags there, but only for ID_CURV
-		// which is actually it's own chunk-type in LWOB
-		// instead of sub-defition of POLS (as in LWO2)
-		//if (pPolyList->m_uiPolyTypeID == ID_CURV)
-
-		// skip past vertex-count (short)
-		// to actual index-list
-		pBufPos = (pBufPos +2);
-
-		CLwoPolygons::CLwoPolyRow *pVertList = new CLwoPolygons::CLwoPolyRow(lPolyRowIndex, wVertexCount, wFlags);
-
-		// handle each index according to size
-		for (int l = 0; l < wVertexCount; l++)
+		short sSurfaceIndex = 0;
+		if (Read_LWOB_PolyRow(Cursor, *pPolyList, sSurfaceIndex) == false)
 		{
-			// in older LWOB, we have only 2-byte integers and indices?
-			// (newer have variable-length indices)
-			pVertList->m_piIndices[l] = BSwap2s((unsigned short*)pBufPos);
-
-			// skip to next index
-			pBufPos = (pBufPos +2);
-		} // for
-
-		// additionally, index to surface-list after each vertex-index "row"?
-		short sSurfaceIndex = BSwap2s((unsigned short*)pBufPos);
-		pBufPos = (pBufPos +2);
+			return false;
+		}
 
 		if (sSurfaceIndex < 0)
 		{
-			// we keep the absolute-number of negative surface-index 
-			// to determine actual surface-index
-			sSurfaceIndex = abs(sSurfaceIndex);
-			// -> keep this with actual poly
-			pVertList->m_wSurfaceIndex = sSurfaceIndex;
-
 			// if negative (has detail-polygon), 
 			// followed by U2 to define how many detail-polygons
 			// belong to current polygon and list of those detail-polygons:
 			// detail-polygons cannot have sub-details but otherwise same as normal
+			unsigned short usDPolyCount = 0;
+			if (Cursor.ReadU2(usDPolyCount) == false)
+			{
+				return SetError(Cursor);
+			}
 
-			// detail-poly count
-			unsigned short usDPolyCount = BSwap2s((unsigned short*)pBufPos);
-			pBufPos = (pBufPos +2);
+			// detail-polygons in second list (same points)
+			if (pPolyList->m_pDetailPolygons == NULL
+				&& usDPolyCount > 0)
+			{
+				CLwoPolygons *pDetails = m_ObjectData.AddChunk(unique_ptr<CLwoPolygons>(new CLwoPolygons(pCurrentLayer->m_uiLayerIndex)));
+				pDetails->m_pPointsList = pPolyList->m_pPointsList;
+				pDetails->m_uiPolyTypeID = ID_FACE;
+				pDetails->m_pParentPolygons = pPolyList;
+				pPolyList->m_pDetailPolygons = pDetails;
 
-			// count of vertex-indices for the poly
-			unsigned short usDPolyVertCount = BSwap2s((unsigned short*)pBufPos);
-			pBufPos = (pBufPos +2);
+				pCurrentLayer->AddChunkToLayer(pDetails);
+			}
 
-			for (int v = 0; v < usDPolyVertCount; v++)
+			CLwoPolygons::CLwoPolyRow &ParentRow = pPolyList->m_PolyList.back();
+			ParentRow.m_usDetailCount = usDPolyCount;
+			if (usDPolyCount > 0)
 			{
-				// in older LWOB, we have only 2-byte integers and indices?
-				// (newer have variable-length indices)
-				//pVertList->m_piIndices[l] = BSwap2s((unsigned short*)pBufPos);
-				unsigned short usTemp = BSwap2s((unsigned short*)pBufPos);
+				ParentRow.m_lFirstDetailIndex = (long)pPolyList->m_pDetailPolygons->m_PolyList.size();
+			}
 
-				// skip to next index
-				pBufPos = (pBufPos +2);
+			for (int d = 0; d < usDPolyCount; d++)
+			{
+				CLwoPolygons *pDetails = pPolyList->m_pDetailPolygons;
 
+				short sDSurfaceIndex = 0;
+				if (Read_LWOB_PolyRow(Cursor, *pDetails, sDSurfaceIndex) == false)
+				{
+					return false;
+				}
+				pDetails->m_PolyList.back().m_lParentRowIndex = lPolyRowIndex;
 			}
-
-			// surface-index of the detail-polygon
-			short sDSurfaceIndex = BSwap2s((unsigned short*)pBufPos);
-			pBufPos = (pBufPos +2);
 		}
-		else
+		lPolyRowIndex++;
+	}
+
+	// surface-mapping like in LWO2
+	if (Handle_LWOB_SurfaceTags(pPolyList, pCurrentLayer) == false)
+	{
+		return false;
+	}
+	if (pPolyList->m_pDetailPolygons != NULL)
+	{
+		return Handle_LWOB_SurfaceTags(pPolyList->m_pDetailPolygons, pCurrentLayer);
+	}
+	return true;
+}
+
+// in LWOB each polygon has 1-based index to SRFS-list:
+// keep as PTAG SURF-mapping with 0-based tag-index (as in LWO2)
+// so that same handling applies to both formats
+bool CLwoReader::Handle_LWOB_SurfaceTags(CLwoPolygons *pPolyList, CLwoLayer *pLayer)
+{
+	CLwoPolyTags *pPolyTags = m_ObjectData.AddChunk(unique_ptr<CLwoPolyTags>(new CLwoPolyTags(pLayer->m_uiLayerIndex)));
+	pPolyTags->m_pPolyList = pPolyList;
+	pPolyTags->m_uiPtagTypeID = ID_SURF;
+	pPolyTags->m_PolyTagList.reserve(pPolyList->m_PolyList.size());
+
+	for (size_t i = 0; i < pPolyList->m_PolyList.size(); i++)
+	{
+		const CLwoPolygons::CLwoPolyRow &Row = pPolyList->m_PolyList[i];
+
+		// zero: no surface given
+		if (Row.m_wSurfaceIndex > 0)
 		{
-			pVertList->m_wSurfaceIndex = sSurfaceIndex;
+			pPolyTags->m_PolyTagList.push_back(CLwoPolyTags::tPolToTag((int)i, (int)Row.m_wSurfaceIndex -1));
 		}
-
-		// keep row for later
-		pPolyList->m_PolyList.push_back(pVertList);
-		lPolyRowIndex++;
 	}
 
-	pCurrentLayer->AddChunkToLayer(pPolyList);
-	m_ObjectData.AddChunk(pPolyList);
+	pLayer->AddChunkToLayer(pPolyTags);
 	return true;
 }
 
 // spline curve data
 bool CLwoReader::Handle_LWOB_ID_CRVS(const char *pChunk, const unsigned int uiChunkSize)
 {
-	CLwoLayer *pCurrentLayer = (CLwoLayer*)m_ObjectData.GetPreviousOfType(ID_LAYR);
+	LWO_STAT_HANDLER("Handle_LWOB_ID_CRVS", uiChunkSize);
 
-	if (pCurrentLayer == NULL)
-	{
-		pCurrentLayer = new CLwoLayer(0);
-		m_ObjectData.AddChunk(pCurrentLayer);
-	}
+	CLwoLayer *pCurrentLayer = GetCurrentLayer();
 
 	// use polylist as curve (like with LWO2 sub-type)
-	CLwoPolygons *pPolyList = new CLwoPolygons(pCurrentLayer->m_uiLayerIndex);
+	CLwoPolygons *pPolyList = m_ObjectData.AddChunk(unique_ptr<CLwoPolygons>(new CLwoPolygons(pCurrentLayer->m_uiLayerIndex)));
 	pPolyList->m_pPointsList = (CLwoPoints*)m_ObjectData.GetPreviousOfType(ID_PNTS);
 
 	// assume CURV as type here (sub-type of polygons in LWO2)
 	pPolyList->m_uiPolyTypeID = ID_CURV;
 
-	char *pBufPos = (char*)pChunk;
-
-	// count end of chunk for handling
-	const char *pEnd = (pBufPos + uiChunkSize);
+	// keep reference in layer, store to object data container
+	// (released with object data also on error)
+	pCurrentLayer->AddChunkToLayer(pPolyList);
 
-	long lPolyRowIndex = 0;
-	while (pBufPos != pEnd)
+	CLwoCursor Cursor(pChunk, uiChunkSize);
+	while (Cursor.IsAtEnd() == false)
 	{
-		unsigned short wVertexCount = BSwap2s((unsigned short*)pBufPos);
-		pBufPos = (pBufPos +2);
+		unsigned short wVertexCount = 0;
+		if (Cursor.ReadU2(wVertexCount) == false
+			|| Cursor.Require(((size_t)wVertexCount +2)*2) == false)
+		{
+			return SetError(Cursor);
+		}
 
-		CLwoPolygons::CLwoPolyRow *pVertList = new CLwoPolygons::CLwoPolyRow(lPolyRowIndex, wVertexCount, 0);
+		CLwoPolygons::CLwoPolyRow &VertList = pPolyList->AddRow(wVertexCount, 0);
+		int *piIndices = pPolyList->GetIndices(VertList);
 
 		for (int i = 0; i < wVertexCount; i++)
 		{
 			// indices like in POLS but cannot have detail polygons
 			// (TODO: was this 1 or 0 based?)
-			pVertList->m_piIndices[i] = (int)BSwap2s((unsigned short*)pBufPos);
-
-			// skip to next
-			pBufPos = (pBufPos +2);
+			piIndices[i] = (int)Cursor.U2();
 		}
 
 		// indices here like in POLS but cannot have detail polygons
-		pVertList->m_wSurfaceIndex = BSwap2s((unsigned short*)pBufPos);
-		pBufPos = (pBufPos +2);
+		VertList.m_wSurfaceIndex = Cursor.U2();
 
 		// flags: if bit zero is set then the first point is a continuity
 		// control point, and if bit one is set then the last point is
-		pVertList->m_wFlags = BSwap2s((unsigned short*)pBufPos);
-		pBufPos = (pBufPos +2);
-		
-		// keep row for later
-		pPolyList->m_PolyList.push_back(pVertList);
-		lPolyRowIndex++;
+		VertList.m_wFlags = Cursor.U2();
 	}
 
-	pCurrentLayer->AddChunkToLayer(pPolyList);
-	m_ObjectData.AddChunk(pPolyList);
-	return true;
+	// surface-mapping like in LWO2
+	return Handle_LWOB_SurfaceTags(pPolyList, pCurrentLayer);
 }
 
 bool CLwoReader::Handle_LWOB_ID_SRFS(const char *pChunk, const unsigned int uiChunkSize)
 {
-	CLwoLayer *pCurrentLayer = (CLwoLayer*)m_ObjectData.GetPreviousOfType(ID_LAYR);
+	LWO_STAT_HANDLER("Handle_LWOB_ID_SRFS", uiChunkSize);
 
-	if (pCurrentLayer == NULL)
-	{
-		pCurrentLayer = new CLwoLayer(0);
-		m_ObjectData.AddChunk(pCurrentLayer);
-	}
+	// surface names are kept like TAGS in LWO2:
+	// 1-based index on older LWOB, handled internally as 0-based
+	// (see Handle_LWOB_SurfaceTags())
+	CLwoTagnameList *pTagnames = m_ObjectData.AddChunk(unique_ptr<CLwoTagnameList>(new CLwoTagnameList()));
 
-	 // 1-based index on older LWOB, handle internally as 0-based?
-	long lSrfsIx = 0;
-	char *pBufPos = (char*)pChunk;
-	char *pSurfacesEnd = (pBufPos + uiChunkSize);
-	while (pBufPos != pSurfacesEnd)
+	CLwoCursor Cursor(pChunk, uiChunkSize);
+	while (Cursor.IsAtEnd() == false)
 	{
-		// size with possible padding
-		unsigned int uiStrLen = 0;
-
-		// note: in LWOB-format there are 1-based indices
-		// to this surface-list where most other indices are zero-based?
-
 		// each string is ASCII with terminating NULL,
 		// but can have double-NULL to make even-byte alignment
-		string szSurfaceName = GetPaddedString(pBufPos, uiStrLen);
-
-		// TODO: keep the names somewhere..
+		string szSurfaceName;
+		if (Cursor.ReadS0(szSurfaceName) == false)
+		{
+			return SetError(Cursor);
+		}
 
-		// more strings? (this should be in loop then)
-		pBufPos = (pBufPos + uiStrLen);
-		lSrfsIx++;
+		pTagnames->AddTagname(szSurfaceName);
 	}
 	return true;
 }
 
 bool CLwoReader::Handle_LWO2_ID_SURF(const char *pChunk, const unsigned int uiChunkSize)
 {
-	CLwoLayer *pCurrentLayer = (CLwoLayer*)m_ObjectData.GetPreviousOfType(ID_LAYR);
+	LWO_STAT_HANDLER("Handle_LWO2_ID_SURF", uiChunkSize);
+
+	CLwoLayer *pCurrentLayer = GetCurrentLayer();
 
 	// in LWO2, surface is linked to polygon via PTAG-list
 	// of mapping between polygons and surfaces (0-based)
-	CLwoSurface *pSurfaces = new CLwoSurface(pCurrentLayer->m_uiLayerIndex);
-
-	char *pBufPos = (char*)pChunk;
+	CLwoSurface *pSurfaces = m_ObjectData.AddChunk(unique_ptr<CLwoSurface>(new CLwoSurface(pCurrentLayer->m_uiLayerIndex)));
 
-	// count end of chunk for handling
-	const char *pSurfEnd = (pBufPos + uiChunkSize);
-
-	unsigned int uiStrSize = 0;
+	// keep in layer and object data
+	// (released with object data also on error)
+	pCurrentLayer->AddChunkToLayer(pSurfaces);
 
-	// name of this surface
-	pSurfaces->m_szSurfaceName = GetPaddedString(pBufPos, uiStrSize);
-	pBufPos = (pBufPos + uiStrSize);
+	CLwoCursor Cursor(pChunk, uiChunkSize);
 
+	// name of this surface,
 	// LWO2 can have parent-surface name:
 	// name of parent-surface (if any),
 	// a surface can inherit from it's parent
-	pSurfaces->m_szParentSurfaceName = GetPaddedString(pBufPos, uiStrSize);
-	pBufPos = (pBufPos + uiStrSize);
-
-	while (pBufPos != pSurfEnd)
+	if (Cursor.ReadS0(pSurfaces->m_szSurfaceName) == false
+		|| Cursor.ReadS0(pSurfaces->m_szParentSurfaceName) == false)
 	{
-		unsigned short usSCSize = 0;
-		unsigned int uiSCType = GetSubChunkType(pBufPos, usSCSize);
-		pBufPos = (pBufPos +6); // type (4) + size (2) bytes
-
-		// count end of sub-chunk
-		const char *pSubChunkEnd = (pBufPos + usSCSize);
+		return SetError(Cursor);
+	}
 
-		// TODO: need to move BLOK separately..
-		// from here..
+	while (Cursor.IsAtEnd() == false)
+	{
+		// sub-chunk must fit in the surface-chunk:
+		// handling below may not read all of sub-chunk,
+		// cursor is already at next one (if any)
+		unsigned int uiSCType = 0;
+		CLwoCursor SubChunk(NULL, 0);
+		if (Cursor.ReadSubChunk(uiSCType, SubChunk) == false)
+		{
+			return SetError(Cursor);
+		}
 
-		// blok: nested sub-chunks
+		// blok: nested sub-chunks of texture layer
 		if (uiSCType == ID_BLOK)
 		{
-			// skip this sub-chunk
-			pBufPos = (pBufPos +usSCSize);
-
-			// processing
-			//pBufPos = Handle_LWO2_BLOK(pBufPos, usSCSize);
-
+			CLwoSurface::CLwoTextureLayer Layer;
+			if (Handle_LWO2_BLOK(SubChunk, Layer) == false)
+			{
+				return false;
+			}
+			if (Layer.m_uiBlokTypeID != 0)
+			{
+				pSurfaces->m_TextureLayers.push_back(Layer);
+			}
 			continue;
 		}
 
@@ -952,21 +1030,11 @@ bool CLwoReader::Handle_LWO2_ID_SURF(const char *pChunk, const unsigned int uiCh
 			{
 				// three color-values (RGB) in 4-byte floats,
 				// and one VX for enveloping
-				float *pfRGB = new float[3];
-				float *pfChunkRGB = (float*)pBufPos;
-				for (int i = 0; i < 3; i++)
+				if (SubChunk.ReadVec12(pSurfaces->m_fColor) == false
+					|| SubChunk.ReadVX(pSurfaces->m_uiColorEnvelope) == false)
 				{
-					pfRGB[i] = BSwapF(pfChunkRGB[i]);
+					return SetError(SubChunk);
 				}
-				pBufPos = (pBufPos + 3*sizeof(float));
-
-				// TODO: keep buffer instead of deleting
-				delete pfRGB;
-
-				// also index to envelope
-				int iIxSize = 0;
-				int iEnvelope = (int)GetVarlenIX(pBufPos, iIxSize);
-				pBufPos = (pBufPos + iIxSize);
 			}
 			break;
 
@@ -976,85 +1044,65 @@ bool CLwoReader::Handle_LWO2_ID_SURF(const char *pChunk, const unsigned int uiCh
 		case ID_REFL:
 		case ID_TRAN:
 		case ID_TRNL:
-			//DIFF, LUMI, SPEC, REFL, TRAN, TRNL
-			// have same structure of information,
-			// if any of these is missing, value of zero is assumed for it
-			{
-				float *pfBuf = (float*)pBufPos;
-				float fTemp = BSwapF(*pfBuf);
-				pBufPos = (pBufPos +4);
-
-				// also index to envelope
-				int iIxSize = 0;
-				int iEnvelope = (int)GetVarlenIX(pBufPos, iIxSize);
-				pBufPos = (pBufPos + iIxSize);
-			}
-			break;
-
 		case ID_GLOS:
-			// glossiness
+		case ID_BUMP:
+		case ID_RIND:
+			//DIFF, LUMI, SPEC, REFL, TRAN, TRNL (and GLOS, BUMP, RIND)
+			// have same structure of information,
+			// if any of these is missing, default value is assumed for it
 			{
-				float *pfBuf = (float*)pBufPos;
-				float fTemp = BSwapF(*pfBuf);
-				pBufPos = (pBufPos +4);
-
-				// also index to envelope
-				int iIxSize = 0;
-				int iEnvelope = (int)GetVarlenIX(pBufPos, iIxSize);
-				pBufPos = (pBufPos + iIxSize);
+				// value and index to envelope
+				unsigned int uiEnvelope = 0;
+				if (SubChunk.ReadF4(*(pSurfaces->GetChannelValue(uiSCType))) == false
+					|| SubChunk.ReadVX(uiEnvelope) == false)
+				{
+					return SetError(SubChunk);
+				}
 			}
 			break;
 
 		case ID_SHRP:
 			// sharpness
 			{
-				float *pfBuf = (float*)pBufPos;
-				float fTemp = BSwapF(*pfBuf);
-				pBufPos = (pBufPos +4);
-
-				// also index to envelope
-				int iIxSize = 0;
-				int iEnvelope = (int)GetVarlenIX(pBufPos, iIxSize);
-				pBufPos = (pBufPos + iIxSize);
-			}
-			break;
-
-		case ID_BUMP:
-			// bump intensity
-			{
-				float *pfBuf = (float*)pBufPos;
-				float fTemp = BSwapF(*pfBuf);
-				pBufPos = (pBufPos +4);
-
-				// also index to envelope
-				int iIxSize = 0;
-				int iEnvelope = (int)GetVarlenIX(pBufPos, iIxSize);
-				pBufPos = (pBufPos + iIxSize);
+				// value and index to envelope
+				float fTemp = 0.0f;
+				unsigned int uiEnvelope = 0;
+				if (SubChunk.ReadF4(fTemp) == false
+					|| SubChunk.ReadVX(uiEnvelope) == false)
+				{
+					return SetError(SubChunk);
+				}
 			}
 			break;
 
 		case ID_SIDE:
 			// polygon sidedness
 			{
-				unsigned short wTemp = BSwap2s((unsigned short*)pBufPos);
-				pBufPos = (pBufPos +2);
+				if (SubChunk.ReadU2(pSurfaces->m_usSidedness) == false)
+				{
+					return SetError(SubChunk);
+				}
 			}
 			break;
 
 		case ID_SMAN:
 			// max smoothing angle (in radians)
 			{
-				float *pfBuf = (float*)pBufPos;
-				float fTemp = BSwapF(*pfBuf);
-				pBufPos = (pBufPos +4);
+				if (SubChunk.ReadF4(pSurfaces->m_fSmoothingAngle) == false)
+				{
+					return SetError(SubChunk);
+				}
 			}
 			break;
 
 		case ID_RFOP:
 			// reflection-options
 			{
-				unsigned short wTemp = BSwap2s((unsigned short*)pBufPos);
-				pBufPos = (pBufPos +2);
+				unsigned short wTemp = 0;
+				if (SubChunk.ReadU2(wTemp) == false)
+				{
+					return SetError(SubChunk);
+				}
 			}
 			break;
 
@@ -1063,9 +1111,11 @@ bool CLwoReader::Handle_LWO2_ID_SURF(const char *pChunk, const unsigned int uiCh
 			// index to CLIP
 			{
 				// note: if value is zero, not used
-				int iIxSize = 0;
-				int iIndex = (int)GetVarlenIX(pBufPos, iIxSize);
-				pBufPos = (pBufPos + iIxSize);
+				unsigned int uiIndex = 0;
+				if (SubChunk.ReadVX(uiIndex) == false)
+				{
+					return SetError(SubChunk);
+				}
 			}
 			break;
 
@@ -1074,146 +1124,140 @@ bool CLwoReader::Handle_LWO2_ID_SURF(const char *pChunk, const unsigned int uiCh
 			// index to CLIP
 			{
 				// note: if value is zero, not used
-				int iIxSize = 0;
-				int iIndex = (int)GetVarlenIX(pBufPos, iIxSize);
-				pBufPos = (pBufPos + iIxSize);
+				unsigned int uiIndex = 0;
+				if (SubChunk.ReadVX(uiIndex) == false)
+				{
+					return SetError(SubChunk);
+				}
 			}
 			break;
 
 		case ID_RSAN:
 			// reflection map image seam angle (in radians)
 			{
-				float *pfBuf = (float*)pBufPos;
-				float fTemp = BSwapF(*pfBuf);
-				pBufPos = (pBufPos +4);
-
-				int iIxSize = 0;
-				int iEnvelope = (int)GetVarlenIX(pBufPos, iIxSize);
-				pBufPos = (pBufPos + iIxSize);
+				// value and index to envelope
+				float fTemp = 0.0f;
+				unsigned int uiEnvelope = 0;
+				if (SubChunk.ReadF4(fTemp) == false
+					|| SubChunk.ReadVX(uiEnvelope) == false)
+				{
+					return SetError(SubChunk);
+				}
 			}
 			break;
 
 		case ID_RBLR:
 			// reflection-blur percentage
 			{
-				float *pfBuf = (float*)pBufPos;
-				float fTemp = BSwapF(*pfBuf);
-				pBufPos = (pBufPos +4);
-
-				int iIxSize = 0;
-				int iEnvelope = (int)GetVarlenIX(pBufPos, iIxSize);
-				pBufPos = (pBufPos + iIxSize);
+				// value and index to envelope
+				float fTemp = 0.0f;
+				unsigned int uiEnvelope = 0;
+				if (SubChunk.ReadF4(fTemp) == false
+					|| SubChunk.ReadVX(uiEnvelope) == false)
+				{
+					return SetError(SubChunk);
+				}
 			}
 			break;
 
 		case ID_TBLR:
 			// refraction-blur percentage
 			{
-				float *pfBuf = (float*)pBufPos;
-				float fTemp = BSwapF(*pfBuf);
-				pBufPos = (pBufPos +4);
-
-				int iIxSize = 0;
-				int iEnvelope = (int)GetVarlenIX(pBufPos, iIxSize);
-				pBufPos = (pBufPos + iIxSize);
-			}
-			break;
-
-		case ID_RIND:
-			// refractive index
-			{
-				float *pfBuf = (float*)pBufPos;
-				float fTemp = BSwapF(*pfBuf);
-				pBufPos = (pBufPos +4);
-
-				int iIxSize = 0;
-				int iEnvelope = (int)GetVarlenIX(pBufPos, iIxSize);
-				pBufPos = (pBufPos + iIxSize);
+				// value and index to envelope
+				float fTemp = 0.0f;
+				unsigned int uiEnvelope = 0;
+				if (SubChunk.ReadF4(fTemp) == false
+					|| SubChunk.ReadVX(uiEnvelope) == false)
+				{
+					return SetError(SubChunk);
+				}
 			}
 			break;
 
 		case ID_TROP:
 			// transparency options
 			{
-				unsigned short wTemp = BSwap2s((unsigned short*)pBufPos);
-				pBufPos = (pBufPos +2);
+				unsigned short wTemp = 0;
+				if (SubChunk.ReadU2(wTemp) == false)
+				{
+					return SetError(SubChunk);
+				}
 			}
 			break;
 
 		case ID_CLRH:
 			// color highlights
 			{
-				float *pfBuf = (float*)pBufPos;
-				float fTemp = BSwapF(*pfBuf);
-				pBufPos = (pBufPos +4);
-
-				int iIxSize = 0;
-				int iEnvelope = (int)GetVarlenIX(pBufPos, iIxSize);
-				pBufPos = (pBufPos + iIxSize);
+				// value and index to envelope
+				float fTemp = 0.0f;
+				unsigned int uiEnvelope = 0;
+				if (SubChunk.ReadF4(fTemp) == false
+					|| SubChunk.ReadVX(uiEnvelope) == false)
+				{
+					return SetError(SubChunk);
+				}
 			}
 			break;
 
 		case ID_CLRF:
 			// color filter
 			{
-				float *pfBuf = (float*)pBufPos;
-				float fTemp = BSwapF(*pfBuf);
-				pBufPos = (pBufPos +4);
-
-				int iIxSize = 0;
-				int iEnvelope = (int)GetVarlenIX(pBufPos, iIxSize);
-				pBufPos = (pBufPos + iIxSize);
+				// value and index to envelope
+				float fTemp = 0.0f;
+				unsigned int uiEnvelope = 0;
+				if (SubChunk.ReadF4(fTemp) == false
+					|| SubChunk.ReadVX(uiEnvelope) == false)
+				{
+					return SetError(SubChunk);
+				}
 			}
 			break;
 
 		case ID_ADTR:
 			// additive transparency
 			{
-				float *pfBuf = (float*)pBufPos;
-				float fTemp = BSwapF(*pfBuf);
-				pBufPos = (pBufPos +4);
-
-				int iIxSize = 0;
-				int iEnvelope = (int)GetVarlenIX(pBufPos, iIxSize);
-				pBufPos = (pBufPos + iIxSize);
+				// value and index to envelope
+				float fTemp = 0.0f;
+				unsigned int uiEnvelope = 0;
+				if (SubChunk.ReadF4(fTemp) == false
+					|| SubChunk.ReadVX(uiEnvelope) == false)
+				{
+					return SetError(SubChunk);
+				}
 			}
 			break;
 
 		case ID_GLOW:
 			// glow effect
 			{
-				int iIxSize = 0;
-
-				unsigned short wTemp = BSwap2s((unsigned short*)pBufPos);
-				pBufPos = (pBufPos +2);
-
-				float fIntensity = BSwapF((*((float*)pBufPos)));
-				pBufPos = (pBufPos +4);
-
-				iIxSize = 0;
-				// intensity-envelope
-				int iEnvelope = (int)GetVarlenIX(pBufPos, iIxSize);
-				pBufPos = (pBufPos + iIxSize);
-
-				float fSize = BSwapF((*((float*)pBufPos)));
-				pBufPos = (pBufPos +4);
-
-				iIxSize = 0;
-				// size-envelope
-				int iSizeEnvelope = (int)GetVarlenIX(pBufPos, iIxSize);
-				pBufPos = (pBufPos + iIxSize);
+				// type, intensity and intensity-envelope,
+				// size and size-envelope
+				unsigned short wTemp = 0;
+				float fIntensity = 0.0f;
+				unsigned int uiEnvelope = 0;
+				float fSize = 0.0f;
+				unsigned int uiSizeEnvelope = 0;
+				if (SubChunk.ReadU2(wTemp) == false
+					|| SubChunk.ReadF4(fIntensity) == false
+					|| SubChunk.ReadVX(uiEnvelope) == false
+					|| SubChunk.ReadF4(fSize) == false
+					|| SubChunk.ReadVX(uiSizeEnvelope) == false)
+				{
+					return SetError(SubChunk);
+				}
 			}
 			break;
 
 		case ID_GVAL:
 			{
-				float *pfBuf = (float*)pBufPos;
-				float fTemp = BSwapF(*pfBuf);
-				pBufPos = (pBufPos +4);
-
-				int iIxSize = 0;
-				int iEnvelope = (int)GetVarlenIX(pBufPos, iIxSize);
-				pBufPos = (pBufPos + iIxSize);
+				// value and index to envelope
+				float fTemp = 0.0f;
+				unsigned int uiEnvelope = 0;
+				if (SubChunk.ReadF4(fTemp) == false
+					|| SubChunk.ReadVX(uiEnvelope) == false)
+				{
+					return SetError(SubChunk);
+				}
 			}
 			break;
 
@@ -1226,7 +1270,7 @@ bool CLwoReader::Handle_LWO2_ID_SURF(const char *pChunk, const unsigned int uiCh
 				unsigned short wFlags = BSwap2s((unsigned short*)pBufPos);
 				pBufPos = (pBufPos +2);
 
-				float fSize = BSwapF((*((float*)pBufPos)));
+				float fSize = LwoGetF4(pBufPos);
 				pBufPos = (pBufPos +4);
 
 				iIxSize = 0;
@@ -1240,111 +1284,118 @@ bool CLwoReader::Handle_LWO2_ID_SURF(const char *pChunk, const unsigned int uiCh
 		case ID_ALPH:
 			// alpha-mode
 			{
-				unsigned short wTemp = BSwap2s((unsigned short*)pBufPos);
-				pBufPos = (pBufPos +2);
-
-				float *pfBuf = (float*)pBufPos;
-				float fTemp = BSwapF(*pfBuf);
-				pBufPos = (pBufPos +4);
+				unsigned short wTemp = 0;
+				float fTemp = 0.0f;
+				if (SubChunk.ReadU2(wTemp) == false
+					|| SubChunk.ReadF4(fTemp) == false)
+				{
+					return SetError(SubChunk);
+				}
 			}
 			break;
 
 		case ID_VCOL:
 			// vertex color map
 			{
-				float *pfBuf = (float*)pBufPos;
-				float fTemp = BSwapF(*pfBuf);
-				pBufPos = (pBufPos +4);
-
-				int iIxSize = 0;
-				int iEnvelope = (int)GetVarlenIX(pBufPos, iIxSize);
-				pBufPos = (pBufPos + iIxSize);
-
-				unsigned int uiVmapType = MakeTag(pBufPos);
-				pBufPos = (pBufPos +4);
+				// intensity and envelope,
+				// type and name of vertex map
+				float fTemp = 0.0f;
+				unsigned int uiEnvelope = 0;
+				if (SubChunk.ReadF4(fTemp) == false
+					|| SubChunk.ReadVX(uiEnvelope) == false)
+				{
+					return SetError(SubChunk);
+				}
+				// type of vertex map is not kept (yet)
+				if (SubChunk.Require(4) == false)
+				{
+					return SetError(SubChunk);
+				}
+				SubChunk.Skip(4);
 
-				unsigned int uiStrSize = 0;
-				string szName = GetPaddedString(pBufPos, uiStrSize);
-				pBufPos = (pBufPos + uiStrSize);
+				string szName;
+				if (SubChunk.ReadS0(szName) == false)
+				{
+					return SetError(SubChunk);
+				}
 			}
 			break;
 		}
-
-		// skip to next sub-chunk (if any)
-		// note: check if any of above changed value..
-		if (pBufPos != pSubChunkEnd)
-		{
-			pBufPos = (pBufPos +usSCSize);
-		}
 	}
 
-	pCurrentLayer->AddChunkToLayer(pSurfaces);
-	m_ObjectData.AddChunk(pSurfaces);
+	// layers are evaluated in order of ordinal-strings
+	stable_sort(pSurfaces->m_TextureLayers.begin(), pSurfaces->m_TextureLayers.end());
 	return true;
 }
 
 bool CLwoReader::Handle_LWOB_ID_SURF(const char *pChunk, const unsigned int uiChunkSize)
 {
-	CLwoLayer *pCurrentLayer = (CLwoLayer*)m_ObjectData.GetPreviousOfType(ID_LAYR);
+	LWO_STAT_HANDLER("Handle_LWOB_ID_SURF", uiChunkSize);
 
-	// in LWOB, there might not be layers
-	// -> add a default layer for us
-	if (pCurrentLayer == NULL)
-	{
-		pCurrentLayer = new CLwoLayer(0);
-		m_ObjectData.AddChunk(pCurrentLayer);
-	}
+	CLwoLayer *pCurrentLayer = GetCurrentLayer();
 
 	// in LWOB, polygons have surface-index to which they use (1-based)
-	CLwoSurface *pSurfaces = new CLwoSurface(pCurrentLayer->m_uiLayerIndex);
-
-	char *pBufPos = (char*)pChunk;
+	CLwoSurface *pSurfaces = m_ObjectData.AddChunk(unique_ptr<CLwoSurface>(new CLwoSurface(pCurrentLayer->m_uiLayerIndex)));
 
-	// count end of chunk for handling
-	const char *pSurfEnd = (pBufPos + uiChunkSize);
+	// keep in layer and object data
+	// (released with object data also on error)
+	pCurrentLayer->AddChunkToLayer(pSurfaces);
 
-	unsigned int uiStrSize = 0;
+	CLwoCursor Cursor(pChunk, uiChunkSize);
 
 	// name of this surface
-	pSurfaces->m_szSurfaceName = GetPaddedString(pBufPos, uiStrSize);
-	pBufPos = (pBufPos + uiStrSize);
+	if (Cursor.ReadS0(pSurfaces->m_szSurfaceName) == false)
+	{
+		return SetError(Cursor);
+	}
 
-	while (pBufPos != pSurfEnd)
+	// LWOB smoothing-angle is used only when smoothing-flag is set
+	// (89.5 degrees when not given, as in Lightwave SDK)
+	unsigned short wSurfaceFlags = 0;
+	float fSmoothingAngle = 89.5f;
+
+	// texture layer of most recent xTEX (NULL before first one):
+	// following texture sub-chunks refer to it
+	CLwoSurface::CLwoTextureLayer *pTexture = NULL;
+
+	while (Cursor.IsAtEnd() == false)
 	{
-		unsigned short usSCSize = 0;
-		unsigned int uiSCType = GetSubChunkType(pBufPos, usSCSize);
-		pBufPos = (pBufPos +6); // type (4) + size (2) bytes
+		// sub-chunk must fit in the surface-chunk:
+		// handling below may not read all of sub-chunk,
+		// cursor is already at next one (if any)
+		unsigned int uiSCType = 0;
+		CLwoCursor SubChunk(NULL, 0);
+		if (Cursor.ReadSubChunk(uiSCType, SubChunk) == false)
+		{
+			return SetError(Cursor);
+		}
 
-		// count end of sub-chunk
-		const char *pSubChunkEnd = (pBufPos + usSCSize);
 		switch (uiSCType)
 		{
 		case ID_COLR:
 			// three color-values (RGB) in 1-byte integers,
 			// and one byte which is unused in LWOB and should be zero
 			{
-				// TODO: keep in object-datalist
-				char *pcRGB = new char[3];
-
+				if (SubChunk.Require(3) == false)
+				{
+					return SetError(SubChunk);
+				}
 				for (int i = 0; i < 3; i++)
 				{
-					pcRGB[i] = pBufPos[i];
+					pSurfaces->m_fColor[i] = SubChunk.U1() / 255.0f;
 				}
-				pBufPos = (pBufPos +3);
-
-				// TODO: keep buffer instead of deleting
-				delete pcRGB;
-
-				// should be zero in older LWOB-format (not used)
-				int iEnvelope = (char)(*pBufPos);
-				pBufPos = (pBufPos +1);
 			}
 			break;
 
 		case ID_FLAG:
 			{
-				unsigned short wFlags = BSwap2s((unsigned short*)pBufPos);
-				pBufPos = (pBufPos +2);
+				if (SubChunk.ReadU2(wSurfaceFlags) == false)
+				{
+					return SetError(SubChunk);
+				}
+
+				// bit 8: double-sided
+				pSurfaces->m_usSidedness = ((wSurfaceFlags & 0x100) != 0) ? 3 : 1;
 			}
 			break;
 
@@ -1353,18 +1404,60 @@ bool CLwoReader::Handle_LWOB_ID_SURF(const char *pChunk, const unsigned int uiCh
 		case ID_SPEC:
 		case ID_REFL:
 		case ID_TRAN:
-			// if any of these is missing, value of zero is assumed for it
+			// if any of these is missing, value of zero is assumed for it:
+			// fixed-point value where 256 is 100%
 			{
-				unsigned short wSurProp = BSwap2s((unsigned short*)pBufPos);
-				pBufPos = (pBufPos +2);
+				unsigned short wSurProp = 0;
+				if (SubChunk.ReadU2(wSurProp) == false)
+				{
+					return SetError(SubChunk);
+				}
+				*(pSurfaces->GetChannelValue(uiSCType)) = (wSurProp / 256.0f);
+			}
+			break;
+
+		case ID_VLUM:
+		case ID_VDIF:
+		case ID_VSPC:
+		case ID_VRFL:
+		case ID_VTRN:
+			// floating-point versions of above,
+			// these override the fixed-point values
+			{
+				unsigned int uiChannel = ID_LUMI;
+				switch (uiSCType)
+				{
+				case ID_VDIF:
+					uiChannel = ID_DIFF;
+					break;
+				case ID_VSPC:
+					uiChannel = ID_SPEC;
+					break;
+				case ID_VRFL:
+					uiChannel = ID_REFL;
+					break;
+				case ID_VTRN:
+					uiChannel = ID_TRAN;
+					break;
+				}
+
+				if (SubChunk.ReadF4(*(pSurfaces->GetChannelValue(uiChannel))) == false)
+				{
+					return SetError(SubChunk);
+				}
 			}
 			break;
 
 		case ID_GLOS:
 			// needed only if specular-setting is non-zero above..
+			// (from 2 to 1024, converted to range of LWO2 as in Lightwave SDK)
 			{
-				unsigned short wSurProp = BSwap2s((unsigned short*)pBufPos);
-				pBufPos = (pBufPos +2);
+				unsigned short wSurProp = 0;
+				if (SubChunk.ReadU2(wSurProp) == false)
+				{
+					return SetError(SubChunk);
+				}
+				pSurfaces->m_fGlossiness = (wSurProp > 0) ? (float)(log((double)wSurProp) / 20.7944) : 0.0f;
 			}
 			break;
 
@@ -1372,9 +1465,11 @@ bool CLwoReader::Handle_LWOB_ID_SURF(const char *pChunk, const unsigned int uiCh
 			// name of file for reflection map
 			// or sequence of files
 			{
-				unsigned int uiStrSize = 0;
-				string szFilename = GetPaddedString(pBufPos, uiStrSize);
-				pBufPos = (pBufPos + uiStrSize);
+				string szFilename;
+				if (SubChunk.ReadS0(szFilename) == false)
+				{
+					return SetError(SubChunk);
+				}
 
 				// if last part of string is " (sequence)",
 				// then string defines _prefix_ for sequence of images
@@ -1383,15 +1478,20 @@ bool CLwoReader::Handle_LWOB_ID_SURF(const char *pChunk, const unsigned int uiCh
 			break;
 
 		case ID_TIMG:
-			// like RIMG, may have sequence of files
+			// like RIMG, may have sequence of files:
+			// image of current texture as a clip (as IMAG in LWO2)
 			{
-				unsigned int uiStrSize = 0;
-				string szFilename = GetPaddedString(pBufPos, uiStrSize);
-				pBufPos = (pBufPos + uiStrSize);
-
-				// if last part of string is " (sequence)",
-				// then string defines _prefix_ for sequence of images
-				// -> append three digit frame number for actual name
+				string szFilename;
+				if (SubChunk.ReadS0(szFilename) == false)
+				{
+					return SetError(SubChunk);
+				}
+
+				if (pTexture != NULL
+					&& szFilename != "(none)")
+				{
+					pTexture->m_uiImageIndex = Get_LWOB_ImageClip(szFilename);
+				}
 			}
 			break;
 
@@ -1399,36 +1499,42 @@ bool CLwoReader::Handle_LWOB_ID_SURF(const char *pChunk, const unsigned int uiCh
 			// heading angle of 
 			// reflection map seam
 			{
-				float *pfBuf = (float*)pBufPos;
-				float fTemp = BSwapF(*pfBuf);
-				pBufPos = (pBufPos +4);
+				float fTemp = 0.0f;
+				if (SubChunk.ReadF4(fTemp) == false)
+				{
+					return SetError(SubChunk);
+				}
 			}
 			break;
 
 		case ID_RIND:
 			// refractive index
 			{
-				float *pfBuf = (float*)pBufPos;
-				float fTemp = BSwapF(*pfBuf);
-				pBufPos = (pBufPos +4);
+				if (SubChunk.ReadF4(pSurfaces->m_fRefractiveIndex) == false)
+				{
+					return SetError(SubChunk);
+				}
 			}
 			break;
 
 		case ID_EDGE:
 			// edge transparency
 			{
-				float *pfBuf = (float*)pBufPos;
-				float fTemp = BSwapF(*pfBuf);
-				pBufPos = (pBufPos +4);
+				float fTemp = 0.0f;
+				if (SubChunk.ReadF4(fTemp) == false)
+				{
+					return SetError(SubChunk);
+				}
 			}
 			break;
 
 		case ID_SMAN:
 			// max. smooth-shading angle between polygons (in degrees)
 			{
-				float *pfBuf = (float*)pBufPos;
-				float fTemp = BSwapF(*pfBuf);
-				pBufPos = (pBufPos +4);
+				if (SubChunk.ReadF4(fSmoothingAngle) == false)
+				{
+					return SetError(SubChunk);
+				}
 			}
 			break;
 
@@ -1442,19 +1548,58 @@ bool CLwoReader::Handle_LWOB_ID_SURF(const char *pChunk, const unsigned int uiCh
 			{
 				// when detecting one of these,
 				// all following in SURF-chunk refer to this texture
-				// until one of these is detected again
+				// until one of these is detected again:
+				// kept as texture layer like BLOK in LWO2
+				// (no ordinals, layers are in order of file)
+				string szTextureType;
+				if (SubChunk.ReadS0(szTextureType) == false)
+				{
+					return SetError(SubChunk);
+				}
 
-				unsigned int uiStrSize = 0;
-				string szTextureType = GetPaddedString(pBufPos, uiStrSize);
-				pBufPos = (pBufPos + uiStrSize);
+				pSurfaces->m_TextureLayers.push_back(CLwoSurface::CLwoTextureLayer());
+				pTexture = &(pSurfaces->m_TextureLayers.back());
+				pTexture->m_uiChannel = Get_LWOB_TextureChannel(uiSCType);
+
+				// image-map by projection in name,
+				// otherwise procedural texture by name
+				static const char *szProjections[] = {"Planar Image Map", "Cylindrical Image Map", "Spherical Image Map", "Cubic Image Map", "Front Projection Image Map"};
+				pTexture->m_uiBlokTypeID = ID_PROC;
+				for (unsigned short i = 0; i < (sizeof(szProjections) / sizeof(szProjections[0])); i++)
+				{
+					if (szTextureType == szProjections[i])
+					{
+						pTexture->m_uiBlokTypeID = ID_IMAP;
+						pTexture->m_usProjection = i;
+						break;
+					}
+				}
+				if (pTexture->m_uiBlokTypeID == ID_PROC)
+				{
+					pTexture->m_szFunction = szTextureType;
+				}
 			}
 			break;
 
 		case ID_TFLG:
-			// flags for current texture
+			// flags for current texture:
+			// bits 0-2: axis X/Y/Z, 3: world coordinates,
+			// 4: negative image, 5: pixel blending, 6: antialiasing
 			{
-				unsigned short wFlags = BSwap2s((unsigned short*)pBufPos);
-				pBufPos = (pBufPos +2);
+				unsigned short wFlags = 0;
+				if (SubChunk.ReadU2(wFlags) == false)
+				{
+					return SetError(SubChunk);
+				}
+
+				if (pTexture != NULL)
+				{
+					pTexture->m_usAxis = ((wFlags & 0x4) != 0) ? 2 : (((wFlags & 0x2) != 0) ? 1 : 0);
+					pTexture->m_usCoordSystem = ((wFlags & 0x8) != 0) ? 1 : 0;
+					pTexture->m_usNegative = ((wFlags & 0x10) != 0) ? 1 : 0;
+					pTexture->m_usPixelBlending = ((wFlags & 0x20) != 0) ? 1 : 0;
+					pTexture->m_usAntialiasFlags = ((wFlags & 0x40) != 0) ? 1 : 0;
+				}
 			}
 			break;
 
@@ -1464,63 +1609,100 @@ bool CLwoReader::Handle_LWOB_ID_SURF(const char *pChunk, const unsigned int uiCh
 		case ID_TVEL:
 			// XYZ-components of 
 			// texture's size, center, falloff, velocity
+			// (as TMAP in LWO2, which has no velocity)
 			{
-				float *pfTex = new float[3];
-				float *pfChunkTex = (float*)pBufPos;
-				for (int i = 0; i < 3; i++)
+				float fTex[3];
+				if (SubChunk.ReadVec12(fTex) == false)
 				{
-					pfTex[i] = BSwapF(pfChunkTex[i]);
+					return SetError(SubChunk);
 				}
-				pBufPos = (pBufPos + 3*sizeof(float));
 
-				// TODO: keep buffer instead of deleting
-				delete pfTex;
+				float *pfTarget = NULL;
+				if (pTexture != NULL)
+				{
+					switch (uiSCType)
+					{
+					case ID_TSIZ:
+						pfTarget = pTexture->m_fSize;
+						break;
+					case ID_TCTR:
+						pfTarget = pTexture->m_fCenter;
+						break;
+					case ID_TFAL:
+						pfTarget = pTexture->m_fFalloff;
+						break;
+					}
+				}
+				if (pfTarget != NULL)
+				{
+					for (int i = 0; i < 3; i++)
+					{
+						pfTarget[i] = fTex[i];
+					}
+				}
 			}
 			break;
 
 		case ID_TCLR:
-			// texture color (should also have CTEX before this)
+			// texture color (should also have CTEX before this):
+			// RGB and one byte which should be zero in older LWOB-format (not used),
+			// kept as value of procedural (as VALU in LWO2)
 			{
-				// TODO: keep in object-datalist
-				char *pcRGB = new char[3];
-
-				for (int i = 0; i < 3; i++)
+				if (SubChunk.Require(4) == false)
 				{
-					pcRGB[i] = pBufPos[i];
+					return SetError(SubChunk);
+				}
+				if (pTexture != NULL)
+				{
+					for (int i = 0; i < 3; i++)
+					{
+						pTexture->m_fValue[i] = SubChunk.U1() / 255.0f;
+					}
+					pTexture->m_usValueCount = 3;
 				}
-				pBufPos = (pBufPos +3);
-
-				// TODO: keep buffer instead of deleting
-				delete pcRGB;
-
-				// should be zero in older LWOB-format (not used)
-				int iEnvelope = (char)(*pBufPos);
-				pBufPos = (pBufPos +1);
 			}
 			break;
 
 		case ID_TVAL:
 			// texture value of a diffuse/specular/reflection/transparency texture
+			// (fixed-point where 256 is 100%, as VALU in LWO2)
 			{
-				unsigned short wTexProp = BSwap2s((unsigned short*)pBufPos);
-				pBufPos = (pBufPos +2);
+				unsigned short wTexProp = 0;
+				if (SubChunk.ReadU2(wTexProp) == false)
+				{
+					return SetError(SubChunk);
+				}
+				if (pTexture != NULL)
+				{
+					pTexture->m_fValue[0] = (wTexProp / 256.0f);
+					pTexture->m_usValueCount = 1;
+				}
 			}
 			break;
 
 		case ID_TAMP:
 			// amplitude of current bump-texture (should have BTEX before)
 			{
-				float *pfBuf = (float*)pBufPos;
-				float fTemp = BSwapF(*pfBuf);
-				pBufPos = (pBufPos +4);
+				float fTemp = 0.0f;
+				if (SubChunk.ReadF4(fTemp) == false)
+				{
+					return SetError(SubChunk);
+				}
+				if (pTexture != NULL)
+				{
+					pTexture->m_fAmplitude = fTemp;
+				}
 			}
 			break;
 
 		case ID_TFRQ:
 			// number of noise frequencies or wave sources for current texture
 			{
-				unsigned short wTexProp = BSwap2s((unsigned short*)pBufPos);
-				pBufPos = (pBufPos +2);
+				unsigned short wTexProp = 0;
+				if (SubChunk.ReadU2(wTexProp) == false)
+				{
+					return SetError(SubChunk);
+				}
 			}
 			break;
 
@@ -1531,8 +1713,7 @@ bool CLwoReader::Handle_LWOB_ID_SURF(const char *pChunk, const unsigned int uiCh
 			// texture parameters
 			// (depend on order of buttons in GUI..)
 			{
-				float *pfBuf = (float*)pBufPos;
-				float fTemp = BSwapF(*pfBuf);
+				float fTemp = LwoGetF4(pBufPos);
 				pBufPos = (pBufPos +4);
 			}
 			break;
@@ -1547,231 +1728,377 @@ bool CLwoReader::Handle_LWOB_ID_SURF(const char *pChunk, const unsigned int uiCh
 			break;
 			*/
 		}
+	}
+
+	// bit 2: smoothing, angle in radians as in LWO2
+	if ((wSurfaceFlags & 0x4) != 0)
+	{
+		pSurfaces->m_fSmoothingAngle = (float)(fSmoothingAngle * 3.14159265358979 / 180.0);
+	}
+
+	return true;
+}
+
+// surface channel of LWOB texture by its sub-chunk
+unsigned int CLwoReader::Get_LWOB_TextureChannel(const unsigned int uiTexType)
+{
+	switch (uiTexType)
+	{
+	case ID_DTEX:
+		return ID_DIFF;
+	case ID_STEX:
+		return ID_SPEC;
+	case ID_RTEX:
+		return ID_REFL;
+	case ID_TTEX:
+		return ID_TRAN;
+	case ID_BTEX:
+		return ID_BUMP;
+	}
+	return ID_COLR;
+}
 
-		// skip to next sub-chunk (if any)
-		// note: check if any of above changed value..
-		if (pBufPos != pSubChunkEnd)
+// LWOB has no CLIP-chunks: image of texture is kept as a clip
+// so that it is resolved as in LWO2,
+// same image in other textures uses same clip
+unsigned int CLwoReader::Get_LWOB_ImageClip(const string &szImage)
+{
+	// if last part of string is " (sequence)",
+	// then string defines _prefix_ for sequence of images
+	// -> append three digit frame number for actual name
+	static const string szSequence(" (sequence)");
+	unsigned int uiClipTypeID = ID_STIL;
+	string szFilename(szImage);
+	if (szFilename.size() > szSequence.size()
+		&& szFilename.compare(szFilename.size() - szSequence.size(), szSequence.size(), szSequence) == 0)
+	{
+		uiClipTypeID = ID_ISEQ;
+		szFilename.resize(szFilename.size() - szSequence.size());
+	}
+
+	const tClipList &Clips = m_ObjectData.GetClips();
+	for (size_t i = 0; i < Clips.size(); i++)
+	{
+		if (Clips[i]->m_uiClipTypeID == uiClipTypeID
+			&& Clips[i]->m_szFilename == szFilename)
 		{
-			pBufPos = (pBufPos +usSCSize);
+			return Clips[i]->m_uiClipIndex;
 		}
 	}
 
-	pCurrentLayer->AddChunkToLayer(pSurfaces);
-	m_ObjectData.AddChunk(pSurfaces);
-	return true;
+	CLwoClip *pClip = m_ObjectData.AddChunk(unique_ptr<CLwoClip>(new CLwoClip(0)));
+	pClip->m_uiClipIndex = (unsigned int)Clips.size();
+	pClip->m_uiClipTypeID = uiClipTypeID;
+	pClip->m_szFilename = szFilename;
+	if (uiClipTypeID == ID_ISEQ)
+	{
+		pClip->m_ucSeqDigits = 3;
+	}
+	return pClip->m_uiClipIndex;
 }
 
 bool CLwoReader::Handle_LWO2_ID_ENVL(const char *pChunk, const unsigned int uiChunkSize)
 {
-	CLwoLayer *pCurrentLayer = (CLwoLayer*)m_ObjectData.GetPreviousOfType(ID_LAYR);
+	LWO_STAT_HANDLER("Handle_LWO2_ID_ENVL", uiChunkSize);
 
-	char *pBufPos = (char*)pChunk;
+	CLwoLayer *pCurrentLayer = (CLwoLayer*)m_ObjectData.GetPreviousOfType(ID_LAYR);
 
-	// count end of chunk for handling
-	const char *pEnd = (pBufPos + uiChunkSize);
+	CLwoEnvelope *pEnvelope = m_ObjectData.AddChunk(unique_ptr<CLwoEnvelope>(new CLwoEnvelope((pCurrentLayer != NULL) ? pCurrentLayer->m_uiLayerIndex : 0)));
 
-	int iIxSize = 0;
-	int iIndex = (int)GetVarlenIX(pBufPos, iIxSize);
-	pBufPos = (pBufPos +iIxSize);
+	CLwoCursor Cursor(pChunk, uiChunkSize);
 
-	while (pBufPos != pEnd)
+	unsigned int uiIndex = 0;
+	if (Cursor.ReadVX(uiIndex) == false)
 	{
-		unsigned short usSCSize = 0;
-		unsigned int uiSCType = GetSubChunkType(pBufPos, usSCSize);
-		pBufPos = (pBufPos +6); // type (4) + size (2) bytes
+		return SetError(Cursor);
+	}
+	pEnvelope->m_iEnvelopeIndex = (int)uiIndex;
 
-		// count end of sub-chunk
-		const char *pSubChunkEnd = (pBufPos + usSCSize);
+	while (Cursor.IsAtEnd() == false)
+	{
+		// handling below may not read all of sub-chunk,
+		// cursor is already at next one (if any)
+		unsigned int uiSCType = 0;
+		CLwoCursor SubChunk(NULL, 0);
+		if (Cursor.ReadSubChunk(uiSCType, SubChunk) == false)
+		{
+			return SetError(Cursor);
+		}
 
+		bool bRet = true;
 		switch (uiSCType)
 		{
 		case ID_TYPE:
+			bRet = SubChunk.Require(2);
+			if (bRet == true)
 			{
-				BYTE bUsrFormat = (*pBufPos);
-				pBufPos = (pBufPos +1);
-				BYTE bType = (*pBufPos);
-				pBufPos = (pBufPos +1);
+				pEnvelope->m_ucUserFormat = SubChunk.U1();
+				pEnvelope->m_ucType = SubChunk.U1();
 			}
 			break;
 
 		case ID_PRE:
-			{
-				unsigned short wType = BSwap2s((unsigned short*)pBufPos);
-				pBufPos = (pBufPos +2);
-			}
+			bRet = SubChunk.ReadU2(pEnvelope->m_usPreBehavior);
 			break;
 
 		case ID_POST:
-			{
-				unsigned short wType = BSwap2s((unsigned short*)pBufPos);
-				pBufPos = (pBufPos +2);
-			}
+			bRet = SubChunk.ReadU2(pEnvelope->m_usPostBehavior);
 			break;
 
 		case ID_KEY:
 			{
-				float fKey = BSwapF((*((float*)pBufPos)));
-				pBufPos = (pBufPos +4);
+				float fTime = 0.0f;
+				float fValue = 0.0f;
+				bRet = (SubChunk.ReadF4(fTime)
+					&& SubChunk.ReadF4(fValue));
 
-				float fValue = BSwapF((*((float*)pBufPos)));
-				pBufPos = (pBufPos +4);
+				pEnvelope->m_Keys.push_back(CLwoEnvelope::CLwoEnvelopeKey(fTime, fValue));
 			}
 			break;
 
-			/*
 		case ID_SPAN:
+			// shape of the curve from previous key to most recent key
+			{
+				if (SubChunk.Require(4) == false)
+				{
+					return SetError(SubChunk);
+				}
+				if (pEnvelope->m_Keys.empty() == true)
+				{
+					// span without key
+					return SetError(LWO_ERROR_CHUNK, SubChunk.GetPos());
+				}
+				CLwoEnvelope::CLwoEnvelopeKey &Key = pEnvelope->m_Keys.back();
+				Key.m_uiShape = SubChunk.U4();
+
+				// parameters according to shape (upto four):
+				// as many as there are in sub-chunk
+				float fParams[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+				int iParamCount = 0;
+				while (iParamCount < 4
+					&& SubChunk.GetRemaining() >= 4)
+				{
+					fParams[iParamCount] = SubChunk.F4();
+					iParamCount++;
+				}
+
+				if (Key.m_uiShape == ID_TCB)
+				{
+					Key.m_fTension = fParams[0];
+					Key.m_fContinuity = fParams[1];
+					Key.m_fBias = fParams[2];
+				}
+				else if (Key.m_uiShape == ID_HERM
+					|| Key.m_uiShape == ID_BEZI
+					|| Key.m_uiShape == ID_BEZ2)
+				{
+					for (int i = 0; i < 4; i++)
+					{
+						Key.m_fParam[i] = fParams[i];
+					}
+				}
+			}
 			break;
 
 		case ID_CHAN:
+			// channel modifier: plugin server-name, flags and data
+			{
+				CLwoEnvelope::CLwoEnvelopePlugin Plugin;
+				bRet = (SubChunk.ReadS0(Plugin.m_szServerName)
+					&& SubChunk.ReadU2(Plugin.m_usFlags));
+				if (bRet == true)
+				{
+					Plugin.m_Data.assign(SubChunk.GetPos(), SubChunk.GetEnd());
+					pEnvelope->m_Plugins.push_back(Plugin);
+				}
+			}
 			break;
-			*/
 
 		case ID_NAME:
-			{
-				unsigned int uiStrSize = 0;
-				string szName = GetPaddedString(pBufPos, uiStrSize);
-				pBufPos = (pBufPos + uiStrSize);
-			}
+			bRet = SubChunk.ReadS0(pEnvelope->m_szName);
 			break;
 		}
 
-		// skip to next sub-chunk (if any)
-		// note: check if any of above changed value..
-		if (pBufPos != pSubChunkEnd)
+		if (bRet == false)
 		{
-			pBufPos = (pBufPos +usSCSize);
+			return SetError(SubChunk);
 		}
-
 	}
 
+	// evaluation expects keys in order of time
+	stable_sort(pEnvelope->m_Keys.begin(), pEnvelope->m_Keys.end());
 	return true;
 }
 
 bool CLwoReader::Handle_LWO2_ID_CLIP(const char *pChunk, const unsigned int uiChunkSize)
 {
-	CLwoLayer *pCurrentLayer = (CLwoLayer*)m_ObjectData.GetPreviousOfType(ID_LAYR);
+	LWO_STAT_HANDLER("Handle_LWO2_ID_CLIP", uiChunkSize);
 
-	char *pBufPos = (char*)pChunk;
+	CLwoLayer *pCurrentLayer = (CLwoLayer*)m_ObjectData.GetPreviousOfType(ID_LAYR);
 
-	// count end of chunk for handling
-	const char *pEnd = (pBufPos + uiChunkSize);
+	CLwoCursor Cursor(pChunk, uiChunkSize);
 
-	unsigned int uiIndex = BSwap4i((unsigned int*)pBufPos);
-	pBufPos = (pBufPos +4);
+	// index of this clip (referred by texture layers),
+	// followed by sub-chunks
+	unsigned int uiClipIndex = 0;
+	if (Cursor.ReadU4(uiClipIndex) == false)
+	{
+		return SetError(Cursor);
+	}
 
-	unsigned int uiClipType = MakeTag(pBufPos);
-	pBufPos = (pBufPos +4);
+	CLwoClip *pClip = m_ObjectData.AddChunk(unique_ptr<CLwoClip>(new CLwoClip((pCurrentLayer != NULL) ? pCurrentLayer->m_uiLayerIndex : 0)));
+	pClip->m_uiClipIndex = uiClipIndex;
 
-	while (pBufPos != pEnd)
+	while (Cursor.IsAtEnd() == false)
 	{
-		unsigned short usSCSize = 0;
-		unsigned int uiSCType = GetSubChunkType(pBufPos, usSCSize);
-		pBufPos = (pBufPos +6); // type (4) + size (2) bytes
-
-		// count end of sub-chunk
-		const char *pSubChunkEnd = (pBufPos + usSCSize);
+		// handling below may not read all of sub-chunk,
+		// cursor is already at next one (if any)
+		unsigned int uiSCType = 0;
+		CLwoCursor SubChunk(NULL, 0);
+		if (Cursor.ReadSubChunk(uiSCType, SubChunk) == false)
+		{
+			return SetError(Cursor);
+		}
 
+		bool bRet = true;
 		switch (uiSCType)
 		{
 		case ID_STIL:
-			{
-				unsigned int uiStrSize = 0;
-				string szName = GetPaddedString(pBufPos, uiStrSize);
-				pBufPos = (pBufPos + uiStrSize);
-			}
+			pClip->m_uiClipTypeID = uiSCType;
+			bRet = SubChunk.ReadS0(pClip->m_szFilename);
 			break;
+
 		case ID_ISEQ:
+			// digits, flags, offset, reserved, start, end, prefix, suffix
+			{
+				pClip->m_uiClipTypeID = uiSCType;
+				if (SubChunk.Require(10) == false)
+				{
+					return SetError(SubChunk);
+				}
+				pClip->m_ucSeqDigits = SubChunk.U1();
+				pClip->m_ucSeqFlags = SubChunk.U1();
+
+				unsigned short usOffset = 0;
+				unsigned short usReserved = 0;
+				unsigned short usStart = 0;
+				unsigned short usEnd = 0;
+				bRet = (SubChunk.ReadU2(usOffset)
+					&& SubChunk.ReadU2(usReserved)
+					&& SubChunk.ReadU2(usStart)
+					&& SubChunk.ReadU2(usEnd)
+					&& SubChunk.ReadS0(pClip->m_szFilename)
+					&& SubChunk.ReadS0(pClip->m_szSeqSuffix));
+
+				// signed values
+				pClip->m_sSeqOffset = (short)usOffset;
+				pClip->m_sSeqStart = (short)usStart;
+				pClip->m_sSeqEnd = (short)usEnd;
+			}
 			break;
+
 		case ID_ANIM:
+			// filename, server-name, flags and plugin-data
+			pClip->m_uiClipTypeID = uiSCType;
+			bRet = (SubChunk.ReadS0(pClip->m_szFilename)
+				&& SubChunk.ReadS0(pClip->m_szServerName)
+				&& SubChunk.ReadU2(pClip->m_usAnimFlags));
+			if (bRet == true)
+			{
+				pClip->m_AnimData.assign(SubChunk.GetPos(), SubChunk.GetEnd());
+			}
 			break;
+
 		case ID_XREF:
+			// index of another clip and name of this instance
+			pClip->m_uiClipTypeID = uiSCType;
+			bRet = (SubChunk.ReadU4(pClip->m_uiXrefIndex)
+				&& SubChunk.ReadS0(pClip->m_szXrefName));
 			break;
+
 		case ID_STCC:
-			break;
-		case ID_TIME:
+			// color-cycling still: cycle range and filename
 			{
-				float fStart = BSwapF((*((float*)pBufPos)));
-				pBufPos = (pBufPos +4);
+				pClip->m_uiClipTypeID = uiSCType;
+				unsigned short usLow = 0;
+				unsigned short usHigh = 0;
+				bRet = (SubChunk.ReadU2(usLow)
+					&& SubChunk.ReadU2(usHigh)
+					&& SubChunk.ReadS0(pClip->m_szFilename));
+				pClip->m_sCycleLow = (short)usLow;
+				pClip->m_sCycleHigh = (short)usHigh;
+			}
+			break;
 
-				float fDuration = BSwapF((*((float*)pBufPos)));
-				pBufPos = (pBufPos +4);
+		case ID_TIME:
+			bRet = (SubChunk.ReadF4(pClip->m_fStartTime)
+				&& SubChunk.ReadF4(pClip->m_fDuration)
+				&& SubChunk.ReadF4(pClip->m_fFrameRate));
+			break;
 
-				float fFrameRate = BSwapF((*((float*)pBufPos)));
-				pBufPos = (pBufPos +4);
-			}
+		case ID_CLRS:
+			bRet = SubChunk.ReadU2(pClip->m_usColorSpaceRGB);
+			break;
+		case ID_CLRA:
+			bRet = SubChunk.ReadU2(pClip->m_usColorSpaceAlpha);
+			break;
+		case ID_FILT:
+			bRet = SubChunk.ReadU2(pClip->m_usFiltering);
+			break;
+		case ID_DITH:
+			bRet = SubChunk.ReadU2(pClip->m_usDithering);
 			break;
-		case ID_CONT:
-			{
-				float *pfBuf = (float*)pBufPos;
-				float fTemp = BSwapF(*pfBuf);
-				pBufPos = (pBufPos +4);
 
-				int iIxSize = 0;
-				int iEnvelope = (int)GetVarlenIX(pBufPos, iIxSize);
-				pBufPos = (pBufPos +iIxSize);
-			}
+		case ID_CONT:
+			bRet = (SubChunk.ReadF4(pClip->m_Contrast.m_fValue)
+				&& SubChunk.ReadVX(pClip->m_Contrast.m_uiEnvelope));
 			break;
 		case ID_BRIT:
-			{
-				float *pfBuf = (float*)pBufPos;
-				float fTemp = BSwapF(*pfBuf);
-				pBufPos = (pBufPos +4);
-
-				int iIxSize = 0;
-				int iEnvelope = (int)GetVarlenIX(pBufPos, iIxSize);
-				pBufPos = (pBufPos +iIxSize);
-			}
+			bRet = (SubChunk.ReadF4(pClip->m_Brightness.m_fValue)
+				&& SubChunk.ReadVX(pClip->m_Brightness.m_uiEnvelope));
 			break;
 		case ID_SATR:
-			{
-				float *pfBuf = (float*)pBufPos;
-				float fTemp = BSwapF(*pfBuf);
-				pBufPos = (pBufPos +4);
-
-				int iIxSize = 0;
-				int iEnvelope = (int)GetVarlenIX(pBufPos, iIxSize);
-				pBufPos = (pBufPos +iIxSize);
-			}
+			bRet = (SubChunk.ReadF4(pClip->m_Saturation.m_fValue)
+				&& SubChunk.ReadVX(pClip->m_Saturation.m_uiEnvelope));
 			break;
 		case ID_HUE:
-			{
-				float *pfBuf = (float*)pBufPos;
-				float fTemp = BSwapF(*pfBuf);
-				pBufPos = (pBufPos +4);
-
-				int iIxSize = 0;
-				int iEnvelope = (int)GetVarlenIX(pBufPos, iIxSize);
-				pBufPos = (pBufPos +iIxSize);
-			}
+			bRet = (SubChunk.ReadF4(pClip->m_Hue.m_fValue)
+				&& SubChunk.ReadVX(pClip->m_Hue.m_uiEnvelope));
 			break;
 		case ID_GAMM:
-			{
-				float *pfBuf = (float*)pBufPos;
-				float fTemp = BSwapF(*pfBuf);
-				pBufPos = (pBufPos +4);
-
-				int iIxSize = 0;
-				int iEnvelope = (int)GetVarlenIX(pBufPos, iIxSize);
-				pBufPos = (pBufPos +iIxSize);
-			}
+			bRet = (SubChunk.ReadF4(pClip->m_Gamma.m_fValue)
+				&& SubChunk.ReadVX(pClip->m_Gamma.m_uiEnvelope));
 			break;
 		case ID_NEGA:
-			{
-				unsigned short wEnable = BSwap2s((unsigned short*)pBufPos);
-				pBufPos = (pBufPos +2);
-			}
+			bRet = SubChunk.ReadU2(pClip->m_usNegative);
 			break;
+
 		case ID_IFLT:
-			break;
 		case ID_PFLT:
+			// plugin filter: server-name, flags and data
+			{
+				CLwoClip::CLwoClipFilter Filter;
+				bRet = (SubChunk.ReadS0(Filter.m_szServerName)
+					&& SubChunk.ReadU2(Filter.m_usFlags));
+				if (bRet == true)
+				{
+					Filter.m_Data.assign(SubChunk.GetPos(), SubChunk.GetEnd());
+					if (uiSCType == ID_IFLT)
+					{
+						pClip->m_ImageFilters.push_back(Filter);
+					}
+					else
+					{
+						pClip->m_PixelFilters.push_back(Filter);
+					}
+				}
+			}
 			break;
 		}
 
-		// skip to next sub-chunk (if any)
-		// note: check if any of above changed value..
-		if (pBufPos != pSubChunkEnd)
+		if (bRet == false)
 		{
-			pBufPos = (pBufPos +usSCSize);
+			return SetError(SubChunk);
 		}
 	}
 
@@ -1780,369 +2107,807 @@ bool CLwoReader::Handle_LWO2_ID_CLIP(const char *pChunk, const unsigned int uiCh
 
 bool CLwoReader::Handle_LWO2_ID_VMAP(const char *pChunk, const unsigned int uiChunkSize)
 {
-	CLwoLayer *pCurrentLayer = (CLwoLayer*)m_ObjectData.GetPreviousOfType(ID_LAYR);
+	LWO_STAT_HANDLER("Handle_LWO2_ID_VMAP", uiChunkSize);
 
-	// points-list this refers to
-	CLwoPoints *pPrevPoints = (CLwoPoints*)m_ObjectData.GetPreviousOfType(ID_PNTS);
+	CLwoLayer *pCurrentLayer = GetCurrentLayer();
 
-	char *pBufPos = (char*)pChunk;
+	CLwoVertexMap *pVmap = m_ObjectData.AddChunk(unique_ptr<CLwoVertexMap>(new CLwoVertexMap(pCurrentLayer->m_uiLayerIndex)));
 
-	unsigned int uiVmapType = MakeTag(pBufPos);
-	pBufPos = (pBufPos +4);
+	// points-list this refers to
+	pVmap->m_pPointsList = (CLwoPoints*)m_ObjectData.GetPreviousOfType(ID_PNTS);
 
-	/* is this needed?
-	switch (uiVmapType)
-	{
-	case ID_PICK:
-	case ID_WGHT:
-	case ID_MNVW:
-	case ID_TXUV:
-	case ID_RGB:
-	case ID_RGBA:
-	case ID_MORF:
-	case ID_SPOT:
-		break;
-	}
-	*/
+	// keep in container before reading values
+	// so it is released even if chunk is not valid
+	pCurrentLayer->AddChunkToLayer(pVmap);
 
-	unsigned short wDimension = BSwap2s((unsigned short*)pBufPos);
-	pBufPos = (pBufPos +2);
+	CLwoCursor Cursor(pChunk, uiChunkSize);
 
-	unsigned int uiStrSize = 0;
-	string szName = GetPaddedString(pBufPos, uiStrSize);
-	pBufPos = (pBufPos + uiStrSize);
+	// PICK, WGHT, MNVW, TXUV, RGB, RGBA, MORF, SPOT..
+	if (Cursor.ReadU4(pVmap->m_uiVmapTypeID) == false
+		|| Cursor.ReadU2(pVmap->m_usDimension) == false
+		|| Cursor.ReadS0(pVmap->m_szName) == false)
+	{
+		return SetError(Cursor);
+	}
 
-	for (int i = 0; i < wDimension; i++)
+	// for each mapped vertex:
+	// index of vertex and values (amount of dimension)
+	const size_t nValuesSize = pVmap->m_usDimension*sizeof(float);
+	while (Cursor.IsAtEnd() == false)
 	{
-		int iIxSize = 0;
-		int iVertIndex = (int)GetVarlenIX(pBufPos, iIxSize);
-		pBufPos = (pBufPos +iIxSize);
+		unsigned int uiVertIndex = 0;
+		if (Cursor.ReadVX(uiVertIndex) == false
+			|| Cursor.Require(nValuesSize) == false)
+		{
+			return SetError(Cursor);
+		}
+		pVmap->m_VertexIndices.push_back((int)uiVertIndex);
 
-		float *pfBuf = (float*)pBufPos;
-		float fTemp = BSwapF(*pfBuf);
-		pBufPos = (pBufPos +4);
+		for (int i = 0; i < pVmap->m_usDimension; i++)
+		{
+			pVmap->m_Values.push_back(Cursor.F4());
+		}
 	}
-
 	return true;
 }
 
 bool CLwoReader::Handle_LWO2_ID_VMAD(const char *pChunk, const unsigned int uiChunkSize)
 {
-	CLwoLayer *pCurrentLayer = (CLwoLayer*)m_ObjectData.GetPreviousOfType(ID_LAYR);
+	LWO_STAT_HANDLER("Handle_LWO2_ID_VMAD", uiChunkSize);
 
-	// points-list this refers to
-	CLwoPoints *pPrevPoints = (CLwoPoints*)m_ObjectData.GetPreviousOfType(ID_PNTS);
+	CLwoLayer *pCurrentLayer = GetCurrentLayer();
 
-	char *pBufPos = (char*)pChunk;
+	// discontinuous: values are per vertex of polygon
+	CLwoVertexMap *pVmad = m_ObjectData.AddChunk(unique_ptr<CLwoVertexMap>(new CLwoVertexMap(pCurrentLayer->m_uiLayerIndex, true)));
 
-	unsigned int uiVmadType = MakeTag(pBufPos);
-	pBufPos = (pBufPos +4);
+	// points-list this refers to
+	pVmad->m_pPointsList = (CLwoPoints*)m_ObjectData.GetPreviousOfType(ID_PNTS);
 
-	/* is this needed?
-	switch (uiVmadType)
-	{
-	case ID_PICK:
-	case ID_WGHT:
-	case ID_MNVW:
-	case ID_TXUV:
-	case ID_RGB:
-	case ID_RGBA:
-	case ID_MORF:
-	case ID_SPOT:
-		break;
-	}
-	*/
+	// polygon-indices refer to polygon-list before this
+	pVmad->m_pPolyList = (CLwoPolygons*)m_ObjectData.GetPreviousOfType(ID_POLS);
 
-	unsigned short wDimension = BSwap2s((unsigned short*)pBufPos);
-	pBufPos = (pBufPos +2);
+	pCurrentLayer->AddChunkToLayer(pVmad);
 
-	unsigned int uiStrSize = 0;
-	string szName = GetPaddedString(pBufPos, uiStrSize);
-	pBufPos = (pBufPos + uiStrSize);
+	CLwoCursor Cursor(pChunk, uiChunkSize);
 
-	for (int i = 0; i < wDimension; i++)
+	if (Cursor.ReadU4(pVmad->m_uiVmapTypeID) == false
+		|| Cursor.ReadU2(pVmad->m_usDimension) == false
+		|| Cursor.ReadS0(pVmad->m_szName) == false)
 	{
-		int iIxSize = 0;
-		int iVertIndex = (int)GetVarlenIX(pBufPos, iIxSize);
-		pBufPos = (pBufPos +iIxSize);
+		return SetError(Cursor);
+	}
 
-		int iPolIndex = (int)GetVarlenIX(pBufPos, iIxSize);
-		pBufPos = (pBufPos +iIxSize);
+	// for each mapped vertex of polygon:
+	// index of vertex, index of polygon and values
+	const size_t nValuesSize = pVmad->m_usDimension*sizeof(float);
+	while (Cursor.IsAtEnd() == false)
+	{
+		unsigned int uiVertIndex = 0;
+		unsigned int uiPolIndex = 0;
+		if (Cursor.ReadVX(uiVertIndex) == false
+			|| Cursor.ReadVX(uiPolIndex) == false
+			|| Cursor.Require(nValuesSize) == false)
+		{
+			return SetError(Cursor);
+		}
+		pVmad->m_VertexIndices.push_back((int)uiVertIndex);
+		pVmad->m_PolyIndices.push_back((int)uiPolIndex);
 
-		float *pfBuf = (float*)pBufPos;
-		float fTemp = BSwapF(*pfBuf);
-		pBufPos = (pBufPos +4);
+		for (int i = 0; i < pVmad->m_usDimension; i++)
+		{
+			pVmad->m_Values.push_back(Cursor.F4());
+		}
 	}
-
 	return true;
 }
 
-// this is testing
-char *CLwoReader::Handle_LWO2_BLOK(char *pBufPos, const unsigned short usBLOKSize)
+// texture layer: BLOK sub-chunk of surface,
+// first sub-chunk is the header (IMAP, PROC, GRAD or SHDR)
+// followed by mapping (TMAP) and attributes of that texture type
+bool CLwoReader::Handle_LWO2_BLOK(CLwoCursor &Blok, CLwoSurface::CLwoTextureLayer &Layer)
 {
-	const char *pBlokChunkEnd = (pBufPos + usBLOKSize);
+	LWO_STAT_HANDLER("Handle_LWO2_BLOK", Blok.GetRemaining());
 
-	// type of sub-chunk in this BLOK
-	// (IMAP, TMAP, PROC, GRAD, SHDR)
-	unsigned short usBlokCSize = 0;
-	unsigned int uiBlokCType = GetSubChunkType(pBufPos, usBlokCSize);
-	pBufPos = (pBufPos +6); // type (4) + size (2) bytes
-
-	// keep separately..
-	// read each blok one at a time..
-	const char *pBlokHeaderEnd = (pBufPos + usBlokCSize);
+	// header: type of texture in this BLOK
+	CLwoCursor Header(NULL, 0);
+	if (Blok.ReadSubChunk(Layer.m_uiBlokTypeID, Header) == false)
+	{
+		return SetError(Blok);
+	}
 
-	// ordinal string next
-	unsigned int uiStrSize = 0;
-	string szBlokOrdinal = GetPaddedString(pBufPos, uiStrSize);
-	pBufPos = (pBufPos + uiStrSize);
+	if (Layer.m_uiBlokTypeID != ID_IMAP
+		&& Layer.m_uiBlokTypeID != ID_PROC
+		&& Layer.m_uiBlokTypeID != ID_GRAD
+		&& Layer.m_uiBlokTypeID != ID_SHDR)
+	{
+		// unknown texture type:
+		// skip whole block as any unknown sub-chunk
+		Layer.m_uiBlokTypeID = 0;
+		return true;
+	}
+	if (Handle_LWO2_BLOK_Header(Header, Layer) == false)
+	{
+		return false;
+	}
 
-	// handle header-attributes now
-	while (pBufPos != pBlokHeaderEnd)
+	// attributes of the texture
+	while (Blok.IsAtEnd() == false)
 	{
-		// now actual sub-sub-chunks of sub-chunk in BLOK?
-		unsigned short usSBCSize = 0;
-		unsigned int uiSBCType = GetSubChunkType(pBufPos, usSBCSize);
-		pBufPos = (pBufPos +6); // type (4) + size (2) bytes
+		unsigned int uiSBCType = 0;
+		CLwoCursor SubChunk(NULL, 0);
+		if (Blok.ReadSubChunk(uiSBCType, SubChunk) == false)
+		{
+			return SetError(Blok);
+		}
 
-		// blok-header attributes (CHAN, ENAB, OPAC, AXIS)
-		switch (uiSBCType)
+		if (uiSBCType == ID_TMAP)
 		{
-		case ID_CHAN:
-			{
-				// COLR, DIFF, LUMI, SPEC, GLOS, REFL, TRAN, RIND, TRNL, or BUMP:
-				// see "normal" sub-chunks
-				unsigned int uiChanType = MakeTag(pBufPos);
-				pBufPos = (pBufPos +4);
-			}
-			break;
-		case ID_ENAB:
+			// texture mapping has nested sub-chunks
+			if (Handle_LWO2_BLOK_TMAP(SubChunk, Layer) == false)
 			{
-				unsigned short wTemp = BSwap2s((unsigned short*)pBufPos);
-				pBufPos = (pBufPos +2);
+				return false;
 			}
-			break;
-		case ID_OPAC:
-			{
-				unsigned short wTemp = BSwap2s((unsigned short*)pBufPos);
-				pBufPos = (pBufPos +2);
+		}
+		else if (Handle_LWO2_BLOK_Chunks(SubChunk, uiSBCType, Layer) == false)
+		{
+			return SetError(SubChunk);
+		}
+	}
+	return true;
+}
 
-				float *pfBuf = (float*)pBufPos;
-				float fTemp = BSwapF(*pfBuf);
-				pBufPos = (pBufPos +4);
+// header of texture layer:
+// ordinal string and header attributes (CHAN, ENAB, OPAC, AXIS, NEGA)
+bool CLwoReader::Handle_LWO2_BLOK_Header(CLwoCursor &Header, CLwoSurface::CLwoTextureLayer &Layer)
+{
+	// ordinal string first
+	if (Header.ReadS0(Layer.m_szOrdinal) == false)
+	{
+		return SetError(Header);
+	}
 
-				// also index to envelope
-				int iIxSize = 0;
-				int iEnvelope = (int)GetVarlenIX(pBufPos, iIxSize);
-				pBufPos = (pBufPos + iIxSize);
-			}
+	while (Header.IsAtEnd() == false)
+	{
+		unsigned int uiSBCType = 0;
+		CLwoCursor SubChunk(NULL, 0);
+		if (Header.ReadSubChunk(uiSBCType, SubChunk) == false)
+		{
+			return SetError(Header);
+		}
+
+		bool bRet = true;
+		switch (uiSBCType)
+		{
+		case ID_CHAN:
+			// COLR, DIFF, LUMI, SPEC, GLOS, REFL, TRAN, RIND, TRNL, or BUMP:
+			// see "normal" sub-chunks
+			bRet = SubChunk.ReadU4(Layer.m_uiChannel);
+			break;
+		case ID_ENAB:
+			bRet = SubChunk.ReadU2(Layer.m_usEnable);
+			break;
+		case ID_OPAC:
+			bRet = (SubChunk.ReadU2(Layer.m_usOpacityType)
+				&& SubChunk.ReadF4(Layer.m_fOpacity)
+				&& SubChunk.ReadVX(Layer.m_uiOpacityEnvelope));
 			break;
 		case ID_AXIS:
-			{
-				unsigned short wTemp = BSwap2s((unsigned short*)pBufPos);
-				pBufPos = (pBufPos +2);
-			}
+			// displacement axis
+			bRet = SubChunk.ReadU2(Layer.m_usDisplacementAxis);
 			break;
-
-		default:
-			// skip past unknown type
-			pBufPos = (pBufPos +usSBCSize);
+		case ID_NEGA:
+			bRet = SubChunk.ReadU2(Layer.m_usNegative);
 			break;
 		}
+		if (bRet == false)
+		{
+			return SetError(SubChunk);
+		}
 	}
+	return true;
+}
 
-	// now handle other sub-BLOK-chunks
-
-	pBufPos = Handle_LWO2_BLOK_Chunks(pBufPos);
+// texture mapping of the layer:
+// CNTR, SIZE, ROTA, OREF, FALL, CSYS
+bool CLwoReader::Handle_LWO2_BLOK_TMAP(CLwoCursor &Tmap, CLwoSurface::CLwoTextureLayer &Layer)
+{
+	while (Tmap.IsAtEnd() == false)
+	{
+		unsigned int uiSBCType = 0;
+		CLwoCursor SubChunk(NULL, 0);
+		if (Tmap.ReadSubChunk(uiSBCType, SubChunk) == false)
+		{
+			return SetError(Tmap);
+		}
 
-	// continue on upper-level chunk start
-	return pBufPos;
+		bool bRet = true;
+		switch (uiSBCType)
+		{
+		case ID_CNTR:
+			bRet = (SubChunk.ReadVec12(Layer.m_fCenter)
+				&& SubChunk.ReadVX(Layer.m_uiCenterEnvelope));
+			break;
+		case ID_SIZE:
+			bRet = (SubChunk.ReadVec12(Layer.m_fSize)
+				&& SubChunk.ReadVX(Layer.m_uiSizeEnvelope));
+			break;
+		case ID_ROTA:
+			bRet = (SubChunk.ReadVec12(Layer.m_fRotation)
+				&& SubChunk.ReadVX(Layer.m_uiRotationEnvelope));
+			break;
+		case ID_OREF:
+			bRet = SubChunk.ReadS0(Layer.m_szReferenceObject);
+			break;
+		case ID_FALL:
+			bRet = (SubChunk.ReadU2(Layer.m_usFalloffType)
+				&& SubChunk.ReadVec12(Layer.m_fFalloff)
+				&& SubChunk.ReadVX(Layer.m_uiFalloffEnvelope));
+			break;
+		case ID_CSYS:
+			bRet = SubChunk.ReadU2(Layer.m_usCoordSystem);
+			break;
+		}
+		if (bRet == false)
+		{
+			return SetError(SubChunk);
+		}
+	}
+	return true;
 }
 
-// this is testing
-char *CLwoReader::Handle_LWO2_BLOK_Chunks(char *pBufPos)
+// attributes of texture layer after header:
+// IMAP : PROJ, AXIS, IMAG, WRAP, WRPW, WRPH, VMAP, AAST, PIXB, STCK, TAMP
+// PROC : AXIS, VALU, FUNC
+// GRAD : PNAM, INAM, GRST, GREN, GRPT, FKEY, IKEY
+// SHDR : FUNC
+bool CLwoReader::Handle_LWO2_BLOK_Chunks(CLwoCursor &Cursor, const unsigned int uiSBCType, CLwoSurface::CLwoTextureLayer &Layer)
 {
-	// sub-bloks and their chunks
-	// TMAP : CNTR, SIZE, ROTA, OREF, FALL, CSYS
-	// IMAP : PROJ, AXIS, IMAG, WRAP, WRPW, WRPH, VMAP, AAST, PIXB, STCK, TAMP
-	// PROC : AXIS, VALU, FUNC
-	// GRAD : PNAM, INAM, GRST, GREN, GRPT, FKEY, IKEY
-	// SHDR : FUNC
+	switch (uiSBCType)
+	{
+	case ID_PROJ:
+		return Cursor.ReadU2(Layer.m_usProjection);
 
-	// should get one of sub-bloks now
-	unsigned short usBlokCSize = 0;
-	unsigned int uiBlokCType = GetSubChunkType(pBufPos, usBlokCSize);
-	pBufPos = (pBufPos +6); // type (4) + size (2) bytes
+	case ID_AXIS:
+		return Cursor.ReadU2(Layer.m_usAxis);
 
-	// count after incrementing
-	const char *pBlokEnd = (pBufPos + usBlokCSize);
+	case ID_IMAG:
+		// index of clip
+		return Cursor.ReadVX(Layer.m_uiImageIndex);
 
-	while (pBufPos != pBlokEnd)
-	{
-		// now actual sub-sub-chunks of sub-chunk in BLOK?
-		unsigned short usSBCSize = 0;
-		unsigned int uiSBCType = GetSubChunkType(pBufPos, usSBCSize);
+	case ID_WRAP:
+		return (Cursor.ReadU2(Layer.m_usWrapWidth)
+			&& Cursor.ReadU2(Layer.m_usWrapHeight));
+
+	case ID_WRPW:
+		return (Cursor.ReadF4(Layer.m_fWrapWidthCycles)
+			&& Cursor.ReadVX(Layer.m_uiWrapWidthEnvelope));
+
+	case ID_WRPH:
+		return (Cursor.ReadF4(Layer.m_fWrapHeightCycles)
+			&& Cursor.ReadVX(Layer.m_uiWrapHeightEnvelope));
+
+	case ID_VMAP:
+		// name of UV-map
+		return Cursor.ReadS0(Layer.m_szVmapName);
 
-		// did not handle padding correctly?
-		if (uiSBCType == ID_BLOK)
+	case ID_AAST:
+		return (Cursor.ReadU2(Layer.m_usAntialiasFlags)
+			&& Cursor.ReadF4(Layer.m_fAntialiasStrength));
+
+	case ID_PIXB:
+		return Cursor.ReadU2(Layer.m_usPixelBlending);
+
+	case ID_STCK:
+		return (Cursor.ReadU2(Layer.m_usSticky)
+			&& Cursor.ReadF4(Layer.m_fStickyTime));
+
+	case ID_TAMP:
+		return (Cursor.ReadF4(Layer.m_fAmplitude)
+			&& Cursor.ReadVX(Layer.m_uiAmplitudeEnvelope));
+
+	case ID_VALU:
+		// one or three values according to texture
+		Layer.m_usValueCount = 0;
+		while (Cursor.IsAtEnd() == false
+			&& Layer.m_usValueCount < 3)
 		{
-			return pBufPos;
+			if (Cursor.ReadF4(Layer.m_fValue[Layer.m_usValueCount]) == false)
+			{
+				return false;
+			}
+			Layer.m_usValueCount++;
 		}
+		return true;
+
+	case ID_FUNC:
+		// algorithm name and data (plugin-specific)
+		if (Cursor.ReadS0(Layer.m_szFunction) == false)
+		{
+			return false;
+		}
+		Layer.m_FunctionData.assign(Cursor.GetPos(), Cursor.GetEnd());
+		return true;
+
+	case ID_PNAM:
+		return Cursor.ReadS0(Layer.m_szParameterName);
 
-		pBufPos = (pBufPos +6); // type (4) + size (2) bytes
+	case ID_INAM:
+		return Cursor.ReadS0(Layer.m_szItemName);
 
-		// this is according to given sub-blok type
-		if (uiBlokCType == ID_TMAP)
+	case ID_GRST:
+		return Cursor.ReadF4(Layer.m_fGradientStart);
+
+	case ID_GREN:
+		return Cursor.ReadF4(Layer.m_fGradientEnd);
+
+	case ID_GRPT:
+		return Cursor.ReadU2(Layer.m_usRepeatMode);
+
+	case ID_FKEY:
+		// list of keys: input and RGBA output
 		{
-			// texture-map attributes
-			switch (uiSBCType)
+			const size_t nKeySize = 5*sizeof(float);
+			Layer.m_GradientKeys.reserve(Cursor.GetRemaining() / nKeySize);
+			while (Cursor.GetRemaining() >= nKeySize)
 			{
-				/*
-			case ID_CNTR:
-				break;
-			case ID_SIZE:
-				break;
-			case ID_ROTA:
-				break;
-			case ID_OREF:
-				break;
-				*/
-			case ID_FALL:
+				CLwoSurface::CLwoTextureLayer::CLwoGradientKey Key;
+				Key.m_fInput = Cursor.F4();
+				for (int i = 0; i < 4; i++)
 				{
-					unsigned short wTemp = BSwap2s((unsigned short*)pBufPos);
-					pBufPos = (pBufPos +2);
+					Key.m_fOutput[i] = Cursor.F4();
+				}
+				Layer.m_GradientKeys.push_back(Key);
+			}
+		}
+		return true;
 
-					float *pfVals = new float[3];
-					float *pfChunk = (float*)pBufPos;
-					for (int i = 0; i < 3; i++)
-					{
-						pfVals[i] = BSwapF(pfChunk[i]);
-					}
-					pBufPos = (pBufPos + 3*sizeof(float));
+	case ID_IKEY:
+		// interpolation of each key
+		// (as many as there are in sub-chunk)
+		Layer.m_GradientInterpolation.reserve(Cursor.GetRemaining() / 2);
+		while (Cursor.GetRemaining() >= 2)
+		{
+			Layer.m_GradientInterpolation.push_back(Cursor.U2());
+		}
+		return true;
+	}
+
+	// unknown type: skip it
+	return true;
+}
+
+// points straight from window in batches
+bool CLwoReader::Stream_PNTS(CMemFile &LwoFile, const unsigned long ulChunkOffset, const unsigned int uiChunkSize, CLwoEventHandler &Handler)
+{
+	LWO_STAT_HANDLER("Stream_PNTS", uiChunkSize);
 
-					// TODO: keep buffer instead of deleting
-					delete pfVals;
+	const unsigned long ulPointCount = uiChunkSize / 12;
 
-					// also index to envelope
-					int iIxSize = 0;
-					int iEnvelope = (int)GetVarlenIX(pBufPos, iIxSize);
-					pBufPos = (pBufPos + iIxSize);
+	unsigned long ulPoint = 0;
+	while (ulPoint < ulPointCount)
+	{
+		unsigned long ulCount = (ulPointCount - ulPoint);
+		if (ulCount > LWO_EVENT_BATCH_SIZE)
+		{
+			ulCount = LWO_EVENT_BATCH_SIZE;
+		}
+
+		const char *pPointBuf = LwoFile.GetAtOffset(ulChunkOffset + ulPoint*12, ulCount*12);
+		if (pPointBuf == NULL)
+		{
+			return SetReadError(LwoFile);
+		}
+
+		m_vBatchValues.resize(ulCount*3);
+		CLwoByteSwap::Swap4(m_vBatchValues.data(), pPointBuf, ulCount*3);
+
+		if (Handler.OnPoints(m_vBatchValues.data(), ulCount, ulPoint) == false)
+		{
+			return false;
+		}
+		ulPoint += ulCount;
+	}
+	return true;
+}
+
+// polygons of variable length:
+// each part of chunk is decoded up to last complete polygon,
+// next part starts from there
+bool CLwoReader::Stream_POLS(CMemFile &LwoFile, const unsigned long ulChunkOffset, const unsigned int uiChunkSize, const unsigned int uiChunkType, CLwoEventHandler &Handler)
+{
+	LWO_STAT_HANDLER("Stream_POLS", uiChunkSize);
+
+	const unsigned long ulEnd = (ulChunkOffset + uiChunkSize);
+	unsigned long ulPos = ulChunkOffset;
+
+	// LWOB: always FACE in POLS, curves in own chunk,
+	// 2-byte indices and surface-index after each polygon
+	const bool bLwob = (m_uiLwoFileType != ID_LWO2);
+	unsigned int uiPolyTypeID = (uiChunkType == ID_CRVS) ? ID_CURV : ID_FACE;
+	if (bLwob == false)
+	{
+		const char *pType = LwoFile.GetAtOffset(ulPos, 4);
+		if (pType == NULL)
+		{
+			return SetReadError(LwoFile);
+		}
+		if (uiChunkSize < 4)
+		{
+			return SetError(LWO_ERROR_OVERRUN, NULL);
+		}
+		uiPolyTypeID = MakeTag(pType);
+		ulPos += 4;
+	}
+
+	m_vBatchCounts.clear();
+	m_vBatchFlags.clear();
+	m_vBatchIndices.clear();
+	m_vBatchTags.clear();
+
+	unsigned long ulFirstPolygon = 0;
+	unsigned long ulWindow = LWO_EVENT_WINDOW_SIZE;
+	while (ulPos < ulEnd)
+	{
+		unsigned long ulPartSize = (ulEnd - ulPos);
+		if (ulPartSize > ulWindow)
+		{
+			ulPartSize = ulWindow;
+		}
+		const char *pPart = LwoFile.GetAtOffset(ulPos, ulPartSize);
+		if (pPart == NULL)
+		{
+			return SetReadError(LwoFile);
+		}
+
+		// record which does not fit in part is not an error
+		// (read again in next part): cursor is local
+		CLwoCursor Cursor(pPart, ulPartSize);
+		size_t nDecoded = 0;
+		while (Cursor.IsAtEnd() == false)
+		{
+			const size_t nIndicesBefore = m_vBatchIndices.size();
+
+			unsigned short usVertexCount = 0;
+			bool bComplete = Cursor.ReadU2(usVertexCount);
+
+			// flags in upper 6-bits (not in LWOB curves)
+			unsigned short usFlags = 0;
+			if (bLwob == false
+				|| uiChunkType != ID_CRVS)
+			{
+				usFlags = ((0xfc00 & usVertexCount) >> 10);
+				usVertexCount = (0x03ff & usVertexCount);
+			}
+			if (bLwob == false
+				&& uiPolyTypeID == ID_CURV)
+			{
+				// continuity point toggles only
+				usFlags = (usFlags & 0x3);
+			}
+
+			for (int l = 0; l < usVertexCount && bComplete == true; l++)
+			{
+				unsigned int uiIndex = 0;
+				if (bLwob == true)
+				{
+					unsigned short usIndex = 0;
+					bComplete = Cursor.ReadU2(usIndex);
+					uiIndex = usIndex;
 				}
-				break;
-			case ID_CSYS:
+				else
 				{
-					unsigned short wTemp = BSwap2s((unsigned short*)pBufPos);
-					pBufPos = (pBufPos +2);
+					bComplete = Cursor.ReadVX(uiIndex);
 				}
-				break;
-			default:
-				// skip past unknown type
-				pBufPos = (pBufPos +usSBCSize);
-				break;
+				m_vBatchIndices.push_back(uiIndex);
 			}
-		}
-		else if (uiBlokCType == ID_IMAP)
-		{
-			// image-map attributes
-			switch (uiSBCType)
+
+			unsigned short usSurface = 0;
+			if (bLwob == true
+				&& bComplete == true)
 			{
-			case ID_PROJ:
+				bComplete = Cursor.ReadU2(usSurface);
+				if (bComplete == true
+					&& uiChunkType == ID_CRVS)
 				{
-					unsigned short wTemp = BSwap2s((unsigned short*)pBufPos);
-					pBufPos = (pBufPos +2);
+					// curve flags after surface
+					bComplete = Cursor.ReadU2(usFlags);
 				}
-				break;
-			case ID_AXIS:
+				else if (bComplete == true
+					&& (short)usSurface < 0)
 				{
-					unsigned short wTemp = BSwap2s((unsigned short*)pBufPos);
-					pBufPos = (pBufPos +2);
+					// count of detail-polygons:
+					// those follow as ordinary polygons
+					unsigned short usDetailCount = 0;
+					bComplete = Cursor.ReadU2(usDetailCount);
 				}
-				break;
-				/*
-			case ID_IMAG:
-			case ID_WRAP:
-			case ID_WRPW:
-			case ID_WRPH:
-			case ID_VMAP:
-			case ID_AAST:
-			case ID_PIXB:
-			case ID_STCK:
-			case ID_TAMP:
-				break;
-				*/
-			default:
-				// skip past unknown type
-				pBufPos = (pBufPos +usSBCSize);
+				usSurface = (unsigned short)abs((int)((short)usSurface));
+			}
+
+			if (bComplete == false)
+			{
+				// polygon continues in next part
+				m_vBatchIndices.resize(nIndicesBefore);
 				break;
 			}
+			nDecoded = Cursor.GetOffset();
+
+			m_vBatchCounts.push_back(usVertexCount);
+			m_vBatchFlags.push_back(usFlags);
+			if (bLwob == true)
+			{
+				m_vBatchTags.push_back(usSurface);
+			}
+
+			if (m_vBatchCounts.size() >= LWO_EVENT_BATCH_SIZE)
+			{
+				ulFirstPolygon += (unsigned long)m_vBatchCounts.size();
+				if (Flush_POLS(uiPolyTypeID, ulFirstPolygon - (unsigned long)m_vBatchCounts.size(), Handler) == false)
+				{
+					return false;
+				}
+			}
 		}
-		else if (uiBlokCType == ID_PROC)
+
+		if (nDecoded == 0)
 		{
-			// procedural texture attributes
-			switch (uiSBCType)
+			// single polygon does not fit in part:
+			// larger part unless chunk ends (truncated)
+			if (ulPartSize == (ulEnd - ulPos))
 			{
-				/*
-			case ID_AXIS:
-				break;
-			case ID_VALU:
-				break;
-			case ID_FUNC:
-				break;
-				*/
-			default:
-				// skip past unknown type
-				pBufPos = (pBufPos +usSBCSize);
-				break;
+				return SetError(LWO_ERROR_OVERRUN, NULL);
 			}
+			ulWindow *= 2;
+			continue;
+		}
+		ulPos += (unsigned long)nDecoded;
+	}
+
+	if (m_vBatchCounts.empty() == false)
+	{
+		return Flush_POLS(uiPolyTypeID, ulFirstPolygon, Handler);
+	}
+	return true;
+}
+
+bool CLwoReader::Flush_POLS(const unsigned int uiPolyTypeID, const unsigned long ulFirstPolygon, CLwoEventHandler &Handler)
+{
+	tLwoPolygonBatch Batch;
+	Batch.m_uiPolyTypeID = uiPolyTypeID;
+	Batch.m_ulFirstPolygon = ulFirstPolygon;
+	Batch.m_nCount = m_vBatchCounts.size();
+	Batch.m_pusVertexCounts = m_vBatchCounts.data();
+	Batch.m_pusFlags = m_vBatchFlags.data();
+	Batch.m_puiIndices = m_vBatchIndices.data();
+	Batch.m_pusSurfaces = (m_vBatchTags.empty() == true) ? NULL : m_vBatchTags.data();
+
+	bool bRet = Handler.OnPolygons(Batch);
+
+	m_vBatchCounts.clear();
+	m_vBatchFlags.clear();
+	m_vBatchIndices.clear();
+	m_vBatchTags.clear();
+	return bRet;
+}
+
+// pairs of polygon-index and tag-index in batches
+bool CLwoReader::Stream_PTAG(CMemFile &LwoFile, const unsigned long ulChunkOffset, const unsigned int uiChunkSize, CLwoEventHandler &Handler)
+{
+	LWO_STAT_HANDLER("Stream_PTAG", uiChunkSize);
+
+	const unsigned long ulEnd = (ulChunkOffset + uiChunkSize);
+	unsigned long ulPos = ulChunkOffset;
+
+	const char *pType = LwoFile.GetAtOffset(ulPos, 4);
+	if (pType == NULL)
+	{
+		return SetReadError(LwoFile);
+	}
+	if (uiChunkSize < 4)
+	{
+		return SetError(LWO_ERROR_OVERRUN, NULL);
+	}
+
+	tLwoPtagBatch Batch;
+	Batch.m_uiPtagTypeID = MakeTag(pType);
+	ulPos += 4;
+
+	m_vBatchPolygons.clear();
+	m_vBatchTags.clear();
+
+	while (ulPos < ulEnd)
+	{
+		// pairs are at most 6 bytes:
+		// part always has complete pairs unless truncated
+		unsigned long ulPartSize = (ulEnd - ulPos);
+		if (ulPartSize > LWO_EVENT_WINDOW_SIZE)
+		{
+			ulPartSize = LWO_EVENT_WINDOW_SIZE;
+		}
+		const char *pPart = LwoFile.GetAtOffset(ulPos, ulPartSize);
+		if (pPart == NULL)
+		{
+			return SetReadError(LwoFile);
 		}
-		else if (uiBlokCType == ID_GRAD)
+
+		CLwoCursor Cursor(pPart, ulPartSize);
+		size_t nDecoded = 0;
+		while (Cursor.IsAtEnd() == false)
 		{
-			// gradient texture attributes
-			switch (uiSBCType)
+			unsigned int uiPolIX = 0;
+			unsigned short usTagIX = 0;
+			if (Cursor.ReadVX(uiPolIX) == false
+				|| Cursor.ReadU2(usTagIX) == false)
 			{
-				/*
-			case ID_PNAM:
-			case ID_INAM:
-			case ID_GRST:
-			case ID_GREN:
-			case ID_GRPT:
-			case ID_FKEY:
-			case ID_IKEY:
-				break;
-				*/
-			default:
-				// skip past unknown type
-				pBufPos = (pBufPos +usSBCSize);
 				break;
 			}
+			nDecoded = Cursor.GetOffset();
+			m_vBatchPolygons.push_back(uiPolIX);
+			m_vBatchTags.push_back(usTagIX);
+
+			if (m_vBatchPolygons.size() >= LWO_EVENT_BATCH_SIZE)
+			{
+				Batch.m_nCount = m_vBatchPolygons.size();
+				Batch.m_puiPolygons = m_vBatchPolygons.data();
+				Batch.m_pusTags = m_vBatchTags.data();
+				if (Handler.OnPtag(Batch) == false)
+				{
+					return false;
+				}
+				m_vBatchPolygons.clear();
+				m_vBatchTags.clear();
+			}
+		}
+
+		if (nDecoded == 0)
+		{
+			// truncated pair
+			return SetError(LWO_ERROR_OVERRUN, NULL);
+		}
+		ulPos += (unsigned long)nDecoded;
+	}
+
+	if (m_vBatchPolygons.empty() == false)
+	{
+		Batch.m_nCount = m_vBatchPolygons.size();
+		Batch.m_puiPolygons = m_vBatchPolygons.data();
+		Batch.m_pusTags = m_vBatchTags.data();
+		return Handler.OnPtag(Batch);
+	}
+	return true;
+}
+
+// vertex map values in batches,
+// VMAD has also polygon-index for each
+bool CLwoReader::Stream_VMAP(CMemFile &LwoFile, const unsigned long ulChunkOffset, const unsigned int uiChunkSize, const bool bPerPolygon, CLwoEventHandler &Handler)
+{
+	LWO_STAT_HANDLER("Stream_VMAP", uiChunkSize);
+
+	const unsigned long ulEnd = (ulChunkOffset + uiChunkSize);
+	unsigned long ulPos = ulChunkOffset;
+
+	tLwoVmapBatch Batch;
+	Batch.m_bPerPolygon = bPerPolygon;
+	Batch.m_puiPolygons = NULL;
+
+	// header: type, dimension and name
+	// (name may be longer than window)
+	string szName;
+	unsigned long ulWindow = LWO_EVENT_WINDOW_SIZE;
+	while (true)
+	{
+		unsigned long ulPartSize = (ulEnd - ulPos);
+		if (ulPartSize > ulWindow)
+		{
+			ulPartSize = ulWindow;
+		}
+		const char *pPart = LwoFile.GetAtOffset(ulPos, ulPartSize);
+		if (pPart == NULL)
+		{
+			return SetReadError(LwoFile);
+		}
+		if (ulPartSize < 4)
+		{
+			return SetError(LWO_ERROR_OVERRUN, NULL);
+		}
+
+		CLwoCursor Cursor(pPart, ulPartSize);
+		Batch.m_uiVmapTypeID = Cursor.U4();
+		if (Cursor.ReadU2(Batch.m_usDimension) == true
+			&& Cursor.ReadS0(szName) == true)
+		{
+			ulPos += (unsigned long)Cursor.GetOffset();
+			break;
+		}
+		if (ulPartSize == (ulEnd - ulPos))
+		{
+			// name or dimension truncated
+			return SetError(Cursor.GetError(), NULL);
+		}
+		ulWindow *= 2;
+	}
+	Batch.m_szName = szName.c_str();
+
+	m_vBatchIndices.clear();
+	m_vBatchPolygons.clear();
+	m_vBatchValues.clear();
+
+	const unsigned long ulValuesSize = Batch.m_usDimension*sizeof(float);
+	ulWindow = LWO_EVENT_WINDOW_SIZE;
+	while (ulPos < ulEnd)
+	{
+		unsigned long ulPartSize = (ulEnd - ulPos);
+		if (ulPartSize > ulWindow)
+		{
+			ulPartSize = ulWindow;
+		}
+		const char *pPart = LwoFile.GetAtOffset(ulPos, ulPartSize);
+		if (pPart == NULL)
+		{
+			return SetReadError(LwoFile);
 		}
-		else if (uiBlokCType == ID_SHDR)
+
+		CLwoCursor Cursor(pPart, ulPartSize);
+		size_t nDecoded = 0;
+		while (Cursor.IsAtEnd() == false)
 		{
-			// shader-program attributes
-			switch (uiSBCType)
+			unsigned int uiVertIndex = 0;
+			unsigned int uiPolIndex = 0;
+			if (Cursor.ReadVX(uiVertIndex) == false
+				|| (bPerPolygon == true && Cursor.ReadVX(uiPolIndex) == false)
+				|| Cursor.Require(ulValuesSize) == false)
 			{
-				/*
-			case ID_FUNC:
+				break;
+			}
+			m_vBatchIndices.push_back(uiVertIndex);
+			if (bPerPolygon == true)
+			{
+				m_vBatchPolygons.push_back(uiPolIndex);
+			}
+
+			for (int i = 0; i < Batch.m_usDimension; i++)
+			{
+				m_vBatchValues.push_back(Cursor.F4());
+			}
+			nDecoded = Cursor.GetOffset();
+
+			if (m_vBatchIndices.size() >= LWO_EVENT_BATCH_SIZE)
+			{
+				Batch.m_nCount = m_vBatchIndices.size();
+				Batch.m_puiPoints = m_vBatchIndices.data();
+				Batch.m_puiPolygons = (bPerPolygon == true) ? m_vBatchPolygons.data() : NULL;
+				Batch.m_pfValues = m_vBatchValues.data();
+				if (Handler.OnVmap(Batch) == false)
 				{
-					// algorithm name and data (shader-code)
+					return false;
 				}
-				break;
-				*/
-			default:
-				// skip past unknown type
-				pBufPos = (pBufPos +usSBCSize);
-				break;
+				m_vBatchIndices.clear();
+				m_vBatchPolygons.clear();
+				m_vBatchValues.clear();
 			}
 		}
-		else
+
+		if (nDecoded == 0)
 		{
-			// abort, skip to end
-			pBufPos = (char*)pBlokEnd;
-			break;
+			// single value does not fit in part
+			if (ulPartSize == (ulEnd - ulPos))
+			{
+				return SetError(LWO_ERROR_OVERRUN, NULL);
+			}
+			ulWindow *= 2;
+			continue;
 		}
+		ulPos += (unsigned long)nDecoded;
 	}
 
-	return pBufPos;
+	if (m_vBatchIndices.empty() == false)
+	{
+		Batch.m_nCount = m_vBatchIndices.size();
+		Batch.m_puiPoints = m_vBatchIndices.data();
+		Batch.m_puiPolygons = (bPerPolygon == true) ? m_vBatchPolygons.data() : NULL;
+		Batch.m_pfValues = m_vBatchValues.data();
+		return Handler.OnVmap(Batch);
+	}
+	return true;
 }
 
 
@@ -2151,7 +2916,22 @@ char *CLwoReader::Handle_LWO2_BLOK_Chunks(char *pBufPos)
 CLwoReader::CLwoReader()
 : m_uiLWOSize(0)
 , m_uiLwoFileType(0)
+, m_pProcessChunk(NULL)
 , m_ObjectData()
+, m_pChunkData(NULL)
+, m_ulChunkOffset(0)
+, m_eError(LWO_ERROR_NONE)
+, m_ulErrorOffset(0)
+, m_ulFileBufferSize(0)
+, m_ullMemoryBudget(0)
+, m_eBudgetPolicy(LWO_BUDGET_FAIL)
+, m_ullObjectBytes(0)
+, m_nAccountedChunks(0)
+, m_ulSkippedChunks(0)
+#ifdef LWO_INSTRUMENTATION
+, m_Stats()
+, m_pAllocs(NULL)
+#endif
 {
 }
 
@@ -2159,16 +2939,43 @@ CLwoReader::~CLwoReader()
 {
 }
 
+void CLwoReader::Reset()
+{
+	m_uiLWOSize = 0;
+	m_uiLwoFileType = 0;
+	m_pProcessChunk = NULL;
+	m_pChunkData = NULL;
+	m_ulChunkOffset = 0;
+	m_eError = LWO_ERROR_NONE;
+	m_ulErrorOffset = 0;
+	m_ulFileBufferSize = 0;
+	m_ullObjectBytes = 0;
+	m_nAccountedChunks = 0;
+	m_ulSkippedChunks = 0;
+	m_ObjectData.Clear();
+}
+
 bool CLwoReader::ProcessFromFile(CMemFile &LwoFile)
 {
+	// reused reader: don't append to previous object
+	Reset();
+	LWO_STAT_FILE(LwoFile);
+	CLwoTraceScope Trace("parse", 0, LwoFile.GetFilesize(), LwoFile.GetFilename());
+
 	// handle file header first:
 	// check we have valid IFF-header in there
-	if (HandleFileHeader(LwoFile.GetAtOffset(0, 12), LwoFile.GetFilesize()) == false)
+	bool bRet = true;
 	{
-		return false;
+		CLwoTraceScope TraceHeader("header", 0, 12);
+		bRet = HandleFileHeader(LwoFile.GetAtOffset(0, 12), LwoFile.GetFilesize());
+	}
+	if (bRet == false)
+	{
+		return SetError(LWO_ERROR_HEADER, NULL);
 	}
 
-	bool bRet = true;
+	// chunks in order of file
+	CLwoTraceScope TraceScan("scan", 0, m_uiLWOSize);
 
 	// start after file IFF-header to process chunks
 	unsigned int uiChunkOffset = 12;
@@ -2178,7 +2985,14 @@ bool CLwoReader::ProcessFromFile(CMemFile &LwoFile)
 		// we need at least type+size for next chunk (8 bytes):
 		// get type and size from the chunk header
 		//
+		m_pChunkData = NULL;
+		m_ulChunkOffset = uiChunkOffset;
+
 		const char *pChunk = LwoFile.GetAtOffset(uiChunkOffset, 8);
+		if (pChunk == NULL)
+		{
+			return SetError(LWO_ERROR_CHUNK_SIZE, NULL);
+		}
 		unsigned int uiChunkSize = 0;
 		unsigned int uiChunkType = GetChunkType(pChunk, uiChunkSize);
 
@@ -2187,23 +3001,267 @@ bool CLwoReader::ProcessFromFile(CMemFile &LwoFile)
 		// if next chunk is larger than remains in file -> error, abort
 		if (uiChunkSize > (LwoFile.GetFilesize() - uiChunkOffset))
 		{
-			return false;
+			return SetError(LWO_ERROR_CHUNK_SIZE, NULL);
 		}
 
 		// verify we have the data in buffer 
 		// for the actual chunk-data
 		const char *pChunkData = LwoFile.GetAtOffset(uiChunkOffset, uiChunkSize);
+		if (pChunkData == NULL
+			&& uiChunkSize > 0)
+		{
+			// streamed file: read failed or over budget
+			return SetReadError(LwoFile);
+		}
+
+		// errors are located from start of chunk-data
+		m_pChunkData = pChunkData;
+		m_ulChunkOffset = uiChunkOffset;
+
+		// fail before decoding what can't fit
+		// (or leave out optional data)
+		if (m_ullMemoryBudget != 0
+			&& IsChunkWithinBudget(LwoFile, uiChunkType, uiChunkSize) == false)
+		{
+			if (m_eBudgetPolicy == LWO_BUDGET_SKIP_OPTIONAL
+				&& (uiChunkType == ID_VMAP || uiChunkType == ID_VMAD))
+			{
+				m_ulSkippedChunks++;
+				uiChunkOffset += uiChunkSize;
+				continue;
+			}
+			return SetError(LWO_ERROR_BUDGET, NULL);
+		}
+		LWO_STAT_CHUNK(uiChunkType, uiChunkSize);
+		CLwoTraceScope TraceChunk("decode", uiChunkType, uiChunkSize);
 
 		// handle each chunk in file
 		bRet = ProcessChunk(
 					pChunkData, 
 					uiChunkType, 
 					uiChunkSize);
+		if (bRet == true
+			&& m_ullMemoryBudget != 0)
+		{
+			bRet = AccountChunks(LwoFile);
+		}
+		if (bRet == false)
+		{
+			// keeps more specific error if set by handling
+			SetError(LWO_ERROR_CHUNK, NULL);
+		}
 
 		// determine offset of next chunk in file
 		uiChunkOffset += uiChunkSize;
 	}
 
+	TraceScan.End();
+	m_ulFileBufferSize = LwoFile.GetBufferSize();
+
+	if (bRet == true)
+	{
+		// link related chunks for using the data
+		CLwoTraceScope TraceLinkage("linkage");
+		bRet = LinkObjectData();
+	}
 	return bRet;
 }
 
+bool CLwoReader::ProcessWithHandler(CMemFile &LwoFile, CLwoEventHandler &Handler)
+{
+	// reused reader: don't append to previous object
+	Reset();
+	LWO_STAT_FILE(LwoFile);
+	CLwoTraceScope Trace("parse", 0, LwoFile.GetFilesize(), LwoFile.GetFilename());
+
+	bool bHeader = false;
+	{
+		CLwoTraceScope TraceHeader("header", 0, 12);
+		bHeader = HandleFileHeader(LwoFile.GetAtOffset(0, 12), LwoFile.GetFilesize());
+	}
+	if (bHeader == false)
+	{
+		return SetError(LWO_ERROR_HEADER, NULL);
+	}
+
+	CLwoTraceScope TraceScan("scan", 0, m_uiLWOSize);
+
+	unsigned long ulChunkOffset = 12;
+	while (ulChunkOffset < m_uiLWOSize)
+	{
+		// streamed parts are not located within chunk:
+		// errors are at start of chunk
+		m_pChunkData = NULL;
+		m_ulChunkOffset = ulChunkOffset;
+
+		// header only: chunk is read when handled
+		const char *pChunkHeader = LwoFile.GetAtOffset(ulChunkOffset, 8);
+		if (pChunkHeader == NULL)
+		{
+			return SetError(LWO_ERROR_CHUNK_SIZE, NULL);
+		}
+		unsigned int uiChunkSize = 0;
+		unsigned int uiChunkType = GetChunkType(pChunkHeader, uiChunkSize);
+
+		ulChunkOffset += 8;
+		if (uiChunkSize > (LwoFile.GetFilesize() - ulChunkOffset))
+		{
+			return SetError(LWO_ERROR_CHUNK_SIZE, NULL);
+		}
+		m_ulChunkOffset = ulChunkOffset;
+		LWO_STAT_CHUNK(uiChunkType, uiChunkSize);
+		CLwoTraceScope TraceChunk("decode", uiChunkType, uiChunkSize);
+
+		bool bRet = true;
+		switch (uiChunkType)
+		{
+		case ID_PNTS:
+			bRet = Stream_PNTS(LwoFile, ulChunkOffset, uiChunkSize, Handler);
+			break;
+
+		case ID_POLS:
+			bRet = Stream_POLS(LwoFile, ulChunkOffset, uiChunkSize, uiChunkType, Handler);
+			break;
+
+		case ID_CRVS:
+			if (m_uiLwoFileType != ID_LWO2)
+			{
+				bRet = Stream_POLS(LwoFile, ulChunkOffset, uiChunkSize, uiChunkType, Handler);
+			}
+			break;
+
+		case ID_PTAG:
+			if (m_uiLwoFileType == ID_LWO2)
+			{
+				bRet = Stream_PTAG(LwoFile, ulChunkOffset, uiChunkSize, Handler);
+			}
+			break;
+
+		case ID_VMAP:
+		case ID_VMAD:
+			if (m_uiLwoFileType == ID_LWO2)
+			{
+				bRet = Stream_VMAP(LwoFile, ulChunkOffset, uiChunkSize, (uiChunkType == ID_VMAD), Handler);
+			}
+			break;
+
+		case ID_LAYR:
+		case ID_TAGS:
+		case ID_SRFS:
+		case ID_SURF:
+			// small chunks: parse as usual
+			// and give what was added to object
+			if (uiChunkSize > 0)
+			{
+				const size_t nChunksBefore = m_ObjectData.GetChunkList().size();
+				m_pChunkData = LwoFile.GetAtOffset(ulChunkOffset, uiChunkSize);
+				if (m_pChunkData == NULL)
+				{
+					return SetReadError(LwoFile);
+				}
+				bRet = ProcessChunk(m_pChunkData, uiChunkType, uiChunkSize);
+
+				const tOwnedChunkList &ChunkList = m_ObjectData.GetChunkList();
+				for (size_t i = nChunksBefore; i < ChunkList.size() && bRet == true; i++)
+				{
+					CLwoChunk *pChunk = ChunkList[i].get();
+					if (pChunk->m_uiChunkType == ID_LAYR)
+					{
+						bRet = Handler.OnLayer(*((CLwoLayer*)pChunk));
+					}
+					else if (pChunk->m_uiChunkType == ID_TAGS)
+					{
+						bRet = Handler.OnTags(*((CLwoTagnameList*)pChunk));
+					}
+					else if (pChunk->m_uiChunkType == ID_SURF)
+					{
+						bRet = Handler.OnSurface(*((CLwoSurface*)pChunk));
+					}
+				}
+			}
+			break;
+
+		default:
+			// not needed for events: not read at all
+			break;
+		}
+
+		if (bRet == false)
+		{
+			// keeps more specific error if set by handling
+			return SetError(LWO_ERROR_CHUNK, NULL);
+		}
+		ulChunkOffset += uiChunkSize;
+	}
+	m_ulFileBufferSize = LwoFile.GetBufferSize();
+	return true;
+}
+
+bool CLwoReader::ReadChunkTable(CMemFile &LwoFile, vector<tLwoChunkEntry> &Table)
+{
+	Reset();
+	Table.clear();
+
+	if (HandleFileHeader(LwoFile.GetAtOffset(0, 12), LwoFile.GetFilesize()) == false)
+	{
+		return SetError(LWO_ERROR_HEADER, NULL);
+	}
+
+	// same order and limits as when processing
+	unsigned long ulChunkOffset = 12;
+	while (ulChunkOffset < m_uiLWOSize)
+	{
+		m_ulChunkOffset = ulChunkOffset;
+
+		const char *pChunkHeader = LwoFile.GetAtOffset(ulChunkOffset, 8);
+		if (pChunkHeader == NULL)
+		{
+			return SetError(LWO_ERROR_CHUNK_SIZE, NULL);
+		}
+		tLwoChunkEntry Entry;
+		Entry.m_uiType = GetChunkType(pChunkHeader, Entry.m_uiSize);
+		Entry.m_uiSubType = 0;
+
+		ulChunkOffset += 8;
+		if (Entry.m_uiSize > (LwoFile.GetFilesize() - ulChunkOffset))
+		{
+			return SetError(LWO_ERROR_CHUNK_SIZE, NULL);
+		}
+		Entry.m_ulOffset = ulChunkOffset;
+
+		if (m_uiLwoFileType == ID_LWO2
+			&& Entry.m_uiSize >= 4
+			&& (Entry.m_uiType == ID_POLS || Entry.m_uiType == ID_PTAG
+				|| Entry.m_uiType == ID_VMAP || Entry.m_uiType == ID_VMAD))
+		{
+			const char *pSubType = LwoFile.GetAtOffset(ulChunkOffset, 4);
+			if (pSubType == NULL)
+			{
+				return SetReadError(LwoFile);
+			}
+			Entry.m_uiSubType = MakeTag(pSubType);
+		}
+
+		Table.push_back(Entry);
+		ulChunkOffset += Entry.m_uiSize;
+	}
+	return true;
+}
+
+void CLwoReader::GetMemoryReport(tLwoMemoryReport &Report) const
+{
+	tLwoMemoryReport Object;
+	m_ObjectData.GetMemoryReport(Object);
+
+	Object.m_ullFileBuffer = m_ulFileBufferSize;
+	Object.m_ullReaderBuffers = (uint64_t)m_vBatchValues.capacity() * sizeof(float)
+		+ (uint64_t)m_vBatchIndices.capacity() * sizeof(unsigned int)
+		+ (uint64_t)m_vBatchPolygons.capacity() * sizeof(unsigned int)
+		+ (uint64_t)m_vBatchCounts.capacity() * sizeof(unsigned short)
+		+ (uint64_t)m_vBatchFlags.capacity() * sizeof(unsigned short)
+		+ (uint64_t)m_vBatchTags.capacity() * sizeof(unsigned short);
+
+	// object only grows while file is kept
+	Object.m_ullParsePeak = Object.m_ullFileBuffer + Object.m_ullReaderBuffers + Object.GetObjectTotal();
+	Report.Add(Object);
+}
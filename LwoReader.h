@@ -4,6 +4,28 @@
 // CLwoReader processes file-structure into list-form in RAM to make it
 // easily accessible to whatever routines need the object-information.
 //
+// Same reader can process many files one after another:
+// each ProcessFromFile() starts by Reset() and previous object is released
+// (list capacity is kept for next file).
+// Use ReleaseObjectData() to keep object after reader is reused.
+//
+// Memory budget (SetMemoryBudget()) limits file in memory and object
+// while parsing: before each chunk is decoded, its least size
+// (geometry is never smaller decoded than in file) is checked
+// against what remains and decoded chunks are accounted by their
+// actual heap (see CLwoObjectData::GetChunkMemoryReport()).
+// When chunk does not fit, parsing fails with LWO_ERROR_BUDGET
+// or vertex maps are skipped (see LwoBudgetPolicy).
+// For large files stream instead (CMemFile::LoadWithinBudget()).
+//
+// Concurrency:
+// - each reader (and its object) is used by one thread at a time,
+//   separate readers can process files in parallel (no shared state)
+// - finished object (after ProcessFromFile() returns) can be read
+//   from many threads when none of them modifies it
+//   (FlattenLayers() modifies: one thread only).
+//   CLwoEnvelopeEvaluator has caches: one per thread.
+//
 // Ilkka Prusi 2006
 //
 //////////////////////////////////////////////////////////////////////
@@ -14,10 +36,16 @@
 // use ISO-standard typedefs when available
 #include <stdint.h>
 
+// std::move()
+#include <utility>
+
 #include "LwoTags.h" // LWO tag-ID definitions
 
 #include "MemFile.h" // file-IO handler
+#include "LwoCursor.h" // bounds-checked reading
 #include "LwoObjectData.h" // object information structure
+#include "LwoEventHandler.h" // callbacks for streaming
+#include "LwoInstrumentation.h" // statistics of loading (optional)
 
 #ifndef BYTE
 typedef uint8_t  BYTE;
@@ -43,6 +71,31 @@ struct tSubChunkHeader
 };
 #pragma pack()
 
+// chunk in table of contents (see CLwoReader::ReadChunkTable())
+struct tLwoChunkEntry
+{
+	unsigned int m_uiType;
+
+	// type within chunk (LWO2 only): polygon-type of POLS,
+	// tag-type of PTAG, map-type of VMAP and VMAD (zero otherwise)
+	unsigned int m_uiSubType;
+
+	// offset of chunk-data in file
+	unsigned long m_ulOffset;
+	unsigned int m_uiSize;
+};
+
+// what to do when chunk does not fit in memory budget
+enum LwoBudgetPolicy
+{
+	// fail with LWO_ERROR_BUDGET
+	LWO_BUDGET_FAIL = 0,
+
+	// skip vertex maps (VMAP, VMAD) which don't fit,
+	// fail when other chunks don't fit
+	LWO_BUDGET_SKIP_OPTIONAL
+};
+
 // LWO2-IFF format file parsing
 // to internal objects for easier handling
 //
@@ -57,10 +110,55 @@ private:
 	// also LWLO which is LWOB+layers
 	unsigned int m_uiLwoFileType;
 
+	// chunk-handling for the file-type above
+	// (see SelectChunkHandlers())
+	typedef bool (CLwoReader::*tChunkProcessor)(const char *pChunk, const unsigned int uiChunkType, const unsigned int uiChunkSize);
+	tChunkProcessor m_pProcessChunk;
+
 	// processed data from filebuffer
 	// (structured list for easier access)
 	CLwoObjectData m_ObjectData;
 
+	// data of chunk being processed and its offset in file
+	// (for offset of error)
+	const char *m_pChunkData;
+	unsigned long m_ulChunkOffset;
+
+	// first failure of last file and its offset in file
+	LwoParseError m_eError;
+	unsigned long m_ulErrorOffset;
+
+	// bytes of last file kept in memory while parsing
+	// (for memory report)
+	unsigned long m_ulFileBufferSize;
+
+	// limit of file and object in memory (zero when none)
+	uint64_t m_ullMemoryBudget;
+	LwoBudgetPolicy m_eBudgetPolicy;
+
+	// heap of chunks decoded so far (when budget is set):
+	// chunks before index are accounted
+	uint64_t m_ullObjectBytes;
+	size_t m_nAccountedChunks;
+
+	// chunks left out because of budget
+	unsigned long m_ulSkippedChunks;
+
+	// decoded batches for event handler,
+	// kept between files to avoid reallocating
+	vector<float> m_vBatchValues;
+	vector<unsigned int> m_vBatchIndices;
+	vector<unsigned int> m_vBatchPolygons;
+	vector<unsigned short> m_vBatchCounts;
+	vector<unsigned short> m_vBatchFlags;
+	vector<unsigned short> m_vBatchTags;
+
+#ifdef LWO_INSTRUMENTATION
+	// statistics of last file
+	tLwoLoadStats m_Stats;
+	const tLwoAllocCounter *m_pAllocs;
+#endif
+
 protected:
 
 	// tag-ID from data/string
@@ -75,10 +173,6 @@ protected:
 	// (4 bytes)
 	inline unsigned int BSwap4i(const unsigned int *buf);
 
-	// byteswap for float:
-	// avoid int<->float cast during byteswap to avoid rounding errors
-	inline float BSwapF(const float fVal);
-
 	// TODO:?
 	/*
 	float RadToDeg(const float fRad);
@@ -89,8 +183,22 @@ protected:
 	// may be 2 or 4 byte integer
 	inline unsigned int GetVarlenIX(const char *pChunk, int &iIxSize);
 
-	// get string and length where possible padding may occur
-	inline string GetPaddedString(const char *pBufPos, unsigned int &uiSize);
+	// keep first error of file:
+	// position within current chunk, returns false for convenience
+	bool SetError(const LwoParseError eError, const char *pPos);
+	bool SetError(const CLwoCursor &Cursor);
+
+	// reading from file failed: budget or IO
+	bool SetReadError(const CMemFile &LwoFile);
+
+	// check chunk against budget before decoding,
+	// add actual size of decoded chunks afterwards
+	bool IsChunkWithinBudget(const CMemFile &LwoFile, const unsigned int uiChunkType, const unsigned int uiChunkSize) const;
+	bool AccountChunks(const CMemFile &LwoFile);
+
+	// most recent layer, default layer is made
+	// when file has none before the chunk (LWOB or invalid file)
+	CLwoLayer *GetCurrentLayer();
 
 	// handle IFF-header and check file type (LWOB/LWO2)
 	bool HandleFileHeader(const char *pLwoBuf, const unsigned long ulFileSize);
@@ -107,6 +215,17 @@ protected:
 
 	bool ProcessChunk(const char *pChunk, const unsigned int uiChunkType, const unsigned int uiChunkSize);
 
+	// link related chunks when all are processed
+	bool LinkObjectData();
+
+	// handlers of chunks specialized for file-type (LWO2, LWOB or LWLO)
+	// so that format is checked once per file instead of each chunk
+	template <unsigned int uiFileType>
+	bool ProcessChunkOf(const char *pChunk, const unsigned int uiChunkType, const unsigned int uiChunkSize);
+	void SelectChunkHandlers();
+
+	bool Handle_ID_PNTS(const char *pChunk, const unsigned int uiChunkSize);
+
 	bool Handle_LWO2_ID_TAGS(const char *pChunk, const unsigned int uiChunkSize);
 
 	bool Handle_LWO2_ID_PTAG(const char *pChunk, const unsigned int uiChunkSize);
@@ -121,11 +240,23 @@ protected:
 
 	bool Handle_LWOB_ID_CRVS(const char *pChunk, const unsigned int uiChunkSize);
 
+	// LWOB polygon: vertex-count, indices and surface-index (may be negative)
+	bool Read_LWOB_PolyRow(CLwoCursor &Cursor, CLwoPolygons &PolyList, short &sSurfaceIndex);
+
+	// LWOB has surface-index in each polygon:
+	// make same PTAG SURF-mapping as in LWO2 (0-based tag-index to SRFS-names)
+	bool Handle_LWOB_SurfaceTags(CLwoPolygons *pPolyList, CLwoLayer *pLayer);
+
 	bool Handle_LWOB_ID_SRFS(const char *pChunk, const unsigned int uiChunkSize);
 
 	bool Handle_LWO2_ID_SURF(const char *pChunk, const unsigned int uiChunkSize);
 	bool Handle_LWOB_ID_SURF(const char *pChunk, const unsigned int uiChunkSize);
 
+	// LWOB texture (CTEX, DTEX..) as texture layer of LWO2:
+	// surface channel of it and 1-based index of clip for its image
+	unsigned int Get_LWOB_TextureChannel(const unsigned int uiTexType);
+	unsigned int Get_LWOB_ImageClip(const string &szImage);
+
 	bool Handle_LWO2_ID_ENVL(const char *pChunk, const unsigned int uiChunkSize);
 
 	bool Handle_LWO2_ID_CLIP(const char *pChunk, const unsigned int uiChunkSize);
@@ -134,20 +265,127 @@ protected:
 
 	bool Handle_LWO2_ID_VMAD(const char *pChunk, const unsigned int uiChunkSize);
 
+	// streaming of geometry-chunks to event handler:
+	// chunk is read in parts from file and decoded in batches
+	bool Stream_PNTS(CMemFile &LwoFile, const unsigned long ulChunkOffset, const unsigned int uiChunkSize, CLwoEventHandler &Handler);
+	bool Stream_POLS(CMemFile &LwoFile, const unsigned long ulChunkOffset, const unsigned int uiChunkSize, const unsigned int uiChunkType, CLwoEventHandler &Handler);
+	bool Stream_PTAG(CMemFile &LwoFile, const unsigned long ulChunkOffset, const unsigned int uiChunkSize, CLwoEventHandler &Handler);
+	bool Stream_VMAP(CMemFile &LwoFile, const unsigned long ulChunkOffset, const unsigned int uiChunkSize, const bool bPerPolygon, CLwoEventHandler &Handler);
+
+	// give decoded batch of polygons and clear it
+	bool Flush_POLS(const unsigned int uiPolyTypeID, const unsigned long ulFirstPolygon, CLwoEventHandler &Handler);
+
 	// TODO: sub-chunk handling separately?
 	//bool Handle_LWO2_SubChunk(const unsigned int uiType, const unsigned int uiParentType, const char *pSChunk, const unsigned short usChunkSize);
 	//bool Handle_LWO2_ID_SURF_BLOK(const char *pChunk, const unsigned int uiChunkSize);
 
-	// this is testing
-	char *Handle_LWO2_BLOK(char *pBufPos, const unsigned short usBLOKSize);
-	char *Handle_LWO2_BLOK_Chunks(char *pBufPos);
+	// texture layer (BLOK sub-chunk of SURF):
+	// header (IMAP, PROC, GRAD, SHDR), mapping (TMAP) and attributes,
+	// unknown type of header is skipped (layer type is left zero)
+	bool Handle_LWO2_BLOK(CLwoCursor &Blok, CLwoSurface::CLwoTextureLayer &Layer);
+	bool Handle_LWO2_BLOK_Header(CLwoCursor &Header, CLwoSurface::CLwoTextureLayer &Layer);
+	bool Handle_LWO2_BLOK_TMAP(CLwoCursor &Tmap, CLwoSurface::CLwoTextureLayer &Layer);
+	bool Handle_LWO2_BLOK_Chunks(CLwoCursor &Cursor, const unsigned int uiSBCType, CLwoSurface::CLwoTextureLayer &Layer);
 
 public:
 	CLwoReader();
 	virtual ~CLwoReader();
 
+	// processes file into object data,
+	// previous object (if any) is released first
 	bool ProcessFromFile(CMemFile &LwoFile);
 
+	// parse file without keeping geometry:
+	// points, polygons, polygon-tags and vertex maps are given
+	// to handler in batches, layers, tags and surfaces when complete.
+	// works with streaming CMemFile (see CMemFile::OpenStream())
+	// for processing large files in constant memory.
+	// layers, tags and surfaces are kept in object data afterwards.
+	bool ProcessWithHandler(CMemFile &LwoFile, CLwoEventHandler &Handler);
+
+	// chunks of file in order without decoding them
+	// (header is checked, file may be streaming),
+	// previous object (if any) is released first
+	bool ReadChunkTable(CMemFile &LwoFile, vector<tLwoChunkEntry> &Table);
+
+	// release processed object for next file
+	// (keeps allocated capacity)
+	void Reset();
+
+	// limit of bytes for file in memory and object while parsing,
+	// zero for no limit (kept for following files).
+	// give same budget to CMemFile to fail before reading file
+	void SetMemoryBudget(const uint64_t ullBudget, const LwoBudgetPolicy ePolicy = LWO_BUDGET_FAIL)
+	{
+		m_ullMemoryBudget = ullBudget;
+		m_eBudgetPolicy = ePolicy;
+	};
+	uint64_t GetMemoryBudget() const
+	{
+		return m_ullMemoryBudget;
+	};
+
+	// chunks of last file left out because of budget
+	// (see LWO_BUDGET_SKIP_OPTIONAL)
+	unsigned long GetSkippedChunkCount() const
+	{
+		return m_ulSkippedChunks;
+	};
+
+	// hand over processed object to caller,
+	// reader is left empty for next file
+	CLwoObjectData ReleaseObjectData()
+	{
+		CLwoObjectData ObjectData(std::move(m_ObjectData));
+		Reset();
+		return ObjectData;
+	};
+
+	// processed object information
+	const CLwoObjectData &GetObjectData() const
+	{
+		return m_ObjectData;
+	};
+
+	// type of file processed: LWO2, LWOB or LWLO
+	unsigned int GetFileType() const
+	{
+		return m_uiLwoFileType;
+	};
+
+	// reason and offset in file when processing failed
+	// (see GetLwoErrorName())
+	LwoParseError GetError() const
+	{
+		return m_eError;
+	};
+	unsigned long GetErrorOffset() const
+	{
+		return m_ulErrorOffset;
+	};
+
+	// heap of object by category and estimated peak of parsing
+	// (file, object and decode buffers), see LwoMemoryReport.h:
+	// before object is released
+	void GetMemoryReport(tLwoMemoryReport &Report) const;
+
+#ifdef LWO_INSTRUMENTATION
+	// time, bytes and allocations of last file
+	// by chunk type and handler
+	const tLwoLoadStats &GetStats() const
+	{
+		return m_Stats;
+	};
+
+	// counter updated by application (e.g. replaced operator new),
+	// NULL to not count allocations
+	void SetAllocCounter(const tLwoAllocCounter *pAllocs)
+	{
+		m_pAllocs = pAllocs;
+		m_Stats.m_bAllocs = (pAllocs != NULL);
+	};
+#endif
+
 };
 
 #endif // ifndef _LWOREADER_H_
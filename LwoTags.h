@@ -88,6 +88,10 @@
 #define ID_XREF		LWID_('X','R','E','F')
 #define ID_STCC		LWID_('S','T','C','C')
 #define ID_TIME		LWID_('T','I','M','E')
+#define ID_CLRS		LWID_('C','L','R','S')
+#define ID_CLRA		LWID_('C','L','R','A')
+#define ID_FILT		LWID_('F','I','L','T')
+#define ID_DITH		LWID_('D','I','T','H')
 #define ID_CONT		LWID_('C','O','N','T')
 #define ID_BRIT		LWID_('B','R','I','T')
 #define ID_SATR		LWID_('S','A','T','R')
@@ -108,6 +112,14 @@
 #define ID_CHAN		LWID_('C','H','A','N')
 #define ID_NAME		LWID_('N','A','M','E')
 
+/**  ENVELOPE SPAN (KEY SHAPE)  **/
+#define ID_TCB		LWID_('T','C','B',' ')
+#define ID_HERM		LWID_('H','E','R','M')
+#define ID_BEZI		LWID_('B','E','Z','I')
+#define ID_BEZ2		LWID_('B','E','Z','2')
+#define ID_LINE		LWID_('L','I','N','E')
+#define ID_STEP		LWID_('S','T','E','P')
+
 /**  SURFACE SUB-CHUNK ID  **/
 #define ID_COLR		LWID_('C','O','L','R')
 #define ID_DIFF		LWID_('D','I','F','F')
@@ -133,6 +145,11 @@
 #define ID_RBLR		LWID_('R','B','L','R')
 #define ID_RIND		LWID_('R','I','N','D')
 #define ID_EDGE		LWID_('E','D','G','E')
+#define ID_VDIF		LWID_('V','D','I','F')
+#define ID_VLUM		LWID_('V','L','U','M')
+#define ID_VSPC		LWID_('V','S','P','C')
+#define ID_VRFL		LWID_('V','R','F','L')
+#define ID_VTRN		LWID_('V','T','R','N')
 #define ID_TROP		LWID_('T','R','O','P')
 #define ID_TIMG		LWID_('T','I','M','G')
 #define ID_TBLR		LWID_('T','B','L','R')
@@ -198,7 +215,6 @@
 #define ID_PIXB		LWID_('P','I','X','B')
 
 /** Vertex mapping **/
-/*
 #define ID_PICK		LWID_('P','I','C','K')
 #define ID_WGHT		LWID_('W','G','H','T')
 #define ID_MNVW		LWID_('M','N','V','W')
@@ -207,7 +223,6 @@
 #define ID_RGBA		LWID_('R','G','B','A')
 #define ID_MORF		LWID_('M','O','R','F')
 #define ID_SPOT		LWID_('S','P','O','T')
-*/
 
 /**  PROCEDURAL TEXTURE  **/
 #define ID_PROC		LWID_('P','R','O','C')
@@ -220,8 +235,13 @@
 
 /**  GRADIENT **/
 #define ID_GRAD		LWID_('G','R','A','D')
+#define ID_PNAM		LWID_('P','N','A','M')
+#define ID_INAM		LWID_('I','N','A','M')
 #define ID_GRST		LWID_('G','R','S','T')
 #define ID_GREN		LWID_('G','R','E','N')
+#define ID_GRPT		LWID_('G','R','P','T')
+#define ID_FKEY		LWID_('F','K','E','Y')
+#define ID_IKEY		LWID_('I','K','E','Y')
 
 /**  SHADER PLUGIN  */
 #define ID_SHDR		LWID_('S','H','D','R')
@@ -0,0 +1,176 @@
+//////////////////////////////////////////////////////////////////////
+// LwoThreadPool.cpp : work-stealing pool of worker threads
+//
+
+#include "LwoThreadPool.h"
+#include "LwoTrace.h"
+
+#include <string>
+
+// worker of the calling thread:
+// pool and index in it
+static thread_local CLwoThreadPool *t_pWorkerPool = NULL;
+static thread_local int t_iWorkerIndex = -1;
+
+
+CLwoThreadPool::CLwoThreadPool(const size_t nThreads)
+	: m_Queues()
+	, m_Threads()
+	, m_nQueued(0)
+	, m_nPending(0)
+	, m_nSleeping(0)
+	, m_bStop(false)
+	, m_nNextQueue(0)
+{
+	size_t nCount = nThreads;
+	if (nCount == 0)
+	{
+		nCount = thread::hardware_concurrency();
+	}
+	if (nCount == 0)
+	{
+		nCount = 1;
+	}
+
+	// queues before starting any thread
+	for (size_t i = 0; i < nCount; i++)
+	{
+		m_Queues.push_back(unique_ptr<CLwoWorkerQueue>(new CLwoWorkerQueue()));
+	}
+	for (size_t i = 0; i < nCount; i++)
+	{
+		m_Threads.push_back(thread(&CLwoThreadPool::WorkerLoop, this, i));
+	}
+}
+
+CLwoThreadPool::~CLwoThreadPool(void)
+{
+	WaitIdle();
+	{
+		lock_guard<mutex> Lock(m_Lock);
+		m_bStop = true;
+	}
+	m_WorkAvailable.notify_all();
+
+	for (size_t i = 0; i < m_Threads.size(); i++)
+	{
+		m_Threads[i].join();
+	}
+	m_Threads.clear();
+	m_Queues.clear();
+}
+
+int CLwoThreadPool::GetWorkerIndex()
+{
+	return t_iWorkerIndex;
+}
+
+void CLwoThreadPool::Submit(tTask Task)
+{
+	// worker of this pool keeps task to itself,
+	// others are spread over the queues
+	size_t nQueue = 0;
+	if (t_pWorkerPool == this)
+	{
+		nQueue = (size_t)t_iWorkerIndex;
+	}
+	else
+	{
+		nQueue = (m_nNextQueue++) % m_Queues.size();
+	}
+
+	// pending before queueing: never less than tasks not finished,
+	// queued with the task (same lock)
+	m_nPending++;
+	{
+		lock_guard<mutex> Lock(m_Queues[nQueue]->m_Lock);
+		m_Queues[nQueue]->m_Tasks.push_back(Task);
+		m_nQueued++;
+	}
+
+	// sleeper counts itself before checking queued (see WorkerLoop()):
+	// either it sees this task or this sees it sleeping,
+	// lock makes sure it is waiting before notify
+	if (m_nSleeping > 0)
+	{
+		lock_guard<mutex> Lock(m_Lock);
+		m_WorkAvailable.notify_one();
+	}
+}
+
+bool CLwoThreadPool::PopTask(const size_t nWorker, tTask &Task)
+{
+	// own queue: newest task (still in cache)
+	{
+		CLwoWorkerQueue *pQueue = m_Queues[nWorker].get();
+		lock_guard<mutex> Lock(pQueue->m_Lock);
+		if (pQueue->m_Tasks.empty() == false)
+		{
+			Task = pQueue->m_Tasks.back();
+			pQueue->m_Tasks.pop_back();
+			m_nQueued--;
+			return true;
+		}
+	}
+
+	// steal oldest task from others
+	for (size_t i = 1; i < m_Queues.size(); i++)
+	{
+		CLwoWorkerQueue *pQueue = m_Queues[(nWorker + i) % m_Queues.size()].get();
+		lock_guard<mutex> Lock(pQueue->m_Lock);
+		if (pQueue->m_Tasks.empty() == false)
+		{
+			Task = pQueue->m_Tasks.front();
+			pQueue->m_Tasks.pop_front();
+			m_nQueued--;
+			return true;
+		}
+	}
+	return false;
+}
+
+void CLwoThreadPool::WorkerLoop(const size_t nWorker)
+{
+	t_pWorkerPool = this;
+	t_iWorkerIndex = (int)nWorker;
+	CLwoTrace::SetThreadName(("worker " + to_string(nWorker)).c_str());
+
+	while (true)
+	{
+		tTask Task;
+		if (PopTask(nWorker, Task) == true)
+		{
+			Task();
+
+			// last one: lock so that waiter is not between
+			// its check and wait
+			if ((--m_nPending) == 0)
+			{
+				lock_guard<mutex> Lock(m_Lock);
+				m_Idle.notify_all();
+			}
+			continue;
+		}
+
+		// nothing found: sleep until something is queued
+		// (task may be taken by other worker before this wakes, then retry)
+		unique_lock<mutex> Lock(m_Lock);
+		m_nSleeping++;
+		m_WorkAvailable.wait(Lock, [this]() { return (m_bStop == true || m_nQueued > 0); });
+		m_nSleeping--;
+		if (m_bStop == true
+			&& m_nQueued == 0)
+		{
+			break;
+		}
+	}
+
+	t_pWorkerPool = NULL;
+	t_iWorkerIndex = -1;
+}
+
+void CLwoThreadPool::WaitIdle()
+{
+	unique_lock<mutex> Lock(m_Lock);
+	m_Idle.wait(Lock, [this]() { return (m_nPending == 0); });
+}
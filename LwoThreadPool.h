@@ -0,0 +1,87 @@
+//////////////////////////////////////////////////////////////////////
+// LwoThreadPool.h : work-stealing pool of worker threads
+//
+// Each worker has its own queue of tasks:
+// tasks submitted by a worker go to its own queue (newest first),
+// idle workers steal oldest tasks from queues of others.
+// Tasks submitted from outside are spread over the queues.
+// Counters are atomic: tasks take only the lock of a queue,
+// pool-wide lock is only for sleeping and waking workers
+// and waiting until idle.
+//
+
+#ifndef _LWOTHREADPOOL_H_
+#define _LWOTHREADPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+class CLwoThreadPool
+{
+public:
+	typedef function<void()> tTask;
+
+protected:
+	// queue of single worker
+	class CLwoWorkerQueue
+	{
+	public:
+		mutex m_Lock;
+		deque<tTask> m_Tasks;
+	};
+
+	vector<unique_ptr<CLwoWorkerQueue>> m_Queues;
+	vector<thread> m_Threads;
+
+	// counters of tasks: in queues (changed with lock of queue)
+	// and not yet finished
+	atomic<size_t> m_nQueued;
+	atomic<size_t> m_nPending;
+
+	// sleeping workers, waking and waiting until idle:
+	// submit takes the lock only when some worker sleeps
+	mutex m_Lock;
+	condition_variable m_WorkAvailable;
+	condition_variable m_Idle;
+	atomic<size_t> m_nSleeping;
+	bool m_bStop;
+
+	// next queue for tasks from outside of pool
+	atomic<size_t> m_nNextQueue;
+
+	// own queue first (newest), then steal from others (oldest)
+	bool PopTask(const size_t nWorker, tTask &Task);
+
+	void WorkerLoop(const size_t nWorker);
+
+public:
+	// zero threads: amount of hardware threads
+	CLwoThreadPool(const size_t nThreads = 0);
+
+	// waits until all tasks are finished
+	~CLwoThreadPool(void);
+
+	// add task, may be called from any thread (also from tasks)
+	void Submit(tTask Task);
+
+	// wait until all submitted tasks are finished
+	// (don't call from a task)
+	void WaitIdle();
+
+	size_t GetThreadCount() const
+	{
+		return m_Threads.size();
+	};
+
+	// index of worker calling this or -1 when not a worker of any pool
+	static int GetWorkerIndex();
+};
+
+#endif // ifndef _LWOTHREADPOOL_H_
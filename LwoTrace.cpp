@@ -0,0 +1,248 @@
+//////////////////////////////////////////////////////////////////////
+// LwoTrace.cpp : timeline of loading for Chrome trace / Perfetto
+//
+
+#include "LwoTrace.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+struct tLwoTraceEvent
+{
+	const char *m_szName;
+	unsigned int m_uiTag;
+	uint64_t m_ullBytes;
+	int64_t m_llStart;
+	int64_t m_llEnd;
+	char m_szDetail[LWO_TRACE_DETAIL_SIZE];
+};
+
+// ring of single thread:
+// only that thread writes events
+class CLwoTraceBuffer
+{
+public:
+	vector<tLwoTraceEvent> m_Events;
+
+	// events written so far (also overwritten ones)
+	atomic<uint64_t> m_ullWritten;
+
+	unsigned int m_uiThreadId;
+	string m_szThreadName;
+
+	CLwoTraceBuffer(const unsigned int uiThreadId)
+		: m_Events(LWO_TRACE_RING_SIZE)
+		, m_ullWritten(0)
+		, m_uiThreadId(uiThreadId)
+		, m_szThreadName()
+	{};
+};
+
+static atomic<bool> g_bTraceEnabled(false);
+static const chrono::steady_clock::time_point g_TraceEpoch = chrono::steady_clock::now();
+
+// buffers of all threads which have recorded,
+// kept after thread has ended for writing
+static mutex g_TraceLock;
+static vector<shared_ptr<CLwoTraceBuffer>> g_TraceBuffers;
+
+static thread_local shared_ptr<CLwoTraceBuffer> t_pTraceBuffer;
+static thread_local char t_szThreadName[32] = {0};
+
+// buffer of calling thread, created on first event
+// (threads which never record don't allocate)
+static CLwoTraceBuffer *GetThreadBuffer()
+{
+	if (t_pTraceBuffer)
+	{
+		return t_pTraceBuffer.get();
+	}
+
+	lock_guard<mutex> Lock(g_TraceLock);
+	t_pTraceBuffer = make_shared<CLwoTraceBuffer>((unsigned int)g_TraceBuffers.size() +1);
+	t_pTraceBuffer->m_szThreadName = t_szThreadName;
+	g_TraceBuffers.push_back(t_pTraceBuffer);
+	return t_pTraceBuffer.get();
+}
+
+// string with JSON escapes
+static void WriteJsonString(FILE *pFile, const char *szValue)
+{
+	fputc('"', pFile);
+	for (const unsigned char *pChar = (const unsigned char*)szValue; *pChar != 0; pChar++)
+	{
+		if (*pChar == '"' || *pChar == '\\')
+		{
+			fputc('\\', pFile);
+			fputc(*pChar, pFile);
+		}
+		else if (*pChar < 0x20)
+		{
+			fprintf(pFile, "\\u%04x", (unsigned int)*pChar);
+		}
+		else
+		{
+			fputc(*pChar, pFile);
+		}
+	}
+	fputc('"', pFile);
+}
+
+
+void CLwoTrace::Enable(const bool bEnable)
+{
+	g_bTraceEnabled.store(bEnable, memory_order_relaxed);
+}
+
+bool CLwoTrace::IsEnabled()
+{
+	return g_bTraceEnabled.load(memory_order_relaxed);
+}
+
+void CLwoTrace::Clear()
+{
+	lock_guard<mutex> Lock(g_TraceLock);
+	for (size_t i = 0; i < g_TraceBuffers.size(); i++)
+	{
+		g_TraceBuffers[i]->m_ullWritten.store(0, memory_order_relaxed);
+	}
+}
+
+void CLwoTrace::SetThreadName(const char *szName)
+{
+	strncpy(t_szThreadName, szName, sizeof(t_szThreadName) -1);
+	t_szThreadName[sizeof(t_szThreadName) -1] = 0;
+
+	if (t_pTraceBuffer)
+	{
+		lock_guard<mutex> Lock(g_TraceLock);
+		t_pTraceBuffer->m_szThreadName = t_szThreadName;
+	}
+}
+
+int64_t CLwoTrace::Now()
+{
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - g_TraceEpoch).count();
+}
+
+void CLwoTrace::Record(const char *szName, const unsigned int uiTag, const uint64_t ullBytes,
+	const char *szDetail, const int64_t llStart, const int64_t llEnd)
+{
+	CLwoTraceBuffer *pBuffer = GetThreadBuffer();
+	const uint64_t ullIndex = pBuffer->m_ullWritten.load(memory_order_relaxed);
+
+	tLwoTraceEvent &Event = pBuffer->m_Events[(size_t)(ullIndex % LWO_TRACE_RING_SIZE)];
+	Event.m_szName = szName;
+	Event.m_uiTag = uiTag;
+	Event.m_ullBytes = ullBytes;
+	Event.m_llStart = llStart;
+	Event.m_llEnd = llEnd;
+	Event.m_szDetail[0] = 0;
+	if (szDetail != NULL)
+	{
+		// end of path is more telling than start
+		size_t nLength = strlen(szDetail);
+		if (nLength >= LWO_TRACE_DETAIL_SIZE)
+		{
+			szDetail = (szDetail + (nLength - (LWO_TRACE_DETAIL_SIZE -1)));
+		}
+		strncpy(Event.m_szDetail, szDetail, LWO_TRACE_DETAIL_SIZE -1);
+		Event.m_szDetail[LWO_TRACE_DETAIL_SIZE -1] = 0;
+	}
+
+	// publish to writer of trace
+	pBuffer->m_ullWritten.store(ullIndex +1, memory_order_release);
+}
+
+bool CLwoTrace::WriteJson(const char *szPath)
+{
+	FILE *pFile = fopen(szPath, "wb");
+	if (pFile == NULL)
+	{
+		return false;
+	}
+
+	lock_guard<mutex> Lock(g_TraceLock);
+
+	fprintf(pFile, "{\"traceEvents\":[\n");
+	bool bFirst = true;
+	for (size_t i = 0; i < g_TraceBuffers.size(); i++)
+	{
+		const CLwoTraceBuffer &Buffer = *(g_TraceBuffers[i]);
+
+		if (Buffer.m_szThreadName.empty() == false)
+		{
+			fprintf(pFile, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+				(bFirst == true) ? "" : ",\n", Buffer.m_uiThreadId);
+			WriteJsonString(pFile, Buffer.m_szThreadName.c_str());
+			fprintf(pFile, "}}");
+			bFirst = false;
+		}
+
+		// oldest kept event first
+		const uint64_t ullWritten = Buffer.m_ullWritten.load(memory_order_acquire);
+		const uint64_t ullCount = (ullWritten < LWO_TRACE_RING_SIZE) ? ullWritten : LWO_TRACE_RING_SIZE;
+		for (uint64_t ullIndex = (ullWritten - ullCount); ullIndex < ullWritten; ullIndex++)
+		{
+			const tLwoTraceEvent &Event = Buffer.m_Events[(size_t)(ullIndex % LWO_TRACE_RING_SIZE)];
+
+			// chunk type after name of stage (e.g. "decode POLS")
+			string szName = Event.m_szName;
+			if (Event.m_uiTag != 0)
+			{
+				szName += ' ';
+				for (int iShift = 24; iShift >= 0; iShift -= 8)
+				{
+					char c = (char)((Event.m_uiTag >> iShift) & 0xFF);
+					szName += (c >= 0x20 && c < 0x7F) ? c : '?';
+				}
+			}
+
+			// timestamps in microseconds
+			fprintf(pFile, "%s{\"name\":", (bFirst == true) ? "" : ",\n");
+			WriteJsonString(pFile, szName.c_str());
+			fprintf(pFile, ",\"cat\":\"lwo\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"bytes\":%llu",
+				Event.m_llStart / 1000.0, (Event.m_llEnd - Event.m_llStart) / 1000.0,
+				Buffer.m_uiThreadId, (unsigned long long)Event.m_ullBytes);
+			if (Event.m_szDetail[0] != 0)
+			{
+				fprintf(pFile, ",\"detail\":");
+				WriteJsonString(pFile, Event.m_szDetail);
+			}
+			fprintf(pFile, "}}");
+			bFirst = false;
+		}
+	}
+	fprintf(pFile, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+	bool bRet = (ferror(pFile) == 0);
+	if (fclose(pFile) != 0)
+	{
+		bRet = false;
+	}
+	return bRet;
+}
+
+uint64_t CLwoTrace::GetDroppedCount()
+{
+	lock_guard<mutex> Lock(g_TraceLock);
+	uint64_t ullDropped = 0;
+	for (size_t i = 0; i < g_TraceBuffers.size(); i++)
+	{
+		const uint64_t ullWritten = g_TraceBuffers[i]->m_ullWritten.load(memory_order_acquire);
+		if (ullWritten > LWO_TRACE_RING_SIZE)
+		{
+			ullDropped += (ullWritten - LWO_TRACE_RING_SIZE);
+		}
+	}
+	return ullDropped;
+}
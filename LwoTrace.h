@@ -0,0 +1,111 @@
+//////////////////////////////////////////////////////////////////////
+// LwoTrace.h : timeline of loading for Chrome trace / Perfetto
+//
+// When enabled, stages of loading (file open/map/read, header,
+// chunk scan, decoding of each chunk, linkage, baking..)
+// are recorded as events with steady-clock timestamps
+// on each thread, and written as Chrome trace JSON
+// (open in chrome://tracing or ui.perfetto.dev).
+//
+// Each thread has its own ring buffer of events (no locking),
+// oldest events are overwritten when it is full.
+// When disabled, a scope only checks the flag.
+//
+// Write the trace when loading is finished:
+// buffers are read without locking.
+//
+
+#ifndef _LWOTRACE_H_
+#define _LWOTRACE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// events kept per thread
+#ifndef LWO_TRACE_RING_SIZE
+#define LWO_TRACE_RING_SIZE 32768
+#endif
+
+// characters of detail (e.g. end of file path) kept in event
+#define LWO_TRACE_DETAIL_SIZE 40
+
+class CLwoTrace
+{
+public:
+	// start recording (previous events are kept)
+	static void Enable(const bool bEnable);
+	static bool IsEnabled();
+
+	// remove events of all threads
+	// (when no thread is recording)
+	static void Clear();
+
+	// name of calling thread in trace (e.g. "worker 2")
+	static void SetThreadName(const char *szName);
+
+	// nanoseconds since start of program (steady clock)
+	static int64_t Now();
+
+	// completed event on calling thread:
+	// name must be a string literal (kept as pointer),
+	// tag is chunk type (shown after name when not zero)
+	static void Record(const char *szName, const unsigned int uiTag, const uint64_t ullBytes,
+		const char *szDetail, const int64_t llStart, const int64_t llEnd);
+
+	// all events of all threads as Chrome trace JSON
+	static bool WriteJson(const char *szPath);
+
+	// events overwritten in full ring buffers
+	static uint64_t GetDroppedCount();
+};
+
+// event from construction to end of scope
+class CLwoTraceScope
+{
+private:
+	const char *m_szName;
+	unsigned int m_uiTag;
+	uint64_t m_ullBytes;
+	const char *m_szDetail;
+	int64_t m_llStart;
+	bool m_bActive;
+
+public:
+	CLwoTraceScope(const char *szName, const unsigned int uiTag = 0, const uint64_t ullBytes = 0, const char *szDetail = NULL)
+		: m_szName(szName)
+		, m_uiTag(uiTag)
+		, m_ullBytes(ullBytes)
+		, m_szDetail(szDetail)
+		, m_llStart(0)
+		, m_bActive(CLwoTrace::IsEnabled())
+	{
+		if (m_bActive == true)
+		{
+			m_llStart = CLwoTrace::Now();
+		}
+	}
+
+	~CLwoTraceScope()
+	{
+		End();
+	}
+
+	// end event before end of scope
+	void End()
+	{
+		if (m_bActive == true)
+		{
+			CLwoTrace::Record(m_szName, m_uiTag, m_ullBytes, m_szDetail, m_llStart, CLwoTrace::Now());
+			m_bActive = false;
+		}
+	}
+
+	// when size is known only after scope started
+	// (e.g. file open)
+	void SetBytes(const uint64_t ullBytes)
+	{
+		m_ullBytes = ullBytes;
+	}
+};
+
+#endif // ifndef _LWOTRACE_H_
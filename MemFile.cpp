@@ -9,9 +9,21 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "MemFile.h"
+#include "LwoTrace.h"
 
 // need explicit include for GCC..
 #include <cstdlib>
+#include <cstring>
+
+// memory-mapping of file
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
@@ -21,6 +33,18 @@ CMemFile::CMemFile(const char *file)
 : m_strFilename(file)
 , m_pLWO_buf(NULL)
 , m_pFile(NULL)
+, m_ulFilesize(0)
+, m_bMapped(false)
+, m_pMapping(NULL)
+, m_bExternal(false)
+, m_bStreaming(false)
+, m_pWindow(NULL)
+, m_ulWindowOffset(0)
+, m_ulWindowSize(0)
+, m_ulWindowCapacity(0)
+, m_ulReadAhead(0)
+, m_ulMemoryBudget(0)
+, m_bOverBudget(false)
 {
 }
 
@@ -37,11 +61,42 @@ void CMemFile::Destroy()
 		m_pFile = NULL;
 	}
 
+	if (m_bExternal == true)
+	{
+		// owned by caller
+		m_pLWO_buf = NULL;
+		m_bExternal = false;
+	}
+
+	if (m_pLWO_buf != NULL
+		&& m_bMapped == true)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(m_pLWO_buf);
+		CloseHandle((HANDLE)m_pMapping);
+		m_pMapping = NULL;
+#else
+		munmap(m_pLWO_buf, m_ulFilesize);
+#endif
+		m_pLWO_buf = NULL;
+		m_bMapped = false;
+	}
+
 	if (m_pLWO_buf != NULL)
 	{
 		free(m_pLWO_buf);
 		m_pLWO_buf = NULL;
 	}
+
+	if (m_pWindow != NULL)
+	{
+		free(m_pWindow);
+		m_pWindow = NULL;
+	}
+	m_bStreaming = false;
+	m_ulWindowOffset = 0;
+	m_ulWindowSize = 0;
+	m_ulWindowCapacity = 0;
 	m_ulFilesize = 0;
 }
 
@@ -60,6 +115,8 @@ unsigned long CMemFile::GetSizeOfFile()
 
 bool CMemFile::LoadFile()
 {
+	CLwoTraceScope Trace("read", 0, 0, m_strFilename.c_str());
+
 	if (m_pFile != NULL
 		|| m_pLWO_buf != NULL)
 	{
@@ -75,6 +132,11 @@ bool CMemFile::LoadFile()
 		return false;
 	}
 
+#if !defined(_WIN32) && defined(POSIX_FADV_SEQUENTIAL)
+	// whole file is read in order
+	posix_fadvise(fileno(m_pFile), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
 	// obtain file size (this method is normal)
 	fseek(m_pFile, 0, SEEK_END);
 	long lFilesize = ftell(m_pFile);
@@ -87,6 +149,15 @@ bool CMemFile::LoadFile()
 		return false;
 	}
 
+	// fail before allocating:
+	// file is closed so that it can be streamed instead
+	if (CheckBudget((unsigned long)lFilesize) == false)
+	{
+		fclose(m_pFile);
+		m_pFile = NULL;
+		return false;
+	}
+
 	// allocate memory, the size of the real file
 	m_pLWO_buf = malloc( lFilesize );
 	if (m_pLWO_buf == NULL)
@@ -131,6 +202,7 @@ bool CMemFile::LoadFile()
 
 	// now we have data in the buffer
 	m_ulFilesize = lReadTotal;
+	Trace.SetBytes(m_ulFilesize);
 
 	if (m_pFile != NULL)
 	{
@@ -141,10 +213,255 @@ bool CMemFile::LoadFile()
 	return true;
 }
 
-// TODO: in case of streaming from file, determine amount to read
-// and get that amount.
-//
-// for now, just return from full-file buffer read previously.
+bool CMemFile::MapFile()
+{
+	CLwoTraceScope Trace("map", 0, 0, m_strFilename.c_str());
+
+	if (m_pFile != NULL
+		|| m_pLWO_buf != NULL)
+	{
+		// ignore read second time
+		return false;
+	}
+
+#ifdef _WIN32
+	HANDLE hFile = CreateFileA(m_strFilename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER liSize;
+	if (GetFileSizeEx(hFile, &liSize) == FALSE
+		|| liSize.QuadPart <= 0
+		|| liSize.QuadPart > (LONGLONG)((unsigned long)-1)
+		|| CheckBudget((unsigned long)liSize.QuadPart) == false)
+	{
+		CloseHandle(hFile);
+		return false;
+	}
+
+	// mapping keeps file open, handle can be closed
+	HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(hFile);
+	if (hMapping == NULL)
+	{
+		return false;
+	}
+
+	void *pView = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+	if (pView == NULL)
+	{
+		CloseHandle(hMapping);
+		return false;
+	}
+
+	m_pMapping = hMapping;
+	m_pLWO_buf = pView;
+	m_ulFilesize = (unsigned long)liSize.QuadPart;
+#else
+	int iFile = open(m_strFilename.c_str(), O_RDONLY);
+	if (iFile < 0)
+	{
+		return false;
+	}
+
+	// empty file is not useful
+	struct stat sStat;
+	if (fstat(iFile, &sStat) != 0
+		|| sStat.st_size <= 0
+		|| (unsigned long long)sStat.st_size > (unsigned long long)((unsigned long)-1)
+		|| CheckBudget((unsigned long)sStat.st_size) == false)
+	{
+		close(iFile);
+		return false;
+	}
+
+	// mapping stays valid after closing
+	void *pView = mmap(NULL, (size_t)sStat.st_size, PROT_READ, MAP_PRIVATE, iFile, 0);
+	close(iFile);
+	if (pView == MAP_FAILED)
+	{
+		return false;
+	}
+
+	m_pLWO_buf = pView;
+	m_ulFilesize = (unsigned long)sStat.st_size;
+#endif
+
+	m_bMapped = true;
+	Trace.SetBytes(m_ulFilesize);
+	return true;
+}
+
+bool CMemFile::SetBuffer(const void *pBuf, const unsigned long ulSize)
+{
+	if (m_pFile != NULL
+		|| m_pLWO_buf != NULL
+		|| m_bStreaming == true)
+	{
+		// ignore read second time
+		return false;
+	}
+
+	m_pLWO_buf = (void*)pBuf;
+	m_ulFilesize = (pBuf != NULL) ? ulSize : 0;
+	m_bExternal = true;
+	return true;
+}
+
+bool CMemFile::OpenStream(const unsigned long ulReadAhead)
+{
+	CLwoTraceScope Trace("open", 0, 0, m_strFilename.c_str());
+
+	if (m_pFile != NULL
+		|| m_pLWO_buf != NULL)
+	{
+		// ignore read second time
+		return false;
+	}
+
+	m_pFile = fopen(m_strFilename.c_str(),"rb");
+	if (m_pFile == NULL)
+	{
+		return false;
+	}
+
+#if !defined(_WIN32) && defined(POSIX_FADV_SEQUENTIAL)
+	// chunks are read in order
+	posix_fadvise(fileno(m_pFile), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+	fseek(m_pFile, 0, SEEK_END);
+	long lFilesize = ftell(m_pFile);
+	rewind(m_pFile);
+
+	// empty file is not useful
+	if (lFilesize <= 0)
+	{
+		fclose(m_pFile);
+		m_pFile = NULL;
+		return false;
+	}
+
+	m_ulFilesize = (unsigned long)lFilesize;
+	m_ulReadAhead = ulReadAhead;
+	m_bStreaming = true;
+	m_bOverBudget = false;
+	return true;
+}
+
+bool CMemFile::LoadWithinBudget(const unsigned long ulReadAhead)
+{
+	if (LoadFile() == true)
+	{
+		return true;
+	}
+	if (m_bOverBudget == false)
+	{
+		// missing or invalid file
+		return false;
+	}
+	return OpenStream(ulReadAhead);
+}
+
+const char *CMemFile::GetFromStream(const unsigned long ulOffset, const unsigned long ulChunkSize)
+{
+	// already in window
+	if (m_pWindow != NULL
+		&& ulOffset >= m_ulWindowOffset
+		&& (ulOffset + ulChunkSize) <= (m_ulWindowOffset + m_ulWindowSize))
+	{
+		return (m_pWindow + (ulOffset - m_ulWindowOffset));
+	}
+
+	// read at least read-ahead amount (within file)
+	unsigned long ulReadSize = ulChunkSize;
+	if (ulReadSize < m_ulReadAhead)
+	{
+		ulReadSize = m_ulReadAhead;
+	}
+	if (ulReadSize > (m_ulFilesize - ulOffset))
+	{
+		ulReadSize = (m_ulFilesize - ulOffset);
+	}
+
+	// read-ahead only within budget,
+	// range itself must fit
+	if (m_ulMemoryBudget != 0
+		&& ulReadSize > m_ulMemoryBudget
+		&& ulChunkSize <= m_ulMemoryBudget)
+	{
+		ulReadSize = m_ulMemoryBudget;
+	}
+	if (CheckBudget(ulReadSize) == false)
+	{
+		return NULL;
+	}
+
+	// window grows only when larger range is asked
+	if (ulReadSize > m_ulWindowCapacity)
+	{
+		char *pWindow = (char*)realloc(m_pWindow, ulReadSize);
+		if (pWindow == NULL)
+		{
+			return NULL;
+		}
+		m_pWindow = pWindow;
+		m_ulWindowCapacity = ulReadSize;
+	}
+
+	// window is not valid if reading fails
+	m_ulWindowSize = 0;
+	if (fseek(m_pFile, (long)ulOffset, SEEK_SET) != 0
+		|| fread(m_pWindow, 1, ulReadSize, m_pFile) != ulReadSize)
+	{
+		return NULL;
+	}
+	m_ulWindowOffset = ulOffset;
+	m_ulWindowSize = ulReadSize;
+	return m_pWindow;
+}
+
+void CMemFile::Prefetch(const char *file)
+{
+#if !defined(_WIN32) && defined(POSIX_FADV_WILLNEED)
+	int iFile = open(file, O_RDONLY);
+	if (iFile < 0)
+	{
+		return;
+	}
+
+	// readahead continues after closing
+	posix_fadvise(iFile, 0, 0, POSIX_FADV_WILLNEED);
+	close(iFile);
+#else
+	// no portable hint: file is read when loaded
+	(void)file;
+#endif
+}
+
+bool CMemFile::Evict(const char *file)
+{
+#if !defined(_WIN32) && defined(POSIX_FADV_DONTNEED)
+	int iFile = open(file, O_RDONLY);
+	if (iFile < 0)
+	{
+		return false;
+	}
+
+	// clean pages are dropped
+	bool bRet = (posix_fadvise(iFile, 0, 0, POSIX_FADV_DONTNEED) == 0);
+	close(iFile);
+	return bRet;
+#else
+	(void)file;
+	return false;
+#endif
+}
+
+// when streaming from file, range is read to window,
+// otherwise return from full-file buffer read previously.
 // 
 const char *CMemFile::GetAtOffset(unsigned long ulOffset, const unsigned long ulChunkSize)
 {
@@ -159,6 +476,11 @@ const char *CMemFile::GetAtOffset(unsigned long ulOffset, const unsigned long ul
 		return NULL;
 	}
 
+	if (m_bStreaming == true)
+	{
+		return GetFromStream(ulOffset, ulChunkSize);
+	}
+
 	char *pBuf = (char*)GetFileBuf();
 
 	return (&pBuf[ulOffset]);
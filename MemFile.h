@@ -1,9 +1,15 @@
 // MemFile.h: interface for the CMemFile class.
 //
 // Implements file-IO related handling (platform-dependent).
-// Currerntly only reading full file to buffer supported.
+// Whole file can be read to buffer (LoadFile()) or mapped (MapFile()),
+// or streamed through a window (OpenStream()) as accessed by caller.
+// Data already in memory can be used with SetBuffer().
 //
-// TODO: reading stream from file as accessed by caller.
+// Optional memory budget (SetMemoryBudget()) limits bytes of file
+// kept in memory: whole file is not read or mapped when larger
+// (fails before allocating, see IsOverBudget()),
+// window of stream does not grow past it.
+// LoadWithinBudget() streams file when it does not fit.
 //
 // TODO: unicode&ascii interface support?
 //
@@ -46,6 +52,43 @@ private:
 	unsigned long m_ulFilesize;
 	string m_strFilename;
 
+	// buffer is mapped view of file instead of allocated
+	// (see MapFile())
+	bool m_bMapped;
+
+	// platform handle of mapping (Windows)
+	void * m_pMapping;
+
+	// buffer is given by caller and not released
+	// (see SetBuffer())
+	bool m_bExternal;
+
+	// streaming: only window of file is in buffer
+	// (see OpenStream())
+	bool m_bStreaming;
+	char * m_pWindow;
+	unsigned long m_ulWindowOffset;
+	unsigned long m_ulWindowSize;
+	unsigned long m_ulWindowCapacity;
+
+	// minimum amount to read at a time when streaming
+	unsigned long m_ulReadAhead;
+
+	// limit of bytes in memory (zero when none)
+	// and if last load or read was refused by it
+	unsigned long m_ulMemoryBudget;
+	bool m_bOverBudget;
+
+	// refuse size over budget
+	bool CheckBudget(const unsigned long ulSize)
+	{
+		m_bOverBudget = (m_ulMemoryBudget != 0 && ulSize > m_ulMemoryBudget);
+		return (m_bOverBudget == false);
+	};
+
+	// read range to window (when streaming)
+	const char *GetFromStream(const unsigned long ulOffset, const unsigned long ulChunkSize);
+
 public:
 	CMemFile(const char *file);
 	virtual ~CMemFile();
@@ -57,6 +100,7 @@ protected:
 
 public:
 
+	// whole file (NULL when streaming)
 	const void *GetFileBuf() const
 	{
 		return m_pLWO_buf;
@@ -74,6 +118,70 @@ public:
 
 	bool LoadFile();
 
+	// map file to memory (read-only) instead of reading:
+	// pages are read by OS when accessed
+	bool MapFile();
+
+	bool IsMapped() const
+	{
+		return m_bMapped;
+	};
+
+	// use data in memory instead of file (not copied):
+	// caller keeps buffer until this is destroyed
+	bool SetBuffer(const void *pBuf, const unsigned long ulSize);
+
+	// open file for reading parts as accessed:
+	// only range asked from GetAtOffset() is kept in memory
+	// (at least ulReadAhead bytes are read at a time)
+	bool OpenStream(const unsigned long ulReadAhead = 65536);
+
+	bool IsStreaming() const
+	{
+		return m_bStreaming;
+	};
+
+	// bytes of file kept in memory:
+	// whole file or window of stream
+	unsigned long GetBufferSize() const
+	{
+		return (m_bStreaming == true) ? m_ulWindowCapacity : m_ulFilesize;
+	};
+
+	// limit of bytes of file kept in memory,
+	// zero for no limit (set before loading)
+	void SetMemoryBudget(const unsigned long long ullBudget)
+	{
+		// larger than any file
+		m_ulMemoryBudget = (ullBudget > (unsigned long long)((unsigned long)-1)) ? (unsigned long)-1 : (unsigned long)ullBudget;
+	};
+	unsigned long GetMemoryBudget() const
+	{
+		return m_ulMemoryBudget;
+	};
+
+	// last load or read failed because of budget
+	// (not because of missing or invalid file)
+	bool IsOverBudget() const
+	{
+		return m_bOverBudget;
+	};
+
+	// whole file when it fits in budget,
+	// otherwise open stream (see OpenStream())
+	bool LoadWithinBudget(const unsigned long ulReadAhead = 65536);
+
+	// hint OS to start reading file into cache
+	// (for file which is loaded soon), returns without waiting
+	static void Prefetch(const char *file);
+
+	// hint OS to drop file from cache
+	// (for measuring cold loads), false when not supported:
+	// pages in use by others may be kept
+	static bool Evict(const char *file);
+
+	// pointer to range of file or NULL if outside of file:
+	// when streaming, valid only until next call
 	const char *GetAtOffset(const unsigned long ulOffset, const unsigned long ulChunkSize);
 
 };
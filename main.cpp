@@ -11,16 +11,1087 @@
 // 
 #include "MemFile.h"
 #include "LwoReader.h"
+#include "LwoParseCache.h"
+#include "LwoBatchLoader.h"
+#include "LwoThreadPool.h"
+#include "LwoTrace.h"
+#include "LwoExport.h"
 
 #include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <memory>
+#include <set>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
 
 using namespace std;
 
-int main( int argc, char *argv[] )
+// bytes by category, tab-separated
+static void PrintMemoryReport(const char *szName, const tLwoMemoryReport &Report)
+{
+	cout << szName
+		<< "\t" << Report.m_ullPoints
+		<< "\t" << Report.m_ullPolygons
+		<< "\t" << Report.m_ullIndices
+		<< "\t" << Report.m_ullPolyTags
+		<< "\t" << Report.m_ullVertexMaps
+		<< "\t" << Report.m_ullSurfaces
+		<< "\t" << Report.m_ullStrings
+		<< "\t" << Report.m_ullOverhead
+		<< "\t" << Report.GetObjectTotal()
+		<< "\t" << Report.m_ullFileBuffer
+		<< "\t" << Report.m_ullParsePeak << endl;
+}
+
+static void PrintUsage()
+{
+	cout << "usage: LWReader [--trace <out.json>] <command> [options] <files..>" << endl
+		<< "commands:" << endl
+		<< "  stats    chunk counts, points, polygons, triangles, time and memory of each file" << endl
+		<< "  dump     table of chunks (type, offset, size) of each file" << endl
+		<< "  convert  write each file to --out <dir> as --format <baked|obj|ply|ply-ascii|glb|glb-quantized>" << endl
+		<< "  bench    load all files --repeat <n> times (--cold: drop from cache before each)" << endl
+		<< "options:" << endl
+		<< "  --threads <n>       zero for amount of hardware threads" << endl
+		<< "  --manifest <file>   paths from file, one per line" << endl
+		<< "  --json              JSON instead of text (stats, dump, bench)" << endl
+		<< "  --cache <dir>       parsed objects from and to cache (stats, convert --format baked, bench)" << endl
+		<< "  --cache-max <bytes> limit of cache directory, least recently used removed" << endl
+		<< "older forms: LWReader <file>, --batch, --cache <dir> <file>, --stats <file>" << endl;
+}
+
+// options of commands (stats, dump, convert, bench)
+struct tCommandOptions
+{
+	// zero: amount of hardware threads
+	size_t m_nThreads;
+
+	// JSON instead of text
+	bool m_bJson;
+
+	// directory and format of output (convert)
+	string m_szOutDir;
+	string m_szFormat;
+
+	// name of output for each input path without extension (convert),
+	// see MakeOutputNames()
+	map<string, string> m_OutNames;
+
+	// rounds of loading, files dropped from cache before each (bench)
+	unsigned long m_ulRepeat;
+	bool m_bCold;
+
+	// parse-cache directory and its size-limit (zero: none),
+	// cache is made by RunSubcommand() when directory is given
+	string m_szCacheDir;
+	uint64_t m_ullCacheMax;
+	CLwoParseCache *m_pCache;
+
+	vector<string> m_vPaths;
+
+	tCommandOptions()
+		: m_nThreads(0)
+		, m_bJson(false)
+		, m_szOutDir()
+		, m_szFormat("baked")
+		, m_OutNames()
+		, m_ulRepeat(5)
+		, m_bCold(false)
+		, m_szCacheDir()
+		, m_ullCacheMax(0)
+		, m_pCache(NULL)
+		, m_vPaths()
+	{};
+};
+
+// options after command, at least one file is needed
+static bool ParseCommandOptions(int argc, char *argv[], tCommandOptions &Options)
+{
+	for (int i = 2; i < argc; i++)
+	{
+		const bool bHasValue = ((i +1) < argc);
+		if (strcmp(argv[i], "--json") == 0)
+		{
+			Options.m_bJson = true;
+		}
+		else if (strcmp(argv[i], "--cold") == 0)
+		{
+			Options.m_bCold = true;
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && bHasValue == true)
+		{
+			Options.m_nThreads = (size_t)atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--repeat") == 0 && bHasValue == true)
+		{
+			Options.m_ulRepeat = strtoul(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "--out") == 0 && bHasValue == true)
+		{
+			Options.m_szOutDir = argv[++i];
+		}
+		else if (strcmp(argv[i], "--format") == 0 && bHasValue == true)
+		{
+			Options.m_szFormat = argv[++i];
+		}
+		else if (strcmp(argv[i], "--cache") == 0 && bHasValue == true)
+		{
+			Options.m_szCacheDir = argv[++i];
+		}
+		else if (strcmp(argv[i], "--cache-max") == 0 && bHasValue == true)
+		{
+			Options.m_ullCacheMax = (uint64_t)strtoull(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "--manifest") == 0 && bHasValue == true)
+		{
+			if (CLwoBatchLoader::ReadManifest(argv[++i], Options.m_vPaths) == false)
+			{
+				cout << "Failed to read manifest: " << argv[i] << endl;
+				return false;
+			}
+		}
+		else if (strncmp(argv[i], "--", 2) == 0)
+		{
+			cout << "Unknown option: " << argv[i] << endl;
+			return false;
+		}
+		else
+		{
+			Options.m_vPaths.push_back(argv[i]);
+		}
+	}
+	return (Options.m_vPaths.empty() == false);
+}
+
+// string with JSON escapes
+static void AppendJsonString(string &szJson, const string &szValue)
+{
+	szJson += '"';
+	for (size_t i = 0; i < szValue.size(); i++)
+	{
+		const unsigned char c = (unsigned char)szValue[i];
+		if (c == '"' || c == '\\')
+		{
+			szJson += '\\';
+			szJson += (char)c;
+		}
+		else if (c < 0x20)
+		{
+			char szEscape[8];
+			snprintf(szEscape, sizeof(szEscape), "\\u%04x", (unsigned int)c);
+			szJson += szEscape;
+		}
+		else
+		{
+			szJson += (char)c;
+		}
+	}
+	szJson += '"';
+}
+
+// chunk tag-ID as text (e.g. "POLS")
+static string GetTagName(const unsigned int uiTag)
+{
+	string szTag;
+	for (int i = 3; i >= 0; i--)
+	{
+		char c = (char)((uiTag >> (i*8)) & 0xFF);
+		szTag += (c >= 0x20 && c < 0x7F) ? c : '?';
+	}
+	return szTag;
+}
+
+// reason of failure with offset in file
+static string GetReaderError(const CLwoReader &Reader)
+{
+	char szOffset[64];
+	snprintf(szOffset, sizeof(szOffset), " at offset %lu", Reader.GetErrorOffset());
+	return (GetLwoErrorName(Reader.GetError()) + string(szOffset));
+}
+
+// file name without directory and extension
+static string GetFileStem(const string &szPath)
+{
+	size_t nStart = szPath.find_last_of("/\\");
+	nStart = (nStart == string::npos) ? 0 : (nStart +1);
+	size_t nEnd = szPath.find_last_of('.');
+	if (nEnd == string::npos || nEnd < nStart)
+	{
+		nEnd = szPath.size();
+	}
+	return szPath.substr(nStart, nEnd - nStart);
+}
+
+// names of converted files in output directory: stem of each file,
+// files with same stem (from other directories) get suffix "-2", "-3"..
+// in order given, so that no file overwrites output of another.
+// names are compared ignoring case (as on Windows and macOS),
+// same path given again is converted once
+static void MakeOutputNames(tCommandOptions &Options)
+{
+	set<string> setUsed;
+	vector<string> vPaths;
+	for (size_t i = 0; i < Options.m_vPaths.size(); i++)
+	{
+		const string &szPath = Options.m_vPaths[i];
+		if (Options.m_OutNames.find(szPath) != Options.m_OutNames.end())
+		{
+			continue;
+		}
+
+		const string szStem = GetFileStem(szPath);
+		string szName = szStem;
+		for (int iSuffix = 2; ; iSuffix++)
+		{
+			string szKey = szName;
+			for (size_t n = 0; n < szKey.length(); n++)
+			{
+				szKey[n] = (char)tolower((unsigned char)szKey[n]);
+			}
+			if (setUsed.insert(szKey).second == true)
+			{
+				break;
+			}
+			szName = szStem + "-" + to_string(iSuffix);
+		}
+
+		Options.m_OutNames[szPath] = szName;
+		vPaths.push_back(szPath);
+	}
+	Options.m_vPaths.swap(vPaths);
+}
+
+// command for single file: output is text (or JSON object) of file,
+// reader of calling worker can be used
+typedef function<bool(const string &szPath, CLwoReader &Reader, string &szOutput)> tFileCommand;
+
+// run command for each file on pool of threads,
+// output of files in order given (JSON as array),
+// returns count of failed files
+static size_t RunForEachFile(const tCommandOptions &Options, tFileCommand Command)
+{
+	CLwoThreadPool Pool(Options.m_nThreads);
+	vector<unique_ptr<CLwoReader>> vReaders;
+	for (size_t i = 0; i < Pool.GetThreadCount(); i++)
+	{
+		vReaders.push_back(unique_ptr<CLwoReader>(new CLwoReader()));
+	}
+
+	const size_t nFiles = Options.m_vPaths.size();
+	vector<string> vOutput(nFiles);
+	vector<char> vFailed(nFiles, 0);
+	for (size_t i = 0; i < nFiles; i++)
+	{
+		Pool.Submit([&, i]()
+		{
+			CLwoReader &Reader = *vReaders[CLwoThreadPool::GetWorkerIndex()];
+			vFailed[i] = (Command(Options.m_vPaths[i], Reader, vOutput[i]) == true) ? 0 : 1;
+		});
+	}
+	Pool.WaitIdle();
+
+	size_t nFailed = 0;
+	if (Options.m_bJson == true)
+	{
+		cout << "[" << endl;
+	}
+	for (size_t i = 0; i < nFiles; i++)
+	{
+		cout << vOutput[i];
+		if (Options.m_bJson == true && (i +1) < nFiles)
+		{
+			cout << ",";
+		}
+		cout << endl;
+		nFailed += vFailed[i];
+	}
+	if (Options.m_bJson == true)
+	{
+		cout << "]" << endl;
+	}
+	return nFailed;
+}
+
+// geometry of all layers:
+// triangles when faces are triangulated as fans
+struct tGeometryCounts
+{
+	unsigned long m_ulLayers;
+	uint64_t m_ullPoints;
+	uint64_t m_ullPolygons;
+	uint64_t m_ullTriangles;
+	unsigned long m_ulSurfaces;
+	unsigned long m_ulVertexMaps;
+};
+
+static void CountGeometry(const CLwoObjectData &Object, tGeometryCounts &Counts)
+{
+	const tLayerList &Layers = Object.GetLayers();
+	Counts.m_ulLayers = (unsigned long)Layers.size();
+	Counts.m_ullPoints = 0;
+	Counts.m_ullPolygons = 0;
+	Counts.m_ullTriangles = 0;
+	for (size_t l = 0; l < Layers.size(); l++)
+	{
+		const tPointsList &Points = Layers[l]->GetPoints();
+		for (size_t p = 0; p < Points.size(); p++)
+		{
+			Counts.m_ullPoints += Points[p]->GetPointCount();
+		}
+		const tPolygonsList &Polygons = Layers[l]->GetPolygons();
+		for (size_t p = 0; p < Polygons.size(); p++)
+		{
+			const CLwoPolygons::tPolyList &Rows = Polygons[p]->m_PolyList;
+			Counts.m_ullPolygons += Rows.size();
+			if (Polygons[p]->m_uiPolyTypeID != ID_FACE)
+			{
+				continue;
+			}
+			for (size_t r = 0; r < Rows.size(); r++)
+			{
+				if (Rows[r].m_wVertexCount >= 3)
+				{
+					Counts.m_ullTriangles += (Rows[r].m_wVertexCount - 2);
+				}
+			}
+		}
+	}
+	Counts.m_ulSurfaces = (unsigned long)Object.GetSurfaces().size();
+	Counts.m_ulVertexMaps = (unsigned long)Object.GetVertexMaps().size();
+}
+
+// same from baked form (parse-cache hit)
+static void CountGeometry(const CLwoBakedFile &Baked, tGeometryCounts &Counts)
+{
+	size_t nCount = 0;
+	Baked.GetLayers(nCount);
+	Counts.m_ulLayers = (unsigned long)nCount;
+	Counts.m_ullPoints = 0;
+	Counts.m_ullPolygons = 0;
+	Counts.m_ullTriangles = 0;
+
+	const tLwoBakedPointSet *pPointSets = Baked.GetPointSets(nCount);
+	for (size_t i = 0; i < nCount; i++)
+	{
+		Counts.m_ullPoints += pPointSets[i].m_uiPointCount;
+	}
+	size_t nPolygons = 0;
+	const tLwoBakedPolygon *pPolygons = Baked.GetPolygons(nPolygons);
+	const tLwoBakedPolySet *pPolySets = Baked.GetPolySets(nCount);
+	for (size_t i = 0; i < nCount; i++)
+	{
+		const tLwoBakedPolySet &Set = pPolySets[i];
+		Counts.m_ullPolygons += Set.m_uiPolygonCount;
+		if (Set.m_uiPolyTypeID != ID_FACE)
+		{
+			continue;
+		}
+		for (uint32_t r = Set.m_uiFirstPolygon; r < (Set.m_uiFirstPolygon + Set.m_uiPolygonCount) && r < nPolygons; r++)
+		{
+			if (pPolygons[r].m_usVertexCount >= 3)
+			{
+				Counts.m_ullTriangles += (pPolygons[r].m_usVertexCount - 2);
+			}
+		}
+	}
+	Baked.GetSurfaces(nCount);
+	Counts.m_ulSurfaces = (unsigned long)nCount;
+	Baked.GetVmaps(nCount);
+	Counts.m_ulVertexMaps = (unsigned long)nCount;
+}
+
+// stats: counts of chunks and geometry, time and memory
+// (from parse-cache when given: no memory of parsing on hit)
+static bool StatsFile(const tCommandOptions &Options, const string &szPath, CLwoReader &Reader, string &szOutput)
+{
+	char szText[512];
+	CMemFile LwoFile(szPath.c_str());
+
+	chrono::steady_clock::time_point Start = chrono::steady_clock::now();
+	bool bRet = LwoFile.LoadFile();
+	chrono::steady_clock::time_point Loaded = chrono::steady_clock::now();
+
+	// table first: also chunks which are not decoded
+	vector<tLwoChunkEntry> Table;
+	map<unsigned int, unsigned long> ChunkCounts;
+	if (bRet == true
+		&& Reader.ReadChunkTable(LwoFile, Table) == true)
+	{
+		for (size_t i = 0; i < Table.size(); i++)
+		{
+			ChunkCounts[Table[i].m_uiType]++;
+		}
+	}
+
+	CLwoBakedFile Baked;
+	bool bHit = false;
+	chrono::steady_clock::time_point ParseStart = chrono::steady_clock::now();
+	if (bRet == true
+		&& Options.m_pCache != NULL)
+	{
+		bRet = Options.m_pCache->Load(LwoFile, Reader, Baked, bHit);
+	}
+	else if (bRet == true)
+	{
+		bRet = Reader.ProcessFromFile(LwoFile);
+	}
+	chrono::steady_clock::time_point Parsed = chrono::steady_clock::now();
+
+	if (bRet == false)
+	{
+		string szError = "failed to read file";
+		if (LwoFile.GetFileBuf() != NULL)
+		{
+			szError = (Reader.GetError() == LWO_ERROR_NONE) ? "failed to use cache" : GetReaderError(Reader);
+		}
+		if (Options.m_bJson == true)
+		{
+			szOutput = "{\"file\":";
+			AppendJsonString(szOutput, szPath);
+			szOutput += ",\"error\":";
+			AppendJsonString(szOutput, szError);
+			szOutput += "}";
+		}
+		else
+		{
+			szOutput = "file: " + szPath + "\nerror: " + szError + "\n";
+		}
+		Reader.Reset();
+		return false;
+	}
+
+	tGeometryCounts Counts;
+	tLwoMemoryReport Memory;
+	if (bHit == true)
+	{
+		CountGeometry(Baked, Counts);
+	}
+	else
+	{
+		CountGeometry(Reader.GetObjectData(), Counts);
+		Reader.GetMemoryReport(Memory);
+	}
+
+	const double dLoadMs = chrono::duration<double>(Loaded - Start).count() * 1000.0;
+	const double dParseMs = chrono::duration<double>(Parsed - ParseStart).count() * 1000.0;
+	const string szType = GetTagName((bHit == true) ? Baked.GetHeader()->m_uiSourceType : Reader.GetFileType());
+
+	if (Options.m_bJson == true)
+	{
+		szOutput = "{\"file\":";
+		AppendJsonString(szOutput, szPath);
+		szOutput += ",\"type\":";
+		AppendJsonString(szOutput, szType);
+		snprintf(szText, sizeof(szText), ",\"size\":%lu,\"chunks\":{", LwoFile.GetFilesize());
+		szOutput += szText;
+		for (map<unsigned int, unsigned long>::const_iterator it = ChunkCounts.begin(); it != ChunkCounts.end(); ++it)
+		{
+			if (it != ChunkCounts.begin())
+			{
+				szOutput += ",";
+			}
+			AppendJsonString(szOutput, GetTagName(it->first));
+			snprintf(szText, sizeof(szText), ":%lu", it->second);
+			szOutput += szText;
+		}
+		snprintf(szText, sizeof(szText),
+			"},\"layers\":%lu,\"points\":%llu,\"polygons\":%llu,\"triangles\":%llu,\"surfaces\":%lu,\"vertex_maps\":%lu"
+			",\"load_ms\":%.3f,\"parse_ms\":%.3f",
+			Counts.m_ulLayers, (unsigned long long)Counts.m_ullPoints, (unsigned long long)Counts.m_ullPolygons,
+			(unsigned long long)Counts.m_ullTriangles, Counts.m_ulSurfaces, Counts.m_ulVertexMaps, dLoadMs, dParseMs);
+		szOutput += szText;
+		if (Options.m_pCache != NULL)
+		{
+			szOutput += (bHit == true) ? ",\"cache\":\"hit\"" : ",\"cache\":\"miss\"";
+		}
+		if (bHit == false)
+		{
+			snprintf(szText, sizeof(szText), ",\"object_bytes\":%llu,\"parse_peak\":%llu",
+				(unsigned long long)Memory.GetObjectTotal(), (unsigned long long)Memory.m_ullParsePeak);
+			szOutput += szText;
+		}
+		szOutput += "}";
+	}
+	else
+	{
+		szOutput = "file: " + szPath + "\n";
+		snprintf(szText, sizeof(szText), "type: %s size: %lu chunks: %lu (",
+			szType.c_str(), LwoFile.GetFilesize(), (unsigned long)Table.size());
+		szOutput += szText;
+		for (map<unsigned int, unsigned long>::const_iterator it = ChunkCounts.begin(); it != ChunkCounts.end(); ++it)
+		{
+			snprintf(szText, sizeof(szText), "%s%s %lu", (it != ChunkCounts.begin()) ? ", " : "",
+				GetTagName(it->first).c_str(), it->second);
+			szOutput += szText;
+		}
+		snprintf(szText, sizeof(szText),
+			")\nlayers: %lu points: %llu polygons: %llu triangles: %llu surfaces: %lu vertex maps: %lu\n",
+			Counts.m_ulLayers, (unsigned long long)Counts.m_ullPoints, (unsigned long long)Counts.m_ullPolygons,
+			(unsigned long long)Counts.m_ullTriangles, Counts.m_ulSurfaces, Counts.m_ulVertexMaps);
+		szOutput += szText;
+		if (bHit == true)
+		{
+			// not parsed: time of opening cached object
+			snprintf(szText, sizeof(szText), "load: %.3f ms cached: %.3f ms\ncache: hit\n", dLoadMs, dParseMs);
+			szOutput += szText;
+		}
+		else
+		{
+			snprintf(szText, sizeof(szText),
+				"load: %.3f ms parse: %.3f ms (%.1f MB/s)\n"
+				"memory: object %llu bytes, parse peak %llu bytes\n",
+				dLoadMs, dParseMs, (dParseMs > 0.0) ? (LwoFile.GetFilesize() / (dParseMs * 1000.0)) : 0.0,
+				(unsigned long long)Memory.GetObjectTotal(), (unsigned long long)Memory.m_ullParsePeak);
+			szOutput += szText;
+			if (Options.m_pCache != NULL)
+			{
+				szOutput += "cache: miss\n";
+			}
+		}
+	}
+
+	// object is not kept
+	Reader.Reset();
+	return true;
+}
+
+// dump: table of chunks, file is streamed (not decoded)
+static bool DumpFile(const tCommandOptions &Options, const string &szPath, CLwoReader &Reader, string &szOutput)
+{
+	char szText[256];
+	CMemFile LwoFile(szPath.c_str());
+	vector<tLwoChunkEntry> Table;
+
+	bool bRet = LwoFile.OpenStream();
+	string szError = "failed to read file";
+	if (bRet == true)
+	{
+		bRet = Reader.ReadChunkTable(LwoFile, Table);
+		szError = GetReaderError(Reader);
+	}
+
+	if (Options.m_bJson == true)
+	{
+		szOutput = "{\"file\":";
+		AppendJsonString(szOutput, szPath);
+		szOutput += ",\"type\":";
+		AppendJsonString(szOutput, GetTagName(Reader.GetFileType()));
+		snprintf(szText, sizeof(szText), ",\"size\":%lu,\"chunks\":[", LwoFile.GetFilesize());
+		szOutput += szText;
+		for (size_t i = 0; i < Table.size(); i++)
+		{
+			// tags of invalid files may have any characters
+			szOutput += (i > 0) ? ",{\"type\":" : "{\"type\":";
+			AppendJsonString(szOutput, GetTagName(Table[i].m_uiType));
+			snprintf(szText, sizeof(szText), ",\"offset\":%lu,\"size\":%u", Table[i].m_ulOffset, Table[i].m_uiSize);
+			szOutput += szText;
+			if (Table[i].m_uiSubType != 0)
+			{
+				szOutput += ",\"sub\":";
+				AppendJsonString(szOutput, GetTagName(Table[i].m_uiSubType));
+			}
+			szOutput += "}";
+		}
+		szOutput += "]";
+		if (bRet == false)
+		{
+			szOutput += ",\"error\":";
+			AppendJsonString(szOutput, szError);
+		}
+		szOutput += "}";
+	}
+	else
+	{
+		snprintf(szText, sizeof(szText), " (%s, %lu bytes, %lu chunks)\n%10s %10s  type\n",
+			GetTagName(Reader.GetFileType()).c_str(), LwoFile.GetFilesize(), (unsigned long)Table.size(), "offset", "size");
+		szOutput = szPath + szText;
+		for (size_t i = 0; i < Table.size(); i++)
+		{
+			snprintf(szText, sizeof(szText), "%10lu %10u  %s",
+				Table[i].m_ulOffset, Table[i].m_uiSize, GetTagName(Table[i].m_uiType).c_str());
+			szOutput += szText;
+			if (Table[i].m_uiSubType != 0)
+			{
+				szOutput += " " + GetTagName(Table[i].m_uiSubType);
+			}
+			szOutput += "\n";
+		}
+		if (bRet == false)
+		{
+			szOutput += "error: " + szError + "\n";
+		}
+	}
+	Reader.Reset();
+	return bRet;
+}
+
+// convert: parsed object written to output directory
+static bool ConvertFile(const tCommandOptions &Options, const string &szPath, CLwoReader &Reader, string &szOutput)
+{
+	CMemFile LwoFile(szPath.c_str());
+	if (LwoFile.LoadFile() == false)
+	{
+		szOutput = szPath + ": failed to read file";
+		return false;
+	}
+
+	// baked form from parse-cache (only with baked format)
+	CLwoBakedFile Baked;
+	bool bHit = false;
+	bool bParsed = false;
+	if (Options.m_pCache != NULL)
+	{
+		bParsed = Options.m_pCache->Load(LwoFile, Reader, Baked, bHit);
+	}
+	else
+	{
+		bParsed = Reader.ProcessFromFile(LwoFile);
+	}
+	if (bParsed == false)
+	{
+		szOutput = szPath + ": " + ((Reader.GetError() == LWO_ERROR_NONE) ? string("failed to use cache") : GetReaderError(Reader));
+		Reader.Reset();
+		return false;
+	}
+
+	bool bRet = false;
+	string szOutPath = Options.m_szOutDir + "/" + Options.m_OutNames.at(szPath);
+	if (Options.m_szFormat == "baked")
+	{
+		szOutPath += LWO_BAKED_EXTENSION;
+
+		tLwoSourceKey Source;
+		bRet = CLwoBakedFile::MakeSourceKey(szPath.c_str(), LwoFile.GetFileBuf(), LwoFile.GetFilesize(), Source);
+		if (bRet == true
+			&& bHit == true)
+		{
+			// cached from same content, maybe of other file:
+			// same object with source of this file
+			const char *pCached = (const char*)Baked.GetHeader();
+			vector<char> Buffer(pCached, pCached + Baked.GetHeader()->m_ullFileSize);
+			((tLwoBakedHeader*)Buffer.data())->m_Source = Source;
+			bRet = CLwoBakedWriter::WriteAtomic(szOutPath, Buffer);
+		}
+		else if (bRet == true)
+		{
+			CLwoBakedWriter Writer;
+			bRet = Writer.WriteFile(Reader.GetObjectData(), Reader.GetFileType(), Source, szOutPath.c_str());
+		}
+	}
+	else
+	{
+		// files are already in parallel when many:
+		// blocks of one file formatted on all threads otherwise
+		CLwoExporter Exporter((Options.m_vPaths.size() > 1) ? 1 : Options.m_nThreads);
+		if (Options.m_szFormat == "obj")
+		{
+			szOutPath += ".obj";
+			bRet = Exporter.WriteObj(Reader.GetObjectData(), szOutPath.c_str());
+		}
+		else if (Options.m_szFormat == "glb"
+			|| Options.m_szFormat == "glb-quantized")
+		{
+			szOutPath += ".glb";
+			bRet = Exporter.WriteGlb(Reader.GetObjectData(), szOutPath.c_str(), (Options.m_szFormat == "glb-quantized"));
+		}
+		else
+		{
+			szOutPath += ".ply";
+			bRet = Exporter.WritePly(Reader.GetObjectData(), szOutPath.c_str(), (Options.m_szFormat == "ply"));
+		}
+	}
+	Reader.Reset();
+
+	szOutput = szPath + ((bRet == true) ? " -> " : ": failed to write ") + szOutPath;
+	return bRet;
+}
+
+// bench: all files loaded in batch for each round,
+// warm-up round first unless files are dropped from cache
+static int RunBench(const tCommandOptions &Options)
+{
+	CLwoBatchLoader Loader(Options.m_nThreads);
+	Loader.SetParseCache(Options.m_pCache);
+	vector<double> vSeconds;
+	uint64_t ullBytes = 0;
+	size_t nFailed = 0;
+	bool bEvicted = true;
+
+	const unsigned long ulRounds = (Options.m_ulRepeat > 0) ? Options.m_ulRepeat : 1;
+	for (unsigned long ulRound = 0; ulRound <= ulRounds; ulRound++)
+	{
+		if (ulRound == 0
+			&& Options.m_bCold == true)
+		{
+			continue;
+		}
+		if (Options.m_bCold == true)
+		{
+			for (size_t i = 0; i < Options.m_vPaths.size(); i++)
+			{
+				if (CMemFile::Evict(Options.m_vPaths[i].c_str()) == false)
+				{
+					bEvicted = false;
+				}
+			}
+		}
+
+		mutex ResultLock;
+		uint64_t ullRoundBytes = 0;
+		size_t nRoundFailed = 0;
+		chrono::steady_clock::time_point Start = chrono::steady_clock::now();
+		Loader.LoadAll(Options.m_vPaths, [&](CLwoBatchLoader::tResult Result)
+		{
+			lock_guard<mutex> Lock(ResultLock);
+			ullRoundBytes += Result->m_ulFilesize;
+			nRoundFailed += (Result->m_bSuccess == true) ? 0 : 1;
+		});
+		Loader.Wait();
+		double dSeconds = chrono::duration<double>(chrono::steady_clock::now() - Start).count();
+
+		// warm-up round is not measured
+		if (ulRound > 0)
+		{
+			vSeconds.push_back(dSeconds);
+		}
+		ullBytes = ullRoundBytes;
+		nFailed = nRoundFailed;
+	}
+
+	vector<double> vSorted(vSeconds);
+	sort(vSorted.begin(), vSorted.end());
+	const double dMedian = vSorted[vSorted.size() / 2];
+	const double dMB = ullBytes / (1024.0 * 1024.0);
+
+	if (Options.m_bJson == true)
+	{
+		string szJson;
+		char szText[256];
+		snprintf(szText, sizeof(szText), "{\"files\":%lu,\"failed\":%lu,\"bytes\":%llu,\"threads\":%lu,\"cold\":%s,\"evicted\":%s,\"rounds\":[",
+			(unsigned long)Options.m_vPaths.size(), (unsigned long)nFailed, (unsigned long long)ullBytes,
+			(unsigned long)Loader.GetThreadCount(), (Options.m_bCold == true) ? "true" : "false",
+			(Options.m_bCold == true && bEvicted == true) ? "true" : "false");
+		szJson += szText;
+		for (size_t i = 0; i < vSeconds.size(); i++)
+		{
+			snprintf(szText, sizeof(szText), "%s%.6f", (i > 0) ? "," : "", vSeconds[i]);
+			szJson += szText;
+		}
+		snprintf(szText, sizeof(szText), "],\"min\":%.6f,\"median\":%.6f,\"max\":%.6f,\"mb_per_s\":%.3f,\"files_per_s\":%.3f",
+			vSorted.front(), dMedian, vSorted.back(), dMB / dMedian, Options.m_vPaths.size() / dMedian);
+		szJson += szText;
+		if (Options.m_pCache != NULL)
+		{
+			snprintf(szText, sizeof(szText), ",\"cache_hits\":%lu,\"cache_misses\":%lu",
+				Options.m_pCache->GetHits(), Options.m_pCache->GetMisses());
+			szJson += szText;
+		}
+		szJson += "}";
+		cout << szJson << endl;
+	}
+	else
+	{
+		cout << "files: " << Options.m_vPaths.size() << " failed: " << nFailed << " bytes: " << ullBytes << endl;
+		cout << "threads: " << Loader.GetThreadCount() << " rounds: " << vSeconds.size()
+			<< ((Options.m_bCold == true) ? " (cold)" : " (warm)") << endl;
+		if (Options.m_bCold == true && bEvicted == false)
+		{
+			cout << "note: dropping files from cache is not supported here" << endl;
+		}
+		for (size_t i = 0; i < vSeconds.size(); i++)
+		{
+			cout << "round " << (i +1) << ": " << vSeconds[i] << " s" << endl;
+		}
+		cout << "min: " << vSorted.front() << " s median: " << dMedian << " s max: " << vSorted.back() << " s" << endl;
+		cout << "median: " << (dMB / dMedian) << " MB/s " << (Options.m_vPaths.size() / dMedian) << " files/s" << endl;
+		if (Options.m_pCache != NULL)
+		{
+			cout << "cache: hits " << Options.m_pCache->GetHits() << " misses " << Options.m_pCache->GetMisses() << endl;
+		}
+	}
+	return (nFailed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// subcommands: stats, dump, convert, bench
+// (-1 when not a subcommand)
+static int RunSubcommand(int argc, char *argv[])
+{
+	const string szCommand = argv[1];
+	if (szCommand != "stats"
+		&& szCommand != "dump"
+		&& szCommand != "convert"
+		&& szCommand != "bench")
+	{
+		return -1;
+	}
+
+	tCommandOptions Options;
+	if (ParseCommandOptions(argc, argv, Options) == false)
+	{
+		PrintUsage();
+		return EXIT_FAILURE;
+	}
+
+	// cache is shared by all workers
+	unique_ptr<CLwoParseCache> pCache;
+	if (Options.m_szCacheDir.empty() == false)
+	{
+		if (szCommand == "convert"
+			&& Options.m_szFormat != "baked")
+		{
+			// other formats need the parsed object also on hit
+			cout << "convert uses --cache only with --format baked" << endl;
+			return EXIT_FAILURE;
+		}
+		pCache.reset(new CLwoParseCache(Options.m_szCacheDir, Options.m_ullCacheMax));
+		Options.m_pCache = pCache.get();
+	}
+
+	size_t nFailed = 0;
+	if (szCommand == "stats")
+	{
+		nFailed = RunForEachFile(Options, [&Options](const string &szPath, CLwoReader &Reader, string &szOutput)
+			{ return StatsFile(Options, szPath, Reader, szOutput); });
+	}
+	else if (szCommand == "dump")
+	{
+		nFailed = RunForEachFile(Options, [&Options](const string &szPath, CLwoReader &Reader, string &szOutput)
+			{ return DumpFile(Options, szPath, Reader, szOutput); });
+	}
+	else if (szCommand == "convert")
+	{
+		if (Options.m_szOutDir.empty() == true
+			|| (Options.m_szFormat != "baked"
+				&& Options.m_szFormat != "obj"
+				&& Options.m_szFormat != "ply"
+				&& Options.m_szFormat != "ply-ascii"
+				&& Options.m_szFormat != "glb"
+				&& Options.m_szFormat != "glb-quantized"))
+		{
+			cout << "convert needs --out <dir> and --format baked, obj, ply, ply-ascii, glb or glb-quantized" << endl;
+			return EXIT_FAILURE;
+		}
+		// create directory if missing (single level),
+		// existing directory is used as is
+#ifdef _WIN32
+		_mkdir(Options.m_szOutDir.c_str());
+#else
+		mkdir(Options.m_szOutDir.c_str(), 0777);
+#endif
+		struct stat DirInfo;
+		if (stat(Options.m_szOutDir.c_str(), &DirInfo) != 0
+			|| (DirInfo.st_mode & S_IFMT) != S_IFDIR)
+		{
+			cout << "cannot create output directory: " << Options.m_szOutDir << endl;
+			return EXIT_FAILURE;
+		}
+		// text of each file, no JSON
+		Options.m_bJson = false;
+		MakeOutputNames(Options);
+		nFailed = RunForEachFile(Options, [&Options](const string &szPath, CLwoReader &Reader, string &szOutput)
+			{ return ConvertFile(Options, szPath, Reader, szOutput); });
+	}
+	else
+	{
+		return RunBench(Options);
+	}
+	return (nFailed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int RunCommand( int argc, char *argv[] )
 {
 	if (argc < 2)
 	{
+		PrintUsage();
+		return EXIT_FAILURE;
+	}
+
+	// stats, dump, convert or bench with many files
+	int iRet = RunSubcommand(argc, argv);
+	if (iRet >= 0)
+	{
+		return iRet;
+	}
+
+	// optional parse-cache:
+	// LWReader --cache <dir> <file>
+	if (argc >= 4
+		&& strcmp(argv[1], "--cache") == 0)
+	{
+		CLwoParseCache Cache(argv[2]);
+		CLwoBakedFile Baked;
+		bool bHit = false;
+		if (Cache.Load(argv[3], Baked, bHit) == false)
+		{
+			cout << "Failed to handle file: " << argv[3] << endl;
+			return EXIT_FAILURE;
+		}
+
+		size_t nPolygons = 0;
+		Baked.GetPolygons(nPolygons);
+		cout << "filename: " << argv[3] << endl;
+		cout << "cache: " << ((bHit == true) ? "hit" : "miss") << endl;
+		cout << "polygons: " << nPolygons << endl;
+		return EXIT_SUCCESS;
+	}
+
+	// batch of files in parallel:
+	// LWReader --batch [--threads <n>] [--manifest <file>] [--memory]
+	//   [--budget <bytes> [--skip-vmaps]] [--cache <dir> [--cache-max <bytes>]] <files..>
+	// (memory: heap of each object by category and peak of parsing,
+	// budget: limit of file and object in memory for each file,
+	// cache: parsed objects from and to cache directory)
+	if (strcmp(argv[1], "--batch") == 0)
+	{
+		size_t nThreads = 0;
+		bool bMemory = false;
+		string szCacheDir;
+		uint64_t ullCacheMax = 0;
+		uint64_t ullBudget = 0;
+		LwoBudgetPolicy eBudgetPolicy = LWO_BUDGET_FAIL;
+		vector<string> vPaths;
+		for (int i = 2; i < argc; i++)
+		{
+			if (strcmp(argv[i], "--memory") == 0)
+			{
+				bMemory = true;
+			}
+			else if (strcmp(argv[i], "--skip-vmaps") == 0)
+			{
+				eBudgetPolicy = LWO_BUDGET_SKIP_OPTIONAL;
+			}
+			else if (strcmp(argv[i], "--budget") == 0
+				&& (i +1) < argc)
+			{
+				ullBudget = (uint64_t)strtoull(argv[++i], NULL, 10);
+			}
+			else if (strcmp(argv[i], "--threads") == 0
+				&& (i +1) < argc)
+			{
+				nThreads = (size_t)atoi(argv[++i]);
+			}
+			else if (strcmp(argv[i], "--cache") == 0
+				&& (i +1) < argc)
+			{
+				szCacheDir = argv[++i];
+			}
+			else if (strcmp(argv[i], "--cache-max") == 0
+				&& (i +1) < argc)
+			{
+				ullCacheMax = (uint64_t)strtoull(argv[++i], NULL, 10);
+			}
+			else if (strcmp(argv[i], "--manifest") == 0
+				&& (i +1) < argc)
+			{
+				if (CLwoBatchLoader::ReadManifest(argv[++i], vPaths) == false)
+				{
+					cout << "Failed to read manifest: " << argv[i] << endl;
+					return EXIT_FAILURE;
+				}
+			}
+			else
+			{
+				vPaths.push_back(argv[i]);
+			}
+		}
+
+		mutex OutputLock;
+		size_t nFailed = 0;
+		tLwoMemoryReport TotalMemory;
+		chrono::steady_clock::time_point Start = chrono::steady_clock::now();
+
+		if (bMemory == true)
+		{
+			cout << "file\tpoints\tpolygons\tindices\tptags\tvmaps\tsurfaces\tstrings\toverhead\tobject\tfile buffer\tparse peak" << endl;
+		}
+
+		unique_ptr<CLwoParseCache> pCache;
+		if (szCacheDir.empty() == false)
+		{
+			pCache.reset(new CLwoParseCache(szCacheDir, ullCacheMax));
+		}
+
+		CLwoBatchLoader Loader(nThreads);
+		Loader.SetMemoryBudget(ullBudget, eBudgetPolicy);
+		Loader.SetParseCache(pCache.get());
+		Loader.LoadAll(vPaths, [&](CLwoBatchLoader::tResult Result)
+		{
+			lock_guard<mutex> Lock(OutputLock);
+			if (Result->m_bSuccess == false
+				&& Result->m_szError == "budget")
+			{
+				cout << "Exceeds memory budget: " << Result->m_szPath << endl;
+				nFailed++;
+			}
+			else if (Result->m_bSuccess == false)
+			{
+				cout << "Failed to " << Result->m_szError << " file: " << Result->m_szPath << endl;
+				nFailed++;
+			}
+			else if (bMemory == true
+				&& Result->m_bCacheHit == true)
+			{
+				// not parsed: no memory of parsing
+				cout << Result->m_szPath << "\tcached" << endl;
+			}
+			else if (bMemory == true)
+			{
+				PrintMemoryReport(Result->m_szPath.c_str(), Result->m_Memory);
+				TotalMemory.Add(Result->m_Memory);
+			}
+		});
+		Loader.Wait();
+
+		double dSeconds = chrono::duration<double>(chrono::steady_clock::now() - Start).count();
+		if (bMemory == true)
+		{
+			// peak of totals is largest single file
+			PrintMemoryReport("total", TotalMemory);
+			cout << "process peak RSS: " << GetLwoProcessPeakRSS() << endl;
+		}
+		cout << "threads: " << Loader.GetThreadCount() << endl;
+		cout << "files: " << vPaths.size() << " ok: " << (vPaths.size() - nFailed) << " failed: " << nFailed << endl;
+		if (pCache)
+		{
+			cout << "cache: hits " << pCache->GetHits() << " misses " << pCache->GetMisses() << endl;
+		}
+		cout << "seconds: " << dSeconds << endl;
+		return (nFailed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	// statistics of loading as JSON:
+	// LWReader --stats <file>
+	if (argc >= 3
+		&& strcmp(argv[1], "--stats") == 0)
+	{
+#ifdef LWO_INSTRUMENTATION
+		CMemFile StatsFile(argv[2]);
+		if (StatsFile.LoadFile() == false)
+		{
+			cout << "Failed to read file: " << argv[2] << endl;
+			return EXIT_FAILURE;
+		}
+		CLwoReader StatsReader;
+		StatsReader.SetAllocCounter(GetLwoAllocCounter());
+		bool bRet = StatsReader.ProcessFromFile(StatsFile);
+
+		// statistics also for failed file (up to failure)
+		cout << StatsReader.GetStats().ToJson() << endl;
+		return (bRet == true) ? EXIT_SUCCESS : EXIT_FAILURE;
+#else
+		cout << "Statistics need build with LWO_INSTRUMENTATION" << endl;
 		return EXIT_FAILURE;
+#endif
 	}
 
 	// handler of file-IO
@@ -45,7 +1116,8 @@ int main( int argc, char *argv[] )
 	//
 	if (LwoReader.ProcessFromFile(LwoFile) == false)
 	{
-		cout << "Failed to handle chunks from file: " << LwoFile.GetFilename() << endl;
+		cout << "Failed to handle chunks from file: " << LwoFile.GetFilename()
+			<< " (" << GetLwoErrorName(LwoReader.GetError()) << " at offset " << LwoReader.GetErrorOffset() << ")" << endl;
 		return EXIT_FAILURE;
 	}
 
@@ -61,3 +1133,35 @@ int main( int argc, char *argv[] )
 	return EXIT_SUCCESS;
 }
 
+int main( int argc, char *argv[] )
+{
+	// timeline of loading as Chrome trace (see LwoTrace.h),
+	// with any of the other options:
+	// LWReader --trace <out.json> ..
+	const char *szTrace = NULL;
+	if (argc >= 3
+		&& strcmp(argv[1], "--trace") == 0)
+	{
+		szTrace = argv[2];
+		CLwoTrace::SetThreadName("main");
+		CLwoTrace::Enable(true);
+
+		// rest of options as usual
+		argv[2] = argv[0];
+		argc -= 2;
+		argv += 2;
+	}
+
+	int iRet = RunCommand(argc, argv);
+
+	if (szTrace != NULL)
+	{
+		CLwoTrace::Enable(false);
+		if (CLwoTrace::WriteJson(szTrace) == false)
+		{
+			cout << "Failed to write trace: " << szTrace << endl;
+			return EXIT_FAILURE;
+		}
+	}
+	return iRet;
+}
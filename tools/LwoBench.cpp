@@ -0,0 +1,708 @@
+//////////////////////////////////////////////////////////////////////
+// LwoBench.cpp : benchmarks of CLwoReader with synthetic objects
+//
+// Objects are made with CLwoSynth (same options give same file),
+// time and allocations are shown for each stage
+// (file header, each chunk type, linkage).
+//
+//   LwoBench                      all presets
+//   LwoBench --preset large -n 5  one preset
+//   LwoBench --points 50000 --vmad 0.5 --write synth.lwo
+//   LwoBench --decode --preset uvs  checked cursor reads against raw reads
+//
+
+#include "LwoTimedReader.h"
+#include "LwoSynth.h"
+#include "LwoCursor.h"
+#include "LwoByteSwap.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <new>
+#include <string>
+#include <vector>
+#include <chrono>
+
+using namespace std;
+
+
+// all allocations of process:
+// only reader is running while a stage is timed
+static tLwoAllocCounter g_Allocs;
+
+// release is kept out of line: when inlined into callers
+// GCC sees free() of pointer from operator new (-Wmismatched-new-delete)
+#if defined(__GNUC__)
+#define LWO_BENCH_NOINLINE __attribute__((noinline))
+#else
+#define LWO_BENCH_NOINLINE
+#endif
+
+void *operator new(size_t nSize)
+{
+	g_Allocs.Add(nSize);
+	void *pMem = malloc((nSize > 0) ? nSize : 1);
+	if (pMem == NULL)
+	{
+		throw bad_alloc();
+	}
+	return pMem;
+}
+
+void *operator new[](size_t nSize)
+{
+	return operator new(nSize);
+}
+
+LWO_BENCH_NOINLINE void operator delete(void *pMem) noexcept
+{
+	free(pMem);
+}
+
+LWO_BENCH_NOINLINE void operator delete[](void *pMem) noexcept
+{
+	free(pMem);
+}
+
+
+struct tLwoBenchPreset
+{
+	const char *m_szName;
+	tLwoSynthOptions m_Options;
+};
+
+static vector<tLwoBenchPreset> GetPresets()
+{
+	vector<tLwoBenchPreset> vPresets;
+
+	tLwoBenchPreset Preset;
+	Preset.m_szName = "default";
+	vPresets.push_back(Preset);
+
+	// larger than 0xFF00 points: 4-byte indices
+	Preset = tLwoBenchPreset();
+	Preset.m_szName = "large";
+	Preset.m_Options.m_ulPointsPerLayer = 200000;
+	Preset.m_Options.m_ulPolygonsPerLayer = 400000;
+	vPresets.push_back(Preset);
+
+	// mix of 2-byte and 4-byte indices within small range
+	Preset = tLwoBenchPreset();
+	Preset.m_szName = "wide";
+	Preset.m_Options.m_fWideIndexDensity = 0.5f;
+	vPresets.push_back(Preset);
+
+	Preset = tLwoBenchPreset();
+	Preset.m_szName = "ngons";
+	Preset.m_Options.m_usMinPolygonSize = 3;
+	Preset.m_Options.m_usMaxPolygonSize = 16;
+	vPresets.push_back(Preset);
+
+	Preset = tLwoBenchPreset();
+	Preset.m_szName = "layers";
+	Preset.m_Options.m_uiLayers = 32;
+	Preset.m_Options.m_ulPointsPerLayer = 1000;
+	Preset.m_Options.m_ulPolygonsPerLayer = 2000;
+	vPresets.push_back(Preset);
+
+	Preset = tLwoBenchPreset();
+	Preset.m_szName = "uvs";
+	Preset.m_Options.m_fVmapDensity = 1.0f;
+	Preset.m_Options.m_fVmadDensity = 0.5f;
+	vPresets.push_back(Preset);
+
+	Preset = tLwoBenchPreset();
+	Preset.m_szName = "surfaces";
+	Preset.m_Options.m_ulPointsPerLayer = 1000;
+	Preset.m_Options.m_ulPolygonsPerLayer = 2000;
+	Preset.m_Options.m_uiSurfaces = 256;
+	Preset.m_Options.m_uiBlocksPerSurface = 8;
+	vPresets.push_back(Preset);
+
+	return vPresets;
+}
+
+static void RunBenchmark(const char *szName, const tLwoSynthOptions &Options, const int iIterations)
+{
+	CLwoSynth Synth(Options);
+	const vector<char> &vFile = Synth.Generate();
+
+	CMemFile LwoFile(szName);
+	LwoFile.SetBuffer(vFile.data(), (unsigned long)vFile.size());
+
+	// first run is not counted:
+	// reader keeps capacity between files as in normal use
+	CLwoTimedReader Reader(&g_Allocs);
+	tLwoStageTimes Times;
+#ifdef LWO_INSTRUMENTATION
+	Reader.SetAllocCounter(&g_Allocs);
+#endif
+	if (Reader.ProcessTimed(LwoFile, Times) == false)
+	{
+		printf("%s: failed (%s at offset %lu)\n", szName,
+			GetLwoErrorName(Reader.GetError()), Reader.GetErrorOffset());
+		return;
+	}
+
+	Times.clear();
+	chrono::steady_clock::time_point Start = chrono::steady_clock::now();
+	for (int i = 0; i < iIterations; i++)
+	{
+		Reader.ProcessTimed(LwoFile, Times);
+	}
+	chrono::duration<double> Elapsed = (chrono::steady_clock::now() - Start);
+
+	printf("== %s: %u bytes, %d iterations, %.3f ms/file, %.1f MB/s\n", szName,
+		(unsigned int)vFile.size(), iIterations,
+		Elapsed.count() * 1000.0 / iIterations,
+		CLwoTimedReader::GetMBps((unsigned long long)vFile.size() * iIterations, Elapsed.count()));
+	CLwoTimedReader::PrintStages(Times, true);
+#ifdef LWO_INSTRUMENTATION
+	// handlers over all iterations (including first)
+	printf("%s\n", Reader.GetStats().ToJson().c_str());
+#endif
+	printf("\n");
+}
+
+//// --decode: checked cursor reads against raw pointer reads
+
+// payloads of one chunk type, in file order
+struct tLwoDecodeChunks
+{
+	unsigned int m_uiType;
+	const char *m_szName;
+	vector<pair<const char*, size_t> > m_vPayloads;
+	size_t m_nBytes;
+};
+
+// decoded values are written to preallocated buffers (same for both paths),
+// checksum keeps work from being optimized away and compares results
+struct tLwoDecodeOutput
+{
+	vector<float> m_vFloats;
+	vector<unsigned int> m_vIndices;
+	unsigned long long m_ullChecksum;
+};
+
+static void FindDecodeChunks(const vector<char> &vFile, vector<tLwoDecodeChunks> &vChunks)
+{
+	// FORM header: ID, size, file type
+	size_t nPos = 12;
+	while (nPos + 8 <= vFile.size())
+	{
+		const unsigned int uiType = LwoGetU4(vFile.data() + nPos);
+		const size_t nSize = LwoGetU4(vFile.data() + nPos +4);
+		const char *pData = vFile.data() + nPos +8;
+		if (nPos + 8 + nSize > vFile.size())
+		{
+			break;
+		}
+		for (size_t i = 0; i < vChunks.size(); i++)
+		{
+			if (vChunks[i].m_uiType == uiType)
+			{
+				vChunks[i].m_vPayloads.push_back(pair<const char*, size_t>(pData, nSize));
+				vChunks[i].m_nBytes += nSize;
+			}
+		}
+		nPos += 8 + nSize + (nSize & 1);
+	}
+}
+
+// raw variable-length index: 2 bytes or 4 bytes when first byte is 0xFF
+inline unsigned int GetRawVX(const char *&pPos)
+{
+	if ((unsigned char)pPos[0] != 0xFF)
+	{
+		unsigned int uiValue = LwoGetU2(pPos);
+		pPos += 2;
+		return uiValue;
+	}
+	unsigned int uiValue = LwoGetU4(pPos) & 0x00FFFFFF;
+	pPos += 4;
+	return uiValue;
+}
+
+//// checked: same reads as handlers in CLwoReader
+
+static bool DecodeCheckedPnts(const char *pData, const size_t nSize, tLwoDecodeOutput &Output)
+{
+	CLwoCursor Cursor(pData, nSize);
+	const size_t nCount = (nSize / 4);
+	if (Cursor.Require(nCount * 4) == false)
+	{
+		return false;
+	}
+	float *pOut = Output.m_vFloats.data();
+	for (size_t i = 0; i < nCount; i++)
+	{
+		pOut[i] = Cursor.F4();
+	}
+	Output.m_ullChecksum += nCount;
+	return true;
+}
+
+static bool DecodeCheckedPols(const char *pData, const size_t nSize, tLwoDecodeOutput &Output)
+{
+	CLwoCursor Cursor(pData, nSize);
+	unsigned int uiType = 0;
+	if (Cursor.ReadU4(uiType) == false)
+	{
+		return false;
+	}
+	unsigned int *pOut = Output.m_vIndices.data();
+	size_t nOut = 0;
+	while (Cursor.IsAtEnd() == false)
+	{
+		unsigned short usCount = 0;
+		if (Cursor.ReadU2(usCount) == false)
+		{
+			return false;
+		}
+		usCount &= 0x03FF;
+		if (Cursor.GetRemaining() >= (size_t)usCount * 4)
+		{
+			// enough for widest form
+			for (unsigned short i = 0; i < usCount; i++)
+			{
+				pOut[nOut++] = Cursor.VX();
+			}
+		}
+		else
+		{
+			for (unsigned short i = 0; i < usCount; i++)
+			{
+				if (Cursor.ReadVX(pOut[nOut++]) == false)
+				{
+					return false;
+				}
+			}
+		}
+	}
+	Output.m_ullChecksum += nOut + pOut[nOut / 2];
+	return true;
+}
+
+static bool DecodeCheckedPtag(const char *pData, const size_t nSize, tLwoDecodeOutput &Output)
+{
+	CLwoCursor Cursor(pData, nSize);
+	unsigned int uiType = 0;
+	if (Cursor.ReadU4(uiType) == false)
+	{
+		return false;
+	}
+	unsigned int *pOut = Output.m_vIndices.data();
+	size_t nOut = 0;
+	while (Cursor.IsAtEnd() == false)
+	{
+		if (Cursor.GetRemaining() < 6)
+		{
+			unsigned short usTag = 0;
+			if (Cursor.ReadVX(pOut[nOut]) == false
+				|| Cursor.ReadU2(usTag) == false)
+			{
+				return false;
+			}
+			pOut[nOut +1] = usTag;
+		}
+		else
+		{
+			pOut[nOut] = Cursor.VX();
+			pOut[nOut +1] = Cursor.U2();
+		}
+		nOut += 2;
+	}
+	Output.m_ullChecksum += nOut + pOut[nOut / 2];
+	return true;
+}
+
+static bool DecodeCheckedVmap(const char *pData, const size_t nSize, tLwoDecodeOutput &Output)
+{
+	CLwoCursor Cursor(pData, nSize);
+	unsigned int uiType = 0;
+	unsigned short usDimension = 0;
+	string szName;
+	if (Cursor.ReadU4(uiType) == false
+		|| Cursor.ReadU2(usDimension) == false
+		|| Cursor.ReadS0(szName) == false)
+	{
+		return false;
+	}
+	unsigned int *pIndices = Output.m_vIndices.data();
+	float *pValues = Output.m_vFloats.data();
+	size_t nIndices = 0;
+	size_t nValues = 0;
+	while (Cursor.IsAtEnd() == false)
+	{
+		if (Cursor.ReadVX(pIndices[nIndices++]) == false
+			|| Cursor.Require((size_t)usDimension * 4) == false)
+		{
+			return false;
+		}
+		for (unsigned short i = 0; i < usDimension; i++)
+		{
+			pValues[nValues++] = Cursor.F4();
+		}
+	}
+	Output.m_ullChecksum += nIndices + nValues;
+	return true;
+}
+
+//// raw: unchecked pointer reads, no bounds checks
+
+static bool DecodeRawPnts(const char *pData, const size_t nSize, tLwoDecodeOutput &Output)
+{
+	const size_t nCount = (nSize / 4);
+	float *pOut = Output.m_vFloats.data();
+	for (size_t i = 0; i < nCount; i++)
+	{
+		pOut[i] = LwoGetF4(pData + i * 4);
+	}
+	Output.m_ullChecksum += nCount;
+	return true;
+}
+
+static bool DecodeRawPols(const char *pData, const size_t nSize, tLwoDecodeOutput &Output)
+{
+	const char *pPos = pData +4;
+	const char *pEnd = pData + nSize;
+	unsigned int *pOut = Output.m_vIndices.data();
+	size_t nOut = 0;
+	while (pPos < pEnd)
+	{
+		unsigned short usCount = (LwoGetU2(pPos) & 0x03FF);
+		pPos += 2;
+		for (unsigned short i = 0; i < usCount; i++)
+		{
+			pOut[nOut++] = GetRawVX(pPos);
+		}
+	}
+	Output.m_ullChecksum += nOut + pOut[nOut / 2];
+	return true;
+}
+
+static bool DecodeRawPtag(const char *pData, const size_t nSize, tLwoDecodeOutput &Output)
+{
+	const char *pPos = pData +4;
+	const char *pEnd = pData + nSize;
+	unsigned int *pOut = Output.m_vIndices.data();
+	size_t nOut = 0;
+	while (pPos < pEnd)
+	{
+		pOut[nOut] = GetRawVX(pPos);
+		pOut[nOut +1] = LwoGetU2(pPos);
+		pPos += 2;
+		nOut += 2;
+	}
+	Output.m_ullChecksum += nOut + pOut[nOut / 2];
+	return true;
+}
+
+static bool DecodeRawVmap(const char *pData, const size_t nSize, tLwoDecodeOutput &Output)
+{
+	const char *pPos = pData +4;
+	const char *pEnd = pData + nSize;
+	const unsigned short usDimension = LwoGetU2(pPos);
+	pPos += 2;
+	// name is S0: padded to even length
+	const string szName(pPos);
+	pPos += szName.size() + 2 - (szName.size() & 1);
+
+	unsigned int *pIndices = Output.m_vIndices.data();
+	float *pValues = Output.m_vFloats.data();
+	size_t nIndices = 0;
+	size_t nValues = 0;
+	while (pPos < pEnd)
+	{
+		pIndices[nIndices++] = GetRawVX(pPos);
+		for (unsigned short i = 0; i < usDimension; i++)
+		{
+			pValues[nValues++] = LwoGetF4(pPos);
+			pPos += 4;
+		}
+	}
+	Output.m_ullChecksum += nIndices + nValues;
+	return true;
+}
+
+typedef bool (*tLwoDecodeFunc)(const char *pData, const size_t nSize, tLwoDecodeOutput &Output);
+
+// best time of all iterations (in seconds)
+static double TimeDecode(const tLwoDecodeChunks &Chunks, tLwoDecodeFunc pDecode,
+	const int iIterations, tLwoDecodeOutput &Output)
+{
+	double dBest = 0.0;
+	for (int i = 0; i < iIterations; i++)
+	{
+		Output.m_ullChecksum = 0;
+		chrono::steady_clock::time_point Start = chrono::steady_clock::now();
+		for (size_t j = 0; j < Chunks.m_vPayloads.size(); j++)
+		{
+			if (pDecode(Chunks.m_vPayloads[j].first, Chunks.m_vPayloads[j].second, Output) == false)
+			{
+				return -1.0;
+			}
+		}
+		chrono::duration<double> Elapsed = (chrono::steady_clock::now() - Start);
+		if (i == 0 || Elapsed.count() < dBest)
+		{
+			dBest = Elapsed.count();
+		}
+	}
+	return dBest;
+}
+
+static void RunDecodeBenchmark(const char *szName, const tLwoSynthOptions &Options, const int iIterations)
+{
+	CLwoSynth Synth(Options);
+	const vector<char> &vFile = Synth.Generate();
+
+	vector<tLwoDecodeChunks> vChunks(4);
+	vChunks[0].m_uiType = ID_PNTS;
+	vChunks[0].m_szName = "PNTS";
+	vChunks[1].m_uiType = ID_POLS;
+	vChunks[1].m_szName = "POLS";
+	vChunks[2].m_uiType = ID_PTAG;
+	vChunks[2].m_szName = "PTAG";
+	vChunks[3].m_uiType = ID_VMAP;
+	vChunks[3].m_szName = "VMAP";
+	for (size_t i = 0; i < vChunks.size(); i++)
+	{
+		vChunks[i].m_nBytes = 0;
+	}
+	FindDecodeChunks(vFile, vChunks);
+
+	const tLwoDecodeFunc pChecked[4] = { DecodeCheckedPnts, DecodeCheckedPols, DecodeCheckedPtag, DecodeCheckedVmap };
+	const tLwoDecodeFunc pRaw[4] = { DecodeRawPnts, DecodeRawPols, DecodeRawPtag, DecodeRawVmap };
+
+	printf("== %s: decode, %d iterations (best time)\n", szName, iIterations);
+	printf("  %-6s %10s %12s %12s %10s\n", "chunk", "bytes", "checked ms", "raw ms", "overhead");
+
+	double dCheckedTotal = 0.0;
+	double dRawTotal = 0.0;
+	for (size_t i = 0; i < vChunks.size(); i++)
+	{
+		const tLwoDecodeChunks &Chunks = vChunks[i];
+		if (Chunks.m_vPayloads.empty() == true)
+		{
+			continue;
+		}
+
+		// one value per 2 bytes at most (smallest index)
+		size_t nLargest = 0;
+		for (size_t j = 0; j < Chunks.m_vPayloads.size(); j++)
+		{
+			if (Chunks.m_vPayloads[j].second > nLargest)
+			{
+				nLargest = Chunks.m_vPayloads[j].second;
+			}
+		}
+		tLwoDecodeOutput Output;
+		Output.m_vFloats.resize(nLargest / 2 + 1);
+		Output.m_vIndices.resize(nLargest / 2 + 2);
+
+		const double dChecked = TimeDecode(Chunks, pChecked[i], iIterations, Output);
+		const unsigned long long ullChecked = Output.m_ullChecksum;
+		const double dRaw = TimeDecode(Chunks, pRaw[i], iIterations, Output);
+		if (dChecked < 0.0 || dRaw < 0.0)
+		{
+			printf("  %-6s decode failed\n", Chunks.m_szName);
+			continue;
+		}
+		if (ullChecked != Output.m_ullChecksum)
+		{
+			printf("  %-6s results differ\n", Chunks.m_szName);
+			continue;
+		}
+
+		printf("  %-6s %10lu %12.3f %12.3f %9.1f%%\n", Chunks.m_szName,
+			(unsigned long)Chunks.m_nBytes, dChecked * 1000.0, dRaw * 1000.0,
+			(dRaw > 0.0) ? (dChecked / dRaw - 1.0) * 100.0 : 0.0);
+		dCheckedTotal += dChecked;
+		dRawTotal += dRaw;
+	}
+	printf("  %-6s %10s %12.3f %12.3f %9.1f%%\n\n", "total", "",
+		dCheckedTotal * 1000.0, dRawTotal * 1000.0,
+		(dRawTotal > 0.0) ? (dCheckedTotal / dRawTotal - 1.0) * 100.0 : 0.0);
+}
+
+static void PrintUsage(const char *szProgram)
+{
+	printf("Usage: %s [options]\n", szProgram);
+	printf("  --preset <name>     default, large, wide, ngons, layers, uvs, surfaces\n");
+	printf("  -n <count>          iterations (default 10)\n");
+	printf("  --seed <n>          --layers <n>   --points <n>   --polygons <n>\n");
+	printf("  --poly-min <n>      --poly-max <n>\n");
+	printf("  --wide <f>          fraction of small indices in 4-byte form\n");
+	printf("  --ptag <f>          --vmap <f>     --vmad <f>\n");
+	printf("  --surfaces <n>      --blocks <n>   texture layers per surface\n");
+	printf("  --write <file>      write generated object instead of benchmark\n");
+	printf("  --decode            time PNTS/POLS/PTAG/VMAP decoding with checked cursor\n");
+	printf("                      and raw pointer reads instead of benchmark\n");
+}
+
+int main(int argc, char* argv[])
+{
+	vector<tLwoBenchPreset> vPresets = GetPresets();
+
+	tLwoSynthOptions Options;
+	bool bCustom = false;
+	string szPreset;
+	string szWrite;
+	bool bDecode = false;
+	int iIterations = 10;
+
+	for (int i = 1; i < argc; i++)
+	{
+		string szArg = argv[i];
+		if (szArg == "--decode")
+		{
+			bDecode = true;
+			continue;
+		}
+		if ((i + 1) >= argc)
+		{
+			PrintUsage(argv[0]);
+			return EXIT_FAILURE;
+		}
+		const char *szValue = argv[++i];
+
+		if (szArg == "-n")
+		{
+			iIterations = atoi(szValue);
+			if (iIterations < 1)
+			{
+				iIterations = 1;
+			}
+		}
+		else if (szArg == "--preset")
+		{
+			szPreset = szValue;
+		}
+		else if (szArg == "--write")
+		{
+			szWrite = szValue;
+		}
+		else
+		{
+			bCustom = true;
+			if (szArg == "--seed")
+			{
+				Options.m_uiSeed = (unsigned int)strtoul(szValue, NULL, 10);
+			}
+			else if (szArg == "--layers")
+			{
+				Options.m_uiLayers = (unsigned int)strtoul(szValue, NULL, 10);
+			}
+			else if (szArg == "--points")
+			{
+				Options.m_ulPointsPerLayer = strtoul(szValue, NULL, 10);
+			}
+			else if (szArg == "--polygons")
+			{
+				Options.m_ulPolygonsPerLayer = strtoul(szValue, NULL, 10);
+			}
+			else if (szArg == "--poly-min")
+			{
+				Options.m_usMinPolygonSize = (unsigned short)strtoul(szValue, NULL, 10);
+			}
+			else if (szArg == "--poly-max")
+			{
+				Options.m_usMaxPolygonSize = (unsigned short)strtoul(szValue, NULL, 10);
+			}
+			else if (szArg == "--wide")
+			{
+				Options.m_fWideIndexDensity = (float)atof(szValue);
+			}
+			else if (szArg == "--ptag")
+			{
+				Options.m_fPtagDensity = (float)atof(szValue);
+			}
+			else if (szArg == "--vmap")
+			{
+				Options.m_fVmapDensity = (float)atof(szValue);
+			}
+			else if (szArg == "--vmad")
+			{
+				Options.m_fVmadDensity = (float)atof(szValue);
+			}
+			else if (szArg == "--surfaces")
+			{
+				Options.m_uiSurfaces = (unsigned int)strtoul(szValue, NULL, 10);
+			}
+			else if (szArg == "--blocks")
+			{
+				Options.m_uiBlocksPerSurface = (unsigned int)strtoul(szValue, NULL, 10);
+			}
+			else
+			{
+				PrintUsage(argv[0]);
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	// preset as base of options given
+	if (szPreset.empty() == false)
+	{
+		size_t nPreset = 0;
+		while (nPreset < vPresets.size()
+			&& szPreset != vPresets[nPreset].m_szName)
+		{
+			nPreset++;
+		}
+		if (nPreset >= vPresets.size())
+		{
+			printf("Unknown preset: %s\n", szPreset.c_str());
+			return EXIT_FAILURE;
+		}
+		if (bCustom == true)
+		{
+			printf("Options can't be combined with preset\n");
+			return EXIT_FAILURE;
+		}
+		Options = vPresets[nPreset].m_Options;
+		bCustom = true;
+	}
+
+	if (szWrite.empty() == false)
+	{
+		CLwoSynth Synth(Options);
+		Synth.Generate();
+		if (Synth.WriteFile(szWrite.c_str()) == false)
+		{
+			printf("Failed to write file: %s\n", szWrite.c_str());
+			return EXIT_FAILURE;
+		}
+		return EXIT_SUCCESS;
+	}
+
+	if (bCustom == true)
+	{
+		const char *szName = (szPreset.empty() == false) ? szPreset.c_str() : "custom";
+		if (bDecode == true)
+		{
+			RunDecodeBenchmark(szName, Options, iIterations);
+		}
+		else
+		{
+			RunBenchmark(szName, Options, iIterations);
+		}
+		return EXIT_SUCCESS;
+	}
+
+	for (size_t i = 0; i < vPresets.size(); i++)
+	{
+		if (bDecode == true)
+		{
+			RunDecodeBenchmark(vPresets[i].m_szName, vPresets[i].m_Options, iIterations);
+		}
+		else
+		{
+			RunBenchmark(vPresets[i].m_szName, vPresets[i].m_Options, iIterations);
+		}
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,192 @@
+//////////////////////////////////////////////////////////////////////
+// LwoFuzz.cpp : fuzz target and corpus throughput for CLwoReader
+//
+// Built with libFuzzer (clang -fsanitize=fuzzer),
+// each input is given to the reader from memory
+// both as object (ProcessFromFile()) and as events (ProcessWithHandler()):
+//
+//   LwoFuzz -timeout=5 corpus/ ../tools/corpus/
+//
+// Built with LWO_FUZZ_REPLAY, same inputs are files or directories
+// which are checked once and then parsed repeatedly
+// for throughput of each chunk type:
+//
+//   LwoFuzzReplay [-n iterations] corpus/ ...
+//
+
+#include "LwoReader.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+#include <chrono>
+
+using namespace std;
+
+// inputs larger than this are not interesting for fuzzing
+// (only make each run slower)
+#define LWO_FUZZ_MAX_INPUT (4*1024*1024)
+
+
+// parse buffer in both ways reader supports:
+// result does not matter, only that it returns
+static void ParseBuffer(const uint8_t *pData, const size_t nSize)
+{
+	CLwoReader LwoReader;
+	{
+		CMemFile LwoFile("<memory>");
+		LwoFile.SetBuffer(pData, (unsigned long)nSize);
+		LwoReader.ProcessFromFile(LwoFile);
+	}
+
+	// reused reader, default handler accepts everything
+	{
+		CMemFile LwoFile("<memory>");
+		LwoFile.SetBuffer(pData, (unsigned long)nSize);
+		CLwoEventHandler Handler;
+		LwoReader.ProcessWithHandler(LwoFile, Handler);
+	}
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *pData, size_t nSize)
+{
+	if (nSize > LWO_FUZZ_MAX_INPUT)
+	{
+		return 0;
+	}
+
+	// copy to exact size so that reading past end is detected
+	// (fuzzer data may be in larger buffer)
+	vector<uint8_t> vBuffer(pData, pData + nSize);
+	ParseBuffer(vBuffer.data(), vBuffer.size());
+	return 0;
+}
+
+
+#ifdef LWO_FUZZ_REPLAY
+
+#include "LwoTimedReader.h"
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+// files in directory (not recursive)
+static void AddInputs(const char *szPath, vector<string> &vInputs)
+{
+#ifndef _WIN32
+	struct stat Stat;
+	if (stat(szPath, &Stat) == 0
+		&& S_ISDIR(Stat.st_mode))
+	{
+		DIR *pDir = opendir(szPath);
+		if (pDir == NULL)
+		{
+			return;
+		}
+		while (struct dirent *pEntry = readdir(pDir))
+		{
+			if (pEntry->d_name[0] == '.')
+			{
+				continue;
+			}
+			string szFile = string(szPath) + "/" + pEntry->d_name;
+			if (stat(szFile.c_str(), &Stat) == 0
+				&& S_ISREG(Stat.st_mode))
+			{
+				vInputs.push_back(szFile);
+			}
+		}
+		closedir(pDir);
+		return;
+	}
+#endif
+	vInputs.push_back(szPath);
+}
+
+int main(int argc, char* argv[])
+{
+	int iIterations = 10;
+	vector<string> vInputs;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-n") == 0
+			&& (i + 1) < argc)
+		{
+			iIterations = atoi(argv[++i]);
+			if (iIterations < 1)
+			{
+				iIterations = 1;
+			}
+			continue;
+		}
+		AddInputs(argv[i], vInputs);
+	}
+
+	if (vInputs.empty() == true)
+	{
+		printf("Usage: %s [-n iterations] <file|directory> ...\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	tLwoStageTimes Times;
+	unsigned long long ullTotalBytes = 0;
+	double dTotalSeconds = 0.0;
+	size_t nParsed = 0;
+
+	for (size_t i = 0; i < vInputs.size(); i++)
+	{
+		CMemFile LwoFile(vInputs[i].c_str());
+		if (LwoFile.LoadFile() == false)
+		{
+			printf("Failed to read file: %s\n", vInputs[i].c_str());
+			continue;
+		}
+
+		// check first: same as fuzz target
+		const uint8_t *pData = (const uint8_t*)LwoFile.GetFileBuf();
+		LLVMFuzzerTestOneInput(pData, LwoFile.GetFilesize());
+
+		// time only valid files:
+		// failed files stop early and would skew throughput
+		CLwoReader LwoReader;
+		if (LwoReader.ProcessFromFile(LwoFile) == false)
+		{
+			printf("%s: %s at offset %lu\n", vInputs[i].c_str(),
+				GetLwoErrorName(LwoReader.GetError()), LwoReader.GetErrorOffset());
+			continue;
+		}
+		nParsed++;
+
+		chrono::steady_clock::time_point Start = chrono::steady_clock::now();
+		for (int iIter = 0; iIter < iIterations; iIter++)
+		{
+			LwoReader.ProcessFromFile(LwoFile);
+		}
+		chrono::duration<double> Elapsed = (chrono::steady_clock::now() - Start);
+		dTotalSeconds += Elapsed.count();
+		ullTotalBytes += (unsigned long long)LwoFile.GetFilesize() * iIterations;
+
+		CLwoTimedReader TimedReader;
+		for (int iIter = 0; iIter < iIterations; iIter++)
+		{
+			TimedReader.ProcessTimed(LwoFile, Times);
+		}
+	}
+
+	printf("inputs: %u valid: %u iterations: %d\n", (unsigned int)vInputs.size(), (unsigned int)nParsed, iIterations);
+	CLwoTimedReader::PrintStages(Times, false);
+
+	// includes all stages
+	printf("%-8s %10s %14llu %12.3f %10.1f\n", "total", "", ullTotalBytes,
+		dTotalSeconds * 1000.0, CLwoTimedReader::GetMBps(ullTotalBytes, dTotalSeconds));
+
+	return EXIT_SUCCESS;
+}
+
+#endif // LWO_FUZZ_REPLAY
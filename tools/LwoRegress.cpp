@@ -0,0 +1,688 @@
+//////////////////////////////////////////////////////////////////////
+// LwoRegress.cpp : regression checks of reader with crafted objects
+//
+// Each check makes small LWO2-file in memory
+// (with writer of LwoSynth.h) and verifies parsed object and error.
+// Run by ctest, or directly: returns failure when any check fails.
+//
+
+#include "LwoSynth.h"
+#include "LwoReader.h"
+#include "LwoImageResolver.h"
+#include "LwoAsyncLoader.h"
+#include "LwoTags.h"
+#include "LwoExport.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace std;
+
+// failed checks of all tests
+static int g_iFailures = 0;
+
+#define LWO_CHECK(bExpr) \
+	if (!(bExpr)) \
+	{ \
+		printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #bExpr); \
+		g_iFailures++; \
+	}
+
+// writer of synthetic objects with chunks given by test
+class CLwoCraft : public CLwoSynth
+{
+public:
+	CLwoCraft()
+		: CLwoSynth(tLwoSynthOptions())
+	{};
+
+	using CLwoSynth::PutU1;
+	using CLwoSynth::PutU2;
+	using CLwoSynth::PutU4;
+	using CLwoSynth::PutF4;
+	using CLwoSynth::PutID;
+	using CLwoSynth::PutS0;
+	using CLwoSynth::BeginChunk;
+	using CLwoSynth::EndChunk;
+	using CLwoSynth::BeginSubChunk;
+	using CLwoSynth::EndSubChunk;
+
+	// FORM and file type (LWO2 or LWOB):
+	// returns position of size for EndChunk()
+	size_t BeginForm(const unsigned int uiFileType = ID_LWO2)
+	{
+		m_vBuffer.clear();
+		size_t nFormPos = BeginChunk(ID_FORM);
+		PutID(uiFileType);
+		return nFormPos;
+	};
+
+	// 2-byte index (test objects are small)
+	void PutVX(const unsigned short usIndex)
+	{
+		PutU2(usIndex);
+	};
+};
+
+// parse buffer as object (buffer must outlive reader's use)
+static bool ParseBuffer(const vector<char> &vBuffer, CLwoReader &LwoReader)
+{
+	CMemFile LwoFile("<regress>");
+	LwoFile.SetBuffer(vBuffer.data(), (unsigned long)vBuffer.size());
+	return LwoReader.ProcessFromFile(LwoFile);
+}
+
+// parse buffer as events
+static bool StreamBuffer(const vector<char> &vBuffer, CLwoReader &LwoReader, CLwoEventHandler &Handler)
+{
+	CMemFile LwoFile("<regress>");
+	LwoFile.SetBuffer(vBuffer.data(), (unsigned long)vBuffer.size());
+	return LwoReader.ProcessWithHandler(LwoFile, Handler);
+}
+
+// counts of streamed records
+class CLwoCountHandler : public CLwoEventHandler
+{
+public:
+	size_t m_nPolygons;
+	size_t m_nPtags;
+	size_t m_nVmapValues;
+
+	CLwoCountHandler()
+		: m_nPolygons(0)
+		, m_nPtags(0)
+		, m_nVmapValues(0)
+	{};
+
+	virtual bool OnPolygons(const tLwoPolygonBatch &Batch)
+	{
+		m_nPolygons += Batch.m_nCount;
+		return true;
+	};
+	virtual bool OnPtag(const tLwoPtagBatch &Batch)
+	{
+		m_nPtags += Batch.m_nCount;
+		return true;
+	};
+	virtual bool OnVmap(const tLwoVmapBatch &Batch)
+	{
+		m_nVmapValues += Batch.m_nCount;
+		return true;
+	};
+};
+
+// surface with name and no parent
+static size_t BeginSurface(CLwoCraft &Craft, const char *szName)
+{
+	size_t nSurfPos = Craft.BeginChunk(ID_SURF);
+	Craft.PutS0(szName);
+	Craft.PutS0("");
+	return nSurfPos;
+}
+
+// header of texture layer: type, ordinal and channel
+static size_t BeginBlok(CLwoCraft &Craft, const unsigned int uiType, const char *szOrdinal)
+{
+	size_t nBlokPos = Craft.BeginSubChunk(ID_BLOK);
+	size_t nHeaderPos = Craft.BeginSubChunk(uiType);
+	Craft.PutS0(szOrdinal);
+	size_t nChanPos = Craft.BeginSubChunk(ID_CHAN);
+	Craft.PutID(ID_COLR);
+	Craft.EndSubChunk(nChanPos);
+	Craft.EndSubChunk(nHeaderPos);
+	return nBlokPos;
+}
+
+// BLOK of unknown type is skipped as any unknown sub-chunk:
+// surface is kept with following sub-chunks and known layers
+static void TestUnknownBlok()
+{
+	CLwoCraft Craft;
+	size_t nFormPos = Craft.BeginForm();
+	size_t nSurfPos = BeginSurface(Craft, "Unknown");
+
+	size_t nBlokPos = BeginBlok(Craft, LWID_('X','B','L','K'), "\x80");
+	size_t nSubPos = Craft.BeginSubChunk(ID_AXIS);
+	Craft.PutU2(1);
+	Craft.EndSubChunk(nSubPos);
+	Craft.EndSubChunk(nBlokPos);
+
+	nBlokPos = BeginBlok(Craft, ID_PROC, "\x81");
+	nSubPos = Craft.BeginSubChunk(ID_AXIS);
+	Craft.PutU2(2);
+	Craft.EndSubChunk(nSubPos);
+	Craft.EndSubChunk(nBlokPos);
+
+	nSubPos = Craft.BeginSubChunk(ID_COLR);
+	Craft.PutF4(0.25f);
+	Craft.PutF4(0.5f);
+	Craft.PutF4(0.75f);
+	Craft.PutVX(0);
+	Craft.EndSubChunk(nSubPos);
+
+	Craft.EndChunk(nSurfPos);
+	Craft.EndChunk(nFormPos);
+
+	CLwoReader LwoReader;
+	LWO_CHECK(ParseBuffer(Craft.GetBuffer(), LwoReader) == true);
+	LWO_CHECK(LwoReader.GetError() == LWO_ERROR_NONE);
+
+	const tSurfaceList &Surfaces = LwoReader.GetObjectData().GetSurfaces();
+	LWO_CHECK(Surfaces.size() == 1);
+	if (Surfaces.size() == 1)
+	{
+		const CLwoSurface *pSurface = Surfaces[0];
+		LWO_CHECK(pSurface->m_TextureLayers.size() == 1);
+		if (pSurface->m_TextureLayers.size() == 1)
+		{
+			LWO_CHECK(pSurface->m_TextureLayers[0].m_uiBlokTypeID == ID_PROC);
+			LWO_CHECK(pSurface->m_TextureLayers[0].m_usAxis == 2);
+		}
+		LWO_CHECK(pSurface->m_fColor[2] == 0.75f);
+	}
+}
+
+// lists of values which end with sub-chunk:
+// reading stops at end without error
+static void TestValueLists()
+{
+	CLwoCraft Craft;
+	size_t nFormPos = Craft.BeginForm();
+
+	// envelope: TCB-span with three parameters, linear span without any
+	size_t nEnvlPos = Craft.BeginChunk(ID_ENVL);
+	Craft.PutVX(1);
+	size_t nSubPos = Craft.BeginSubChunk(ID_KEY);
+	Craft.PutF4(0.0f);
+	Craft.PutF4(1.0f);
+	Craft.EndSubChunk(nSubPos);
+	nSubPos = Craft.BeginSubChunk(ID_SPAN);
+	Craft.PutID(ID_TCB);
+	Craft.PutF4(0.5f);
+	Craft.PutF4(0.25f);
+	Craft.PutF4(-0.5f);
+	Craft.EndSubChunk(nSubPos);
+	nSubPos = Craft.BeginSubChunk(ID_KEY);
+	Craft.PutF4(1.0f);
+	Craft.PutF4(2.0f);
+	Craft.EndSubChunk(nSubPos);
+	nSubPos = Craft.BeginSubChunk(ID_SPAN);
+	Craft.PutID(ID_LINE);
+	Craft.EndSubChunk(nSubPos);
+	Craft.EndChunk(nEnvlPos);
+
+	// gradient: interpolation of two keys
+	size_t nSurfPos = BeginSurface(Craft, "Gradient");
+	size_t nBlokPos = BeginBlok(Craft, ID_GRAD, "\x80");
+	nSubPos = Craft.BeginSubChunk(ID_FKEY);
+	for (int i = 0; i < 2; i++)
+	{
+		Craft.PutF4((float)i);
+		for (int j = 0; j < 4; j++)
+		{
+			Craft.PutF4(1.0f);
+		}
+	}
+	Craft.EndSubChunk(nSubPos);
+	nSubPos = Craft.BeginSubChunk(ID_IKEY);
+	Craft.PutU2(1);
+	Craft.PutU2(3);
+	Craft.EndSubChunk(nSubPos);
+	Craft.EndSubChunk(nBlokPos);
+	Craft.EndChunk(nSurfPos);
+
+	Craft.EndChunk(nFormPos);
+
+	CLwoReader LwoReader;
+	LWO_CHECK(ParseBuffer(Craft.GetBuffer(), LwoReader) == true);
+	LWO_CHECK(LwoReader.GetError() == LWO_ERROR_NONE);
+
+	const tEnvelopeList &Envelopes = LwoReader.GetObjectData().GetEnvelopes();
+	LWO_CHECK(Envelopes.size() == 1);
+	if (Envelopes.size() == 1)
+	{
+		const CLwoEnvelope *pEnvelope = Envelopes[0];
+		LWO_CHECK(pEnvelope->m_Keys.size() == 2);
+		if (pEnvelope->m_Keys.size() == 2)
+		{
+			LWO_CHECK(pEnvelope->m_Keys[0].m_uiShape == ID_TCB);
+			LWO_CHECK(pEnvelope->m_Keys[0].m_fBias == -0.5f);
+			LWO_CHECK(pEnvelope->m_Keys[1].m_uiShape == ID_LINE);
+		}
+	}
+
+	const tSurfaceList &Surfaces = LwoReader.GetObjectData().GetSurfaces();
+	LWO_CHECK(Surfaces.size() == 1);
+	if (Surfaces.size() == 1)
+	{
+		const CLwoSurface *pSurface = Surfaces[0];
+		LWO_CHECK(pSurface->m_TextureLayers.size() == 1);
+		if (pSurface->m_TextureLayers.size() == 1)
+		{
+			const CLwoSurface::CLwoTextureLayer &Layer = pSurface->m_TextureLayers[0];
+			LWO_CHECK(Layer.m_GradientKeys.size() == 2);
+			LWO_CHECK(Layer.m_GradientInterpolation.size() == 2);
+			if (Layer.m_GradientInterpolation.size() == 2)
+			{
+				LWO_CHECK(Layer.m_GradientInterpolation[1] == 3);
+			}
+		}
+	}
+}
+
+// LWOB sub-chunk with a string
+static void PutStringSubChunk(CLwoCraft &Craft, const unsigned int uiType, const char *szValue)
+{
+	size_t nSubPos = Craft.BeginSubChunk(uiType);
+	Craft.PutS0(szValue);
+	Craft.EndSubChunk(nSubPos);
+}
+
+// LWOB textures are texture layers as BLOK in LWO2:
+// channel by xTEX, projection by name, TMAP-values and image as clip
+static void TestLwobTextures()
+{
+	CLwoCraft Craft;
+	size_t nFormPos = Craft.BeginForm(ID_LWOB);
+	size_t nSurfPos = Craft.BeginChunk(ID_SURF);
+	Craft.PutS0("Wood");
+
+	PutStringSubChunk(Craft, ID_CTEX, "Cylindrical Image Map");
+	size_t nSubPos = Craft.BeginSubChunk(ID_TFLG);
+	Craft.PutU2(0x2 | 0x20);
+	Craft.EndSubChunk(nSubPos);
+	nSubPos = Craft.BeginSubChunk(ID_TSIZ);
+	Craft.PutF4(2.0f);
+	Craft.PutF4(3.0f);
+	Craft.PutF4(4.0f);
+	Craft.EndSubChunk(nSubPos);
+	nSubPos = Craft.BeginSubChunk(ID_TCTR);
+	Craft.PutF4(0.5f);
+	Craft.PutF4(0.0f);
+	Craft.PutF4(-0.5f);
+	Craft.EndSubChunk(nSubPos);
+	PutStringSubChunk(Craft, ID_TIMG, "Images/wood.tga");
+
+	PutStringSubChunk(Craft, ID_DTEX, "Fractal Noise");
+	nSubPos = Craft.BeginSubChunk(ID_TVAL);
+	Craft.PutU2(128);
+	Craft.EndSubChunk(nSubPos);
+
+	PutStringSubChunk(Craft, ID_BTEX, "Planar Image Map");
+	PutStringSubChunk(Craft, ID_TIMG, "Images/wood.tga");
+
+	Craft.EndChunk(nSurfPos);
+	Craft.EndChunk(nFormPos);
+
+	CLwoReader LwoReader;
+	LWO_CHECK(ParseBuffer(Craft.GetBuffer(), LwoReader) == true);
+	LWO_CHECK(LwoReader.GetError() == LWO_ERROR_NONE);
+
+	// same image is one clip
+	LWO_CHECK(LwoReader.GetObjectData().GetClips().size() == 1);
+
+	const tSurfaceList &Surfaces = LwoReader.GetObjectData().GetSurfaces();
+	LWO_CHECK(Surfaces.size() == 1);
+	if (Surfaces.size() == 1)
+	{
+		const CLwoSurface::tTextureLayerList &Layers = Surfaces[0]->m_TextureLayers;
+		LWO_CHECK(Layers.size() == 3);
+		if (Layers.size() == 3)
+		{
+			LWO_CHECK(Layers[0].m_uiBlokTypeID == ID_IMAP);
+			LWO_CHECK(Layers[0].m_uiChannel == ID_COLR);
+			LWO_CHECK(Layers[0].m_usProjection == 1);
+			LWO_CHECK(Layers[0].m_usAxis == 1);
+			LWO_CHECK(Layers[0].m_usPixelBlending == 1);
+			LWO_CHECK(Layers[0].m_fSize[2] == 4.0f);
+			LWO_CHECK(Layers[0].m_fCenter[2] == -0.5f);
+			LWO_CHECK(Layers[0].m_uiImageIndex == 1);
+			LWO_CHECK(Layers[0].m_pClip != NULL);
+			if (Layers[0].m_pClip != NULL)
+			{
+				LWO_CHECK(Layers[0].m_pClip->m_uiClipTypeID == ID_STIL);
+				LWO_CHECK(Layers[0].m_pClip->m_szFilename == "Images/wood.tga");
+			}
+
+			LWO_CHECK(Layers[1].m_uiBlokTypeID == ID_PROC);
+			LWO_CHECK(Layers[1].m_uiChannel == ID_DIFF);
+			LWO_CHECK(Layers[1].m_szFunction == "Fractal Noise");
+			LWO_CHECK(Layers[1].m_usValueCount == 1);
+			LWO_CHECK(Layers[1].m_fValue[0] == 0.5f);
+
+			LWO_CHECK(Layers[2].m_uiBlokTypeID == ID_IMAP);
+			LWO_CHECK(Layers[2].m_uiChannel == ID_BUMP);
+			LWO_CHECK(Layers[2].m_usProjection == 0);
+			LWO_CHECK(Layers[2].m_pClip == Layers[0].m_pClip);
+		}
+	}
+}
+
+// still image clip with given index and filename
+static void PutStillClip(CLwoCraft &Craft, const unsigned int uiIndex, const char *szFilename)
+{
+	size_t nClipPos = Craft.BeginChunk(ID_CLIP);
+	Craft.PutU4(uiIndex);
+	size_t nSubPos = Craft.BeginSubChunk(ID_STIL);
+	Craft.PutS0(szFilename);
+	Craft.EndSubChunk(nSubPos);
+	Craft.EndChunk(nClipPos);
+}
+
+// device-form ("Device:path") is absolute and same as drive path,
+// texture table keeps details after objects are released
+static void TestImagePaths()
+{
+	CLwoImageResolver Resolver;
+	LWO_CHECK(Resolver.CanonicalizePath("C:Images/x.tga", "/base") == "C:/Images/x.tga");
+	LWO_CHECK(Resolver.CanonicalizePath("c:\\Images\\x.tga", "/base") == "C:/Images/x.tga");
+	LWO_CHECK(Resolver.CanonicalizePath("Images:x.tga", "/base") == "Images:/x.tga");
+	LWO_CHECK(Resolver.CanonicalizePath("Images:../x.tga", "/base") == "Images:/x.tga");
+	LWO_CHECK(Resolver.CanonicalizePath("tex/../x.tga", "/base") == "/base/x.tga");
+	LWO_CHECK(Resolver.CanonicalizePath("x.tga", "Content:scenes") == "Content:/scenes/x.tga");
+	LWO_CHECK(Resolver.CanonicalizePath("//server/share/./x.tga", "/base") == "//server/share/x.tga");
+
+	{
+		CLwoCraft Craft;
+		size_t nFormPos = Craft.BeginForm();
+		PutStillClip(Craft, 1, "C:Images/x.tga");
+		PutStillClip(Craft, 2, "C:/Images/./x.tga");
+		PutStillClip(Craft, 3, "Images:x.tga");
+		Craft.EndChunk(nFormPos);
+
+		CLwoReader LwoReader;
+		LWO_CHECK(ParseBuffer(Craft.GetBuffer(), LwoReader) == true);
+		Resolver.AddObject(LwoReader.GetObjectData(), "/base");
+	}
+
+	// reader and its object are gone here
+	LWO_CHECK(Resolver.GetTextureCount() == 2);
+	LWO_CHECK(Resolver.GetTextureId(0, 1) == Resolver.GetTextureId(0, 2));
+	LWO_CHECK(Resolver.GetTextureId(0, 1) != Resolver.GetTextureId(0, 3));
+	if (Resolver.GetTextureCount() == 2)
+	{
+		const CLwoImageResolver::CLwoTextureRef &Texture = Resolver.GetTexture(Resolver.GetTextureId(0, 1));
+		LWO_CHECK(Texture.m_szPath == "C:/Images/x.tga");
+		LWO_CHECK(Texture.m_uiClipTypeID == ID_STIL);
+		LWO_CHECK(Texture.m_uiRefCount == 2);
+	}
+}
+
+// object over budget of async loader fails as "budget" (as in batch)
+static void TestAsyncBudget()
+{
+	// file in working directory of test
+	const char *szFile = "LwoRegress_budget.lwo";
+	tLwoSynthOptions Options;
+	CLwoSynth Synth(Options);
+	Synth.Generate();
+	LWO_CHECK(Synth.WriteFile(szFile) == true);
+
+	CLwoAsyncLoader::tResult Result;
+	{
+		CLwoAsyncLoader Loader(1, 64*1024);
+		Result = Loader.Load(szFile)->GetFuture().get();
+	}
+	LWO_CHECK(Result->m_bSuccess == false);
+	LWO_CHECK(Result->m_szError == "budget");
+
+	CLwoAsyncLoader::tResult Unlimited;
+	{
+		CLwoAsyncLoader Loader(1, 0);
+		Unlimited = Loader.Load(szFile)->GetFuture().get();
+	}
+	LWO_CHECK(Unlimited->m_bSuccess == true);
+	remove(szFile);
+}
+
+// records across parts of streaming window are not errors,
+// truncated record is an overrun (not generic chunk error)
+static void TestStreamRecords()
+{
+	tLwoSynthOptions Options;
+	Options.m_ulPointsPerLayer = 30000;
+	Options.m_ulPolygonsPerLayer = 60000;
+	Options.m_fWideIndexDensity = 0.3f;
+	Options.m_fVmadDensity = 0.5f;
+	CLwoSynth Synth(Options);
+	Synth.Generate();
+
+	CLwoReader LwoReader;
+	CLwoCountHandler Handler;
+	LWO_CHECK(StreamBuffer(Synth.GetBuffer(), LwoReader, Handler) == true);
+	LWO_CHECK(LwoReader.GetError() == LWO_ERROR_NONE);
+	LWO_CHECK(Handler.m_nPolygons == 60000);
+	LWO_CHECK(Handler.m_nPtags == 60000);
+
+	// polygon of three vertices with two indices
+	{
+		CLwoCraft Craft;
+		size_t nFormPos = Craft.BeginForm();
+		size_t nPolsPos = Craft.BeginChunk(ID_POLS);
+		Craft.PutID(ID_FACE);
+		Craft.PutU2(3);
+		Craft.PutVX(0);
+		Craft.PutVX(1);
+		Craft.EndChunk(nPolsPos);
+		Craft.EndChunk(nFormPos);
+
+		CLwoReader Reader;
+		CLwoCountHandler Counts;
+		LWO_CHECK(StreamBuffer(Craft.GetBuffer(), Reader, Counts) == false);
+		LWO_CHECK(Reader.GetError() == LWO_ERROR_OVERRUN);
+	}
+
+	// tag of polygon missing
+	{
+		CLwoCraft Craft;
+		size_t nFormPos = Craft.BeginForm();
+		size_t nPtagPos = Craft.BeginChunk(ID_PTAG);
+		Craft.PutID(ID_SURF);
+		Craft.PutVX(0);
+		Craft.PutU2(0);
+		Craft.PutVX(1);
+		Craft.EndChunk(nPtagPos);
+		Craft.EndChunk(nFormPos);
+
+		CLwoReader Reader;
+		CLwoCountHandler Counts;
+		LWO_CHECK(StreamBuffer(Craft.GetBuffer(), Reader, Counts) == false);
+		LWO_CHECK(Reader.GetError() == LWO_ERROR_OVERRUN);
+	}
+
+	// second value of UV missing
+	{
+		CLwoCraft Craft;
+		size_t nFormPos = Craft.BeginForm();
+		size_t nVmapPos = Craft.BeginChunk(ID_VMAP);
+		Craft.PutID(ID_TXUV);
+		Craft.PutU2(2);
+		Craft.PutS0("UV");
+		Craft.PutVX(0);
+		Craft.PutF4(0.5f);
+		Craft.EndChunk(nVmapPos);
+		Craft.EndChunk(nFormPos);
+
+		CLwoReader Reader;
+		CLwoCountHandler Counts;
+		LWO_CHECK(StreamBuffer(Craft.GetBuffer(), Reader, Counts) == false);
+		LWO_CHECK(Reader.GetError() == LWO_ERROR_OVERRUN);
+	}
+}
+
+// triangle of points 0, 1, 2 as polygon-list
+static void PutTriangle(CLwoCraft &Craft)
+{
+	size_t nPolsPos = Craft.BeginChunk(ID_POLS);
+	Craft.PutID(ID_FACE);
+	Craft.PutU2(3);
+	Craft.PutVX(0);
+	Craft.PutVX(1);
+	Craft.PutVX(2);
+	Craft.EndChunk(nPolsPos);
+}
+
+// UV of one polygon-vertex
+static void PutCornerUV(CLwoCraft &Craft, const unsigned short usPoint, const float fU, const float fV)
+{
+	size_t nVmadPos = Craft.BeginChunk(ID_VMAD);
+	Craft.PutID(ID_TXUV);
+	Craft.PutU2(2);
+	Craft.PutS0("UV");
+	Craft.PutVX(usPoint);
+	Craft.PutVX(0);
+	Craft.PutF4(fU);
+	Craft.PutF4(fV);
+	Craft.EndChunk(nVmadPos);
+}
+
+// is UV (as written in GLB, V flipped) in floats of file
+static bool HasTexCoord(const vector<char> &vFile, const float fU, const float fV)
+{
+	const float fUV[2] = {fU, 1.0f - fV};
+	for (size_t i = 0; (i + sizeof(fUV)) <= vFile.size(); i += 4)
+	{
+		if (memcmp(&vFile[i], fUV, sizeof(fUV)) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// VMAD refers to polygons of the list before it:
+// same polygon-index in two lists has UVs of each,
+// VMADs of same name for one list are merged
+static void TestVmadLists()
+{
+	CLwoCraft Craft;
+	size_t nFormPos = Craft.BeginForm();
+	size_t nPntsPos = Craft.BeginChunk(ID_PNTS);
+	const float fPoints[9] = {0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f};
+	for (int i = 0; i < 9; i++)
+	{
+		Craft.PutF4(fPoints[i]);
+	}
+	Craft.EndChunk(nPntsPos);
+	PutTriangle(Craft);
+	PutCornerUV(Craft, 0, 0.25f, 0.75f);
+	PutTriangle(Craft);
+	PutCornerUV(Craft, 0, 0.5f, 0.125f);
+	PutCornerUV(Craft, 1, 0.375f, 0.625f);
+	Craft.EndChunk(nFormPos);
+
+	CLwoReader LwoReader;
+	LWO_CHECK(ParseBuffer(Craft.GetBuffer(), LwoReader) == true);
+
+	// file in working directory of test
+	const char *szFile = "LwoRegress_vmad.glb";
+	CLwoExporter Exporter;
+	LWO_CHECK(Exporter.WriteGlb(LwoReader.GetObjectData(), szFile) == true);
+
+	vector<char> vFile;
+	FILE *pFile = fopen(szFile, "rb");
+	if (pFile != NULL)
+	{
+		char Buffer[4096];
+		size_t nRead = 0;
+		while ((nRead = fread(Buffer, 1, sizeof(Buffer), pFile)) > 0)
+		{
+			vFile.insert(vFile.end(), Buffer, Buffer + nRead);
+		}
+		fclose(pFile);
+	}
+	remove(szFile);
+
+	LWO_CHECK(HasTexCoord(vFile, 0.25f, 0.75f) == true);
+	LWO_CHECK(HasTexCoord(vFile, 0.5f, 0.125f) == true);
+	LWO_CHECK(HasTexCoord(vFile, 0.375f, 0.625f) == true);
+}
+
+// header of PLY is written once: count of faces
+// leaves out polygons which are not written (less than three vertices)
+static void TestPlyHeader()
+{
+	CLwoCraft Craft;
+	size_t nFormPos = Craft.BeginForm();
+	size_t nPntsPos = Craft.BeginChunk(ID_PNTS);
+	const float fPoints[9] = {0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f};
+	for (int i = 0; i < 9; i++)
+	{
+		Craft.PutF4(fPoints[i]);
+	}
+	Craft.EndChunk(nPntsPos);
+	size_t nPolsPos = Craft.BeginChunk(ID_POLS);
+	Craft.PutID(ID_FACE);
+	Craft.PutU2(3);
+	Craft.PutVX(0);
+	Craft.PutVX(1);
+	Craft.PutVX(2);
+	Craft.PutU2(2);
+	Craft.PutVX(0);
+	Craft.PutVX(1);
+	Craft.PutU2(3);
+	Craft.PutVX(2);
+	Craft.PutVX(1);
+	Craft.PutVX(0);
+	Craft.EndChunk(nPolsPos);
+	Craft.EndChunk(nFormPos);
+
+	CLwoReader LwoReader;
+	LWO_CHECK(ParseBuffer(Craft.GetBuffer(), LwoReader) == true);
+
+	// file in working directory of test
+	const char *szFile = "LwoRegress_header.ply";
+	CLwoExporter Exporter;
+	LWO_CHECK(Exporter.WritePly(LwoReader.GetObjectData(), szFile, false) == true);
+
+	string szFileText;
+	FILE *pFile = fopen(szFile, "rb");
+	if (pFile != NULL)
+	{
+		char Buffer[4096];
+		size_t nRead = 0;
+		while ((nRead = fread(Buffer, 1, sizeof(Buffer), pFile)) > 0)
+		{
+			szFileText.append(Buffer, nRead);
+		}
+		fclose(pFile);
+	}
+	remove(szFile);
+
+	LWO_CHECK(szFileText.find("element vertex 3\n") != string::npos);
+	LWO_CHECK(szFileText.find("element face 2\n") != string::npos);
+
+	// three points and two faces after header
+	size_t nBody = szFileText.find("end_header\n");
+	LWO_CHECK(nBody != string::npos);
+	if (nBody != string::npos)
+	{
+		size_t nLines = 0;
+		for (size_t i = nBody + 11; i < szFileText.size(); i++)
+		{
+			nLines += (szFileText[i] == '\n') ? 1 : 0;
+		}
+		LWO_CHECK(nLines == 5);
+	}
+}
+
+int main()
+{
+	TestUnknownBlok();
+	TestValueLists();
+	TestLwobTextures();
+	TestImagePaths();
+	TestAsyncBudget();
+	TestStreamRecords();
+	TestVmadLists();
+	TestPlyHeader();
+
+	if (g_iFailures > 0)
+	{
+		printf("%d checks failed\n", g_iFailures);
+		return EXIT_FAILURE;
+	}
+	printf("all checks passed\n");
+	return EXIT_SUCCESS;
+}
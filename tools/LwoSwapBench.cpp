@@ -0,0 +1,394 @@
+//////////////////////////////////////////////////////////////////////
+// LwoSwapBench.cpp : microbenchmarks of decoding single values
+//
+// Variants of byte-swapping (previous pointer-cast code,
+// shifts, compiler builtin, movbe, SSSE3 and AVX2 arrays)
+// on aligned and unaligned data, variable-length indices (VX)
+// with distributions of 2-byte and 4-byte forms, and tag-IDs.
+// Shows ns/element and cycles/byte (TSC on x86).
+//
+// Order of CLwoByteSwap::GetSwap4(LWO_SWAP_AUTO) is based on these.
+//
+//   LwoSwapBench [-n repeats]
+//
+
+#include "LwoByteSwap.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define LWO_BENCH_TSC
+#endif
+
+using namespace std;
+
+
+// keeps results from being optimized away
+static volatile unsigned int g_uiSink = 0;
+
+static unsigned long long ReadCycles()
+{
+#ifdef LWO_BENCH_TSC
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+// run function repeatedly, report best of repeats
+template <typename tFunc>
+static void Measure(const char *szName, const size_t nElements, const size_t nBytes, const int iRepeats, tFunc Func)
+{
+	double dBestSeconds = 0.0;
+	unsigned long long ullBestCycles = 0;
+	for (int i = 0; i < iRepeats; i++)
+	{
+		unsigned long long ullStartCycles = ReadCycles();
+		chrono::steady_clock::time_point Start = chrono::steady_clock::now();
+		Func();
+		chrono::duration<double> Elapsed = (chrono::steady_clock::now() - Start);
+		unsigned long long ullCycles = ReadCycles() - ullStartCycles;
+		if (i == 0 || Elapsed.count() < dBestSeconds)
+		{
+			dBestSeconds = Elapsed.count();
+			ullBestCycles = ullCycles;
+		}
+	}
+
+	printf("%-34s %10.3f ns/elem", szName, dBestSeconds * 1e9 / (double)nElements);
+#ifdef LWO_BENCH_TSC
+	printf(" %8.3f cycles/byte", (double)ullBestCycles / (double)nBytes);
+#endif
+	printf("\n");
+}
+
+
+//// single values as in CLwoReader before LwoByteSwap.h
+
+static unsigned short OldBSwap2s(const unsigned short *buf)
+{
+	unsigned short tmp = (*buf);
+	return (((tmp >> 8)) | (tmp << 8));
+}
+
+static unsigned int OldBSwap4i(const unsigned int *buf)
+{
+	unsigned int tmp = (*buf);
+	return (
+			((tmp & 0x000000FF) << 24) + ((tmp & 0x0000FF00) <<8) +
+			((tmp & 0x00FF0000) >> 8) + ((tmp & 0xFF000000) >>24)
+			);
+}
+
+static float OldBSwapF(const float fVal)
+{
+	// bits of float by copy: reading through cast pointer
+	// is not defined (and GCC sees it as uninitialized)
+	unsigned int uiTmp = 0;
+	memcpy(&uiTmp, &fVal, sizeof(float));
+	uiTmp = OldBSwap4i(&uiTmp);
+
+	float fTmp = 0.0f;
+	memcpy(&fTmp, &uiTmp, sizeof(float));
+	return fTmp;
+}
+
+static unsigned int OldGetVarlenIX(const char *pChunk, int &iIxSize)
+{
+	if ((unsigned char)pChunk[0] == 0xFF)
+	{
+		iIxSize = 4;
+		return (OldBSwap4i((unsigned int*)pChunk) & 0x00FFFFFF);
+	}
+	iIxSize = 2;
+	return OldBSwap2s((unsigned short*)pChunk);
+}
+
+static unsigned int OldMakeTag(const char *buf)
+{
+	return (
+		(unsigned long) (buf[0])<<24
+		| (unsigned long) (buf[1])<<16
+		| (unsigned long) (buf[2])<<8
+		| (unsigned long) (buf[3]));
+}
+
+//// variable-length index variants
+
+// branch on first byte, shifts of bytes (as CLwoCursor)
+static unsigned int ShiftVX(const char *&pBuf)
+{
+	const unsigned char *pBytes = (const unsigned char*)pBuf;
+	if (pBytes[0] == 0xFF)
+	{
+		pBuf = (pBuf +4);
+		return (((unsigned int)pBytes[1] << 16) | ((unsigned int)pBytes[2] << 8) | pBytes[3]);
+	}
+	pBuf = (pBuf +2);
+	return (((unsigned int)pBytes[0] << 8) | pBytes[1]);
+}
+
+// branch on first byte, builtin loads
+static unsigned int BuiltinVX(const char *&pBuf)
+{
+	if ((unsigned char)pBuf[0] == 0xFF)
+	{
+		unsigned int uiValue = (LwoGetU4(pBuf) & 0x00FFFFFF);
+		pBuf = (pBuf +4);
+		return uiValue;
+	}
+	unsigned int uiValue = LwoGetU2(pBuf);
+	pBuf = (pBuf +2);
+	return uiValue;
+}
+
+// one 4-byte load and select without branch
+// (needs 4 readable bytes also for 2-byte form)
+static unsigned int SelectVX(const char *&pBuf)
+{
+	const unsigned int uiValue = LwoGetU4(pBuf);
+	const unsigned int uiWide = ((uiValue >> 24) == 0xFF) ? 1 : 0;
+	pBuf = (pBuf + 2 + uiWide*2);
+	return (uiWide != 0) ? (uiValue & 0x00FFFFFF) : (uiValue >> 16);
+}
+
+
+// indices in VX-form: iWidePercent of values are larger than 2-byte form allows
+static vector<char> MakeIndices(const size_t nCount, const int iWidePercent, unsigned int uiSeed)
+{
+	vector<char> vBuf;
+	vBuf.reserve(nCount*4 + 4);
+	for (size_t i = 0; i < nCount; i++)
+	{
+		uiSeed = (uiSeed * 1664525u + 1013904223u);
+		const bool bWide = ((int)((uiSeed >> 8) % 100) < iWidePercent);
+		uiSeed = (uiSeed * 1664525u + 1013904223u);
+		if (bWide == true)
+		{
+			const unsigned int uiIndex = 0xFF00 + ((uiSeed >> 8) % 0x100000);
+			vBuf.push_back((char)0xFF);
+			vBuf.push_back((char)((uiIndex >> 16) & 0xFF));
+			vBuf.push_back((char)((uiIndex >> 8) & 0xFF));
+			vBuf.push_back((char)(uiIndex & 0xFF));
+		}
+		else
+		{
+			const unsigned int uiIndex = ((uiSeed >> 8) % 0xFF00);
+			vBuf.push_back((char)((uiIndex >> 8) & 0xFF));
+			vBuf.push_back((char)(uiIndex & 0xFF));
+		}
+	}
+
+	// padding for 4-byte loads at end
+	for (int i = 0; i < 4; i++)
+	{
+		vBuf.push_back(0);
+	}
+	return vBuf;
+}
+
+int main(int argc, char* argv[])
+{
+	int iRepeats = 20;
+	if (argc >= 3
+		&& strcmp(argv[1], "-n") == 0)
+	{
+		iRepeats = atoi(argv[2]);
+		if (iRepeats < 1)
+		{
+			iRepeats = 1;
+		}
+	}
+
+	// 1 MB of values (in L2/L3) and 32 MB (memory)
+	const size_t nSizes[2] = {256*1024, 8*1024*1024};
+
+	printf("selected: %s\n\n", CLwoByteSwap::GetVariantName(CLwoByteSwap::GetSelected()));
+
+	for (int iSize = 0; iSize < 2; iSize++)
+	{
+		const size_t nCount = nSizes[iSize];
+
+		// source with room for unaligned start
+		vector<char> vSource(nCount*4 + 16);
+		for (size_t i = 0; i < vSource.size(); i++)
+		{
+			vSource[i] = (char)(i * 131 + 7);
+		}
+		vector<float> vDest(nCount);
+
+		for (int iOffset = 0; iOffset < 2; iOffset++)
+		{
+			// vector data is aligned to at least 8 bytes
+			const char *pSrc = vSource.data() + iOffset;
+			printf("== 4-byte values: %u, %s\n", (unsigned int)nCount, (iOffset == 0) ? "aligned" : "unaligned");
+
+			// previous per-value code: pointer cast
+			// (not valid for unaligned on all platforms)
+			Measure("per-value BSwapF (old)", nCount, nCount*4, iRepeats, [&]()
+			{
+				const float *pfSrc = (const float*)pSrc;
+				for (size_t i = 0; i < nCount; i++)
+				{
+					vDest[i] = OldBSwapF(pfSrc[i]);
+				}
+				g_uiSink += (unsigned int)vDest[nCount/2];
+			});
+
+			Measure("per-value LwoGetF4", nCount, nCount*4, iRepeats, [&]()
+			{
+				for (size_t i = 0; i < nCount; i++)
+				{
+					vDest[i] = LwoGetF4(pSrc + i*4);
+				}
+				g_uiSink += (unsigned int)vDest[nCount/2];
+			});
+
+			const LwoSwapVariant eVariants[5] = {LWO_SWAP_SCALAR, LWO_SWAP_BUILTIN, LWO_SWAP_MOVBE, LWO_SWAP_SSSE3, LWO_SWAP_AVX2};
+			for (int v = 0; v < 5; v++)
+			{
+				tLwoSwap4Func pfnSwap4 = CLwoByteSwap::GetSwap4(eVariants[v]);
+				string szName = string("array Swap4 ") + CLwoByteSwap::GetVariantName(eVariants[v]);
+				if (pfnSwap4 == NULL)
+				{
+					printf("%-34s not supported\n", szName.c_str());
+					continue;
+				}
+				Measure(szName.c_str(), nCount, nCount*4, iRepeats, [&]()
+				{
+					pfnSwap4(vDest.data(), pSrc, nCount);
+					g_uiSink += (unsigned int)vDest[nCount/2];
+				});
+			}
+		}
+		printf("\n");
+	}
+
+	// 2-byte values (LWOB indices, flags)
+	{
+		const size_t nCount = 1024*1024;
+		vector<char> vSource(nCount*2 + 16, 0x5A);
+		for (int iOffset = 0; iOffset < 2; iOffset++)
+		{
+			const char *pSrc = vSource.data() + iOffset;
+			printf("== 2-byte values: %u, %s\n", (unsigned int)nCount, (iOffset == 0) ? "aligned" : "unaligned");
+			Measure("per-value BSwap2s (old)", nCount, nCount*2, iRepeats, [&]()
+			{
+				const unsigned short *pusSrc = (const unsigned short*)pSrc;
+				unsigned int uiSum = 0;
+				for (size_t i = 0; i < nCount; i++)
+				{
+					uiSum += OldBSwap2s(pusSrc + i);
+				}
+				g_uiSink += uiSum;
+			});
+			Measure("per-value LwoGetU2", nCount, nCount*2, iRepeats, [&]()
+			{
+				unsigned int uiSum = 0;
+				for (size_t i = 0; i < nCount; i++)
+				{
+					uiSum += LwoGetU2(pSrc + i*2);
+				}
+				g_uiSink += uiSum;
+			});
+		}
+		printf("\n");
+	}
+
+	// indices: all 2-byte, some 4-byte, mesh of 200k points (~70% 4-byte), all 4-byte
+	const int iWidePercents[4] = {0, 10, 70, 100};
+	for (int d = 0; d < 4; d++)
+	{
+		const size_t nCount = 1024*1024;
+		vector<char> vIndices = MakeIndices(nCount, iWidePercents[d], 12345);
+		const char *pBegin = vIndices.data();
+		const size_t nBytes = vIndices.size() - 4;
+
+		printf("== VX indices: %u, %d%% 4-byte\n", (unsigned int)nCount, iWidePercents[d]);
+		Measure("GetVarlenIX (old)", nCount, nBytes, iRepeats, [&]()
+		{
+			const char *pBuf = pBegin;
+			unsigned int uiSum = 0;
+			for (size_t i = 0; i < nCount; i++)
+			{
+				int iIxSize = 0;
+				uiSum += OldGetVarlenIX(pBuf, iIxSize);
+				pBuf = (pBuf + iIxSize);
+			}
+			g_uiSink += uiSum;
+		});
+		Measure("VX shifts, branch", nCount, nBytes, iRepeats, [&]()
+		{
+			const char *pBuf = pBegin;
+			unsigned int uiSum = 0;
+			for (size_t i = 0; i < nCount; i++)
+			{
+				uiSum += ShiftVX(pBuf);
+			}
+			g_uiSink += uiSum;
+		});
+		Measure("VX builtin, branch", nCount, nBytes, iRepeats, [&]()
+		{
+			const char *pBuf = pBegin;
+			unsigned int uiSum = 0;
+			for (size_t i = 0; i < nCount; i++)
+			{
+				uiSum += BuiltinVX(pBuf);
+			}
+			g_uiSink += uiSum;
+		});
+		Measure("VX builtin, select", nCount, nBytes, iRepeats, [&]()
+		{
+			const char *pBuf = pBegin;
+			unsigned int uiSum = 0;
+			for (size_t i = 0; i < nCount; i++)
+			{
+				uiSum += SelectVX(pBuf);
+			}
+			g_uiSink += uiSum;
+		});
+	}
+	printf("\n");
+
+	// tag-IDs of chunks
+	{
+		const size_t nCount = 1024*1024;
+		vector<char> vTags(nCount*4);
+		const char *szTags = "PNTSPOLSPTAGSURFVMAPVMADLAYRTAGS";
+		for (size_t i = 0; i < vTags.size(); i++)
+		{
+			vTags[i] = szTags[i % 32];
+		}
+		printf("== tag-IDs: %u\n", (unsigned int)nCount);
+		Measure("MakeTag (old)", nCount, nCount*4, iRepeats, [&]()
+		{
+			unsigned int uiSum = 0;
+			for (size_t i = 0; i < nCount; i++)
+			{
+				uiSum += OldMakeTag(vTags.data() + i*4);
+			}
+			g_uiSink += uiSum;
+		});
+		Measure("LwoGetU4", nCount, nCount*4, iRepeats, [&]()
+		{
+			unsigned int uiSum = 0;
+			for (size_t i = 0; i < nCount; i++)
+			{
+				uiSum += LwoGetU4(vTags.data() + i*4);
+			}
+			g_uiSink += uiSum;
+		});
+	}
+	return EXIT_SUCCESS;
+}
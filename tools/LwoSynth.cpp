@@ -0,0 +1,508 @@
+//////////////////////////////////////////////////////////////////////
+// LwoSynth.cpp : deterministic generator of synthetic LWO2-objects
+//
+
+#include "LwoSynth.h"
+#include "LwoTags.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+CLwoSynth::CLwoSynth(const tLwoSynthOptions &Options)
+	: m_Options(Options)
+	, m_vBuffer()
+	, m_uiRandom(Options.m_uiSeed)
+{
+	// vertex count of polygon has 10 bits
+	if (m_Options.m_usMinPolygonSize < 1)
+	{
+		m_Options.m_usMinPolygonSize = 1;
+	}
+	if (m_Options.m_usMaxPolygonSize > 1023)
+	{
+		m_Options.m_usMaxPolygonSize = 1023;
+	}
+	if (m_Options.m_usMaxPolygonSize < m_Options.m_usMinPolygonSize)
+	{
+		m_Options.m_usMaxPolygonSize = m_Options.m_usMinPolygonSize;
+	}
+	if (m_Options.m_uiSurfaces < 1)
+	{
+		m_Options.m_uiSurfaces = 1;
+	}
+}
+
+CLwoSynth::~CLwoSynth()
+{
+}
+
+unsigned int CLwoSynth::Random()
+{
+	// same sequence on every platform
+	m_uiRandom = (m_uiRandom * 1664525u + 1013904223u);
+	return (m_uiRandom >> 8);
+}
+
+float CLwoSynth::RandomUnit()
+{
+	return (float)Random() / 16777216.0f;
+}
+
+unsigned long CLwoSynth::RandomRange(const unsigned long ulMin, const unsigned long ulMax)
+{
+	if (ulMax <= ulMin)
+	{
+		return ulMin;
+	}
+	// 48 bits for large ranges
+	unsigned long long ullRandom = ((unsigned long long)Random() << 24) | Random();
+	return ulMin + (unsigned long)(ullRandom % (unsigned long long)(ulMax - ulMin + 1));
+}
+
+bool CLwoSynth::RandomChance(const float fDensity)
+{
+	if (fDensity <= 0.0f)
+	{
+		return false;
+	}
+	if (fDensity >= 1.0f)
+	{
+		return true;
+	}
+	return (RandomUnit() < fDensity);
+}
+
+void CLwoSynth::PutU1(const unsigned char ucValue)
+{
+	m_vBuffer.push_back((char)ucValue);
+}
+
+void CLwoSynth::PutU2(const unsigned short usValue)
+{
+	PutU1((unsigned char)(usValue >> 8));
+	PutU1((unsigned char)(usValue & 0xFF));
+}
+
+void CLwoSynth::PutU4(const unsigned int uiValue)
+{
+	PutU2((unsigned short)(uiValue >> 16));
+	PutU2((unsigned short)(uiValue & 0xFFFF));
+}
+
+void CLwoSynth::PutF4(const float fValue)
+{
+	unsigned int uiValue = 0;
+	memcpy(&uiValue, &fValue, sizeof(float));
+	PutU4(uiValue);
+}
+
+void CLwoSynth::PutID(const unsigned int uiTag)
+{
+	PutU4(uiTag);
+}
+
+void CLwoSynth::PutS0(const string &szValue)
+{
+	m_vBuffer.insert(m_vBuffer.end(), szValue.begin(), szValue.end());
+	PutU1(0);
+
+	// padded to even length
+	if ((szValue.length() + 1) % 2 != 0)
+	{
+		PutU1(0);
+	}
+}
+
+void CLwoSynth::PutVX(const unsigned long ulIndex)
+{
+	if (ulIndex >= 0xFF00
+		|| RandomChance(m_Options.m_fWideIndexDensity) == true)
+	{
+		PutU4(0xFF000000 | (unsigned int)(ulIndex & 0x00FFFFFF));
+		return;
+	}
+	PutU2((unsigned short)ulIndex);
+}
+
+size_t CLwoSynth::BeginChunk(const unsigned int uiTag)
+{
+	PutID(uiTag);
+	const size_t nSizePos = m_vBuffer.size();
+	PutU4(0);
+	return nSizePos;
+}
+
+void CLwoSynth::EndChunk(const size_t nSizePos)
+{
+	const size_t nSize = m_vBuffer.size() - (nSizePos + 4);
+	m_vBuffer[nSizePos] = (char)((nSize >> 24) & 0xFF);
+	m_vBuffer[nSizePos +1] = (char)((nSize >> 16) & 0xFF);
+	m_vBuffer[nSizePos +2] = (char)((nSize >> 8) & 0xFF);
+	m_vBuffer[nSizePos +3] = (char)(nSize & 0xFF);
+
+	// chunks of odd size have padding-byte
+	if (nSize % 2 != 0)
+	{
+		PutU1(0);
+	}
+}
+
+size_t CLwoSynth::BeginSubChunk(const unsigned int uiTag)
+{
+	PutID(uiTag);
+	const size_t nSizePos = m_vBuffer.size();
+	PutU2(0);
+	return nSizePos;
+}
+
+void CLwoSynth::EndSubChunk(const size_t nSizePos)
+{
+	const size_t nSize = m_vBuffer.size() - (nSizePos + 2);
+	m_vBuffer[nSizePos] = (char)((nSize >> 8) & 0xFF);
+	m_vBuffer[nSizePos +1] = (char)(nSize & 0xFF);
+	if (nSize % 2 != 0)
+	{
+		PutU1(0);
+	}
+}
+
+// surface names (index in PTAG)
+void CLwoSynth::MakeTags()
+{
+	size_t nSizePos = BeginChunk(ID_TAGS);
+	for (unsigned int i = 0; i < m_Options.m_uiSurfaces; i++)
+	{
+		char szName[32];
+		sprintf(szName, "Surface_%u", i);
+		PutS0(szName);
+	}
+	EndChunk(nSizePos);
+}
+
+// still image for image-textures (index 1)
+void CLwoSynth::MakeClip()
+{
+	size_t nSizePos = BeginChunk(ID_CLIP);
+	PutU4(1);
+
+	size_t nSubPos = BeginSubChunk(ID_STIL);
+	PutS0("images/synth.png");
+	EndSubChunk(nSubPos);
+
+	EndChunk(nSizePos);
+}
+
+void CLwoSynth::MakeLayer(const unsigned int uiLayer)
+{
+	const unsigned long ulPoints = m_Options.m_ulPointsPerLayer;
+	const unsigned long ulPolygons = (ulPoints > 0) ? m_Options.m_ulPolygonsPerLayer : 0;
+
+	size_t nSizePos = BeginChunk(ID_LAYR);
+	PutU2((unsigned short)uiLayer);
+	PutU2(0); // flags
+	for (int i = 0; i < 3; i++)
+	{
+		PutF4(0.0f); // pivot
+	}
+	char szName[32];
+	sprintf(szName, "Layer_%u", uiLayer);
+	PutS0(szName);
+	EndChunk(nSizePos);
+
+	// points and their bounding box
+	float fMin[3] = {0.0f, 0.0f, 0.0f};
+	float fMax[3] = {0.0f, 0.0f, 0.0f};
+	nSizePos = BeginChunk(ID_PNTS);
+	for (unsigned long ul = 0; ul < ulPoints; ul++)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			float fValue = RandomUnit() * 2.0f - 1.0f;
+			if (ul == 0 || fValue < fMin[i])
+			{
+				fMin[i] = fValue;
+			}
+			if (ul == 0 || fValue > fMax[i])
+			{
+				fMax[i] = fValue;
+			}
+			PutF4(fValue);
+		}
+	}
+	EndChunk(nSizePos);
+
+	nSizePos = BeginChunk(ID_BBOX);
+	for (int i = 0; i < 3; i++)
+	{
+		PutF4(fMin[i]);
+	}
+	for (int i = 0; i < 3; i++)
+	{
+		PutF4(fMax[i]);
+	}
+	EndChunk(nSizePos);
+
+	if (m_Options.m_fVmapDensity > 0.0f
+		&& ulPoints > 0)
+	{
+		nSizePos = BeginChunk(ID_VMAP);
+		PutID(ID_TXUV);
+		PutU2(2);
+		PutS0("UV");
+		for (unsigned long ul = 0; ul < ulPoints; ul++)
+		{
+			if (RandomChance(m_Options.m_fVmapDensity) == true)
+			{
+				PutVX(ul);
+				PutF4(RandomUnit());
+				PutF4(RandomUnit());
+			}
+		}
+		EndChunk(nSizePos);
+	}
+
+	// polygon vertices are kept for VMAD
+	vector<unsigned short> vCounts;
+	vector<unsigned long> vIndices;
+	vCounts.reserve(ulPolygons);
+
+	nSizePos = BeginChunk(ID_POLS);
+	PutID(ID_FACE);
+	for (unsigned long ul = 0; ul < ulPolygons; ul++)
+	{
+		unsigned short usCount = (unsigned short)RandomRange(m_Options.m_usMinPolygonSize, m_Options.m_usMaxPolygonSize);
+		vCounts.push_back(usCount);
+		PutU2(usCount); // flags are zero
+		for (unsigned short v = 0; v < usCount; v++)
+		{
+			unsigned long ulIndex = RandomRange(0, ulPoints - 1);
+			vIndices.push_back(ulIndex);
+			PutVX(ulIndex);
+		}
+	}
+	EndChunk(nSizePos);
+
+	if (m_Options.m_fPtagDensity > 0.0f
+		&& ulPolygons > 0)
+	{
+		nSizePos = BeginChunk(ID_PTAG);
+		PutID(ID_SURF);
+		for (unsigned long ul = 0; ul < ulPolygons; ul++)
+		{
+			if (RandomChance(m_Options.m_fPtagDensity) == true)
+			{
+				PutVX(ul);
+				PutU2((unsigned short)(ul % m_Options.m_uiSurfaces));
+			}
+		}
+		EndChunk(nSizePos);
+	}
+
+	if (m_Options.m_fVmadDensity > 0.0f
+		&& ulPolygons > 0)
+	{
+		nSizePos = BeginChunk(ID_VMAD);
+		PutID(ID_TXUV);
+		PutU2(2);
+		PutS0("UV");
+		size_t nFirst = 0;
+		for (unsigned long ul = 0; ul < ulPolygons; ul++)
+		{
+			for (unsigned short v = 0; v < vCounts[ul]; v++)
+			{
+				if (RandomChance(m_Options.m_fVmadDensity) == true)
+				{
+					PutVX(vIndices[nFirst + v]);
+					PutVX(ul);
+					PutF4(RandomUnit());
+					PutF4(RandomUnit());
+				}
+			}
+			nFirst += vCounts[ul];
+		}
+		EndChunk(nSizePos);
+	}
+}
+
+// image-texture (even) or procedural (odd)
+void CLwoSynth::MakeBlok(const unsigned int uiSurface, const unsigned int uiBlok)
+{
+	const bool bImage = ((uiBlok % 2) == 0);
+	size_t nBlokPos = BeginSubChunk(ID_BLOK);
+
+	size_t nSubPos = BeginSubChunk(bImage ? ID_IMAP : ID_PROC);
+	string szOrdinal = "\x80";
+	szOrdinal += (char)('A' + (uiBlok % 26));
+	PutS0(szOrdinal);
+	{
+		size_t nPos = BeginSubChunk(ID_CHAN);
+		PutID((uiBlok % 3 == 0) ? ID_COLR : ((uiBlok % 3 == 1) ? ID_DIFF : ID_BUMP));
+		EndSubChunk(nPos);
+
+		nPos = BeginSubChunk(ID_ENAB);
+		PutU2(1);
+		EndSubChunk(nPos);
+
+		nPos = BeginSubChunk(ID_OPAC);
+		PutU2(0);
+		PutF4(1.0f);
+		PutVX(0);
+		EndSubChunk(nPos);
+	}
+	EndSubChunk(nSubPos);
+
+	nSubPos = BeginSubChunk(ID_TMAP);
+	{
+		const unsigned int uiVectors[3] = {ID_CNTR, ID_SIZE, ID_ROTA};
+		for (int i = 0; i < 3; i++)
+		{
+			size_t nPos = BeginSubChunk(uiVectors[i]);
+			for (int k = 0; k < 3; k++)
+			{
+				PutF4((i == 1) ? 1.0f : 0.0f);
+			}
+			PutVX(0);
+			EndSubChunk(nPos);
+		}
+
+		size_t nPos = BeginSubChunk(ID_OREF);
+		PutS0("(none)");
+		EndSubChunk(nPos);
+
+		nPos = BeginSubChunk(ID_CSYS);
+		PutU2(0);
+		EndSubChunk(nPos);
+	}
+	EndSubChunk(nSubPos);
+
+	if (bImage == true)
+	{
+		nSubPos = BeginSubChunk(ID_PROJ);
+		PutU2(5); // UV
+		EndSubChunk(nSubPos);
+
+		nSubPos = BeginSubChunk(ID_AXIS);
+		PutU2(2);
+		EndSubChunk(nSubPos);
+
+		nSubPos = BeginSubChunk(ID_IMAG);
+		PutVX(1);
+		EndSubChunk(nSubPos);
+
+		nSubPos = BeginSubChunk(ID_WRAP);
+		PutU2(1);
+		PutU2(1);
+		EndSubChunk(nSubPos);
+
+		nSubPos = BeginSubChunk(ID_VMAP);
+		PutS0("UV");
+		EndSubChunk(nSubPos);
+
+		nSubPos = BeginSubChunk(ID_AAST);
+		PutU2(1);
+		PutF4(1.0f);
+		EndSubChunk(nSubPos);
+	}
+	else
+	{
+		nSubPos = BeginSubChunk(ID_AXIS);
+		PutU2((unsigned short)(uiSurface % 3));
+		EndSubChunk(nSubPos);
+
+		nSubPos = BeginSubChunk(ID_VALU);
+		for (int i = 0; i < 3; i++)
+		{
+			PutF4(RandomUnit());
+		}
+		EndSubChunk(nSubPos);
+
+		nSubPos = BeginSubChunk(ID_FUNC);
+		PutS0("Turbulence");
+		PutU4(Random());
+		EndSubChunk(nSubPos);
+	}
+
+	EndSubChunk(nBlokPos);
+}
+
+void CLwoSynth::MakeSurface(const unsigned int uiSurface)
+{
+	size_t nSizePos = BeginChunk(ID_SURF);
+
+	char szName[32];
+	sprintf(szName, "Surface_%u", uiSurface);
+	PutS0(szName);
+	PutS0(""); // no parent
+
+	size_t nSubPos = BeginSubChunk(ID_COLR);
+	for (int i = 0; i < 3; i++)
+	{
+		PutF4(RandomUnit());
+	}
+	PutVX(0);
+	EndSubChunk(nSubPos);
+
+	const unsigned int uiChannels[3] = {ID_DIFF, ID_SPEC, ID_GLOS};
+	for (int i = 0; i < 3; i++)
+	{
+		nSubPos = BeginSubChunk(uiChannels[i]);
+		PutF4(RandomUnit());
+		PutVX(0);
+		EndSubChunk(nSubPos);
+	}
+
+	nSubPos = BeginSubChunk(ID_SMAN);
+	PutF4(1.5625f);
+	EndSubChunk(nSubPos);
+
+	nSubPos = BeginSubChunk(ID_SIDE);
+	PutU2(1);
+	EndSubChunk(nSubPos);
+
+	for (unsigned int i = 0; i < m_Options.m_uiBlocksPerSurface; i++)
+	{
+		MakeBlok(uiSurface, i);
+	}
+
+	EndChunk(nSizePos);
+}
+
+const vector<char> &CLwoSynth::Generate()
+{
+	m_vBuffer.clear();
+	m_uiRandom = m_Options.m_uiSeed;
+
+	size_t nFormPos = BeginChunk(ID_FORM);
+	PutID(ID_LWO2);
+
+	MakeTags();
+	MakeClip();
+	for (unsigned int i = 0; i < m_Options.m_uiLayers; i++)
+	{
+		MakeLayer(i);
+	}
+	for (unsigned int i = 0; i < m_Options.m_uiSurfaces; i++)
+	{
+		MakeSurface(i);
+	}
+
+	EndChunk(nFormPos);
+	return m_vBuffer;
+}
+
+bool CLwoSynth::WriteFile(const char *szFile) const
+{
+	FILE *pFile = fopen(szFile, "wb");
+	if (pFile == NULL)
+	{
+		return false;
+	}
+	bool bRet = true;
+	if (m_vBuffer.empty() == false)
+	{
+		bRet = (fwrite(m_vBuffer.data(), 1, m_vBuffer.size(), pFile) == m_vBuffer.size());
+	}
+	fclose(pFile);
+	return bRet;
+}
@@ -0,0 +1,122 @@
+//////////////////////////////////////////////////////////////////////
+// LwoSynth.h : deterministic generator of synthetic LWO2-objects
+//
+// Makes LWO2-file in memory from options
+// (same options and seed give same bytes)
+// for benchmarks and fuzz corpus.
+//
+
+#ifndef _LWOSYNTH_H_
+#define _LWOSYNTH_H_
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// contents of generated object,
+// densities are fractions (0..1) of points or polygons
+struct tLwoSynthOptions
+{
+	unsigned int m_uiSeed;
+
+	// each layer has same amount of points and polygons
+	unsigned int m_uiLayers;
+	unsigned long m_ulPointsPerLayer;
+	unsigned long m_ulPolygonsPerLayer;
+
+	// vertices in each polygon (from min to max)
+	unsigned short m_usMinPolygonSize;
+	unsigned short m_usMaxPolygonSize;
+
+	// indices below 0xFF00 written in 4-byte VX-form
+	// (larger indices always are)
+	float m_fWideIndexDensity;
+
+	// polygons with SURF-tag in PTAG
+	float m_fPtagDensity;
+
+	// points with UV in VMAP
+	// and polygon-vertices with UV in VMAD
+	float m_fVmapDensity;
+	float m_fVmadDensity;
+
+	// surfaces and texture layers (BLOK) in each,
+	// image-textures refer to one CLIP
+	unsigned int m_uiSurfaces;
+	unsigned int m_uiBlocksPerSurface;
+
+	tLwoSynthOptions()
+		: m_uiSeed(1)
+		, m_uiLayers(1)
+		, m_ulPointsPerLayer(10000)
+		, m_ulPolygonsPerLayer(20000)
+		, m_usMinPolygonSize(3)
+		, m_usMaxPolygonSize(4)
+		, m_fWideIndexDensity(0.0f)
+		, m_fPtagDensity(1.0f)
+		, m_fVmapDensity(1.0f)
+		, m_fVmadDensity(0.0f)
+		, m_uiSurfaces(4)
+		, m_uiBlocksPerSurface(1)
+	{};
+};
+
+class CLwoSynth
+{
+protected:
+	tLwoSynthOptions m_Options;
+
+	// file being made
+	vector<char> m_vBuffer;
+
+	// state of random numbers (LCG)
+	unsigned int m_uiRandom;
+
+	unsigned int Random();
+
+	// random number in [0,1)
+	float RandomUnit();
+
+	// random number in [min,max]
+	unsigned long RandomRange(const unsigned long ulMin, const unsigned long ulMax);
+
+	bool RandomChance(const float fDensity);
+
+	void PutU1(const unsigned char ucValue);
+	void PutU2(const unsigned short usValue);
+	void PutU4(const unsigned int uiValue);
+	void PutF4(const float fValue);
+	void PutID(const unsigned int uiTag);
+	void PutS0(const string &szValue);
+	void PutVX(const unsigned long ulIndex);
+
+	// size is set when chunk ends:
+	// returns position of size-field
+	size_t BeginChunk(const unsigned int uiTag);
+	void EndChunk(const size_t nSizePos);
+	size_t BeginSubChunk(const unsigned int uiTag);
+	void EndSubChunk(const size_t nSizePos);
+
+	void MakeTags();
+	void MakeClip();
+	void MakeLayer(const unsigned int uiLayer);
+	void MakeSurface(const unsigned int uiSurface);
+	void MakeBlok(const unsigned int uiSurface, const unsigned int uiBlok);
+
+public:
+	CLwoSynth(const tLwoSynthOptions &Options);
+	virtual ~CLwoSynth();
+
+	// make whole file
+	const vector<char> &Generate();
+
+	const vector<char> &GetBuffer() const
+	{
+		return m_vBuffer;
+	};
+
+	bool WriteFile(const char *szFile) const;
+};
+
+#endif // ifndef _LWOSYNTH_H_
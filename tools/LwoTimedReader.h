@@ -0,0 +1,223 @@
+//////////////////////////////////////////////////////////////////////
+// LwoTimedReader.h : CLwoReader with time of each stage
+//
+// Same steps as CLwoReader::ProcessFromFile(),
+// timing release of previous object, file header,
+// each chunk type and linkage of object
+// (for fuzz replay and benchmarks in tools).
+//
+
+#ifndef _LWOTIMEDREADER_H_
+#define _LWOTIMEDREADER_H_
+
+#include "LwoReader.h"
+
+#include <stdio.h>
+#include <map>
+#include <string>
+#include <chrono>
+
+using namespace std;
+
+// (tLwoAllocCounter is in LwoInstrumentation.h)
+
+// accumulated over processed files
+struct tLwoStageTime
+{
+	unsigned long m_ulCount;
+	unsigned long long m_ullBytes;
+	double m_dSeconds;
+	unsigned long long m_ullAllocs;
+	unsigned long long m_ullAllocBytes;
+
+	tLwoStageTime()
+		: m_ulCount(0)
+		, m_ullBytes(0)
+		, m_dSeconds(0.0)
+		, m_ullAllocs(0)
+		, m_ullAllocBytes(0)
+	{};
+};
+
+// stages by chunk type
+typedef map<unsigned int, tLwoStageTime> tLwoStageTimes;
+
+// stages other than chunks
+#define LWO_STAGE_RESET		LWID_('<','R','S','>')
+#define LWO_STAGE_HEADER	LWID_('<','H','D','>')
+#define LWO_STAGE_LINKAGE	LWID_('<','L','K','>')
+
+class CLwoTimedReader : public CLwoReader
+{
+protected:
+	const tLwoAllocCounter *m_pAllocs;
+
+	// start of stage being timed
+	chrono::steady_clock::time_point m_Start;
+	tLwoAllocCounter m_StartAllocs;
+
+	void BeginStage()
+	{
+		if (m_pAllocs != NULL)
+		{
+			m_StartAllocs = *m_pAllocs;
+		}
+		m_Start = chrono::steady_clock::now();
+	}
+
+	void EndStage(tLwoStageTimes &Times, const unsigned int uiStage, const unsigned long ulBytes)
+	{
+		chrono::duration<double> Elapsed = (chrono::steady_clock::now() - m_Start);
+
+		tLwoStageTime &Time = Times[uiStage];
+		Time.m_ulCount += 1;
+		Time.m_ullBytes += ulBytes;
+		Time.m_dSeconds += Elapsed.count();
+		if (m_pAllocs != NULL)
+		{
+			Time.m_ullAllocs += (m_pAllocs->m_ullCount - m_StartAllocs.m_ullCount);
+			Time.m_ullAllocBytes += (m_pAllocs->m_ullBytes - m_StartAllocs.m_ullBytes);
+		}
+	}
+
+public:
+	CLwoTimedReader(const tLwoAllocCounter *pAllocs = NULL)
+		: CLwoReader()
+		, m_pAllocs(pAllocs)
+	{};
+
+	bool ProcessTimed(CMemFile &LwoFile, tLwoStageTimes &Times)
+	{
+		BeginStage();
+		Reset();
+		EndStage(Times, LWO_STAGE_RESET, 0);
+
+		BeginStage();
+		bool bRet = HandleFileHeader(LwoFile.GetAtOffset(0, 12), LwoFile.GetFilesize());
+		EndStage(Times, LWO_STAGE_HEADER, 12);
+		if (bRet == false)
+		{
+			return false;
+		}
+
+		// size of FORM (already checked with file header)
+		unsigned int uiFormSize = 0;
+		GetChunkType(LwoFile.GetAtOffset(0, 8), uiFormSize);
+		const unsigned long ulFormEnd = (8 + (unsigned long)uiFormSize);
+
+		unsigned long ulChunkOffset = 12;
+		while (ulChunkOffset < ulFormEnd)
+		{
+			const char *pChunk = LwoFile.GetAtOffset(ulChunkOffset, 8);
+			if (pChunk == NULL)
+			{
+				return false;
+			}
+			unsigned int uiChunkSize = 0;
+			unsigned int uiChunkType = GetChunkType(pChunk, uiChunkSize);
+
+			ulChunkOffset += 8;
+			if (uiChunkSize > (LwoFile.GetFilesize() - ulChunkOffset))
+			{
+				return false;
+			}
+
+			const char *pChunkData = LwoFile.GetAtOffset(ulChunkOffset, uiChunkSize);
+
+			BeginStage();
+			bRet = ProcessChunk(pChunkData, uiChunkType, uiChunkSize);
+			EndStage(Times, uiChunkType, uiChunkSize);
+			if (bRet == false)
+			{
+				return false;
+			}
+			ulChunkOffset += uiChunkSize;
+		}
+
+		BeginStage();
+		bRet = LinkObjectData();
+		EndStage(Times, LWO_STAGE_LINKAGE, 0);
+		return bRet;
+	}
+
+	// chunk type or stage as text
+	static string GetStageName(const unsigned int uiStage)
+	{
+		if (uiStage == LWO_STAGE_RESET)
+		{
+			return "reset";
+		}
+		if (uiStage == LWO_STAGE_HEADER)
+		{
+			return "header";
+		}
+		if (uiStage == LWO_STAGE_LINKAGE)
+		{
+			return "linkage";
+		}
+
+		string szTag;
+		for (int i = 3; i >= 0; i--)
+		{
+			char c = (char)((uiStage >> (i*8)) & 0xFF);
+			szTag += (c >= 0x20 && c < 0x7F) ? c : '?';
+		}
+		return szTag;
+	}
+
+	static double GetMBps(const unsigned long long ullBytes, const double dSeconds)
+	{
+		if (dSeconds <= 0.0)
+		{
+			return 0.0;
+		}
+		return ((double)ullBytes / (1024.0*1024.0)) / dSeconds;
+	}
+
+	// table of stages in order of processing
+	static void PrintStages(const tLwoStageTimes &Times, const bool bAllocs)
+	{
+		printf("%-8s %10s %14s %12s %10s", "stage", "count", "bytes", "ms", "MB/s");
+		if (bAllocs == true)
+		{
+			printf(" %10s %14s", "allocs", "alloc bytes");
+		}
+		printf("\n");
+
+		for (int iPass = 0; iPass < 4; iPass++)
+		{
+			for (tLwoStageTimes::const_iterator it = Times.begin(); it != Times.end(); ++it)
+			{
+				int iStagePass = 2;
+				if (it->first == LWO_STAGE_RESET)
+				{
+					iStagePass = 0;
+				}
+				else if (it->first == LWO_STAGE_HEADER)
+				{
+					iStagePass = 1;
+				}
+				else if (it->first == LWO_STAGE_LINKAGE)
+				{
+					iStagePass = 3;
+				}
+				if (iStagePass != iPass)
+				{
+					continue;
+				}
+
+				const tLwoStageTime &Time = it->second;
+				printf("%-8s %10lu %14llu %12.3f %10.1f",
+					GetStageName(it->first).c_str(), Time.m_ulCount, Time.m_ullBytes,
+					Time.m_dSeconds * 1000.0, GetMBps(Time.m_ullBytes, Time.m_dSeconds));
+				if (bAllocs == true)
+				{
+					printf(" %10llu %14llu", Time.m_ullAllocs, Time.m_ullAllocBytes);
+				}
+				printf("\n");
+			}
+		}
+	}
+};
+
+#endif // ifndef _LWOTIMEDREADER_H_